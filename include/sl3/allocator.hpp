@@ -0,0 +1,146 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_ALLOCATOR_HPP_
+#define SL3_ALLOCATOR_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <sl3/config.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief Memory allocator interface for sqlite
+   *
+   * An implementation can be installed via GlobalConfig::allocator,
+   * sqlite will then use it for all its memory.
+   * The functions map to the members of sqlite3_mem_methods.
+   *
+   * Returned memory must be 8 byte aligned.
+   * Functions must not throw, a failed allocation returns nullptr.
+   *
+   * \sa https://www.sqlite.org/c3ref/mem_methods.html
+   */
+  class LIBSL3_API Allocator
+  {
+  public:
+    virtual ~Allocator ();
+
+    /**
+     * \brief allocate memory
+     * \param size bytes wanted, greater 0
+     * \return the memory or nullptr
+     */
+    virtual void* allocate (int size) noexcept = 0;
+
+    /**
+     * \brief free memory from allocate or reallocate
+     * \param p the memory, never nullptr
+     */
+    virtual void deallocate (void* p) noexcept = 0;
+
+    /**
+     * \brief resize memory
+     * \param p memory from allocate or reallocate, never nullptr
+     * \param size new size in bytes, greater 0
+     * \return the memory, p if it could be reused, or nullptr
+     */
+    virtual void* reallocate (void* p, int size) noexcept = 0;
+
+    /**
+     * \brief usable size of an allocation
+     * \param p memory from allocate or reallocate, never nullptr
+     * \return the size, at least the requested one
+     */
+    virtual int size (void* p) noexcept = 0;
+
+    /**
+     * \brief size that an allocation of size would return
+     * \param size wanted size
+     * \return the rounded size
+     */
+    virtual int roundup (int size) noexcept = 0;
+  };
+
+  /**
+   * \brief A slab allocator for small allocations
+   *
+   * Most allocations of sqlite are small and short lived.
+   * Requests up to maxSlabSize bytes are rounded up to a size class and
+   * served from free lists, refilled from chunks of chunkSize bytes.
+   * Larger requests go to malloc.
+   *
+   * The free lists are sharded by thread, so threads rarely wait for each
+   * other. Memory of the chunks is reused but only returned to the system
+   * when the allocator is destroyed.
+   *
+   * An installed allocator must live until sl3::shutdown.
+   */
+  class LIBSL3_API SlabAllocator final : public Allocator
+  {
+  public:
+    /// largest allocation served from a slab
+    static constexpr int maxSlabSize = 2048;
+
+    /**
+     * \brief Constructor
+     * \param chunkSize bytes requested from malloc to refill a free list
+     */
+    explicit SlabAllocator (std::size_t chunkSize = 64 * 1024);
+
+    ~SlabAllocator ();
+
+    SlabAllocator (const SlabAllocator&) = delete;
+    SlabAllocator& operator= (const SlabAllocator&) = delete;
+
+    void* allocate (int size) noexcept override;
+    void  deallocate (void* p) noexcept override;
+    void* reallocate (void* p, int size) noexcept override;
+    int   size (void* p) noexcept override;
+    int   roundup (int size) noexcept override;
+
+    /// number of allocations that are currently in use
+    std::size_t allocations () const;
+
+    /// bytes requested from malloc for chunks
+    std::size_t chunkBytes () const;
+
+  private:
+    static constexpr std::size_t classCount = 8; // 16 ... 2048
+    static constexpr std::size_t shardCount = 8;
+
+    struct FreeBlock
+    {
+      FreeBlock* next;
+    };
+
+    struct Shard
+    {
+      std::mutex         mutex;
+      FreeBlock*         free[classCount] = {};
+      std::vector<void*> chunks;
+      char*              top  = nullptr;
+      std::size_t        left = 0;
+    };
+
+    Shard& shard ();
+    void*  fromSlab (Shard& shard, std::size_t cls);
+
+    std::size_t              _chunkSize;
+    Shard                    _shards[shardCount];
+    std::atomic<std::size_t> _allocations{0};
+    std::atomic<std::size_t> _chunkBytes{0};
+  };
+}
+
+#endif
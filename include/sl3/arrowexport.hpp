@@ -0,0 +1,190 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_ARROWEXPORT_HPP_
+#define SL3_ARROWEXPORT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <sl3/command.hpp>
+#include <sl3/config.hpp>
+#include <sl3/dbvalues.hpp>
+#include <sl3/types.hpp>
+
+// The structs of the Arrow C Data Interface, as given by its
+// specification. The guard lets them coexist with the Arrow headers.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema
+{
+  // Array type description
+  const char*          format;
+  const char*          name;
+  const char*          metadata;
+  int64_t              flags;
+  int64_t              n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema*  dictionary;
+
+  // Release callback
+  void (*release) (struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray
+{
+  // Array data description
+  int64_t             length;
+  int64_t             null_count;
+  int64_t             offset;
+  int64_t             n_buffers;
+  int64_t             n_children;
+  const void**        buffers;
+  struct ArrowArray** children;
+  struct ArrowArray*  dictionary;
+
+  // Release callback
+  void (*release) (struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+} // extern "C"
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace sl3
+{
+  /**
+   * \brief Export the result of a Command in Arrow format
+   *
+   * Steps the Command and writes the rows, batchSize at a time, into
+   * Arrow arrays, following the Arrow C Data Interface. No Arrow library
+   * is needed, the structs are handed to one by the caller.
+   *
+   * Each batch is a struct array with one child per column, the schema a
+   * struct with one nullable field per column. Column types map to
+   *  - Type::Int: int64, format "l"
+   *  - Type::Real: float64, format "g"
+   *  - Type::Text: utf8, format "u"
+   *  - Type::Blob: binary, format "z"
+   *
+   * Given types, other than Type::Variant, are used as they are. The type
+   * of other columns is the storage type of their values in the first
+   * batch, Real if they hold Int and Real values, and Text if they hold
+   * only nulls.
+   * Later values must have the type of their column, only Int values
+   * are accepted in Real columns and converted.
+   *
+   * The Command is stepped by the exporter, it must outlive the exporter
+   * and must not be used while the exporter is.
+   *
+   * If fetching rows fails, the exporter is failed, later calls that
+   * fetch rows throw the same exception again.
+   *
+   * \code
+   *   auto cmd = db.prepare ("SELECT * FROM t;");
+   *   sl3::ArrowExporter exporter{cmd};
+   *   ArrowSchema schema;
+   *   exporter.exportSchema (&schema);
+   *   ArrowArray batch;
+   *   while (exporter.exportNext (&batch))
+   *     consume (&schema, &batch); // the consumer releases the batch
+   * \endcode
+   *
+   * \sa https://arrow.apache.org/docs/format/CDataInterface.html
+   */
+  class LIBSL3_API ArrowExporter
+  {
+  public:
+    /**
+     * \brief Start the export
+     *
+     * Binds the parameters, rows are fetched by exportSchema or
+     * exportNext.
+     *
+     * \param command the Command to export the result of
+     * \param parameters parameters of the command
+     * \param types types of the columns, empty to derive all
+     * \param batchSize maximal number of rows per batch
+     * \throw sl3::ErrTypeMisMatch if types are given, but not one per
+     *   column, or parameters are of the wrong size
+     * \throw sl3::ErrOutOfRange if batchSize is 0
+     * \throw sl3::ErrNoConnection if the database has been closed
+     */
+    explicit ArrowExporter (Command&        command,
+                            const DbValues& parameters = {},
+                            const Types&    types      = {},
+                            std::size_t     batchSize  = 65536);
+
+    /**
+     * \brief Destructor
+     *
+     * Resets the Command if not all rows have been fetched.
+     */
+    ~ArrowExporter ();
+
+    ArrowExporter (const ArrowExporter&) = delete;
+    ArrowExporter& operator= (const ArrowExporter&) = delete;
+
+    /**
+     * \brief Export the schema
+     *
+     * If the column types must be derived, the first batch is fetched.
+     * The caller owns out and has to call its release callback.
+     *
+     * \param out schema to fill
+     * \throw sl3::SQLite3Error if stepping the Command fails
+     * \throw sl3::ErrTypeMisMatch if a column of the first batch holds
+     *   values of incompatible types
+     */
+    void exportSchema (ArrowSchema* out);
+
+    /**
+     * \brief Export the next batch of rows
+     *
+     * The caller owns out and has to call its release callback.
+     *
+     * \param out array to fill, released, release is null, if there
+     *   are no more rows
+     * \throw sl3::SQLite3Error if stepping the Command fails
+     * \throw sl3::ErrTypeMisMatch if a value does not match the type of
+     *   its column
+     * \throw sl3::ErrOutOfRange if a Text or Blob column of the batch
+     *   exceeds 2 GiB, a smaller batchSize helps then
+     * \return false if there have been no more rows
+     */
+    bool exportNext (ArrowArray* out);
+
+    /**
+     * \brief Types of the columns
+     *
+     * Before the first batch is fetched, derived types are
+     * Type::Variant.
+     *
+     * \return one type per column
+     */
+    const Types& types () const noexcept;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+  };
+}
+
+#endif
@@ -0,0 +1,250 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_BLOBSTREAM_HPP_
+#define SL3_BLOBSTREAM_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <sl3/config.hpp>
+
+struct sqlite3_blob;
+
+namespace sl3
+{
+  namespace internal
+  {
+    class Connection;
+  }
+
+  /**
+   * \brief Incremental I/O on a single BLOB
+   *
+   * A BlobStream gives access to the content of one BLOB field without
+   * loading the whole value into memory.
+   * It is created via Database::openBlob or Database::insertZeroBlob.
+   *
+   * The size of a BLOB can not be changed through a BlobStream,
+   * writes are only possible within the existing size.
+   * To create room for new data, insert a zeroblob with the wanted size
+   * first, see Database::insertZeroBlob.
+   *
+   * \sa https://www.sqlite.org/c3ref/blob_open.html
+   */
+  class LIBSL3_API BlobStream
+  {
+    friend class Database;
+    using Connection = std::shared_ptr<internal::Connection>;
+
+  public:
+    /**
+     * \brief Access mode for a BlobStream
+     */
+    enum class Mode
+    {
+      ReadOnly  = 0, //!< only read access
+      ReadWrite = 1  //!< read and write access
+    };
+
+  private:
+    BlobStream (Connection         connection,
+                const std::string& dbname,
+                const std::string& table,
+                const std::string& column,
+                int64_t            rowid,
+                Mode               mode);
+
+    BlobStream ()                  = delete;
+    BlobStream (const BlobStream&) = delete;
+    BlobStream& operator= (const BlobStream&) = delete;
+    BlobStream& operator= (BlobStream&&) = delete;
+
+  public:
+    /**
+     * \brief Move constructor
+     *
+     * A BlobStream is movable
+     */
+    BlobStream (BlobStream&&) noexcept;
+
+    /**
+     * \brief Destructor
+     *
+     * Calls close.
+     */
+    ~BlobStream ();
+
+    /**
+     * \brief Size of the current BLOB
+     *
+     * \throw sl3::ErrNoConnection if the stream is closed
+     * \return size in bytes
+     */
+    std::size_t size () const;
+
+    /**
+     * \brief Rowid of the current BLOB
+     *
+     * \return the rowid
+     */
+    int64_t rowid () const;
+
+    /**
+     * \brief Access mode the stream was opened with
+     *
+     * \return the mode
+     */
+    Mode mode () const;
+
+    /**
+     * \brief Read a part of the BLOB
+     *
+     * Reads up to count bytes starting at offset into buffer.
+     * Fewer bytes are read if the end of the BLOB is reached.
+     *
+     * \param buffer target, must have room for count bytes
+     * \param count number of wanted bytes
+     * \param offset position to start reading
+     * \throw sl3::ErrOutOfRange if offset is behind the end of the BLOB
+     * \throw sl3::SQLite3Error in case of a problem
+     * \return number of bytes read
+     */
+    std::size_t read (char* buffer, std::size_t count, std::size_t offset);
+
+    /**
+     * \brief Write a part of the BLOB
+     *
+     * \param data source
+     * \param count number of bytes to write
+     * \param offset position to start writing
+     * \throw sl3::ErrOutOfRange if offset + count is behind the end of the BLOB
+     * \throw sl3::SQLite3Error in case of a problem,
+     *  for example if the stream is read only
+     */
+    void write (const char* data, std::size_t count, std::size_t offset);
+
+    /**
+     * \brief function object for chunked reading
+     *
+     * Called with a pointer to the chunk data and its size.
+     *
+     * \return false if reading shall stop, true otherwise
+     */
+    using ChunkCallback = std::function<bool(const char*, std::size_t)>;
+
+    /**
+     * \brief Read the BLOB chunk by chunk
+     *
+     * Only one buffer of chunkSize bytes is used,
+     * independent of the size of the BLOB.
+     *
+     * \param cb callback receiving the chunks
+     * \param chunkSize maximal size of a chunk
+     * \throw sl3::ErrOutOfRange if chunkSize is 0
+     * \throw sl3::SQLite3Error in case of a problem
+     */
+    void readChunks (const ChunkCallback& cb, std::size_t chunkSize = 65536);
+
+    /**
+     * \brief Move the stream to an other row
+     *
+     * Points the stream to the BLOB of the same table and column
+     * in the row with the given rowid.
+     * This is considerable faster than opening a new BlobStream.
+     *
+     * \param rowid rowid of the new row
+     * \throw sl3::SQLite3Error if the row does not exist, or the field is
+     *  not a BLOB or TEXT.
+     *  The stream is not usable afterwards in that case.
+     */
+    void reopen (int64_t rowid);
+
+    /**
+     * \brief Close the stream
+     *
+     * Afterwards all operations will throw sl3::ErrNoConnection.
+     *
+     * \throw sl3::SQLite3Error if a pending write fails
+     */
+    void close ();
+
+  private:
+    void ensureOpen () const;
+
+    Connection    _connection;
+    sqlite3_blob* _blob;
+    int64_t       _rowid;
+    Mode          _mode;
+  };
+
+  /**
+   * \brief std::streambuf on top of a BlobStream
+   *
+   * Allows the use of std::istream and std::ostream with a BlobStream,
+   * \code
+   *   auto blob = db.openBlob ("tbl", "data", rowid);
+   *   sl3::BlobStreamBuf buf{blob};
+   *   std::istream in{&buf};
+   * \endcode
+   *
+   * The buffer holds at most bufferSize bytes of the BLOB in memory.
+   * Seeking is supported.
+   * Writing behind the end of the BLOB is not possible and will set the
+   * failbit of the using stream.
+   *
+   * The BlobStream must outlive the BlobStreamBuf.
+   */
+  class LIBSL3_API BlobStreamBuf : public std::streambuf
+  {
+  public:
+    /**
+     * \brief Constructor
+     *
+     * \param blob the underlying blob stream
+     * \param bufferSize size of the internal buffer
+     */
+    explicit BlobStreamBuf (BlobStream& blob, std::size_t bufferSize = 65536);
+
+    /**
+     * \brief Destructor
+     *
+     * Writes pending data. Errors are ignored, call pubsync before
+     * if error handling is required.
+     */
+    ~BlobStreamBuf ();
+
+    BlobStreamBuf (const BlobStreamBuf&) = delete;
+    BlobStreamBuf& operator= (const BlobStreamBuf&) = delete;
+
+  protected:
+    /// \cond HIDDEN_SYMBOLS
+    int_type    underflow () override;
+    int_type    overflow (int_type c) override;
+    int         sync () override;
+    pos_type    seekoff (off_type                off,
+                         std::ios_base::seekdir  dir,
+                         std::ios_base::openmode which) override;
+    pos_type    seekpos (pos_type pos, std::ios_base::openmode which) override;
+    /// \endcond
+
+  private:
+    bool        flush ();
+    std::size_t position () const;
+
+    BlobStream&       _blob;
+    std::vector<char> _buffer;
+    std::size_t       _pos; // blob offset of the buffer begin
+  };
+}
+
+#endif
@@ -0,0 +1,76 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_CHANGES_HPP_
+#define SL3_CHANGES_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <sl3/config.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief A changed row
+   *
+   * \see Database::onChange
+   */
+  struct LIBSL3_API Change
+  {
+    /**
+     * \brief Kind of change
+     */
+    enum class Operation
+    {
+      Insert, //!< row was inserted
+      Update, //!< row was updated
+      Delete  //!< row was deleted
+    };
+
+    Operation   operation; //!< what happened
+    std::string database;  //!< symbolic database name, like "main"
+    std::string table;     //!< table name
+    int64_t     rowid;     //!< rowid of the row
+  };
+
+  /**
+   * \brief Options for the delivery of changes
+   *
+   * \see Database::onChange
+   */
+  struct LIBSL3_API ChangeBatchOptions
+  {
+    /**
+     * \brief Maximal number of changes per callback call
+     *
+     * If a transaction changed more rows, the callback is called several
+     * times. 0 means no limit.
+     */
+    std::size_t maxBatchSize = 0;
+
+    /**
+     * \brief Merge changes of the same row
+     *
+     * If true, several changes of the same row within the delivered
+     * transactions are reported as one change,
+     * an insert followed by a delete is not reported at all.
+     */
+    bool coalesce = false;
+  };
+
+  /**
+   * \brief Callback receiving a batch of committed changes
+   */
+  using ChangeCallback = std::function<void (const std::vector<Change>&)>;
+}
+
+#endif
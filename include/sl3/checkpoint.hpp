@@ -0,0 +1,103 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_CHECKPOINT_HPP_
+#define SL3_CHECKPOINT_HPP_
+
+#include <chrono>
+#include <cstddef>
+
+#include <sl3/config.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief WAL checkpoint modes
+   *
+   * \sa https://www.sqlite.org/c3ref/wal_checkpoint_v2.html
+   */
+  enum class CheckpointMode
+  {
+    /// checkpoint as many frames as possible without waiting
+    Passive,
+    /// wait for writers, then checkpoint all frames
+    Full,
+    /// like Full, and truncate the WAL file to zero bytes
+    Truncate
+  };
+
+  /**
+   * \brief Settings for background checkpoints
+   *
+   * Thresholds are numbers of WAL frames, a frame holds one page.
+   * The mode of a checkpoint is chosen by the number of frames in the WAL
+   * that have not been checkpointed yet: from passiveFrames a Passive,
+   * from fullFrames a Full and from truncateFrames a Truncate checkpoint
+   * is run. If there have been no writes for idleTime, a Truncate
+   * checkpoint is run for any number of frames.
+   *
+   * \see Database::startCheckpoints
+   */
+  struct LIBSL3_API CheckpointOptions
+  {
+    /// frames from which a Passive checkpoint is run
+    std::size_t passiveFrames = 1000;
+
+    /// frames from which a Full checkpoint is run
+    std::size_t fullFrames = 4000;
+
+    /// frames from which a Truncate checkpoint is run
+    std::size_t truncateFrames = 16000;
+
+    /// time without writes after which the WAL is truncated
+    std::chrono::milliseconds idleTime{1000};
+
+    /// busy timeout of the checkpoint connection for Full and Truncate
+    std::chrono::milliseconds busyTimeout{100};
+  };
+
+  /**
+   * \brief Counters of the background checkpoints
+   *
+   * \see Database::checkpointMetrics
+   */
+  struct LIBSL3_API CheckpointMetrics
+  {
+    /// frames in the WAL not yet checkpointed, last observed
+    std::size_t walFrames = 0;
+
+    /// size of walFrames in bytes, frame headers included
+    std::size_t walBytes = 0;
+
+    /// largest number of frames observed
+    std::size_t maxWalFrames = 0;
+
+    /// number of checkpoints run
+    std::size_t checkpoints = 0;
+
+    /// number of checkpoints that could not complete because of locks
+    std::size_t busy = 0;
+
+    /// number of checkpoints that failed with an other error
+    std::size_t errors = 0;
+
+    /// mode of the last checkpoint
+    CheckpointMode lastMode = CheckpointMode::Passive;
+
+    /// duration of the last checkpoint
+    std::chrono::microseconds lastDuration{0};
+
+    /// longest checkpoint
+    std::chrono::microseconds maxDuration{0};
+
+    /// duration of all checkpoints
+    std::chrono::microseconds totalDuration{0};
+  };
+}
+
+#endif
@@ -0,0 +1,120 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_COLLATION_HPP_
+#define SL3_COLLATION_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include <sl3/config.hpp>
+
+struct sqlite3;
+
+namespace sl3
+{
+  /**
+   * \brief Built in collations
+   *
+   * \see Database::createCollation
+   */
+  enum class Collation
+  {
+    /**
+     * Natural sort order, sequences of digits are compared by their
+     * numeric value, so that "file9" sorts before "file10".
+     * All other bytes are compared as they are.
+     */
+    Natural,
+
+    /**
+     * Case insensitive for ASCII letters, A-Z equals a-z.
+     * Other bytes, including UTF-8 sequences, are compared as they are.
+     */
+    AsciiNoCase
+  };
+
+  /**
+   * \brief Compare function for collations
+   *
+   * Receives two strings as pointer and size in bytes, they are not
+   * zero terminated.
+   * Must return a negative number, 0, or a positive number if the first
+   * string is less, equal, or greater than the second.
+   *
+   * The function must be a total order, and must not throw.
+   */
+  using CollationCompare
+      = std::function<int (const char*, std::size_t, const char*, std::size_t)>;
+
+  /**
+   * \brief Sort key function for collations
+   *
+   * Returns a key for the given string, pointer and size in bytes,
+   * so that a bytewise comparison of two keys gives the wanted order.
+   * std::strxfrm is an example of such a function.
+   */
+  using SortKeyFunction = std::function<std::string (const char*, std::size_t)>;
+
+  /**
+   * \brief Compare function of Collation::Natural
+   *
+   * Can also be used outside of sqlite, for example to sort a Dataset.
+   *
+   * \param a first string
+   * \param na size of a
+   * \param b second string
+   * \param nb size of b
+   * \return negative, 0, or positive number
+   */
+  LIBSL3_API int
+  naturalCompare (const char* a, std::size_t na, const char* b, std::size_t nb);
+
+  /**
+   * \brief Compare function of Collation::AsciiNoCase
+   *
+   * \param a first string
+   * \param na size of a
+   * \param b second string
+   * \param nb size of b
+   * \return negative, 0, or positive number
+   */
+  LIBSL3_API int asciiNoCaseCompare (const char* a,
+                                     std::size_t na,
+                                     const char* b,
+                                     std::size_t nb);
+
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief register a collation via sqlite3_create_collation_v2
+     *
+     * \throw sl3::SQLite3Error if registration fails
+     */
+    LIBSL3_API void createCollation (sqlite3*           db,
+                                     const std::string& name,
+                                     CollationCompare   cmp);
+
+    /**
+     * \internal
+     * \brief register a collation comparing cached sort keys
+     *
+     * \throw sl3::SQLite3Error if registration fails
+     */
+    LIBSL3_API void createSortKeyCollation (sqlite3*           db,
+                                            const std::string& name,
+                                            SortKeyFunction    key,
+                                            std::size_t        cacheSize);
+  }
+  /// \endcond
+}
+
+#endif
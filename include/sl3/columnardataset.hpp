@@ -0,0 +1,308 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_COLUMNARDATASET_HPP_
+#define SL3_COLUMNARDATASET_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sl3/columns.hpp>
+#include <sl3/config.hpp>
+#include <sl3/dbvalues.hpp>
+#include <sl3/types.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief One column of a ColumnarDataset
+   *
+   * The values of a column are kept in contiguous arrays, depending on
+   * type():
+   *  - Type::Int: ints(), one int64_t per row
+   *  - Type::Real: reals(), one double per row
+   *  - Type::Text, Type::Blob: bytes() holds the values of all rows one
+   *    after the other, the value of row i are the bytes from offsets()[i]
+   *    to offsets()[i + 1]
+   *  - Type::Variant: a column that holds values of different storage
+   *    types, only accessible per cell
+   *
+   * In each case validity() is a bitmap with one bit per row, the bit is
+   * set if the row holds a value and not null. Bit i is bit i % 64 of word
+   * i / 64. The array slot of a null row holds 0 or an empty value.
+   */
+  class LIBSL3_API Column
+  {
+    friend class ColumnarDataset;
+
+  public:
+    /**
+     * \brief Type of the column
+     *
+     * \return Int, Real, Text, Blob or Variant
+     */
+    Type type () const noexcept;
+
+    /**
+     * \brief Number of rows
+     * \return number of rows
+     */
+    std::size_t size () const noexcept;
+
+    /**
+     * \brief Number of null rows
+     * \return number of rows that are null
+     */
+    std::size_t nullCount () const noexcept;
+
+    /**
+     * \brief Check if a row is null
+     *
+     * \param row the row
+     * \throw sl3::ErrOutOfRange if row is not valid
+     * \return true if the value of row is null
+     */
+    bool isNull (std::size_t row) const;
+
+    /**
+     * \brief Get the value of a row
+     *
+     * The returned DbValue has the type of the column.
+     *
+     * \param row the row
+     * \throw sl3::ErrOutOfRange if row is not valid
+     * \return the value of the row
+     */
+    DbValue get (std::size_t row) const;
+
+    /**
+     * \brief Validity bitmap
+     *
+     * \return (size() + 63) / 64 words, a set bit marks a not null row
+     */
+    const uint64_t* validity () const noexcept;
+
+    /**
+     * \brief Values of an Int column
+     *
+     * \throw sl3::ErrTypeMisMatch if type() is not Type::Int
+     * \return size() values
+     */
+    const int64_t* ints () const;
+
+    /**
+     * \brief Values of a Real column
+     *
+     * \throw sl3::ErrTypeMisMatch if type() is not Type::Real
+     * \return size() values
+     */
+    const double* reals () const;
+
+    /**
+     * \brief Offsets into bytes() of a Text or Blob column
+     *
+     * \throw sl3::ErrTypeMisMatch if type() is not Type::Text or Type::Blob
+     * \return size() + 1 offsets
+     */
+    const std::size_t* offsets () const;
+
+    /**
+     * \brief Bytes of a Text or Blob column
+     *
+     * \throw sl3::ErrTypeMisMatch if type() is not Type::Text or Type::Blob
+     * \return the bytes of all rows
+     */
+    const char* bytes () const;
+
+  private:
+    explicit Column (Type type);
+
+    void    append (const Columns& columns, int idx);
+    void    narrow ();
+    void    ensureRow (std::size_t row) const;
+    DbValue value (std::size_t row) const;
+
+    Type                     _type;
+    std::size_t              _size;
+    std::size_t              _nulls;
+    std::vector<uint64_t>    _validity;
+    std::vector<int64_t>     _ints;
+    std::vector<double>      _reals;
+    std::vector<std::size_t> _offsets;
+    std::string              _bytes;
+    // storage types of the rows of a Variant column
+    std::vector<Type> _types;
+  };
+
+  /**
+   * \brief A query result stored column by column
+   *
+   * Like a Dataset, but the values of each column are kept in typed,
+   * contiguous arrays, see Column. No DbValue is stored per cell, this
+   * saves memory and scans over a column touch only its values.
+   *
+   * A ColumnarDataset is filled via Command::selectColumnar or
+   * Database::selectColumnar.
+   * If types are given, each value must have the type of its column or be
+   * null, otherwise sl3::ErrTypeMisMatch is thrown.
+   * Without types, or for Type::Variant, a column gets the storage type
+   * of its values if all not null values have the same one, otherwise it
+   * stays a Variant column.
+   *
+   * Rows and cells can be accessed like in a Dataset, ds[row][field],
+   * but the values are created on access and returned by value.
+   */
+  class LIBSL3_API ColumnarDataset
+  {
+    friend class Command;
+
+  public:
+    /**
+     * \brief A row of a ColumnarDataset
+     *
+     * A light weight view, valid as long as the ColumnarDataset it refers
+     * to is not changed.
+     */
+    class LIBSL3_API Row
+    {
+      friend class ColumnarDataset;
+
+    public:
+      /**
+       * \brief Number of fields
+       * \return number of fields
+       */
+      std::size_t size () const noexcept;
+
+      /**
+       * \brief Get the value of a field
+       *
+       * \param field index of the field
+       * \return the value, unchecked access
+       */
+      DbValue operator[] (std::size_t field) const;
+
+      /**
+       * \brief Get the value of a field
+       *
+       * \param field index of the field
+       * \throw sl3::ErrOutOfRange if field is not valid
+       * \return the value
+       */
+      DbValue at (std::size_t field) const;
+
+      /**
+       * \brief Copy the row
+       * \return the values of all fields
+       */
+      DbValues values () const;
+
+    private:
+      Row (const ColumnarDataset* ds, std::size_t row) noexcept;
+
+      const ColumnarDataset* _ds;
+      std::size_t            _row;
+    };
+
+    /**
+     * \brief Constructor
+     *
+     * The column types are taken from the result.
+     */
+    ColumnarDataset () noexcept;
+
+    /**
+     * \brief Constructor with column types
+     *
+     * \param types the types of the columns
+     */
+    ColumnarDataset (Types types);
+
+    /**
+     * \brief Number of rows
+     * \return number of rows
+     */
+    std::size_t size () const noexcept;
+
+    /**
+     * \brief Number of columns
+     * \return number of columns, 0 if nothing has been loaded
+     */
+    std::size_t columnCount () const noexcept;
+
+    /**
+     * \brief Get a column
+     *
+     * \param idx index of the column
+     * \throw sl3::ErrOutOfRange if idx is not valid
+     * \return the column
+     */
+    const Column& column (std::size_t idx) const;
+
+    /**
+     * \brief Get a column by name
+     *
+     * \param name name of the column
+     * \throw sl3::ErrOutOfRange if name is not found
+     * \return the column
+     */
+    const Column& column (const std::string& name) const;
+
+    /**
+     * \brief Get the index of a field by name
+     *
+     * \param name field name
+     * \throw sl3::ErrOutOfRange if name is not found
+     * \return field index
+     */
+    std::size_t getIndex (const std::string& name) const;
+
+    /**
+     * \brief Names of the columns
+     * \return column names
+     */
+    const std::vector<std::string>& getNames () const noexcept;
+
+    /**
+     * \brief Access a row
+     *
+     * \param row the row
+     * \return the row, unchecked access
+     */
+    Row operator[] (std::size_t row) const noexcept;
+
+    /**
+     * \brief Access a row
+     *
+     * \param row the row
+     * \throw sl3::ErrOutOfRange if row is not valid
+     * \return the row
+     */
+    Row at (std::size_t row) const;
+
+    /**
+     * \brief Clear the data
+     *
+     * Removes all rows and columns, given types are kept.
+     */
+    void reset ();
+
+  private:
+    void append (const Columns& columns);
+    void finish ();
+
+    Types                    _fieldtypes;
+    std::vector<std::string> _names;
+    std::vector<Column>      _columns;
+    std::size_t              _size;
+  };
+}
+
+#endif
@@ -0,0 +1,297 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_COLUMNKERNELS_HPP_
+#define SL3_COLUMNKERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sl3/columnardataset.hpp>
+#include <sl3/config.hpp>
+#include <sl3/dbvalue.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief Instruction sets used by the column kernels
+   *
+   * The kernels are built for each level, the one to use is chosen at
+   * runtime. On other than x86 CPUs, or other compilers than GCC and
+   * Clang, only Scalar is available.
+   */
+  enum class SimdLevel
+  {
+    /// plain C++ loops
+    Scalar = 0,
+    /// SSE4.2
+    SSE42 = 1,
+    /// AVX2
+    AVX2 = 2,
+    /// AVX-512 foundation
+    AVX512 = 3
+  };
+
+  /**
+   * \brief The highest level the CPU supports
+   *
+   * \return detected level
+   */
+  LIBSL3_API SimdLevel supportedSimdLevel () noexcept;
+
+  /**
+   * \brief The level the kernels use
+   *
+   * Per default the supported level.
+   *
+   * \return level in use
+   */
+  LIBSL3_API SimdLevel simdLevel () noexcept;
+
+  /**
+   * \brief Choose the level the kernels use
+   *
+   * A level above supportedSimdLevel is lowered to it.
+   * Mainly for testing and comparing the levels, the setting is process
+   * wide.
+   *
+   * \param level the wanted level
+   * \return level in use
+   */
+  LIBSL3_API SimdLevel setSimdLevel (SimdLevel level) noexcept;
+
+  /**
+   * \brief Positions of selected rows, ascending
+   */
+  using Selection = std::vector<std::size_t>;
+
+  /**
+   * \brief A Text column encoded as codes into a sorted dictionary
+   *
+   * dictionary() holds each distinct text of the column once, in the order
+   * of dbval_lt, and codes() one index into it per row.
+   * Since the dictionary is sorted, codes compare like the texts, so
+   * filters and min/max on text run on the codes.
+   *
+   * The validity bitmap has the layout of Column::validity, the code of a
+   * null row is 0.
+   */
+  class LIBSL3_API DictionaryColumn
+  {
+  public:
+    /**
+     * \brief Encode a column
+     *
+     * \param column a Text column
+     * \throw sl3::ErrTypeMisMatch if column is not a Text column
+     * \throw sl3::ErrOutOfRange if there are more distinct values than
+     *   codes
+     */
+    explicit DictionaryColumn (const Column& column);
+
+    /**
+     * \brief Number of rows
+     * \return number of rows
+     */
+    std::size_t size () const noexcept;
+
+    /**
+     * \brief Number of null rows
+     * \return number of rows that are null
+     */
+    std::size_t nullCount () const noexcept;
+
+    /**
+     * \brief Check if a row is null
+     *
+     * \param row the row
+     * \throw sl3::ErrOutOfRange if row is not valid
+     * \return true if the value of row is null
+     */
+    bool isNull (std::size_t row) const;
+
+    /**
+     * \brief Get the value of a row
+     *
+     * \param row the row
+     * \throw sl3::ErrOutOfRange if row is not valid
+     * \return the text of the row or null, of Type::Text
+     */
+    DbValue get (std::size_t row) const;
+
+    /**
+     * \brief Validity bitmap
+     *
+     * \return (size() + 63) / 64 words, a set bit marks a not null row
+     */
+    const uint64_t* validity () const noexcept;
+
+    /**
+     * \brief Codes of the rows
+     *
+     * \return size() codes
+     */
+    const int32_t* codes () const noexcept;
+
+    /**
+     * \brief Distinct texts of the column, sorted
+     *
+     * \return the dictionary
+     */
+    const std::vector<std::string>& dictionary () const noexcept;
+
+  private:
+    std::size_t              _size;
+    std::size_t              _nulls;
+    std::vector<uint64_t>    _validity;
+    std::vector<int32_t>     _codes;
+    std::vector<std::string> _dictionary;
+  };
+
+  /**
+   * \brief Number of not null values
+   *
+   * \param column the column
+   * \return number of values
+   */
+  LIBSL3_API std::size_t count (const Column& column) noexcept;
+
+  /// \copydoc count(const Column&)
+  LIBSL3_API std::size_t count (const DictionaryColumn& column) noexcept;
+
+  /**
+   * \brief Number of null values
+   *
+   * \param column the column
+   * \return number of nulls
+   */
+  LIBSL3_API std::size_t nullCount (const Column& column) noexcept;
+
+  /// \copydoc nullCount(const Column&)
+  LIBSL3_API std::size_t nullCount (const DictionaryColumn& column) noexcept;
+
+  /**
+   * \brief Sum of the values of an Int or Real column
+   *
+   * Nulls are skipped. The sum of an Int column wraps around on overflow.
+   *
+   * \param column the column
+   * \throw sl3::ErrTypeMisMatch if column is not an Int or Real column
+   * \return the sum, of the type of the column, null if there are no
+   *   values
+   */
+  LIBSL3_API DbValue sum (const Column& column);
+
+  /**
+   * \brief Mean of the values of an Int or Real column
+   *
+   * Nulls are skipped. Computed from sum(), divided by count().
+   *
+   * \param column the column
+   * \throw sl3::ErrTypeMisMatch if column is not an Int or Real column
+   * \return the mean as Real, null if there are no values
+   */
+  LIBSL3_API DbValue mean (const Column& column);
+
+  /**
+   * \brief Smallest value of an Int or Real column
+   *
+   * \param column the column
+   * \throw sl3::ErrTypeMisMatch if column is not an Int or Real column
+   * \return the smallest value, null if there are no values
+   */
+  LIBSL3_API DbValue min (const Column& column);
+
+  /// \copydoc min(const Column&)
+  LIBSL3_API DbValue max (const Column& column);
+
+  /**
+   * \brief Smallest text
+   *
+   * \param column the column
+   * \return the smallest text, null if there are no values
+   */
+  LIBSL3_API DbValue min (const DictionaryColumn& column);
+
+  /// \copydoc min(const DictionaryColumn&)
+  LIBSL3_API DbValue max (const DictionaryColumn& column);
+
+  /**
+   * \brief Select the rows equal to value
+   *
+   * Numbers compare by value, an Int column is compared to a Real value
+   * exactly. Null values are never selected, and a null value selects
+   * nothing.
+   *
+   * \param column an Int or Real column
+   * \param value the value to compare with
+   * \throw sl3::ErrTypeMisMatch if the column is not an Int or Real
+   *   column, or the value is neither a number nor null
+   * \return the selected rows
+   */
+  LIBSL3_API Selection selectEqual (const Column& column, const DbValue& value);
+
+  /**
+   * \brief Select the rows less than value
+   *
+   * \copydetails selectEqual(const Column&, const DbValue&)
+   */
+  LIBSL3_API Selection selectLess (const Column& column, const DbValue& value);
+
+  /**
+   * \brief Select the rows from lower to upper, both included
+   *
+   * Like SQL BETWEEN.
+   *
+   * \param column an Int or Real column
+   * \param lower the smallest value to select
+   * \param upper the largest value to select
+   * \throw sl3::ErrTypeMisMatch if the column is not an Int or Real
+   *   column, or a value is neither a number nor null
+   * \return the selected rows
+   */
+  LIBSL3_API Selection selectBetween (const Column&  column,
+                                      const DbValue& lower,
+                                      const DbValue& upper);
+
+  /**
+   * \brief Select the rows equal to a text
+   *
+   * \param column the column
+   * \param value the text to compare with
+   * \throw sl3::ErrTypeMisMatch if value is neither text nor null
+   * \return the selected rows
+   */
+  LIBSL3_API Selection selectEqual (const DictionaryColumn& column,
+                                    const DbValue&          value);
+
+  /**
+   * \brief Select the rows less than a text
+   *
+   * \copydetails selectEqual(const DictionaryColumn&, const DbValue&)
+   */
+  LIBSL3_API Selection selectLess (const DictionaryColumn& column,
+                                   const DbValue&          value);
+
+  /**
+   * \brief Select the rows from lower to upper, both included
+   *
+   * \param column the column
+   * \param lower the smallest text to select
+   * \param upper the largest text to select
+   * \throw sl3::ErrTypeMisMatch if a value is neither text nor null
+   * \return the selected rows
+   */
+  LIBSL3_API Selection selectBetween (const DictionaryColumn& column,
+                                      const DbValue&          lower,
+                                      const DbValue&          upper);
+}
+
+#endif
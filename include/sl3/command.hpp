@@ -12,6 +12,7 @@
 #include <memory>
 #include <string>
 
+#include <sl3/columnardataset.hpp>
 #include <sl3/config.hpp>
 #include <sl3/dataset.hpp>
 #include <sl3/dbvalue.hpp>
@@ -38,6 +39,7 @@ namespace sl3
    */
   class LIBSL3_API Command
   {
+    friend class ArrowExporter;
     friend class Database;
     using Connection = std::shared_ptr<internal::Connection>;
 
@@ -111,6 +113,38 @@ namespace sl3
      */
     Dataset select (const Types& types, const DbValues& parameters = {});
 
+    /**
+     * \brief Run the Command and get the result column by column
+     *
+     * Like select(const DbValues&, const Types&), but the result is
+     * stored in a ColumnarDataset.
+     *
+     * \throw sl3::ErrTypeMisMatch if types are given which are invalid,
+     * a value does not match its type, or given parameters are of the
+     * wrong size.
+     * \param parameters a list of parameters
+     * \param types Types the ColumnarDataset shall use
+     * \return A ColumnarDataset containing the query result
+     */
+    ColumnarDataset selectColumnar (const DbValues& parameters = {},
+                                    const Types&    types      = {});
+
+    /**
+     * \brief Run the Command and get the result column by column
+     *
+     * Like select(const Types&, const DbValues&), but the result is
+     * stored in a ColumnarDataset.
+     *
+     * \throw sl3::ErrTypeMisMatch if types are given which are invalid,
+     * a value does not match its type, or given parameters are of the
+     * wrong size.
+     * \param parameters a list of parameters
+     * \param types Types the ColumnarDataset shall use
+     * \return A ColumnarDataset containing the query result
+     */
+    ColumnarDataset selectColumnar (const Types&    types,
+                                    const DbValues& parameters = {});
+
     /**
      * \brief function object for handling a command result.
      *
@@ -231,6 +265,15 @@ namespace sl3
     std::vector<std::string> getParameterNames () const;
 
   private:
+    // bind parameters, the first part of execute
+    void start (const DbValues& parameters);
+    // fetch the next row, false if there is none
+    bool step ();
+    // reset the statement after the last step
+    void finish ();
+    // reset the statement, if the connection is still open
+    void reset () noexcept;
+
     Connection    _connection;
     sqlite3_stmt* _stmt;
     DbValues      _parameters;
@@ -12,10 +12,20 @@
 #include <memory>
 #include <string>
 
+#include <sl3/blobstream.hpp>
+#include <sl3/changes.hpp>
+#include <sl3/checkpoint.hpp>
+#include <sl3/collation.hpp>
+#include <sl3/columnardataset.hpp>
 #include <sl3/command.hpp>
 #include <sl3/config.hpp>
 #include <sl3/dataset.hpp>
 #include <sl3/dbvalue.hpp>
+#include <sl3/function.hpp>
+#include <sl3/memorystats.hpp>
+#include <sl3/session.hpp>
+#include <sl3/snapshot.hpp>
+#include <sl3/vtable.hpp>
 
 struct sqlite3;
 
@@ -26,6 +36,74 @@ namespace sl3
     class Connection;
   }
 
+  /**
+   * \brief Locking behavior of a transaction
+   *
+   * \sa https://www.sqlite.org/lang_transaction.html
+   */
+  enum class TransactionMode
+  {
+    Deferred,  //!< locks are acquired when first needed
+    Immediate, //!< start with a write lock (RESERVED)
+    Exclusive  //!< start with an exclusive lock
+  };
+
+  /**
+   * \brief Settings for opening a Database
+   *
+   * Negative values keep the sqlite default.
+   * The lookaside settings are applied if both are given.
+   */
+  struct LIBSL3_API OpenOptions
+  {
+    /**
+     * \brief sqlite3_open_v2 flags
+     *
+     * 0 means SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE.
+     */
+    int flags = 0;
+
+    /**
+     * \brief size of a lookaside slot, SQLITE_DBCONFIG_LOOKASIDE
+     *
+     * Small allocations of a connection, like those of parsing and
+     * running short statements, are served from lookaside slots before
+     * malloc is used. Rounded down to a multiple of 8 by sqlite.
+     */
+    int lookasideSlotSize = -1;
+
+    /**
+     * \brief number of lookaside slots, SQLITE_DBCONFIG_LOOKASIDE
+     *
+     * 0 disables the lookaside allocator of the connection.
+     */
+    int lookasideSlots = -1;
+
+    /**
+     * \brief name of the VFS to use, empty for the default VFS
+     *
+     * \see InstrumentedVfs
+     */
+    std::string vfs;
+
+    /**
+     * \brief open a file that never changes
+     *
+     * For database files built offline and never written again.
+     * The file is opened read only via the URI parameter immutable=1,
+     * sqlite then skips file locking and change detection and uses no
+     * journal. mmap_size is set to cover the whole file.
+     * SQLITE_OPEN_NOMUTEX is used, open a connection per thread.
+     *
+     * flags are ignored, except SQLITE_OPEN_SHAREDCACHE and
+     * SQLITE_OPEN_PRIVATECACHE.
+     *
+     * \warning if the file is changed anyway, queries may return wrong
+     *  results or report a corrupt database
+     */
+    bool immutable = false;
+  };
+
   /**
    * \brief represents a SQLite3 Database
    *
@@ -70,6 +148,22 @@ namespace sl3
      */
     explicit Database (const std::string& name, int openFlags = 0);
 
+    /**
+     * \brief Constructor
+     *
+     * Opens the database like Database(name, options.flags), with the
+     * VFS options.vfs, and applies the connection settings of options.
+     *
+     * \param name database name, see Database(const std::string&, int)
+     * \param options open flags and connection settings
+     *
+     * \sa https://www.sqlite.org/c3ref/c_dbconfig_enable_fkey.html
+     *
+     * \throw sl3::SQLite3Error if the database can not be opened or a
+     *  setting can not be applied
+     */
+    Database (const std::string& name, const OpenOptions& options);
+
     /**
      * \brief Destructor.
      */
@@ -174,6 +268,29 @@ namespace sl3
      */
     Dataset select (const std::string& sql, const Types& types);
 
+    /**
+     * \brief Execute a SQL query and return the result column by column
+     *
+     * \throw sl3::SQLite3Error in case of a problems.
+     *
+     * \param sql SQL Statements
+     * \return a ColumnarDataset with the result.
+     */
+    ColumnarDataset selectColumnar (const std::string& sql);
+
+    /**
+     * \brief Execute a SQL query and return the result column by column
+     *
+     * \throw sl3::SQLite3Error in case of a problems.
+     * \throw sl3::ErrTypeMisMatch in case of incorrect types.
+     *
+     * \param sql SQL Statements
+     * \param types wanted types of the columns
+     * \return a ColumnarDataset with the result.
+     */
+    ColumnarDataset selectColumnar (const std::string& sql,
+                                    const Types&       types);
+
     /**
      * \brief Select a single value form the database.
      *
@@ -267,6 +384,396 @@ namespace sl3
      */
     int64_t getLastInsertRowid ();
 
+    /**
+     * \brief Open a BLOB for incremental I/O
+     *
+     * \param table table name
+     * \param column column name
+     * \param rowid rowid of the row
+     * \param mode access mode
+     * \param dbname symbolic database name, like "main", "temp" or the
+     *  name of an attached database
+     *
+     * \throw sl3::SQLite3Error if the BLOB can not be opened
+     * \return a BlobStream for the requested field
+     */
+    BlobStream openBlob (const std::string& table,
+                         const std::string& column,
+                         int64_t            rowid,
+                         BlobStream::Mode   mode = BlobStream::Mode::ReadOnly,
+                         const std::string& dbname = "main");
+
+    /**
+     * \brief Insert a preallocated BLOB and open it for writing
+     *
+     * Inserts a new row into table where column is set to a zeroblob of
+     * the given size, all other fields get their default values.
+     * The returned BlobStream can be used to fill the BLOB piece by piece,
+     * so that the data never needs to be in memory at once.
+     *
+     * If other fields of the new row need values, use an UPDATE statement
+     * with BlobStream::rowid, or insert the row with
+     * \code zeroblob(size) \endcode via SQL and use openBlob.
+     *
+     * \param table table name
+     * \param column column name
+     * \param size size of the BLOB
+     * \param dbname symbolic database name
+     *
+     * \throw sl3::SQLite3Error in case of a problem
+     * \return a writable BlobStream for the new BLOB
+     */
+    BlobStream insertZeroBlob (const std::string& table,
+                               const std::string& column,
+                               std::size_t        size,
+                               const std::string& dbname = "main");
+
+    /**
+     * \brief Get notified about committed row changes
+     *
+     * Inserted, updated and deleted rows are collected via
+     * sqlite3_update_hook while a transaction runs.
+     * After the transaction has been committed, the changes are passed to
+     * cb in batches, changes of a rolled back transaction are dropped.
+     * Rolling back a Savepoint drops the changes made since the savepoint.
+     *
+     * The callback runs after the statement, Transaction::commit or
+     * Savepoint::release that committed the changes has finished,
+     * so it may use this database.
+     * Exceptions from the callback propagate to the caller of that function,
+     * undelivered changes of the current round are lost in that case.
+     *
+     * Limitations of sqlite3_update_hook apply: changes of WITHOUT ROWID
+     * tables, of the truncate optimization (DELETE without WHERE) and of
+     * incremental BLOB I/O are not reported. An UPDATE of the rowid itself
+     * reports the new rowid.
+     * Changes rolled back by a ROLLBACK TO statement that was not issued by
+     * a Savepoint object are reported too.
+     *
+     * Only one callback can be registered, a new call replaces it.
+     * Passing an empty callback stops the change feed.
+     *
+     * \param cb callback receiving the changes
+     * \param options batch options
+     */
+    void onChange (ChangeCallback cb, ChangeBatchOptions options = {});
+
+    /**
+     * \brief Get memory and cache statistics of this connection
+     *
+     * Take two snapshots and subtract them to get the cache hits and
+     * misses of a workload, to size cache_size from data.
+     *
+     * \param reset if true, counters and high water marks are reset after
+     *  reading
+     * \throw sl3::ErrNoConnection if the database has been closed
+     * \return a snapshot of the statistics
+     */
+    DbMemoryStats memoryStats (bool reset = false) const;
+
+    /**
+     * \brief Run WAL checkpoints in a background thread
+     *
+     * Disables the auto checkpoint of this connection, which runs inline
+     * on the writer that crosses the threshold. Instead, the size of the
+     * WAL is observed via sqlite3_wal_hook and checkpoints are run by a
+     * background thread with an own connection, in a mode according to
+     * the thresholds and the idle time of options.
+     *
+     * The database must be a file in journal_mode WAL.
+     * A running background checkpointer is replaced,
+     * closing the database stops it.
+     *
+     * \param options thresholds and timeouts
+     * \throw sl3::SQLite3Error if the database is not a WAL file or the
+     *  checkpoint connection can not be opened
+     * \throw sl3::ErrNoConnection if the database has been closed
+     */
+    void startCheckpoints (CheckpointOptions options = {});
+
+    /**
+     * \brief Stop background checkpoints
+     *
+     * Waits for a running checkpoint and restores the auto checkpoint
+     * of sqlite. Does nothing if no checkpointer runs.
+     */
+    void stopCheckpoints ();
+
+    /**
+     * \brief Metrics of the background checkpoints
+     *
+     * \return a copy of the current metrics,
+     *  all zero if startCheckpoints was not called
+     */
+    CheckpointMetrics checkpointMetrics () const;
+
+    /**
+     * \brief Create a Session recording changes into changesets
+     *
+     * The returned Session records nothing until tables are attached.
+     *
+     * \code
+     *   auto session = db.createSession ();
+     *   session.attach ("tbl");
+     *   db.execute ("INSERT INTO tbl VALUES (1, 'one');");
+     *   replica.applyChangeset (session.changeset ());
+     * \endcode
+     *
+     * Requires a build with the SQLITE_ENABLE_SESSION option,
+     * see sl3::build_sqlite3_session.
+     *
+     * \param dbname symbolic name of the database to record, like "main"
+     * \throw sl3::SQLite3Error if the session extension is not available
+     *  or the session can not be created
+     * \throw sl3::ErrNoConnection if the database has been closed
+     * \return a new Session
+     */
+    Session createSession (const std::string& dbname = "main");
+
+    /**
+     * \brief Apply a changeset or patchset
+     *
+     * All changes are applied in one transaction.
+     * Changes that conflict with the content of this database, like an
+     * update of a modified or missing row, or an insert of an existing
+     * key, are handled according to policy.
+     * With ConflictPolicy::Abort, the first conflict rolls back all
+     * changes and an exception is thrown.
+     *
+     * Requires a build with the SQLITE_ENABLE_SESSION option,
+     * see sl3::build_sqlite3_session.
+     *
+     * \param changeset a changeset or patchset created by a Session
+     * \param policy how to handle conflicts
+     * \param filter if given, only changes of tables for which filter
+     *  returns true are applied
+     * \throw sl3::SQLite3Error if applying fails or has been aborted
+     * \throw sl3::ErrNoConnection if the database has been closed
+     */
+    void applyChangeset (const Blob&     changeset,
+                         ConflictPolicy  policy = ConflictPolicy::Abort,
+                         ChangesetFilter filter = nullptr);
+
+    /**
+     * \brief Make in memory data available as virtual table
+     *
+     * Creates the table name in the temp schema, it can be used in
+     * queries and joins like any other table, but is read only.
+     * The data is not copied, sqlite reads it from source on demand.
+     *
+     * If a keyColumn is given, equality and range constraints on this
+     * column, and ORDER BY the key column, are resolved via a sorted index
+     * over the key, instead of a full scan.
+     * The index is built on first use.
+     * Constraints with an other collation than BINARY, or with a value of
+     * an other storage class than the keys, are resolved by a full scan.
+     *
+     * The columns of the virtual table have no type affinity,
+     * so values compare by their storage type, 1 is not equal to '1'.
+     *
+     * The table, and the reference to source, exist until the table is
+     * dropped or the database is closed.
+     *
+     * \param name table name
+     * \param source data of the table
+     * \param keyColumn name of a column to index, or empty
+     *
+     * \throw sl3::ErrOutOfRange if keyColumn is not a column of source
+     * \throw sl3::SQLite3Error if the table can not be created,
+     *  for example because the name is already used
+     */
+    void createVirtualTable (const std::string&                 name,
+                             std::shared_ptr<const TableSource> source,
+                             const std::string&                 keyColumn = "");
+
+    /**
+     * \brief Make a Dataset available as virtual table
+     *
+     * Same as the TableSource version, using a DatasetSource.
+     * The Dataset must outlive the virtual table and must not be modified
+     * while the table is used.
+     *
+     * \param name table name
+     * \param ds the Dataset
+     * \param keyColumn name of a column to index, or empty
+     *
+     * \throw sl3::ErrOutOfRange if keyColumn is not a column of ds
+     * \throw sl3::SQLite3Error if the table can not be created
+     */
+    void createVirtualTable (const std::string& name,
+                             const Dataset&     ds,
+                             const std::string& keyColumn = "");
+
+    /**
+     * \brief Register a collation
+     *
+     * The collation can be used via COLLATE name in ORDER BY, indexes
+     * and column definitions.
+     * Registering an existing name replaces the existing collation,
+     * as long as no statement using it is active.
+     *
+     * \param name collation name
+     * \param cmp compare function
+     *
+     * \throw sl3::ErrUnexpected if cmp is empty
+     * \throw sl3::SQLite3Error if the collation can not be registered
+     */
+    void createCollation (const std::string& name, CollationCompare cmp);
+
+    /**
+     * \brief Register a built in collation
+     *
+     * \code
+     *   db.createCollation ("natsort", sl3::Collation::Natural);
+     *   db.execute ("CREATE INDEX idx ON files (name COLLATE natsort);");
+     * \endcode
+     *
+     * \param name collation name
+     * \param collation the collation to use
+     *
+     * \throw sl3::SQLite3Error if the collation can not be registered
+     */
+    void createCollation (const std::string& name, Collation collation);
+
+    /**
+     * \brief Register a collation based on sort keys
+     *
+     * For expensive comparisons, like locale aware ones, it is cheaper to
+     * transform each string once into a sort key and compare the keys
+     * bytewise.
+     * Up to cacheSize computed keys are kept, so sorting or an index lookup
+     * calls key about once per distinct string instead of twice per
+     * comparison.
+     *
+     * \param name collation name
+     * \param key sort key function
+     * \param cacheSize number of cached keys, 0 disables caching
+     *
+     * \throw sl3::ErrUnexpected if key is empty
+     * \throw sl3::SQLite3Error if the collation can not be registered
+     */
+    void createSortKeyCollation (const std::string& name,
+                                 SortKeyFunction    key,
+                                 std::size_t        cacheSize = 1024);
+
+    /**
+     * \brief Register a C++ callable as scalar SQL function
+     *
+     * The number and the types of the SQL arguments are deduced from the
+     * signature of f. Supported argument types are integral and floating
+     * point types, std::string, sl3::Blob and sl3::Value.
+     * Use sl3::Value to receive NULL, or any type, unconverted.
+     * The same types, plus sl3::DbValue and const char*, can be returned.
+     * A function returning void yields NULL.
+     *
+     * \code
+     *   db.createFunction ("add", [](int64_t a, int64_t b) { return a + b; },
+     *                      sl3::FunctionFlag::Deterministic);
+     * \endcode
+     *
+     * Exceptions thrown by f are reported as SQL error of the statement
+     * calling the function.
+     *
+     * Registering a function with a name and arity that already exists
+     * replaces the existing one.
+     *
+     * \param name SQL name of the function
+     * \param f function, lambda or function object
+     * \param flags combination of sl3::FunctionFlag values
+     *
+     * \throw sl3::SQLite3Error if the function can not be registered
+     */
+    template <typename F>
+    void
+    createFunction (const std::string& name,
+                    F                  f,
+                    int                flags = FunctionFlag::None)
+    {
+      using traits = internal::CallableTraits<F>;
+      registerFunction (name,
+                        static_cast<int> (traits::arity),
+                        flags,
+                        new internal::ScalarFunction<F> (std::move (f)));
+    }
+
+    /**
+     * \brief Register a C++ class as aggregate SQL function
+     *
+     * State needs to be default constructible and provide
+     * \code
+     *   void step (ARGS...);   // called for each row of a group
+     *   R    final ();         // called once to get the result of a group
+     * \endcode
+     * The arguments of step define the arguments of the SQL function,
+     * the same types as for createFunction are supported.
+     *
+     * Each group gets its own State object, it is created within the memory
+     * of sqlite3_aggregate_context on the first call of a group and
+     * destroyed after final.
+     * final is also called, on a default constructed State, if a group has
+     * no rows.
+     *
+     * \code
+     *   struct Median
+     *   {
+     *     std::vector<double> values;
+     *     void step (double v) { values.push_back (v); }
+     *     double final () { ... }
+     *   };
+     *   db.createAggregate<Median> ("median");
+     * \endcode
+     *
+     * Exceptions thrown by State are reported as SQL error of the statement.
+     *
+     * \param name SQL name of the function
+     * \param flags combination of sl3::FunctionFlag values
+     *
+     * \throw sl3::SQLite3Error if the function can not be registered
+     */
+    template <typename State>
+    void
+    createAggregate (const std::string& name, int flags = FunctionFlag::None)
+    {
+      using function = internal::AggregateFunction<State>;
+      registerAggregate (name,
+                         static_cast<int> (function::arity),
+                         flags,
+                         new function (),
+                         false);
+    }
+
+    /**
+     * \brief Register a C++ class as aggregate window function
+     *
+     * In addition to the requirements of createAggregate, State needs to
+     * provide
+     * \code
+     *   void inverse (ARGS...); // remove a row from the window
+     *   R    value () const;    // result of the current window
+     * \endcode
+     * inverse has to take the same arguments as step.
+     *
+     * A window function can be used as ordinary aggregate too.
+     *
+     * \param name SQL name of the function
+     * \param flags combination of sl3::FunctionFlag values
+     *
+     * \throw sl3::SQLite3Error if the function can not be registered,
+     *  or sqlite is older than 3.25.0 and has no window functions.
+     */
+    template <typename State>
+    void
+    createWindowFunction (const std::string& name,
+                          int                flags = FunctionFlag::None)
+    {
+      using function = internal::WindowFunction<State>;
+      registerAggregate (name,
+                         static_cast<int> (function::arity),
+                         flags,
+                         new function (),
+                         true);
+    }
+
     /**
      * \brief Transaction Guard
      *
@@ -277,9 +784,9 @@ namespace sl3
     class Transaction
     {
 
-      sl3::Database* _db;
+      std::shared_ptr<internal::Connection> _connection;
 
-      explicit Transaction (Database&);
+      Transaction (std::shared_ptr<internal::Connection>, TransactionMode);
       friend class Database;
 
     public:
@@ -303,15 +810,132 @@ namespace sl3
       /** \brief Commit the transaction
        *
        * Calls commit transaction.
+       *
+       * \throw sl3::SQLite3Error if commit fails, for example with
+       *  SQLITE_BUSY. In that case the transaction is still active
+       *  and commit can be retried.
        */
       void commit ();
     };
 
     /**
      * \brief Create a TransactionGuard
+     *
+     * \param mode the locking behavior of the transaction.
+     *  Use TransactionMode::Immediate for transactions that will write,
+     *  this avoids a SQLITE_BUSY when upgrading a read lock to a write lock
+     *  in the middle of the transaction.
+     *
+     * \throw sl3::SQLite3Error if the transaction can not be started
      * \return Transaction instance
      */
-    Transaction beginTransaction ();
+    Transaction beginTransaction (
+        TransactionMode mode = TransactionMode::Deferred);
+
+    /**
+     * \brief Take a Snapshot of the current read transaction
+     *
+     * A transaction must be active, for example via beginTransaction.
+     * If it has not read yet, a read of the schema starts the read
+     * transaction. The snapshot is the state this transaction sees.
+     *
+     * \param schema the database to take the snapshot of, like "main"
+     * \throw sl3::SQLite3Error if no transaction is active, the database
+     *  is not in WAL mode, or the snapshot api is not available
+     * \throw sl3::ErrNoConnection if the database has been closed
+     * \return the snapshot
+     */
+    Snapshot takeSnapshot (const std::string& schema = "main");
+
+    /**
+     * \brief Begin a read transaction at a Snapshot
+     *
+     * Starts a deferred transaction that reads the database as of
+     * snapshot, which may have been taken by another connection.
+     * Writing in this transaction fails unless the snapshot is
+     * the newest state of the database.
+     *
+     * \param snapshot the point in time to read
+     * \param schema the database the snapshot belongs to, like "main"
+     * \throw sl3::SQLite3Error if the snapshot can not be opened,
+     *  for example because the WAL has been checkpointed beyond it
+     *  (SQLITE_ERROR_SNAPSHOT), or the snapshot api is not available
+     * \throw sl3::ErrNoConnection if snapshot has been moved
+     * \return Transaction instance
+     */
+    Transaction beginTransaction (const Snapshot&    snapshot,
+                                  const std::string& schema = "main");
+
+    /**
+     * \brief Savepoint Guard
+     *
+     * A savepoint is a named, nestable transaction.
+     * If no transaction is active, creating a Savepoint starts one.
+     *
+     * If an instance of this class goes out of scope and release has
+     * not been called, all changes since the creation are rolled back.
+     *
+     * Savepoints are supposed to be used in a strict nested way,
+     * like local variables in nested scopes.
+     */
+    class Savepoint
+    {
+      std::shared_ptr<internal::Connection> _connection;
+      int                                   _level;
+
+      explicit Savepoint (std::shared_ptr<internal::Connection>);
+      friend class Database;
+
+    public:
+      Savepoint (const Savepoint&) = delete;
+      Savepoint& operator= (const Savepoint&) = delete;
+      Savepoint& operator= (Savepoint&&) = delete;
+
+      /** \brief Move constructor
+       *  A Savepoint is movable.
+       */
+      Savepoint (Savepoint&&) noexcept;
+
+      /** \brief Destructor
+       *
+       * Rolls back and releases the savepoint if release has not been
+       * called.
+       */
+      ~Savepoint ();
+
+      /** \brief Release the savepoint
+       *
+       * The changes become part of the enclosing transaction, or, if
+       * there is none, are committed.
+       *
+       * \throw sl3::SQLite3Error in case of a problem
+       */
+      void release ();
+
+      /** \brief Partial rollback
+       *
+       * Reverts all changes made since the savepoint has been created,
+       * the savepoint stays active and can be used further.
+       *
+       * \throw sl3::SQLite3Error in case of a problem
+       * \throw sl3::ErrNoConnection if the savepoint has been released
+       */
+      void rollback ();
+
+      /** \brief Name of the savepoint
+       *
+       * \return the name used in the SAVEPOINT statement
+       */
+      std::string name () const;
+    };
+
+    /**
+     * \brief Create a Savepoint
+     *
+     * \throw sl3::SQLite3Error if the savepoint can not be created
+     * \return Savepoint instance
+     */
+    Savepoint savepoint ();
 
   protected:
     /**
@@ -334,6 +958,23 @@ namespace sl3
      */
     using ConnectionPtr = std::shared_ptr<internal::Connection>;
 
+    /**
+     * \brief Register a scalar function, takes ownership of fn
+     */
+    void registerFunction (const std::string&      name,
+                           int                     nArg,
+                           int                     flags,
+                           internal::FunctionBase* fn);
+
+    /**
+     * \brief Register an aggregate or window function, takes ownership of fn
+     */
+    void registerAggregate (const std::string&       name,
+                            int                      nArg,
+                            int                      flags,
+                            internal::AggregateBase* fn,
+                            bool                     window);
+
     /**
      * \brief Shared pointer for internal::Connection.
      *
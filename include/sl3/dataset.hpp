@@ -19,6 +19,23 @@
 
 namespace sl3
 {
+  /**
+   * \brief How Dataset::sort uses threads
+   *
+   * \see Dataset::sort
+   */
+  struct LIBSL3_API ExecutionPolicy
+  {
+    /// number of threads, 0 for std::thread::hardware_concurrency
+    std::size_t threads = 0;
+
+    /// Datasets with less rows are sorted on the calling thread only
+    std::size_t minRows = 100000;
+
+    /// keep the order of equal rows
+    bool stable = false;
+  };
+
   /**
    * \brief A utility for processing the result queries.
    *
@@ -47,6 +64,9 @@ namespace sl3
   class LIBSL3_API Dataset final : public Container<std::vector<DbValues>>
   {
     friend class Command;
+    friend class DatasetSource;
+    friend class HashIndex;
+    friend class SortedIndex;
 
   public:
     /**
@@ -94,7 +114,7 @@ namespace sl3
      * \brief Rvalues assignment
      * \return reference to this
      */
-    Dataset& operator= (Dataset&&) = default;
+    Dataset& operator= (Dataset&&);
 
     /**
      * \brief Clear all states.
@@ -131,6 +151,20 @@ namespace sl3
      */
     void merge (const Dataset& other);
 
+    /**
+     * \brief Merge an other Dataset by moving its rows.
+     *
+     * Like merge(const Dataset&), but the rows are moved, not copied.
+     * On success other is left empty.
+     * Merging a Dataset into itself this way changes nothing.
+     *
+     * \throw sl3::ErrTypeMisMatch if field names types are not equal or
+     * size differs.
+     *
+     * \param other Dataset which rows shall be moved into this one.
+     */
+    void merge (Dataset&& other);
+
     /**
      * \brief Merge DbValues.
      *
@@ -143,6 +177,18 @@ namespace sl3
      */
     void merge (const DbValues& row);
 
+    /**
+     * \brief Merge DbValues by moving them.
+     *
+     * Like merge(const DbValues&), but the row is moved, not copied.
+     *
+     * \throw sl3::ErrTypeMisMatch if size differs from existing row size or
+     * if types are not compatible
+     *
+     * \param  row A row which shall be moved in.
+     */
+    void merge (DbValues&& row);
+
     /**
      * \brief Get the index of a field by namespace
      *
@@ -170,6 +216,11 @@ namespace sl3
      * Sort according to the given field indexes.
      * The Dataset will be sorted according to sqlite rules.
      *
+     * With the default cmp, the selected fields of each row are encoded
+     * into a binary key in the order of dbval_lt first, and the keys are
+     * sorted. Rows with equal keys keep their order in this case.
+     * Any other cmp is called per field and comparison.
+     *
      * \throw sl2::OutOfRange if a given index is invalid
      * \param idxs list of field indexes
      * \param cmp pointer to a less than compare function, default dbval_lt
@@ -178,9 +229,35 @@ namespace sl3
                DbValueSort cmp = &dbval_lt
     );
 
+    /**
+     * \brief Sort the Dataset using several threads
+     *
+     * Like sort(const std::vector<size_t>&, DbValueSort), but large
+     * Datasets are split between threads, each part is sorted, and the
+     * parts are merged, the merges also in parallel.
+     * The indexes are checked before sorting, so the Dataset is unchanged
+     * if one is invalid.
+     *
+     * \throw sl2::OutOfRange if a given index is invalid
+     * \param idxs list of field indexes
+     * \param cmp pointer to a less than compare function
+     * \param policy threads to use, and if the sort shall be stable
+     */
+    void sort (const std::vector<size_t>& idxs,
+               DbValueSort                cmp,
+               const ExecutionPolicy&     policy);
+
   private:
+    void ensureMergeable (const Dataset& other) const;
+    void ensureMergeable (const DbValues& row) const;
+
+    // invalidates indexes
+    void modified () noexcept;
+
     Types                    _fieldtypes;
     std::vector<std::string> _names;
+    // changes on modification, indexes are valid for one generation
+    std::size_t _generation;
   };
 }
 
@@ -0,0 +1,177 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_DATASETINDEX_HPP_
+#define SL3_DATASETINDEX_HPP_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sl3/config.hpp>
+#include <sl3/dataset.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief Hash index for equality lookups on fields of a Dataset
+   *
+   * Maps the values of one or more fields to the positions of the rows
+   * that hold them. Values are compared via dbval_eq, so an Int and a Real
+   * of the same value are equal.
+   *
+   * The index refers to the Dataset it was built for, the Dataset must
+   * outlive it. Merging, sorting, resetting or assigning the Dataset
+   * makes the index outdated, lookups throw then and the index has to be
+   * rebuilt. Changing values in place, via the non const accessors of the
+   * Dataset, is not detected.
+   */
+  class LIBSL3_API HashIndex
+  {
+  public:
+    /// Positions of rows in the Dataset, ascending
+    using Rows = std::vector<std::size_t>;
+
+    /**
+     * \brief Build the index
+     *
+     * \param ds the Dataset to index
+     * \param fields indexes of the fields that build the key
+     * \throw sl3::ErrOutOfRange if a field index is invalid
+     */
+    HashIndex (const Dataset& ds, std::vector<std::size_t> fields);
+
+    /**
+     * \brief Find the rows with the given key
+     *
+     * \param key values of the key fields, in the order of the fields
+     * \throw sl3::ErrTypeMisMatch if the size of key is not the number of
+     *   fields
+     * \throw sl3::ErrUnexpected if the Dataset has changed since the build
+     * \return positions of the matching rows, empty if there are none
+     */
+    const Rows& find (const DbValues& key) const;
+
+    /**
+     * \brief Check if the Dataset has not changed since the build
+     *
+     * \return true if lookups can be done
+     */
+    bool isValid () const noexcept;
+
+    /**
+     * \brief Number of distinct keys
+     * \return the number of distinct keys
+     */
+    std::size_t size () const noexcept;
+
+  private:
+    void ensureValid () const;
+
+    const Dataset*                     _ds;
+    std::size_t                        _generation;
+    std::vector<std::size_t>           _fields;
+    std::unordered_map<DbValues, Rows> _rows;
+  };
+
+  /**
+   * \brief Sorted index for range lookups on fields of a Dataset
+   *
+   * Holds the positions of the rows ordered by the values of one or more
+   * fields, in the order of dbval_lt. Lookups take a key with values for
+   * all fields, or for the first ones only.
+   *
+   * The same validity rules as for HashIndex apply.
+   */
+  class LIBSL3_API SortedIndex
+  {
+  public:
+    /// Iterator over row positions in key order
+    using const_iterator = std::vector<std::size_t>::const_iterator;
+
+    /// A range of row positions
+    using Range = std::pair<const_iterator, const_iterator>;
+
+    /**
+     * \brief Build the index
+     *
+     * \param ds the Dataset to index
+     * \param fields indexes of the fields that build the key
+     * \throw sl3::ErrOutOfRange if a field index is invalid
+     */
+    SortedIndex (const Dataset& ds, std::vector<std::size_t> fields);
+
+    /**
+     * \brief First row that is not less than key
+     *
+     * \param key values of the first key fields
+     * \throw sl3::ErrTypeMisMatch if key has more values than fields
+     * \throw sl3::ErrUnexpected if the Dataset has changed since the build
+     * \return position in the index
+     */
+    const_iterator lowerBound (const DbValues& key) const;
+
+    /**
+     * \brief First row that is greater than key
+     *
+     * \copydetails lowerBound
+     */
+    const_iterator upperBound (const DbValues& key) const;
+
+    /**
+     * \brief Rows equal to key
+     *
+     * \copydetails lowerBound
+     */
+    Range equalRange (const DbValues& key) const;
+
+    /**
+     * \brief Rows from lower, inclusive, to upper, exclusive
+     *
+     * \param lower first key of the range
+     * \param upper end key of the range
+     * \throw sl3::ErrTypeMisMatch if a key has more values than fields
+     * \throw sl3::ErrUnexpected if the Dataset has changed since the build
+     * \return the range
+     */
+    Range range (const DbValues& lower, const DbValues& upper) const;
+
+    /**
+     * \brief All rows in key order
+     * \return begin of the rows
+     */
+    const_iterator begin () const noexcept;
+
+    /**
+     * \brief All rows in key order
+     * \return end of the rows
+     */
+    const_iterator end () const noexcept;
+
+    /**
+     * \copydoc HashIndex::isValid
+     */
+    bool isValid () const noexcept;
+
+  private:
+    void ensureValid () const;
+    const_iterator bound (const DbValues& key, bool upper) const;
+
+    const Dataset*           _ds;
+    std::size_t              _generation;
+    std::vector<std::size_t> _fields;
+    // memcmp comparable keys, key of row i at _offsets[i] to _offsets[i+1]
+    std::string              _keys;
+    std::vector<std::size_t> _offsets;
+    std::vector<std::size_t> _order;
+  };
+}
+
+#endif
@@ -142,6 +142,11 @@ namespace sl3
      */
     DbValue& operator= (const std::string& val);
 
+    /**
+     * \copydoc operator=(const DbValue& val)
+     */
+    DbValue& operator= (std::string&& val);
+
     /**
      * \copydoc operator=(const DbValue& val)
      */
@@ -156,11 +161,21 @@ namespace sl3
      */
     DbValue& operator= (const Blob& val);
 
+    /**
+     * \copydoc operator=(const DbValue& val)
+     */
+    DbValue& operator= (Blob&& val);
+
     /**
      * \copydoc operator=(const DbValue& val)
      */
     DbValue& operator= (const Value& val);
 
+    /**
+     * \copydoc operator=(const DbValue& val)
+     */
+    DbValue& operator= (Value&& val);
+
     /** \brief Assignment
      *  \throw sl3::ErrTypeMisMatch if getType is incompatible
      *  \note , only value assignment happens here,
@@ -180,6 +195,11 @@ namespace sl3
      */
     void set (const std::string& val);
 
+    /**
+     * \copydoc set(int val)
+     */
+    void set (std::string&& val);
+
     /**
      * \copydoc set(int val)
      */
@@ -190,6 +210,11 @@ namespace sl3
      */
     void set (const Blob& val);
 
+    /**
+     * \copydoc set(int val)
+     */
+    void set (Blob&& val);
+
     /** \brief Value access
      *  \return reference to the underlying Value
      */
@@ -218,14 +243,24 @@ namespace sl3
     const double& getReal () const;
 
     /**
-     * \copydoc getInt() const
+     * \brief Value access
+     *
+     *  Throws ErrNullValueAccess if the value is null
+     *  and ErrTypeMisMatch if the value is not text.
+     *
+     *  \return a copy of the value, see Value::data for access without copy
      */
-    const std::string& getText () const;
+    std::string getText () const;
 
     /**
-     * \copydoc getInt() const
+     * \brief Value access
+     *
+     *  Throws ErrNullValueAccess if the value is null
+     *  and ErrTypeMisMatch if the value is not a blob.
+     *
+     *  \return a copy of the value, see Value::data for access without copy
      */
-    const Blob& getBlob () const;
+    Blob getBlob () const;
 
     /** \brief Value access with default for a NULL value.
      *
@@ -351,8 +386,7 @@ namespace sl3
     friend void swap (DbValue& a, DbValue& b) noexcept;
 
   private:
-    Type _type;
-
+    // the type is kept in a spare slot of the value to save space
     Value _value;
 
     friend class DbValues;
@@ -426,7 +460,39 @@ namespace sl3
    */
   bool dbval_lt (const DbValue& a, const DbValue& b) noexcept;
 
+  /**
+   * \brief hash, consistent with dbval_eq
+   *
+   * \param v the value to hash
+   * \return the hash value, same as value_hash of the stored value
+   */
+  LIBSL3_API std::size_t dbval_hash (const DbValue& v) noexcept;
+
+}
 
+namespace std
+{
+  /// hash for unordered containers, see sl3::dbval_hash
+  template <>
+  struct hash<sl3::DbValue>
+  {
+    std::size_t
+    operator() (const sl3::DbValue& v) const noexcept
+    {
+      return sl3::dbval_hash (v);
+    }
+  };
+
+  /// equality for unordered containers, see sl3::dbval_eq
+  template <>
+  struct equal_to<sl3::DbValue>
+  {
+    bool
+    operator() (const sl3::DbValue& a, const sl3::DbValue& b) const noexcept
+    {
+      return sl3::dbval_eq (a, b);
+    }
+  };
 }
 
 #endif /* DbValue_HPP_ */
@@ -9,7 +9,9 @@
 #ifndef SL3_DbVALUES_HPP_
 #define SL3_DbVALUES_HPP_
 
+#include <functional>
 #include <initializer_list>
+#include <vector>
 
 #include <sl3/config.hpp>
 #include <sl3/container.hpp>
@@ -98,6 +100,67 @@ namespace sl3
    */
   void swap (DbValues& a, DbValues& b) noexcept;
 
+  /**
+   * \brief equality of rows, ignoring type info
+   *
+   * Rows are equal if they have the same size and all values are equal
+   * according to dbval_eq.
+   *
+   * \param a first row to compare
+   * \param b second row to compare
+   * \return the comparison result
+   */
+  LIBSL3_API bool dbvals_eq (const DbValues& a, const DbValues& b) noexcept;
+
+  /**
+   * \brief hash of a row, consistent with dbvals_eq
+   *
+   * \param row the row to hash
+   * \return the hash value
+   */
+  LIBSL3_API std::size_t dbvals_hash (const DbValues& row) noexcept;
+
+  /**
+   * \brief hash of selected fields of a row
+   *
+   * For use as key of a group by or join on the given fields.
+   * Rows that have equal values, according to dbval_eq, at the given
+   * indexes have the same hash.
+   *
+   * \param row the row to hash
+   * \param idxs indexes of the fields to hash
+   * \throw sl3::ErrOutOfRange if an index is out of range
+   * \return the hash value
+   */
+  LIBSL3_API std::size_t dbvals_hash (const DbValues&            row,
+                                      const std::vector<size_t>& idxs);
+
+}
+
+namespace std
+{
+  /// hash for unordered containers, see sl3::dbvals_hash
+  template <>
+  struct hash<sl3::DbValues>
+  {
+    std::size_t
+    operator() (const sl3::DbValues& row) const noexcept
+    {
+      return sl3::dbvals_hash (row);
+    }
+  };
+
+  /// equality for unordered containers, see sl3::dbvals_eq
+  template <>
+  struct equal_to<sl3::DbValues>
+  {
+    bool
+    operator() (const sl3::DbValues& a, const sl3::DbValues& b) const
+        noexcept
+    {
+      return sl3::dbvals_eq (a, b);
+    }
+  };
 }
 
 #endif
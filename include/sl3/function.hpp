@@ -0,0 +1,479 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_FUNCTION_HPP_
+#define SL3_FUNCTION_HPP_
+
+#include <cstdint>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <sl3/config.hpp>
+#include <sl3/dbvalue.hpp>
+#include <sl3/types.hpp>
+#include <sl3/value.hpp>
+
+struct sqlite3;
+struct sqlite3_context;
+struct sqlite3_value;
+
+namespace sl3
+{
+  /**
+   * \brief Flags for registering SQL functions
+   *
+   * Flags can be combined via |.
+   *
+   * \see Database::createFunction
+   */
+  struct FunctionFlag
+  {
+    /// no special behavior
+    static constexpr int None = 0;
+
+    /**
+     * \brief The function returns always the same result for the same input
+     *
+     * Deterministic functions can be used in indexes and partial indexes,
+     * and the query planner can factor them out of loops.
+     * Same as SQLITE_DETERMINISTIC.
+     */
+    static constexpr int Deterministic = 0x800;
+  };
+
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    //--------------------------------------------------------------------------
+    // sqlite3_value access, implemented in function.cpp so that sqlite3.h
+    // stays out of the public headers
+
+    LIBSL3_API bool        argIsNull (sqlite3_value* v);
+    LIBSL3_API int64_t     argInt64 (sqlite3_value* v);
+    LIBSL3_API double      argReal (sqlite3_value* v);
+    LIBSL3_API std::string argText (sqlite3_value* v);
+    LIBSL3_API Blob        argBlob (sqlite3_value* v);
+    LIBSL3_API Value       argValue (sqlite3_value* v);
+
+    LIBSL3_API void resultNull (sqlite3_context* ctx);
+    LIBSL3_API void resultInt64 (sqlite3_context* ctx, int64_t val);
+    LIBSL3_API void resultReal (sqlite3_context* ctx, double val);
+    LIBSL3_API void resultText (sqlite3_context* ctx, const std::string& val);
+    LIBSL3_API void resultBlob (sqlite3_context* ctx, const Blob& val);
+    LIBSL3_API void resultValue (sqlite3_context* ctx, const Value& val);
+
+    LIBSL3_API void* aggregateContext (sqlite3_context* ctx, std::size_t size);
+
+    //--------------------------------------------------------------------------
+    // C++11 replacement for std::index_sequence
+
+    template <std::size_t...> struct IndexSequence
+    {
+    };
+
+    template <std::size_t N, std::size_t... Is>
+    struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Is...>
+    {
+    };
+
+    template <std::size_t... Is> struct MakeIndexSequence<0, Is...>
+    {
+      using type = IndexSequence<Is...>;
+    };
+
+    //--------------------------------------------------------------------------
+    // signature of a callable
+
+    template <typename T>
+    struct CallableTraits : CallableTraits<decltype (&T::operator())>
+    {
+    };
+
+    template <typename R, typename... ARGS> struct CallableTraits<R (*) (ARGS...)>
+    {
+      using result_type = R;
+      using args_type   = std::tuple<typename std::decay<ARGS>::type...>;
+      static constexpr std::size_t arity = sizeof...(ARGS);
+    };
+
+    template <typename R, typename... ARGS>
+    struct CallableTraits<R (ARGS...)> : CallableTraits<R (*) (ARGS...)>
+    {
+    };
+
+    template <typename C, typename R, typename... ARGS>
+    struct CallableTraits<R (C::*) (ARGS...)> : CallableTraits<R (*) (ARGS...)>
+    {
+    };
+
+    template <typename C, typename R, typename... ARGS>
+    struct CallableTraits<R (C::*) (ARGS...) const>
+        : CallableTraits<R (*) (ARGS...)>
+    {
+    };
+
+    //--------------------------------------------------------------------------
+    // sqlite3_value to C++ argument
+
+    template <typename T, typename Enable = void> struct Arg;
+
+    template <typename T>
+    struct Arg<T, typename std::enable_if<std::is_integral<T>::value>::type>
+    {
+      static T
+      get (sqlite3_value* v)
+      {
+        return static_cast<T> (argInt64 (v));
+      }
+    };
+
+    template <typename T>
+    struct Arg<T,
+               typename std::enable_if<std::is_floating_point<T>::value>::type>
+    {
+      static T
+      get (sqlite3_value* v)
+      {
+        return static_cast<T> (argReal (v));
+      }
+    };
+
+    template <> struct Arg<std::string>
+    {
+      static std::string
+      get (sqlite3_value* v)
+      {
+        return argText (v);
+      }
+    };
+
+    template <> struct Arg<Blob>
+    {
+      static Blob
+      get (sqlite3_value* v)
+      {
+        return argBlob (v);
+      }
+    };
+
+    template <> struct Arg<Value>
+    {
+      static Value
+      get (sqlite3_value* v)
+      {
+        return argValue (v);
+      }
+    };
+
+    //--------------------------------------------------------------------------
+    // C++ return value to sqlite3_result_*
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type
+    setResult (sqlite3_context* ctx, T val)
+    {
+      resultInt64 (ctx, static_cast<int64_t> (val));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type
+    setResult (sqlite3_context* ctx, T val)
+    {
+      resultReal (ctx, static_cast<double> (val));
+    }
+
+    inline void
+    setResult (sqlite3_context* ctx, const std::string& val)
+    {
+      resultText (ctx, val);
+    }
+
+    inline void
+    setResult (sqlite3_context* ctx, const char* val)
+    {
+      if (val)
+        resultText (ctx, std::string{val});
+      else
+        resultNull (ctx);
+    }
+
+    inline void
+    setResult (sqlite3_context* ctx, const Blob& val)
+    {
+      resultBlob (ctx, val);
+    }
+
+    inline void
+    setResult (sqlite3_context* ctx, const Value& val)
+    {
+      resultValue (ctx, val);
+    }
+
+    inline void
+    setResult (sqlite3_context* ctx, const DbValue& val)
+    {
+      resultValue (ctx, val.getValue ());
+    }
+
+    //--------------------------------------------------------------------------
+    // call a callable with converted arguments and set the result
+
+    template <typename R> struct Invoke
+    {
+      template <typename F, typename ARGS, std::size_t... I>
+      static void
+      call (F& f, sqlite3_context* ctx, sqlite3_value** argv, IndexSequence<I...>)
+      {
+        setResult (
+            ctx,
+            f (Arg<typename std::tuple_element<I, ARGS>::type>::get (argv[I])...));
+      }
+    };
+
+    template <> struct Invoke<void>
+    {
+      template <typename F, typename ARGS, std::size_t... I>
+      static void
+      call (F& f, sqlite3_context* ctx, sqlite3_value** argv, IndexSequence<I...>)
+      {
+        f (Arg<typename std::tuple_element<I, ARGS>::type>::get (argv[I])...);
+        resultNull (ctx);
+      }
+    };
+
+    /**
+     * \internal
+     * \brief Type erased base of user defined SQL functions
+     *
+     * Owned by sqlite, deleted via the xDestroy callback.
+     */
+    class LIBSL3_API FunctionBase
+    {
+    public:
+      virtual ~FunctionBase () = default;
+
+      /// implementation of xFunc
+      virtual void call (sqlite3_context* ctx, int argc, sqlite3_value** argv)
+          = 0;
+    };
+
+    template <typename F> class ScalarFunction final : public FunctionBase
+    {
+      using traits = CallableTraits<F>;
+
+    public:
+      explicit ScalarFunction (F f)
+      : _f (std::move (f))
+      {
+      }
+
+      void
+      call (sqlite3_context* ctx, int, sqlite3_value** argv) override
+      {
+        using args_type = typename traits::args_type;
+        using indexes   = typename MakeIndexSequence<traits::arity>::type;
+        Invoke<typename traits::result_type>::template call<F, args_type> (
+            _f, ctx, argv, indexes{});
+      }
+
+    private:
+      F _f;
+    };
+
+    /**
+     * \internal
+     * \brief Type erased base of user defined aggregate and window functions
+     *
+     * Owned by sqlite, deleted via the xDestroy callback.
+     */
+    class LIBSL3_API AggregateBase
+    {
+    public:
+      virtual ~AggregateBase () = default;
+
+      /// implementation of xStep
+      virtual void step (sqlite3_context* ctx, int argc, sqlite3_value** argv)
+          = 0;
+
+      /// implementation of xFinal
+      virtual void final (sqlite3_context* ctx) = 0;
+
+      /// implementation of xValue, window functions only
+      virtual void value (sqlite3_context* ctx) = 0;
+
+      /// implementation of xInverse, window functions only
+      virtual void
+      inverse (sqlite3_context* ctx, int argc, sqlite3_value** argv)
+          = 0;
+    };
+
+    /**
+     * \internal
+     * \brief Storage of a State object within sqlite3_aggregate_context
+     *
+     * sqlite zeroes the memory on first access, so constructed is false
+     * until the state is created by the first call.
+     */
+    template <typename State> struct StateSlot
+    {
+      typename std::aligned_storage<sizeof (State), alignof (State)>::type
+           storage;
+      bool constructed;
+
+      static StateSlot*
+      get (sqlite3_context* ctx)
+      {
+        auto slot
+            = static_cast<StateSlot*> (aggregateContext (ctx, sizeof (StateSlot)));
+        if (slot == nullptr)
+          throw std::bad_alloc{};
+
+        if (!slot->constructed)
+          {
+            new (&slot->storage) State ();
+            slot->constructed = true;
+          }
+        return slot;
+      }
+
+      State&
+      state ()
+      {
+        return *reinterpret_cast<State*> (&storage);
+      }
+
+      void
+      destroy ()
+      {
+        if (constructed)
+          {
+            constructed = false;
+            state ().~State ();
+          }
+      }
+    };
+
+    template <typename State, typename ARGS, std::size_t... I>
+    void
+    callStep (State& state, sqlite3_value** argv, IndexSequence<I...>)
+    {
+      state.step (
+          Arg<typename std::tuple_element<I, ARGS>::type>::get (argv[I])...);
+    }
+
+    template <typename State, typename ARGS, std::size_t... I>
+    void
+    callInverse (State& state, sqlite3_value** argv, IndexSequence<I...>)
+    {
+      state.inverse (
+          Arg<typename std::tuple_element<I, ARGS>::type>::get (argv[I])...);
+    }
+
+    template <typename State> class AggregateFunction : public AggregateBase
+    {
+      // sqlite allocations are 8 byte aligned
+      static_assert (alignof (State) <= 8, "State alignment not supported");
+
+    protected:
+      using traits  = CallableTraits<decltype (&State::step)>;
+      using args    = typename traits::args_type;
+      using indexes = typename MakeIndexSequence<traits::arity>::type;
+
+    public:
+      static constexpr std::size_t arity = traits::arity;
+
+      void
+      step (sqlite3_context* ctx, int, sqlite3_value** argv) override
+      {
+        callStep<State, args> (
+            StateSlot<State>::get (ctx)->state (), argv, indexes{});
+      }
+
+      void
+      final (sqlite3_context* ctx) override
+      {
+        // also called without any step, for example on empty tables
+        auto slot = StateSlot<State>::get (ctx);
+        struct Guard
+        {
+          StateSlot<State>* slot;
+          ~Guard () { slot->destroy (); }
+        } guard{slot};
+        setResult (ctx, slot->state ().final ());
+      }
+
+      void
+      value (sqlite3_context*) override
+      {
+      }
+
+      void
+      inverse (sqlite3_context*, int, sqlite3_value**) override
+      {
+      }
+    };
+
+    template <typename State>
+    class WindowFunction final : public AggregateFunction<State>
+    {
+      using base = AggregateFunction<State>;
+
+    public:
+      void
+      value (sqlite3_context* ctx) override
+      {
+        setResult (ctx, StateSlot<State>::get (ctx)->state ().value ());
+      }
+
+      void
+      inverse (sqlite3_context* ctx, int, sqlite3_value** argv) override
+      {
+        callInverse<State, typename base::args> (
+            StateSlot<State>::get (ctx)->state (),
+            argv,
+            typename base::indexes{});
+      }
+    };
+
+    /**
+     * \internal
+     * \brief register a scalar function
+     *
+     * Takes ownership of fn, also in case of an error.
+     *
+     * \throw sl3::SQLite3Error if registration fails
+     */
+    LIBSL3_API void createScalarFunction (sqlite3*           db,
+                                          const std::string& name,
+                                          int                nArg,
+                                          int                flags,
+                                          FunctionBase*      fn);
+
+    /**
+     * \internal
+     * \brief register an aggregate or window function
+     *
+     * Takes ownership of fn, also in case of an error.
+     *
+     * \throw sl3::SQLite3Error if registration fails, or window functions
+     *  are not supported by the used sqlite version
+     */
+    LIBSL3_API void createAggregateFunction (sqlite3*           db,
+                                             const std::string& name,
+                                             int                nArg,
+                                             int                flags,
+                                             AggregateBase*     fn,
+                                             bool               window);
+  }
+  /// \endcond
+}
+
+#endif
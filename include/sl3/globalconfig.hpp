@@ -0,0 +1,104 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_GLOBALCONFIG_HPP_
+#define SL3_GLOBALCONFIG_HPP_
+
+#include <cstdint>
+#include <memory>
+
+#include <sl3/allocator.hpp>
+#include <sl3/config.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief Threading mode of sqlite
+   *
+   * \sa https://www.sqlite.org/threadsafe.html
+   */
+  enum class ThreadingMode
+  {
+    /// keep the compile time default
+    Default,
+    /// no mutexes, sqlite must only be used by one thread
+    SingleThread,
+    /// a connection must only be used by one thread at a time
+    MultiThread,
+    /// connections can be used by several threads
+    Serialized
+  };
+
+  /**
+   * \brief Process wide sqlite settings
+   *
+   * Negative or empty values keep the sqlite default.
+   *
+   * \see sl3::initialize
+   * \sa https://www.sqlite.org/c3ref/c_config_covering_index_scan.html
+   */
+  struct LIBSL3_API GlobalConfig
+  {
+    /// SQLITE_CONFIG_SINGLETHREAD, MULTITHREAD or SERIALIZED
+    ThreadingMode threading = ThreadingMode::Default;
+
+    /**
+     * \brief SQLITE_CONFIG_MEMSTATUS
+     *
+     * Memory statistics cost a mutex per allocation, turn them off if
+     * sl3::globalMemoryStats is not used.
+     * 0 turns them off, 1 on.
+     */
+    int memoryStatus = -1;
+
+    /// SQLITE_CONFIG_PAGECACHE, size of a page cache slot
+    int pageCacheSlotSize = -1;
+
+    /// SQLITE_CONFIG_PAGECACHE, number of slots allocated by sqlite
+    int pageCacheSlots = -1;
+
+    /// SQLITE_CONFIG_LOOKASIDE, default size of a lookaside slot
+    int lookasideSlotSize = -1;
+
+    /// SQLITE_CONFIG_LOOKASIDE, default number of lookaside slots
+    int lookasideSlots = -1;
+
+    /// SQLITE_CONFIG_MMAP_SIZE, default mmap size of a connection
+    int64_t mmapSize = -1;
+
+    /// SQLITE_CONFIG_MMAP_SIZE, the upper limit of the mmap size
+    int64_t mmapSizeLimit = -1;
+
+    /// SQLITE_CONFIG_MALLOC, if set sqlite allocates all memory from it
+    std::shared_ptr<Allocator> allocator;
+  };
+
+  /**
+   * \brief Configure and initialize sqlite
+   *
+   * Must be called before any other use of sqlite in the process,
+   * or after sl3::shutdown.
+   * The allocator of config is kept until shutdown.
+   *
+   * \param config the settings
+   * \throw sl3::SQLite3Error if sqlite is already in use or a setting is
+   *  not supported
+   */
+  LIBSL3_API void initialize (const GlobalConfig& config);
+
+  /**
+   * \brief Shut down sqlite
+   *
+   * All databases must be closed.
+   * Restores the allocator that was used before sl3::initialize.
+   * sqlite initializes itself with the previous settings on the next use.
+   */
+  LIBSL3_API void shutdown ();
+}
+
+#endif
@@ -0,0 +1,85 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_MEMORYSTATS_HPP_
+#define SL3_MEMORYSTATS_HPP_
+
+#include <cstdint>
+
+#include <sl3/config.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief Memory and cache statistics of a database connection
+   *
+   * Values are in bytes, except the counters.
+   * Subtracting two snapshots gives the difference of each value,
+   * for counters the activity between the snapshots.
+   *
+   * \see Database::memoryStats
+   * \sa https://www.sqlite.org/c3ref/c_dbstatus_options.html
+   */
+  struct LIBSL3_API DbMemoryStats
+  {
+    int64_t cacheUsed       = 0; //!< page cache memory
+    int64_t cacheUsedShared = 0; //!< page cache memory, shared caches split
+    int64_t cacheHit        = 0; //!< counter, page cache hits
+    int64_t cacheMiss       = 0; //!< counter, page cache misses
+    int64_t cacheWrite      = 0; //!< counter, dirty pages written
+    int64_t cacheSpill      = 0; //!< counter, pages spilled during a write
+
+    int64_t lookasideUsed      = 0; //!< lookaside slots in use
+    int64_t lookasideHighwater = 0; //!< most lookaside slots in use
+    int64_t lookasideHit       = 0; //!< counter, lookaside allocations
+    int64_t lookasideMissSize  = 0; //!< counter, too large for lookaside
+    int64_t lookasideMissFull  = 0; //!< counter, lookaside was full
+
+    int64_t schemaUsed = 0; //!< memory of the schemas
+    int64_t stmtUsed   = 0; //!< memory of prepared statements
+
+    /// difference of each value
+    DbMemoryStats operator- (const DbMemoryStats& other) const;
+  };
+
+  /**
+   * \brief Process wide memory statistics of sqlite
+   *
+   * Values are in bytes, except the counters.
+   * Subtracting two snapshots gives the difference of each value.
+   *
+   * \see globalMemoryStats
+   * \sa https://www.sqlite.org/c3ref/c_status_malloc_count.html
+   */
+  struct LIBSL3_API GlobalMemoryStats
+  {
+    int64_t memoryUsed      = 0; //!< memory allocated by sqlite
+    int64_t memoryHighwater = 0; //!< most memory allocated
+    int64_t mallocCount     = 0; //!< current number of allocations
+    int64_t mallocHighwater = 0; //!< most allocations at a time
+    int64_t largestMalloc   = 0; //!< largest single allocation
+
+    int64_t pagecacheUsed      = 0; //!< pages used in a configured cache
+    int64_t pagecacheOverflow  = 0; //!< page cache memory from malloc
+    int64_t pagecacheHighwater = 0; //!< most page cache memory from malloc
+    int64_t largestPagecache   = 0; //!< largest page cache allocation
+
+    /// difference of each value
+    GlobalMemoryStats operator- (const GlobalMemoryStats& other) const;
+  };
+
+  /**
+   * \brief Get the process wide memory statistics of sqlite
+   *
+   * \param reset if true, high water marks are reset after reading
+   * \return a snapshot of the statistics
+   */
+  LIBSL3_API GlobalMemoryStats globalMemoryStats (bool reset = false);
+}
+
+#endif
@@ -0,0 +1,191 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_SESSION_HPP_
+#define SL3_SESSION_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <sl3/config.hpp>
+#include <sl3/types.hpp>
+
+struct sqlite3;
+struct sqlite3_session;
+
+namespace sl3
+{
+  namespace internal
+  {
+    class Connection;
+  }
+
+  /**
+   * \brief How to handle conflicts when applying a changeset
+   *
+   * \see Database::applyChangeset
+   */
+  enum class ConflictPolicy
+  {
+    /// skip the conflicting change
+    Omit,
+
+    /**
+     * overwrite the existing row with the change,
+     * changes of missing rows and constraint violations are skipped
+     */
+    Replace,
+
+    /// roll back all changes of the changeset and throw
+    Abort
+  };
+
+  /**
+   * \brief Records changes of a database into changesets
+   *
+   * A Session records inserts, updates and deletes of the attached
+   * tables. The result can be serialized as changeset or patchset and
+   * applied to another database with the same schema via
+   * Database::applyChangeset.
+   *
+   * Only tables with a PRIMARY KEY can be recorded.
+   *
+   * A Session is created via Database::createSession.
+   * It requires a build with the SQLITE_ENABLE_SESSION option,
+   * see sl3::build_sqlite3_session.
+   *
+   * \sa https://www.sqlite.org/sessionintro.html
+   */
+  class LIBSL3_API Session
+  {
+    friend class Database;
+    using Connection = std::shared_ptr<internal::Connection>;
+
+    Session (Connection connection, const std::string& dbname);
+
+    Session ()               = delete;
+    Session (const Session&) = delete;
+    Session& operator= (const Session&) = delete;
+    Session& operator= (Session&&) = delete;
+
+  public:
+    /**
+     * \brief Move constructor
+     *
+     * A Session is movable
+     */
+    Session (Session&&) noexcept;
+
+    /**
+     * \brief Destructor
+     *
+     * Deletes the session, recorded changes that have not been fetched
+     * are lost.
+     */
+    ~Session ();
+
+    /**
+     * \brief Record changes of a table
+     *
+     * \param table table name
+     * \throw sl3::SQLite3Error in case of a problem
+     * \throw sl3::ErrNoConnection if the database has been closed
+     */
+    void attach (const std::string& table);
+
+    /**
+     * \brief Record changes of all tables
+     *
+     * Also tables created after this call are recorded.
+     *
+     * \throw sl3::SQLite3Error in case of a problem
+     * \throw sl3::ErrNoConnection if the database has been closed
+     */
+    void attachAll ();
+
+    /**
+     * \brief Get the recorded changes as changeset
+     *
+     * A changeset contains the old values of updated and deleted rows,
+     * so conflicts can be detected when it is applied.
+     *
+     * \throw sl3::SQLite3Error in case of a problem
+     * \throw sl3::ErrNoConnection if the database has been closed
+     * \return the serialized changeset
+     */
+    Blob changeset () const;
+
+    /**
+     * \brief Get the recorded changes as patchset
+     *
+     * A patchset is smaller than a changeset, it contains only the
+     * primary key of updated and deleted rows, and only changed columns of
+     * updated rows.
+     *
+     * \throw sl3::SQLite3Error in case of a problem
+     * \throw sl3::ErrNoConnection if the database has been closed
+     * \return the serialized patchset
+     */
+    Blob patchset () const;
+
+    /**
+     * \brief Check if changes have been recorded
+     *
+     * \throw sl3::ErrNoConnection if the database has been closed
+     * \return true if no changes have been recorded
+     */
+    bool isEmpty () const;
+
+    /**
+     * \brief Pause or continue recording
+     *
+     * \param enabled true to record changes
+     * \throw sl3::ErrNoConnection if the database has been closed
+     */
+    void enable (bool enabled);
+
+    /**
+     * \brief Check if the session records changes
+     *
+     * \throw sl3::ErrNoConnection if the database has been closed
+     * \return true if recording
+     */
+    bool isEnabled () const;
+
+  private:
+    void ensureOpen () const;
+
+    Connection       _connection;
+    sqlite3_session* _session;
+  };
+
+  /**
+   * \brief Function to select tables when applying a changeset
+   *
+   * Receives a table name, returns true if changes of the table
+   * shall be applied.
+   */
+  using ChangesetFilter = std::function<bool (const std::string&)>;
+
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Apply a changeset to db, see Database::applyChangeset
+     */
+    LIBSL3_API void applyChangeset (sqlite3*               db,
+                                    const Blob&            changeset,
+                                    ConflictPolicy         policy,
+                                    const ChangesetFilter& filter);
+  }
+  /// \endcond
+}
+
+#endif
@@ -0,0 +1,79 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_SNAPSHOT_HPP_
+#define SL3_SNAPSHOT_HPP_
+
+#include <sl3/config.hpp>
+
+struct sqlite3_snapshot;
+
+namespace sl3
+{
+  /**
+   * \brief A point in time of a WAL database
+   *
+   * A Snapshot is taken by a connection that has a read transaction
+   * open, via Database::takeSnapshot.
+   * Other connections to the same database file can then start read
+   * transactions that see the database exactly as of the snapshot,
+   * via Database::beginTransaction(const Snapshot&).
+   *
+   * This allows consistent reads over several connections.
+   * A snapshot can be opened as long as the WAL has not been
+   * checkpointed beyond it, keep the read transaction that took the
+   * snapshot open until the other connections have opened it.
+   *
+   * Requires a database in journal_mode WAL and a build with the
+   * SQLITE_ENABLE_SNAPSHOT option, see sl3::build_sqlite3_snapshot.
+   *
+   * \sa https://www.sqlite.org/c3ref/snapshot.html
+   */
+  class LIBSL3_API Snapshot
+  {
+    friend class Database;
+
+    explicit Snapshot (sqlite3_snapshot* snapshot);
+
+    Snapshot ()                = delete;
+    Snapshot (const Snapshot&) = delete;
+    Snapshot& operator= (const Snapshot&) = delete;
+    Snapshot& operator= (Snapshot&&) = delete;
+
+  public:
+    /**
+     * \brief Move constructor
+     *
+     * A Snapshot is movable
+     */
+    Snapshot (Snapshot&&) noexcept;
+
+    /**
+     * \brief Destructor, frees the snapshot
+     */
+    ~Snapshot ();
+
+    /**
+     * \brief Compare the age of two snapshots
+     *
+     * The result is only valid for snapshots of the same database file
+     * taken since the WAL was last reset.
+     *
+     * \param other snapshot to compare with
+     * \throw sl3::ErrNoConnection if one of the snapshots has been moved
+     * \return negative if this is older than other, 0 if both are the same,
+     *  positive if this is newer
+     */
+    int compare (const Snapshot& other) const;
+
+  private:
+    sqlite3_snapshot* _snapshot;
+  };
+}
+
+#endif
@@ -9,6 +9,9 @@
 #ifndef SL3_VALUE_HPP_
 #define SL3_VALUE_HPP_
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
 
 #include <sl3/config.hpp>
@@ -28,7 +31,17 @@ namespace sl3
    *
    * The class has the current type info availalbe.
    *
+   * A Value occupies 16 bytes, the type tag is packed into the last byte.
+   * Text and blob values of up to 14 bytes are stored inline, without
+   * allocation. Longer ones are held in a separate, reference counted
+   * buffer. Copies of a value share it, so copying large text or blob
+   * values is cheap. Assigning to a value that shares its buffer replaces
+   * the buffer and leaves the other copies as they are.
    *
+   * \note Since inline values are not held as std::string or Blob objects,
+   * text() and blob(), and the conversion operators, return a copy, not a
+   * reference as in versions before 1.2. data() and size() give access
+   * without copy.
    */
   class LIBSL3_API Value
   {
@@ -55,7 +68,7 @@ namespace sl3
     /**
      * \copydoc Value(int val)
      */
-    explicit Value (std::string val) noexcept;
+    explicit Value (std::string val);
 
     /**
      * \copydoc Value(int val)
@@ -70,7 +83,7 @@ namespace sl3
     /**
      * \copydoc Value(int val)
      */
-    explicit Value (Blob val) noexcept;
+    explicit Value (Blob val);
 
     /**
      * \brief Destructor
@@ -123,11 +136,21 @@ namespace sl3
      */
     Value& operator= (const std::string& val);
 
+    /**
+     * \copydoc operator=(const Value& val)
+     */
+    Value& operator= (std::string&& val);
+
     /**
      * \copydoc operator=(const Value& val)
      */
     Value& operator= (const Blob& val);
 
+    /**
+     * \copydoc operator=(const Value& val)
+     */
+    Value& operator= (Blob&& val);
+
     /** \brief Implicit conversion operator
      *  \throw sl3::ErrNullValueAccess if value is null.
      *  \throw sl3::ErrTypeMisMatch if getType is incompatible
@@ -157,14 +180,14 @@ namespace sl3
      *  \throw sl3::ErrTypeMisMatch if getType is incompatible
      *  \return  the value
      */
-    explicit operator const std::string& () const; // TODO ref or val
+    explicit operator std::string () const;
 
     /** \brief Implicit conversion operator
      *  \throw sl3::ErrNullValueAccess if value is null.
      *  \throw sl3::ErrTypeMisMatch if getType is incompatible
      *  \return  the value
      */
-    explicit operator const Blob& () const; // TODO ref or val
+    explicit operator Blob () const;
 
     /** \brief Access the value
      *  \throw sl3::ErrNullValueAccess if value is null.
@@ -183,20 +206,37 @@ namespace sl3
     /** \brief Access the value
      *  \throw sl3::ErrNullValueAccess if value is null.
      *  \throw sl3::ErrTypeMisMatch if the current value has a different type.
-     *  \return  reference to the value
+     *  \return  a copy of the value, see data() for access without copy
      */
-    const std::string& text () const;
+    std::string text () const;
 
     /** \brief Access the value
      *  \throw sl3::ErrNullValueAccess if value is null.
      *  \throw sl3::ErrTypeMisMatch if the current value has a different type.
-     *  \return  reference to the value
+     *  \return  a copy of the value, see data() for access without copy
      */
-    const Blob& blob () const;
+    Blob blob () const;
+
+    /** \brief Access the bytes of a text or blob value without copy
+     *
+     *  The pointer is valid until the value is changed, moved or destroyed.
+     *  Text is not null terminated.
+     *
+     *  \return pointer to the first byte, nullptr if the type is not
+     *    Type::Text or Type::Blob
+     */
+    const char* data () const noexcept;
+
+    /** \brief Number of bytes of a text or blob value
+     *
+     *  \return the size of the text or blob, 0 for other types
+     */
+    std::size_t size () const noexcept;
 
     /** \brief Moves the current value into the return value
      *
      *  After calling this function the value will be Null.
+     *  If copies of the value share its buffer, the value is copied.
      *
      *  \throw sl3::ErrTypeMisMatch in case of wrong type.
      *  \return The value
@@ -237,6 +277,8 @@ namespace sl3
     friend bool value_eq (const Value& a, const Value& b) noexcept;
     friend bool value_lt (const Value& a, const Value& b) noexcept;
 
+    friend std::size_t value_hash (const Value& v) noexcept;
+
     /**
      * \brief swap function
      *
@@ -248,20 +290,76 @@ namespace sl3
 
 
   private:
-    Type _type{Type::Null};
+    friend class DbValue;
 
-    // that's the type for the union and what is applied in the db
-    union Store
+    // bytes of a text or blob that fit into a Value
+    static constexpr std::size_t inlineCapacity = 14;
+
+    // tag bits 0-2: storage type, bit 3: inline, bits 4-7: aux type
+    enum : uint8_t
     {
-      Store () {}
-      ~Store () {}
-      int64_t     intval;
-      double      realval;
-      std::string textval;
-      Blob        blobval;
+      typeMask   = 0x07,
+      inlineFlag = 0x08,
+      auxShift   = 4
+    };
+
+    // inline text and blob bytes start at offset 0, longer values point
+    // to their shared buffer, see value.cpp
+    struct Store
+    {
+      union
+      {
+        int64_t intval;
+        double  realval;
+        void*   heap;
+      };
+      char    tail[inlineCapacity - sizeof (int64_t)];
+      uint8_t inlineSize;
+      uint8_t tag;
     };
 
     Store _store;
+
+    Type
+    storageType () const noexcept
+    {
+      return static_cast<Type> (_store.tag & typeMask);
+    }
+
+    bool
+    isInline () const noexcept
+    {
+      return (_store.tag & inlineFlag) != 0;
+    }
+
+    bool
+    hasBuffer () const noexcept
+    {
+      return (storageType () == Type::Text || storageType () == Type::Blob)
+             && !isInline ();
+    }
+
+    // type slot for DbValue, not touched by assignments
+    Type
+    auxType () const noexcept
+    {
+      return static_cast<Type> (_store.tag >> auxShift);
+    }
+
+    void
+    auxType (Type type) noexcept
+    {
+      _store.tag = static_cast<uint8_t> ((_store.tag & ~(0xF << auxShift))
+                                         | (static_cast<int> (type)
+                                            << auxShift));
+    }
+
+    void setInline (Type type, const char* data, std::size_t size) noexcept;
+    void setBuffer (Type type, void* heap) noexcept;
+    void releaseBuffer () noexcept;
+    void setStorage (Type type) noexcept;
+    void copyFrom (const Value& other) noexcept;
+    void moveFrom (Value& other) noexcept;
   };
 
   /**
@@ -332,6 +430,17 @@ namespace sl3
    */
   bool value_lt (const Value& a, const Value& b) noexcept;
 
+  /**
+   * \brief hash, consistent with value_eq
+   *
+   * Values that are equal according to value_eq have the same hash,
+   * this includes an Int and a Real of the same numeric value.
+   *
+   * \param v the value to hash
+   * \return the hash value
+   */
+  LIBSL3_API std::size_t value_hash (const Value& v) noexcept;
+
   /**
    * \brief Value specialized swap function
    *
@@ -354,6 +463,28 @@ namespace std
   {
     sl3::swap(lhs, rhs) ;
   }
+
+  /// hash for unordered containers, see sl3::value_hash
+  template <>
+  struct hash<sl3::Value>
+  {
+    std::size_t
+    operator() (const sl3::Value& v) const noexcept
+    {
+      return sl3::value_hash (v);
+    }
+  };
+
+  /// equality for unordered containers, see sl3::value_eq
+  template <>
+  struct equal_to<sl3::Value>
+  {
+    bool
+    operator() (const sl3::Value& a, const sl3::Value& b) const noexcept
+    {
+      return sl3::value_eq (a, b);
+    }
+  };
 }
 
 #endif
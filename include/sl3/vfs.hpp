@@ -0,0 +1,152 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_VFS_HPP_
+#define SL3_VFS_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <sl3/config.hpp>
+
+namespace sl3
+{
+  /**
+   * \brief Kind of a file opened by sqlite
+   */
+  enum class FileKind
+  {
+    MainDb,  //!< a main or attached database file
+    Journal, //!< a rollback or super journal
+    Wal,     //!< a write ahead log
+    Temp,    //!< temporary databases, journals and statement journals
+    Other    //!< anything else
+  };
+
+  /// number of FileKind values
+  constexpr std::size_t fileKindCount = 5;
+
+  /**
+   * \brief Counters of one I/O operation
+   */
+  struct LIBSL3_API IoOpStats
+  {
+    /// number of latency buckets
+    static constexpr std::size_t bucketCount = 20;
+
+    uint64_t                 calls = 0; //!< number of calls
+    uint64_t                 bytes = 0; //!< bytes read or written
+    std::chrono::nanoseconds time{0};   //!< time spent in the calls
+
+    /**
+     * \brief latency histogram
+     *
+     * Bucket 0 counts calls below 1 microsecond, bucket i calls from
+     * 2^(i-1) to below 2^i microseconds, the last bucket all slower ones.
+     */
+    std::array<uint64_t, bucketCount> histogram{};
+
+    /// difference of each value
+    IoOpStats operator- (const IoOpStats& other) const;
+  };
+
+  /**
+   * \brief I/O counters of one FileKind
+   */
+  struct LIBSL3_API FileIoStats
+  {
+    IoOpStats read;  //!< xRead
+    IoOpStats write; //!< xWrite
+    IoOpStats sync;  //!< xSync
+    IoOpStats lock;  //!< xLock
+
+    /// difference of each value
+    FileIoStats operator- (const FileIoStats& other) const;
+  };
+
+  /**
+   * \brief Snapshot of the counters of an InstrumentedVfs
+   */
+  struct LIBSL3_API IoStats
+  {
+    /// counters per FileKind
+    std::array<FileIoStats, fileKindCount> files;
+
+    /// counters of kind
+    const FileIoStats& operator[] (FileKind kind) const;
+
+    /// difference of each value
+    IoStats operator- (const IoStats& other) const;
+  };
+
+  /**
+   * \brief A VFS shim counting file I/O
+   *
+   * Wraps an existing VFS, by default the default VFS of sqlite, and
+   * counts calls, bytes and latency of xRead, xWrite, xSync and xLock
+   * per FileKind.
+   *
+   * The shim is registered under its name and is used by a Database
+   * opened with that name in OpenOptions::vfs.
+   * For counters per Database, use one InstrumentedVfs per Database.
+   *
+   * \code
+   *   sl3::InstrumentedVfs io{"iostats"};
+   *   sl3::OpenOptions options;
+   *   options.vfs = io.name ();
+   *   sl3::Database db{"file.db", options};
+   *   ...
+   *   auto wal = io.stats ()[sl3::FileKind::Wal];
+   * \endcode
+   *
+   * The object must outlive all databases using it.
+   *
+   * \sa https://www.sqlite.org/vfs.html
+   */
+  class LIBSL3_API InstrumentedVfs
+  {
+  public:
+    /**
+     * \brief Create and register the shim
+     *
+     * \param name name to register the VFS with
+     * \param base name of the wrapped VFS, empty for the default VFS
+     * \throw sl3::SQLite3Error if base does not exist or registration
+     *  fails
+     */
+    explicit InstrumentedVfs (const std::string& name,
+                              const std::string& base = "");
+
+    /**
+     * \brief Destructor, unregisters the shim
+     */
+    ~InstrumentedVfs ();
+
+    InstrumentedVfs (const InstrumentedVfs&) = delete;
+    InstrumentedVfs& operator= (const InstrumentedVfs&) = delete;
+
+    /// the registered name
+    const std::string& name () const;
+
+    /// a snapshot of the counters
+    IoStats stats () const;
+
+    /// set all counters to 0
+    void reset ();
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+  };
+}
+
+#endif
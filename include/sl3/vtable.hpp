@@ -0,0 +1,126 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_VTABLE_HPP_
+#define SL3_VTABLE_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <sl3/config.hpp>
+#include <sl3/dataset.hpp>
+#include <sl3/types.hpp>
+#include <sl3/value.hpp>
+
+struct sqlite3;
+
+namespace sl3
+{
+  /**
+   * \brief Read only tabular data that can be queried via SQL
+   *
+   * Implement this interface to make any in memory container available
+   * as virtual table, see Database::createVirtualTable.
+   * Rows and columns are addressed by index.
+   *
+   * The data is not copied, sqlite reads it through this interface while
+   * a statement runs.
+   * Therefore the data must not be modified while the virtual table exists.
+   */
+  class LIBSL3_API TableSource
+  {
+  public:
+    virtual ~TableSource () = default;
+
+    /**
+     * \brief Number of columns
+     * \return column count
+     */
+    virtual std::size_t columnCount () const = 0;
+
+    /**
+     * \brief Name of a column
+     *
+     * \param col column index
+     * \return the column name as used in SQL
+     */
+    virtual std::string columnName (std::size_t col) const = 0;
+
+    /**
+     * \brief Number of rows
+     * \return row count
+     */
+    virtual std::size_t rowCount () const = 0;
+
+    /**
+     * \brief Value of a field
+     *
+     * Sources that hold sl3::Value objects return a reference to them,
+     * others can assign the value to scratch and return scratch.
+     *
+     * \param row row index
+     * \param col column index
+     * \param scratch a Value that may be used for the result
+     * \return reference to the value of the field
+     */
+    virtual const Value&
+    value (std::size_t row, std::size_t col, Value& scratch) const = 0;
+  };
+
+  /**
+   * \brief TableSource for a Dataset
+   *
+   * Refers to the given Dataset, which must outlive this object and
+   * the virtual table using it.
+   *
+   * Column names are taken from the Dataset if it was filled from a query,
+   * otherwise they are c0, c1, ...
+   */
+  class LIBSL3_API DatasetSource final : public TableSource
+  {
+  public:
+    /**
+     * \brief Constructor
+     *
+     * \param ds the Dataset
+     */
+    explicit DatasetSource (const Dataset& ds);
+
+    std::size_t columnCount () const override;
+
+    std::string columnName (std::size_t col) const override;
+
+    std::size_t rowCount () const override;
+
+    const Value&
+    value (std::size_t row, std::size_t col, Value& scratch) const override;
+
+  private:
+    const Dataset& _ds;
+  };
+
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief register the module for source and create a virtual table
+     *
+     * \throw sl3::ErrOutOfRange if keyColumn is not a column of source
+     * \throw sl3::SQLite3Error if the table can not be created
+     */
+    LIBSL3_API void createVirtualTable (sqlite3*                           db,
+                                        const std::string&                 name,
+                                        std::shared_ptr<const TableSource> source,
+                                        const std::string& keyColumn);
+  }
+  /// \endcond
+}
+
+#endif
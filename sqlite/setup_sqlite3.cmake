@@ -27,6 +27,15 @@ if (NOT have_mySqlt3Setup)
     SET (USE_INTERNAL_SQLITE3 ON CACHE BOOL
         "use buildin sqlite3 ON, use system sqlite3 header/lib, OFF" )
 
+    # session extension, for the system sqlite3 this requires a library
+    # that has been built with these options
+    set( SQLITE_ENABLE_SESSION ${SQLITE_ENABLE_SESSION} CACHE BOOL
+        "defines SQLITE_ENABLE_SESSION and SQLITE_ENABLE_PREUPDATE_HOOK if on")
+
+    # snapshot api, same requirement for the system sqlite3
+    set( SQLITE_ENABLE_SNAPSHOT ${SQLITE_ENABLE_SNAPSHOT} CACHE BOOL
+        "defines SQLITE_ENABLE_SNAPSHOT if on")
+
     if (USE_INTERNAL_SQLITE3)
 
         # das geht hier nicht, macros muessen vor include includet werden..
@@ -145,6 +154,15 @@ if (NOT have_mySqlt3Setup)
             list( APPEND mysqlt3_DEFINES  SQLITE_ENABLE_ICU )
         endif ( SQLITE_ENABLE_ICU )
 
+        if ( SQLITE_ENABLE_SESSION )
+            list( APPEND mysqlt3_DEFINES  SQLITE_ENABLE_SESSION )
+            list( APPEND mysqlt3_DEFINES  SQLITE_ENABLE_PREUPDATE_HOOK )
+        endif ( SQLITE_ENABLE_SESSION )
+
+        if ( SQLITE_ENABLE_SNAPSHOT )
+            list( APPEND mysqlt3_DEFINES  SQLITE_ENABLE_SNAPSHOT )
+        endif ( SQLITE_ENABLE_SNAPSHOT )
+
         PREFIX_COMPILER_DEFINES(mysqlt3_DEFINES)
 
 
@@ -170,6 +188,18 @@ if (NOT have_mySqlt3Setup)
           pkg_check_modules(SQLITE3 REQUIRED sqlite3)
           set(sl3_sqlite3LIBS ${SQLITE3_LIBRARIES} CACHE STRING "FOBAR")
 
+          # the api declarations in sqlite3.h depend on these
+          unset( mysqlt3_DEFINES )
+          if ( SQLITE_ENABLE_SESSION )
+            list( APPEND mysqlt3_DEFINES SQLITE_ENABLE_SESSION SQLITE_ENABLE_PREUPDATE_HOOK )
+          endif ( SQLITE_ENABLE_SESSION )
+          if ( SQLITE_ENABLE_SNAPSHOT )
+            list( APPEND mysqlt3_DEFINES SQLITE_ENABLE_SNAPSHOT )
+          endif ( SQLITE_ENABLE_SNAPSHOT )
+          if ( mysqlt3_DEFINES )
+            PREFIX_COMPILER_DEFINES(mysqlt3_DEFINES)
+          endif ( mysqlt3_DEFINES )
+
     endif (USE_INTERNAL_SQLITE3)
 
 
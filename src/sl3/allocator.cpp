@@ -0,0 +1,210 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/allocator.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+namespace sl3
+{
+  namespace
+  {
+    // each block starts with its usable size, keeps 8 byte alignment
+    using Header                         = uint64_t;
+    constexpr std::size_t headerSize     = sizeof (Header);
+    constexpr std::size_t smallestClass  = 16;
+
+    std::size_t
+    classOf (std::size_t size)
+    {
+      std::size_t cls = 0;
+      while ((smallestClass << cls) < size)
+        ++cls;
+      return cls;
+    }
+
+    std::size_t
+    classSize (std::size_t cls)
+    {
+      return smallestClass << cls;
+    }
+
+    Header*
+    headerOf (void* p)
+    {
+      return reinterpret_cast<Header*> (static_cast<char*> (p) - headerSize);
+    }
+  } // ns
+
+  Allocator::~Allocator () {}
+
+  constexpr int         SlabAllocator::maxSlabSize;
+  constexpr std::size_t SlabAllocator::classCount;
+  constexpr std::size_t SlabAllocator::shardCount;
+
+  SlabAllocator::SlabAllocator (std::size_t chunkSize)
+  : _chunkSize (
+      std::max (chunkSize, static_cast<std::size_t> (maxSlabSize) + headerSize))
+  {
+  }
+
+  SlabAllocator::~SlabAllocator ()
+  {
+    for (auto& s : _shards)
+      for (auto chunk : s.chunks)
+        std::free (chunk);
+  }
+
+  SlabAllocator::Shard&
+  SlabAllocator::shard ()
+  {
+    const auto id = std::hash<std::thread::id>{}(std::this_thread::get_id ());
+    return _shards[id % shardCount];
+  }
+
+  void*
+  SlabAllocator::fromSlab (Shard& s, std::size_t cls)
+  {
+    std::lock_guard<std::mutex> lock (s.mutex);
+
+    if (s.free[cls] != nullptr)
+      {
+        FreeBlock* block = s.free[cls];
+        s.free[cls]      = block->next;
+        return block;
+      }
+
+    const std::size_t blockSize = headerSize + classSize (cls);
+    if (s.left < blockSize)
+      {
+        void* chunk = std::malloc (_chunkSize);
+        if (chunk == nullptr)
+          return nullptr;
+
+        s.chunks.push_back (chunk);
+        s.top  = static_cast<char*> (chunk);
+        s.left = _chunkSize;
+        _chunkBytes += _chunkSize;
+      }
+
+    char* block = s.top;
+    s.top += blockSize;
+    s.left -= blockSize;
+
+    *reinterpret_cast<Header*> (block) = classSize (cls);
+    return block + headerSize;
+  }
+
+  void*
+  SlabAllocator::allocate (int size) noexcept
+  {
+    if (size <= 0)
+      return nullptr;
+
+    const auto wanted = static_cast<std::size_t> (size);
+    void*      p      = nullptr;
+
+    if (size <= maxSlabSize)
+      {
+        try
+          {
+            p = fromSlab (shard (), classOf (wanted));
+          }
+        catch (...) // LCOV_EXCL_LINE
+          {
+            return nullptr; // LCOV_EXCL_LINE
+          }
+      }
+    else
+      {
+        const std::size_t capacity = (wanted + 7) & ~std::size_t{7};
+        auto block = static_cast<char*> (std::malloc (headerSize + capacity));
+        if (block != nullptr)
+          {
+            *reinterpret_cast<Header*> (block) = capacity;
+            p                                   = block + headerSize;
+          }
+      }
+
+    if (p != nullptr)
+      ++_allocations;
+
+    return p;
+  }
+
+  void
+  SlabAllocator::deallocate (void* p) noexcept
+  {
+    Header* header = headerOf (p);
+    --_allocations;
+
+    if (*header > static_cast<Header> (maxSlabSize))
+      {
+        std::free (header);
+        return;
+      }
+
+    // the block goes to the list of the current thread
+    Shard&                      s   = shard ();
+    const std::size_t           cls = classOf (static_cast<std::size_t> (*header));
+    std::lock_guard<std::mutex> lock (s.mutex);
+    auto                        block = static_cast<FreeBlock*> (p);
+    block->next                       = s.free[cls];
+    s.free[cls]                       = block;
+  }
+
+  void*
+  SlabAllocator::reallocate (void* p, int size) noexcept
+  {
+    if (size <= this->size (p))
+      return p;
+
+    void* q = allocate (size);
+    if (q == nullptr)
+      return nullptr;
+
+    std::memcpy (q, p, static_cast<std::size_t> (this->size (p)));
+    deallocate (p);
+    return q;
+  }
+
+  int
+  SlabAllocator::size (void* p) noexcept
+  {
+    return static_cast<int> (*headerOf (p));
+  }
+
+  int
+  SlabAllocator::roundup (int size) noexcept
+  {
+    if (size <= 0)
+      return static_cast<int> (smallestClass);
+
+    if (size <= maxSlabSize)
+      return static_cast<int> (
+          classSize (classOf (static_cast<std::size_t> (size))));
+
+    return (size + 7) & ~7;
+  }
+
+  std::size_t
+  SlabAllocator::allocations () const
+  {
+    return _allocations.load ();
+  }
+
+  std::size_t
+  SlabAllocator::chunkBytes () const
+  {
+    return _chunkBytes.load ();
+  }
+}
@@ -0,0 +1,492 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/arrowexport.hpp>
+
+#include "stmtcolumn.hpp"
+
+#include <sqlite3.h>
+
+#include <exception>
+#include <limits>
+#include <sl3/error.hpp>
+#include <string>
+#include <vector>
+
+namespace sl3
+{
+  namespace
+  {
+    const char*
+    arrowFormat (Type type)
+    {
+      switch (type)
+        {
+        case Type::Int:
+          return "l";
+        case Type::Real:
+          return "g";
+        case Type::Blob:
+          return "z";
+        default:
+          return "u";
+        }
+    }
+
+    // buffers of one column of a batch, private data of its ArrowArray
+    struct ColumnBuffers
+    {
+      std::vector<uint8_t> validity;
+      std::vector<int64_t> ints;
+      std::vector<double>  reals;
+      std::vector<int32_t> offsets;
+      std::string          bytes;
+      const void*          buffers[3];
+    };
+
+    void
+    releaseColumn (ArrowArray* array)
+    {
+      delete static_cast<ColumnBuffers*> (array->private_data);
+      array->release = nullptr;
+    }
+
+    struct BatchData
+    {
+      std::vector<ArrowArray>  children;
+      std::vector<ArrowArray*> pointers;
+      const void*              buffers[1];
+    };
+
+    void
+    releaseBatch (ArrowArray* array)
+    {
+      auto batch = static_cast<BatchData*> (array->private_data);
+      // children moved out by the consumer have no release callback
+      for (auto child : batch->pointers)
+        {
+          if (child->release)
+            child->release (child);
+        }
+      delete batch;
+      array->release = nullptr;
+    }
+
+    struct FieldData
+    {
+      std::string name;
+    };
+
+    void
+    releaseField (ArrowSchema* schema)
+    {
+      delete static_cast<FieldData*> (schema->private_data);
+      schema->release = nullptr;
+    }
+
+    struct SchemaData
+    {
+      std::vector<ArrowSchema>  children;
+      std::vector<ArrowSchema*> pointers;
+    };
+
+    void
+    releaseSchema (ArrowSchema* schema)
+    {
+      auto data = static_cast<SchemaData*> (schema->private_data);
+      for (auto child : data->pointers)
+        {
+          if (child->release)
+            child->release (child);
+        }
+      delete data;
+      schema->release = nullptr;
+    }
+
+    // collects the values of a column for one batch
+    class ColumnBuilder
+    {
+    public:
+      ColumnBuilder (std::string name, Type type)
+      : _name (std::move (name))
+      , _type (type)
+      , _fixed (type != Type::Null)
+      , _length (0)
+      , _nulls (0)
+      {
+        clear ();
+      }
+
+      Type
+      type () const noexcept
+      {
+        return _type;
+      }
+
+      const std::string&
+      name () const noexcept
+      {
+        return _name;
+      }
+
+      // no more type changes, columns without values become Text
+      void
+      fix ()
+      {
+        if (_type == Type::Null)
+          setType (Type::Text);
+        _fixed = true;
+      }
+
+      void
+      append (sqlite3_stmt* stmt, int idx)
+      {
+        const Type storage = internal::storageType (stmt, idx);
+
+        if (_length % 8 == 0)
+          _buffers->validity.push_back (0);
+
+        if (storage == Type::Null)
+          {
+            appendNull ();
+            return;
+          }
+
+        if (storage != _type)
+          adapt (storage);
+
+        _buffers->validity.back ()
+            |= static_cast<uint8_t> (1u << (_length % 8));
+
+        switch (_type)
+          {
+          case Type::Int:
+            _buffers->ints.push_back (sqlite3_column_int64 (stmt, idx));
+            break;
+
+          case Type::Real:
+            _buffers->reals.push_back (sqlite3_column_double (stmt, idx));
+            break;
+
+          default:
+            {
+              internal::appendColumnBytes (
+                  _buffers->bytes, stmt, idx, _type);
+
+              if (_buffers->bytes.size ()
+                  > static_cast<std::size_t> (
+                        std::numeric_limits<int32_t>::max ()))
+                throw ErrOutOfRange ("batch too large for column " + _name);
+
+              _buffers->offsets.push_back (
+                  static_cast<int32_t> (_buffers->bytes.size ()));
+            }
+            break;
+          }
+
+        ++_length;
+      }
+
+      // move the collected values into out
+      void
+      exportTo (ArrowArray* out)
+      {
+        ColumnBuffers* buffers = _buffers.get ();
+        // no pointer of a buffer with data may be null
+        buffers->ints.reserve (1);
+        buffers->reals.reserve (1);
+
+        buffers->buffers[0] = _nulls ? buffers->validity.data () : nullptr;
+        buffers->buffers[2] = buffers->bytes.data ();
+        if (_type == Type::Int)
+          buffers->buffers[1] = buffers->ints.data ();
+        else if (_type == Type::Real)
+          buffers->buffers[1] = buffers->reals.data ();
+        else
+          buffers->buffers[1] = buffers->offsets.data ();
+
+        out->length       = static_cast<int64_t> (_length);
+        out->null_count   = static_cast<int64_t> (_nulls);
+        out->offset       = 0;
+        out->n_buffers    = _type == Type::Int || _type == Type::Real ? 2 : 3;
+        out->n_children   = 0;
+        out->buffers      = buffers->buffers;
+        out->children     = nullptr;
+        out->dictionary   = nullptr;
+        out->release      = &releaseColumn;
+        out->private_data = _buffers.release ();
+
+        clear ();
+      }
+
+    private:
+      void
+      clear ()
+      {
+        _buffers.reset (new ColumnBuffers);
+        _length = 0;
+        _nulls  = 0;
+        if (_type == Type::Text || _type == Type::Blob)
+          _buffers->offsets.push_back (0);
+      }
+
+      void
+      appendNull ()
+      {
+        switch (_type)
+          {
+          case Type::Int:
+            _buffers->ints.push_back (0);
+            break;
+          case Type::Real:
+            _buffers->reals.push_back (0.0);
+            break;
+          case Type::Text:
+          case Type::Blob:
+            _buffers->offsets.push_back (_buffers->offsets.back ());
+            break;
+          default: // no type yet, see setType
+            break;
+          }
+        ++_nulls;
+        ++_length;
+      }
+
+      // a value of an other storage type than the column
+      void
+      adapt (Type storage)
+      {
+        if (_type == Type::Real && storage == Type::Int)
+          return; // sqlite3_column_double converts
+
+        if (!_fixed && _type == Type::Int && storage == Type::Real)
+          {
+            for (auto i : _buffers->ints)
+              _buffers->reals.push_back (static_cast<double> (i));
+            std::vector<int64_t> ().swap (_buffers->ints);
+            _type = Type::Real;
+            return;
+          }
+
+        if (!_fixed && _type == Type::Null)
+          {
+            setType (storage);
+            return;
+          }
+
+        throw ErrTypeMisMatch (typeName (storage) + " value in "
+                               + typeName (_type) + " column " + _name);
+      }
+
+      // the first value of a column, add the nulls before it
+      void
+      setType (Type type)
+      {
+        _type = type;
+        if (_type == Type::Int)
+          _buffers->ints.assign (_length, 0);
+        else if (_type == Type::Real)
+          _buffers->reals.assign (_length, 0.0);
+        else
+          _buffers->offsets.assign (_length + 1, 0);
+      }
+
+      std::string                    _name;
+      Type                           _type;
+      bool                           _fixed;
+      std::size_t                    _length;
+      std::size_t                    _nulls;
+      std::unique_ptr<ColumnBuffers> _buffers;
+    };
+  } // ns
+
+  struct ArrowExporter::Impl
+  {
+    Impl (Command& cmd, std::size_t size)
+    : command (cmd)
+    , batchSize (size)
+    , rows (0)
+    , pending (false)
+    , done (false)
+    , typesKnown (false)
+    {
+    }
+
+    // fetch up to batchSize rows into the builders
+    void
+    fetch ()
+    {
+      // a failed row may be in some builders only, the batch is unusable
+      if (error)
+        std::rethrow_exception (error);
+
+      rows = 0;
+      try
+        {
+          while (!done && rows < batchSize)
+            {
+              if (!command.step ())
+                {
+                  done = true;
+                  command.finish ();
+                  break;
+                }
+
+              for (std::size_t i = 0; i < columns.size (); ++i)
+                columns[i].append (command._stmt, static_cast<int> (i));
+              ++rows;
+            }
+        }
+      catch (...)
+        {
+          error = std::current_exception ();
+          throw;
+        }
+
+      if (!typesKnown)
+        {
+          for (std::size_t i = 0; i < columns.size (); ++i)
+            {
+              columns[i].fix ();
+              types[i] = columns[i].type ();
+            }
+          typesKnown = true;
+        }
+    }
+
+    Command&                   command;
+    std::size_t                batchSize;
+    Types                      types;
+    std::vector<ColumnBuilder> columns;
+    std::size_t                rows;
+    bool                       pending;
+    bool                       done;
+    bool                       typesKnown;
+    std::exception_ptr         error;
+  };
+
+  ArrowExporter::ArrowExporter (Command&        command,
+                                const DbValues& parameters,
+                                const Types&    types,
+                                std::size_t     batchSize)
+  : _impl (new Impl (command, batchSize))
+  {
+    if (batchSize == 0)
+      throw ErrOutOfRange ("batchSize must not be 0");
+
+    // checks the connection, the statement is gone if it is closed
+    command.start (parameters);
+
+    sqlite3_stmt* stmt  = command._stmt;
+    const int     count = sqlite3_column_count (stmt);
+    if (types.size () != 0 && types.size () != static_cast<std::size_t> (count))
+      throw ErrTypeMisMatch ("types.size () != column count");
+
+    Types::container_type resolved;
+    for (int i = 0; i < count; ++i)
+      {
+        const Type  given = types.size () ? types[i] : Type::Variant;
+        const char* name  = sqlite3_column_name (stmt, i);
+        const bool  fixed = given != Type::Variant && given != Type::Null;
+        _impl->columns.emplace_back (name ? name : "",
+                                     fixed ? given : Type::Null);
+        resolved.push_back (fixed ? given : Type::Variant);
+      }
+    _impl->types = Types{resolved};
+  }
+
+  ArrowExporter::~ArrowExporter ()
+  {
+    if (!_impl->done)
+      _impl->command.reset ();
+  }
+
+  void
+  ArrowExporter::exportSchema (ArrowSchema* out)
+  {
+    if (!_impl->typesKnown)
+      {
+        _impl->fetch ();
+        _impl->pending = true;
+      }
+
+    const auto& columns = _impl->columns;
+
+    std::unique_ptr<SchemaData> data (new SchemaData);
+    data->children.resize (columns.size ());
+    for (std::size_t i = 0; i < columns.size (); ++i)
+      {
+        ArrowSchema& child = data->children[i];
+        auto         field = new FieldData{columns[i].name ()};
+        child.format       = arrowFormat (columns[i].type ());
+        child.name         = field->name.c_str ();
+        child.metadata     = nullptr;
+        child.flags        = ARROW_FLAG_NULLABLE;
+        child.n_children   = 0;
+        child.children     = nullptr;
+        child.dictionary   = nullptr;
+        child.release      = &releaseField;
+        child.private_data = field;
+        data->pointers.push_back (&child);
+      }
+
+    out->format       = "+s";
+    out->name         = "";
+    out->metadata     = nullptr;
+    out->flags        = 0;
+    out->n_children   = static_cast<int64_t> (columns.size ());
+    out->children     = data->pointers.data ();
+    out->dictionary   = nullptr;
+    out->release      = &releaseSchema;
+    out->private_data = data.release ();
+  }
+
+  bool
+  ArrowExporter::exportNext (ArrowArray* out)
+  {
+    if (!_impl->pending)
+      _impl->fetch ();
+    _impl->pending = false;
+
+    if (_impl->rows == 0)
+      {
+        out->release = nullptr;
+        return false;
+      }
+
+    auto& columns = _impl->columns;
+
+    std::unique_ptr<BatchData> batch (new BatchData);
+    batch->buffers[0] = nullptr;
+    batch->children.resize (columns.size ());
+    for (std::size_t i = 0; i < columns.size (); ++i)
+      {
+        columns[i].exportTo (&batch->children[i]);
+        batch->pointers.push_back (&batch->children[i]);
+      }
+
+    out->length       = static_cast<int64_t> (_impl->rows);
+    out->null_count   = 0;
+    out->offset       = 0;
+    out->n_buffers    = 1;
+    out->n_children   = static_cast<int64_t> (columns.size ());
+    out->buffers      = batch->buffers;
+    out->children     = batch->pointers.data ();
+    out->dictionary   = nullptr;
+    out->release      = &releaseBatch;
+    out->private_data = batch.release ();
+
+    return true;
+  }
+
+  const Types&
+  ArrowExporter::types () const noexcept
+  {
+    return _impl->types;
+  }
+}
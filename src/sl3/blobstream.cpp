@@ -0,0 +1,323 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/blobstream.hpp>
+
+#include <algorithm>
+
+#include <sqlite3.h>
+
+#include "connection.hpp"
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  namespace
+  {
+    sqlite3_blob*
+    openBlob (sqlite3*           db,
+              const std::string& dbname,
+              const std::string& table,
+              const std::string& column,
+              int64_t            rowid,
+              BlobStream::Mode   mode)
+    {
+      if (db == nullptr)
+        throw ErrNoConnection{};
+
+      sqlite3_blob* blob = nullptr;
+      int           rc   = sqlite3_blob_open (db,
+                                      dbname.c_str (),
+                                      table.c_str (),
+                                      column.c_str (),
+                                      rowid,
+                                      static_cast<int> (mode),
+                                      &blob);
+      if (rc != SQLITE_OK)
+        {
+          // on error, sqlite might still have created a handle
+          sqlite3_blob_close (blob);
+          throw SQLite3Error{rc, sqlite3_errmsg (db)};
+        }
+
+      return blob;
+    }
+
+    void
+    closeBlob (void* blob)
+    {
+      sqlite3_blob_close (static_cast<sqlite3_blob*> (blob));
+    }
+
+  } // ns
+
+  BlobStream::BlobStream (Connection         connection,
+                          const std::string& dbname,
+                          const std::string& table,
+                          const std::string& column,
+                          int64_t            rowid,
+                          Mode               mode)
+  : _connection (std::move (connection))
+  , _blob (openBlob (_connection->db (), dbname, table, column, rowid, mode))
+  , _rowid (rowid)
+  , _mode (mode)
+  {
+    // an open blob lets sqlite3_close fail, close it with the database
+    _connection->closeHandlers[_blob] = &closeBlob;
+  }
+
+  BlobStream::BlobStream (BlobStream&& other) noexcept
+  : _connection (std::move (other._connection))
+  , _blob (other._blob)
+  , _rowid (other._rowid)
+  , _mode (other._mode)
+  { // clear blob so that d'tor of other does no action
+    other._blob = nullptr;
+  }
+
+  BlobStream::~BlobStream ()
+  {
+    // if the connection is closed, its close handler closed the blob
+    if (_blob && _connection->isValid ())
+      {
+        _connection->closeHandlers.erase (_blob);
+        sqlite3_blob_close (_blob);
+      }
+  }
+
+  void
+  BlobStream::ensureOpen () const
+  {
+    if (_blob == nullptr || !_connection->isValid ())
+      throw ErrNoConnection{};
+  }
+
+  std::size_t
+  BlobStream::size () const
+  {
+    ensureOpen ();
+    return static_cast<std::size_t> (sqlite3_blob_bytes (_blob));
+  }
+
+  int64_t
+  BlobStream::rowid () const
+  {
+    return _rowid;
+  }
+
+  BlobStream::Mode
+  BlobStream::mode () const
+  {
+    return _mode;
+  }
+
+  std::size_t
+  BlobStream::read (char* buffer, std::size_t count, std::size_t offset)
+  {
+    const std::size_t blobsize = size ();
+
+    if (offset > blobsize)
+      throw ErrOutOfRange ("blob offset out of range");
+
+    const std::size_t n = std::min (count, blobsize - offset);
+    if (n == 0)
+      return 0;
+
+    int rc = sqlite3_blob_read (
+        _blob, buffer, static_cast<int> (n), static_cast<int> (offset));
+
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errmsg (_connection->db ())};
+
+    return n;
+  }
+
+  void
+  BlobStream::write (const char* data, std::size_t count, std::size_t offset)
+  {
+    const std::size_t blobsize = size ();
+
+    if (offset > blobsize || count > blobsize - offset)
+      throw ErrOutOfRange ("blob write out of range");
+
+    if (count == 0)
+      return;
+
+    int rc = sqlite3_blob_write (
+        _blob, data, static_cast<int> (count), static_cast<int> (offset));
+
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errmsg (_connection->db ())};
+  }
+
+  void
+  BlobStream::readChunks (const ChunkCallback& cb, std::size_t chunkSize)
+  {
+    ASSERT_EXCEPT (chunkSize > 0, ErrOutOfRange);
+
+    const std::size_t blobsize = size ();
+    std::vector<char> chunk (std::min (chunkSize, blobsize));
+
+    std::size_t offset = 0;
+    while (offset < blobsize)
+      {
+        const std::size_t n = read (chunk.data (), chunk.size (), offset);
+        offset += n;
+        if (!cb (chunk.data (), n))
+          break;
+      }
+  }
+
+  void
+  BlobStream::reopen (int64_t rowid)
+  {
+    ensureOpen ();
+
+    int rc = sqlite3_blob_reopen (_blob, rowid);
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errmsg (_connection->db ())};
+
+    _rowid = rowid;
+  }
+
+  void
+  BlobStream::close ()
+  {
+    if (_blob == nullptr)
+      return;
+
+    sqlite3_blob* blob = _blob;
+    _blob              = nullptr;
+
+    if (_connection->isValid ())
+      {
+        _connection->closeHandlers.erase (blob);
+        int rc = sqlite3_blob_close (blob);
+        if (rc != SQLITE_OK)
+          throw SQLite3Error{rc, sqlite3_errmsg (_connection->db ())};
+      }
+  }
+
+  //----------------------------------------------------------------------------
+
+  BlobStreamBuf::BlobStreamBuf (BlobStream& blob, std::size_t bufferSize)
+  : _blob (blob)
+  , _buffer (std::max<std::size_t> (bufferSize, 1))
+  , _pos (0)
+  {
+  }
+
+  BlobStreamBuf::~BlobStreamBuf ()
+  {
+    try
+      {
+        flush ();
+      }
+    catch (...) // LCOV_EXCL_LINE
+      {
+      }
+  }
+
+  std::size_t
+  BlobStreamBuf::position () const
+  {
+    if (eback ())
+      return _pos + static_cast<std::size_t> (gptr () - eback ());
+
+    if (pbase ())
+      return _pos + static_cast<std::size_t> (pptr () - pbase ());
+
+    return _pos;
+  }
+
+  bool
+  BlobStreamBuf::flush ()
+  {
+    if (pbase ())
+      {
+        const std::size_t n = static_cast<std::size_t> (pptr () - pbase ());
+        setp (nullptr, nullptr);
+        _blob.write (_buffer.data (), n, _pos);
+        _pos += n;
+      }
+    else if (eback ())
+      {
+        _pos = position ();
+        setg (nullptr, nullptr, nullptr);
+      }
+
+    return true;
+  }
+
+  BlobStreamBuf::int_type
+  BlobStreamBuf::underflow ()
+  {
+    flush ();
+
+    const std::size_t n = _blob.read (_buffer.data (), _buffer.size (), _pos);
+    if (n == 0)
+      return traits_type::eof ();
+
+    setg (_buffer.data (), _buffer.data (), _buffer.data () + n);
+    return traits_type::to_int_type (*gptr ());
+  }
+
+  BlobStreamBuf::int_type
+  BlobStreamBuf::overflow (int_type c)
+  {
+    flush ();
+
+    const std::size_t blobsize = _blob.size ();
+    if (_pos >= blobsize)
+      return traits_type::eof ();
+
+    const std::size_t room = std::min (_buffer.size (), blobsize - _pos);
+    setp (_buffer.data (), _buffer.data () + room);
+
+    if (!traits_type::eq_int_type (c, traits_type::eof ()))
+      {
+        *pptr () = traits_type::to_char_type (c);
+        pbump (1);
+      }
+
+    return traits_type::not_eof (c);
+  }
+
+  int
+  BlobStreamBuf::sync ()
+  {
+    return flush () ? 0 : -1;
+  }
+
+  BlobStreamBuf::pos_type
+  BlobStreamBuf::seekoff (off_type off,
+                          std::ios_base::seekdir dir,
+                          std::ios_base::openmode)
+  {
+    off_type base = 0;
+    if (dir == std::ios_base::cur)
+      base = static_cast<off_type> (position ());
+    else if (dir == std::ios_base::end)
+      base = static_cast<off_type> (_blob.size ());
+
+    const off_type target = base + off;
+    if (target < 0 || target > static_cast<off_type> (_blob.size ()))
+      return pos_type (off_type (-1));
+
+    flush ();
+    _pos = static_cast<std::size_t> (target);
+    return pos_type (target);
+  }
+
+  BlobStreamBuf::pos_type
+  BlobStreamBuf::seekpos (pos_type pos, std::ios_base::openmode which)
+  {
+    return seekoff (off_type (pos), std::ios_base::beg, which);
+  }
+
+} // ns
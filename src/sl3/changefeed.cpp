@@ -0,0 +1,229 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include "changefeed.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <tuple>
+
+namespace sl3
+{
+  namespace internal
+  {
+    ChangeFeed::ChangeFeed (sqlite3*           db,
+                            ChangeCallback     cb,
+                            ChangeBatchOptions options)
+    : _db (db)
+    , _cb (std::move (cb))
+    , _options (options)
+    {
+      sqlite3_update_hook (_db, &ChangeFeed::onUpdate, this);
+      sqlite3_commit_hook (_db, &ChangeFeed::onCommit, this);
+      sqlite3_rollback_hook (_db, &ChangeFeed::onRollback, this);
+    }
+
+    ChangeFeed::~ChangeFeed ()
+    {
+      sqlite3_update_hook (_db, nullptr, nullptr);
+      sqlite3_commit_hook (_db, nullptr, nullptr);
+      sqlite3_rollback_hook (_db, nullptr, nullptr);
+    }
+
+    void
+    ChangeFeed::onUpdate (void*         self,
+                          int           op,
+                          const char*   database,
+                          const char*   table,
+                          sqlite3_int64 rowid)
+    {
+      auto feed = static_cast<ChangeFeed*> (self);
+
+      Change::Operation operation = Change::Operation::Update;
+      if (op == SQLITE_INSERT)
+        operation = Change::Operation::Insert;
+      else if (op == SQLITE_DELETE)
+        operation = Change::Operation::Delete;
+
+      feed->_pending.push_back (
+          Change{operation, database, table, static_cast<int64_t> (rowid)});
+    }
+
+    int
+    ChangeFeed::onCommit (void* self)
+    {
+      auto feed = static_cast<ChangeFeed*> (self);
+
+      // the commit might still fail, for example with SQLITE_BUSY,
+      // deliver checks if it did
+      auto& pending    = feed->_pending;
+      auto& committing = feed->_committing;
+      committing.insert (committing.end (),
+                         std::make_move_iterator (pending.begin ()),
+                         std::make_move_iterator (pending.end ()));
+      pending.clear ();
+      feed->_marks.clear ();
+
+      return 0; // let the commit proceed
+    }
+
+    void
+    ChangeFeed::onRollback (void* self)
+    {
+      auto feed = static_cast<ChangeFeed*> (self);
+      feed->_pending.clear ();
+      feed->_committing.clear (); // a failed commit, rolled back now
+      feed->_marks.clear ();
+    }
+
+    void
+    ChangeFeed::mark (int level)
+    {
+      if (level < 0)
+        return;
+
+      const auto idx = static_cast<std::size_t> (level);
+      if (_marks.size () <= idx)
+        _marks.resize (idx + 1, 0);
+
+      _marks[idx] = _pending.size ();
+    }
+
+    void
+    ChangeFeed::rollbackTo (int level)
+    {
+      const auto idx = static_cast<std::size_t> (level);
+      if (level < 0 || idx >= _marks.size ())
+        return;
+
+      if (_marks[idx] < _pending.size ())
+        _pending.resize (_marks[idx]);
+    }
+
+    std::vector<Change>
+    ChangeFeed::coalesced (std::vector<Change> changes) const
+    {
+      using Key = std::tuple<std::string, std::string, int64_t>;
+
+      std::map<Key, std::size_t> index;
+      std::vector<Change>        result;
+      std::vector<bool>          dropped;
+
+      for (auto& change : changes)
+        {
+          Key  key{change.database, change.table, change.rowid};
+          auto it = index.find (key);
+          if (it == index.end () || dropped[it->second])
+            {
+              index[key] = result.size ();
+              result.push_back (std::move (change));
+              dropped.push_back (false);
+              continue;
+            }
+
+          auto& prev = result[it->second].operation;
+          switch (change.operation)
+            {
+            case Change::Operation::Insert:
+              // deleted and inserted again, the row has new content
+              prev = Change::Operation::Update;
+              break;
+
+            case Change::Operation::Update:
+              // an insert or delete stays what it is
+              break;
+
+            case Change::Operation::Delete:
+              if (prev == Change::Operation::Insert)
+                dropped[it->second] = true; // never visible outside
+              else
+                prev = Change::Operation::Delete;
+              break;
+            }
+        }
+
+      std::size_t out = 0;
+      for (std::size_t i = 0; i < result.size (); ++i)
+        {
+          if (!dropped[i])
+            {
+              if (out != i)
+                result[out] = std::move (result[i]);
+              ++out;
+            }
+        }
+      result.resize (out);
+
+      return result;
+    }
+
+    void
+    ChangeFeed::confirmCommit ()
+    {
+      // if the commit failed, the transaction is still open
+      if (_committing.empty () || !sqlite3_get_autocommit (_db))
+        return;
+
+      _committed.insert (_committed.end (),
+                         std::make_move_iterator (_committing.begin ()),
+                         std::make_move_iterator (_committing.end ()));
+      _committing.clear ();
+    }
+
+    void
+    ChangeFeed::deliver ()
+    {
+      // a callback running a statement would come here again
+      if (_delivering)
+        return;
+
+      confirmCommit ();
+      if (_committed.empty ())
+        return;
+
+      struct Guard
+      {
+        bool& flag;
+        ~Guard () { flag = false; }
+      } guard{_delivering};
+      _delivering = true;
+
+      while (!_committed.empty ())
+        {
+          std::vector<Change> changes;
+          changes.swap (_committed);
+
+          if (_options.coalesce)
+            changes = coalesced (std::move (changes));
+
+          const std::size_t batch
+              = _options.maxBatchSize > 0 ? _options.maxBatchSize
+                                          : changes.size ();
+
+          for (std::size_t begin = 0; begin < changes.size (); begin += batch)
+            {
+              const std::size_t end = std::min (begin + batch, changes.size ());
+              if (begin == 0 && end == changes.size ())
+                {
+                  _cb (changes);
+                }
+              else
+                {
+                  const std::vector<Change> part (changes.begin () + begin,
+                                                  changes.begin () + end);
+                  _cb (part);
+                }
+            }
+
+          // the callback might have committed more changes
+          confirmCommit ();
+        }
+    }
+  }
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_CHANGEFEED_HPP_
+#define SL3_CHANGEFEED_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include <sl3/changes.hpp>
+
+namespace sl3
+{
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Collects changes via sqlite hooks
+     *
+     * The update hook appends to the pending list, the commit hook moves
+     * pending changes to the committing list, the rollback hook drops
+     * both. The commit hook runs before the commit is done, so deliver
+     * moves the committing changes to the committed list only once the
+     * connection is back in autocommit mode, the commit has succeeded then.
+     * Hooks must not use the connection, so committed changes are
+     * delivered later, via deliver, after a statement has finished.
+     */
+    class ChangeFeed
+    {
+    public:
+      ChangeFeed (sqlite3* db, ChangeCallback cb, ChangeBatchOptions options);
+      ~ChangeFeed ();
+
+      ChangeFeed (const ChangeFeed&) = delete;
+      ChangeFeed& operator= (const ChangeFeed&) = delete;
+
+      /// remember the pending position for a savepoint level
+      void mark (int level);
+
+      /// drop pending changes since the mark of level
+      void rollbackTo (int level);
+
+      /// call the callback with committed changes, if any
+      void deliver ();
+
+    private:
+      static void onUpdate (void*         self,
+                            int           op,
+                            const char*   database,
+                            const char*   table,
+                            sqlite3_int64 rowid);
+      static int  onCommit (void* self);
+      static void onRollback (void* self);
+
+      void confirmCommit ();
+
+      std::vector<Change> coalesced (std::vector<Change> changes) const;
+
+      sqlite3*                 _db;
+      ChangeCallback           _cb;
+      ChangeBatchOptions       _options;
+      std::vector<Change>      _pending;
+      std::vector<Change>      _committing;
+      std::vector<Change>      _committed;
+      std::vector<std::size_t> _marks;
+      bool                     _delivering{false};
+    };
+  }
+  /// \endcond
+}
+
+#endif
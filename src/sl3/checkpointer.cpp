@@ -0,0 +1,258 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include "checkpointer.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  namespace internal
+  {
+    namespace
+    {
+      // WAL frame header size, see https://www.sqlite.org/fileformat.html
+      constexpr std::size_t walFrameHeader = 24;
+
+      std::string
+      pragma (sqlite3* db, const char* sql)
+      {
+        sqlite3_stmt* stmt = nullptr;
+        int           rc   = sqlite3_prepare_v2 (db, sql, -1, &stmt, nullptr);
+        using scope_guard
+            = std::unique_ptr<sqlite3_stmt, decltype (&sqlite3_finalize)>;
+        scope_guard guard{stmt, &sqlite3_finalize};
+
+        if (rc == SQLITE_OK)
+          rc = sqlite3_step (stmt);
+
+        if (rc != SQLITE_ROW)
+          throw SQLite3Error{rc, sqlite3_errmsg (db)};
+
+        auto text = sqlite3_column_text (stmt, 0);
+        return text ? reinterpret_cast<const char*> (text) : "";
+      }
+
+      long long
+      pragmaNumber (sqlite3* db, const char* sql)
+      {
+        const auto text   = pragma (db, sql);
+        char*      end    = nullptr;
+        errno             = 0;
+        const auto number = std::strtoll (text.c_str (), &end, 10);
+        if (text.empty () || *end != '\0' || errno == ERANGE)
+          throw SQLite3Error{SQLITE_ERROR,
+                             "unexpected pragma result",
+                             std::string{sql} + " returned " + text};
+
+        return number;
+      }
+
+      int
+      sqliteMode (CheckpointMode mode)
+      {
+        switch (mode)
+          {
+          case CheckpointMode::Full:
+            return SQLITE_CHECKPOINT_FULL;
+          case CheckpointMode::Truncate:
+            return SQLITE_CHECKPOINT_TRUNCATE;
+          default:
+            return SQLITE_CHECKPOINT_PASSIVE;
+          }
+      }
+    } // ns
+
+    Checkpointer::Checkpointer (sqlite3* db, CheckpointOptions options)
+    : _db (db)
+    , _options (options)
+    {
+      if (sqlite3_threadsafe () == 0)
+        throw SQLite3Error{SQLITE_MISUSE,
+                           "background checkpoints need a threadsafe sqlite"};
+
+      const char* filename = sqlite3_db_filename (_db, "main");
+      if (filename == nullptr || std::strlen (filename) == 0)
+        throw SQLite3Error{SQLITE_MISUSE,
+                           "background checkpoints need a database file"};
+
+      // the same VFS, and so the same locking, as the database
+      sqlite3_vfs* vfs = nullptr;
+      sqlite3_file_control (_db, "main", SQLITE_FCNTL_VFS_POINTER, &vfs);
+
+      int rc = sqlite3_open_v2 (filename,
+                                &_own,
+                                SQLITE_OPEN_READWRITE,
+                                vfs ? vfs->zName : nullptr);
+      using scope_guard = std::unique_ptr<sqlite3, decltype (&sqlite3_close)>;
+      scope_guard guard{_own, &sqlite3_close};
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (_own)};
+
+      if (pragma (_own, "PRAGMA journal_mode;") != "wal")
+        throw SQLite3Error{SQLITE_MISUSE,
+                           "background checkpoints need journal_mode WAL"};
+
+      const auto pageSize = pragmaNumber (_own, "PRAGMA page_size;");
+      if (pageSize <= 0)
+        throw SQLite3Error{SQLITE_ERROR, "invalid page_size"};
+      _frameSize = static_cast<std::size_t> (pageSize) + walFrameHeader;
+
+      // restored on stop, 0 if auto checkpoints are off
+      _autoCheckpoint = static_cast<int> (
+          pragmaNumber (_db, "PRAGMA wal_autocheckpoint;"));
+
+      sqlite3_busy_timeout (_own,
+                            static_cast<int> (_options.busyTimeout.count ()));
+
+      _thread = std::thread (&Checkpointer::run, this);
+      guard.release ();
+
+      // replaces the auto checkpoint hook
+      sqlite3_wal_hook (_db, &Checkpointer::onWal, this);
+    }
+
+    Checkpointer::~Checkpointer ()
+    {
+      // replaces onWal
+      sqlite3_wal_autocheckpoint (_db, _autoCheckpoint);
+
+      {
+        std::lock_guard<std::mutex> lock (_mutex);
+        _stop = true;
+      }
+      _wake.notify_one ();
+      _thread.join ();
+
+      sqlite3_close (_own);
+    }
+
+    CheckpointMetrics
+    Checkpointer::metrics () const
+    {
+      std::lock_guard<std::mutex> lock (_mutex);
+      return _metrics;
+    }
+
+    int
+    Checkpointer::onWal (void* self, sqlite3*, const char* dbname, int frames)
+    {
+      auto cp = static_cast<Checkpointer*> (self);
+      if (std::strcmp (dbname, "main") != 0)
+        return SQLITE_OK;
+
+      {
+        std::lock_guard<std::mutex> lock (cp->_mutex);
+
+        const auto total = static_cast<std::size_t> (frames);
+        if (total < cp->_walTotal) // the WAL has been restarted
+          cp->_checkpointed = 0;
+        cp->_walTotal = total;
+        cp->setPending (total - std::min (total, cp->_checkpointed));
+
+        cp->_lastWrite = Clock::now ();
+        cp->_signaled  = true;
+        cp->_idleDone  = false;
+      }
+      cp->_wake.notify_one ();
+
+      return SQLITE_OK;
+    }
+
+    void
+    Checkpointer::setPending (std::size_t frames)
+    {
+      _metrics.walFrames = frames;
+      _metrics.walBytes  = frames * _frameSize;
+      if (frames > _metrics.maxWalFrames)
+        _metrics.maxWalFrames = frames;
+    }
+
+    void
+    Checkpointer::run ()
+    {
+      std::unique_lock<std::mutex> lock (_mutex);
+      auto wakeup = [this]() { return _stop || _signaled; };
+
+      while (!_stop)
+        {
+          if (_signaled)
+            {
+              // at most one checkpoint per commit, a busy one is retried
+              // with the next commit or when idle
+              _signaled            = false;
+              const auto pending = _metrics.walFrames;
+              if (pending >= _options.truncateFrames)
+                checkpoint (lock, CheckpointMode::Truncate);
+              else if (pending >= _options.fullFrames)
+                checkpoint (lock, CheckpointMode::Full);
+              else if (pending >= _options.passiveFrames)
+                checkpoint (lock, CheckpointMode::Passive);
+              continue;
+            }
+
+          if (_idleDone || _walTotal == 0)
+            {
+              _wake.wait (lock, wakeup);
+              continue;
+            }
+
+          if (Clock::now () - _lastWrite >= _options.idleTime)
+            {
+              _idleDone = true;
+              checkpoint (lock, CheckpointMode::Truncate);
+              continue;
+            }
+
+          _wake.wait_until (lock, _lastWrite + _options.idleTime, wakeup);
+        }
+    }
+
+    void
+    Checkpointer::checkpoint (std::unique_lock<std::mutex>& lock,
+                              CheckpointMode                mode)
+    {
+      int log = -1, done = -1;
+
+      lock.unlock ();
+      const auto start = Clock::now ();
+      const int  rc    = sqlite3_wal_checkpoint_v2 (
+          _own, "main", sqliteMode (mode), &log, &done);
+      const auto duration = std::chrono::duration_cast<std::chrono::microseconds> (
+          Clock::now () - start);
+      lock.lock ();
+
+      _metrics.checkpoints += 1;
+      _metrics.lastMode      = mode;
+      _metrics.lastDuration  = duration;
+      _metrics.totalDuration += duration;
+      if (duration > _metrics.maxDuration)
+        _metrics.maxDuration = duration;
+
+      if ((rc & 0xff) == SQLITE_BUSY || (rc & 0xff) == SQLITE_LOCKED)
+        _metrics.busy += 1;
+      else if (rc != SQLITE_OK)
+        _metrics.errors += 1;
+
+      if (log < 0 || done < 0)
+        return;
+
+      // a commit during the checkpoint has reported a newer total
+      if (!_signaled)
+        _walTotal = static_cast<std::size_t> (log);
+      _checkpointed = static_cast<std::size_t> (done);
+      setPending (_walTotal - std::min (_walTotal, _checkpointed));
+    }
+  }
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_CHECKPOINTER_HPP_
+#define SL3_CHECKPOINTER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+#include <sqlite3.h>
+
+#include <sl3/checkpoint.hpp>
+
+namespace sl3
+{
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Runs WAL checkpoints in a background thread
+     *
+     * Replaces the auto checkpoint of db by a wal hook that only records
+     * the WAL size and wakes the thread. The thread checkpoints the main
+     * database via an own connection, so writers on db never run a
+     * checkpoint inline.
+     * The destructor stops the thread and restores the auto checkpoint.
+     */
+    class Checkpointer
+    {
+    public:
+      Checkpointer (sqlite3* db, CheckpointOptions options);
+      ~Checkpointer ();
+
+      Checkpointer (const Checkpointer&) = delete;
+      Checkpointer& operator= (const Checkpointer&) = delete;
+
+      /// a copy of the current metrics
+      CheckpointMetrics metrics () const;
+
+    private:
+      using Clock = std::chrono::steady_clock;
+
+      static int onWal (void* self, sqlite3*, const char* dbname, int frames);
+
+      void run ();
+      void checkpoint (std::unique_lock<std::mutex>& lock, CheckpointMode mode);
+      void setPending (std::size_t frames);
+
+      sqlite3*          _db;
+      sqlite3*          _own{nullptr};
+      CheckpointOptions _options;
+      std::size_t       _frameSize{0};
+      int               _autoCheckpoint{0};
+
+      mutable std::mutex      _mutex;
+      std::condition_variable _wake;
+      bool                    _stop{false};
+      bool                    _signaled{false};
+      bool                    _idleDone{true};
+      std::size_t             _walTotal{0};
+      std::size_t             _checkpointed{0};
+      Clock::time_point       _lastWrite;
+      CheckpointMetrics       _metrics;
+
+      std::thread _thread;
+    };
+  }
+  /// \endcond
+}
+
+#endif
@@ -0,0 +1,237 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/collation.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#include <sqlite3.h>
+
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  namespace
+  {
+    inline bool
+    isDigit (char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    inline unsigned char
+    asciiLower (char c)
+    {
+      const auto u = static_cast<unsigned char> (c);
+      return (u >= 'A' && u <= 'Z') ? static_cast<unsigned char> (u + 32) : u;
+    }
+
+    inline int
+    compareSize (std::size_t a, std::size_t b)
+    {
+      return a < b ? -1 : (a > b ? 1 : 0);
+    }
+
+    int
+    compareBytes (const char* a, std::size_t na, const char* b, std::size_t nb)
+    {
+      const std::size_t n  = std::min (na, nb);
+      const int         rc = n ? std::memcmp (a, b, n) : 0;
+      return rc != 0 ? rc : compareSize (na, nb);
+    }
+
+    struct CollationData
+    {
+      CollationCompare cmp;
+    };
+
+    int
+    collationCompare (void* p, int na, const void* a, int nb, const void* b)
+    {
+      auto data = static_cast<CollationData*> (p);
+      try
+        {
+          return data->cmp (static_cast<const char*> (a),
+                            static_cast<std::size_t> (na),
+                            static_cast<const char*> (b),
+                            static_cast<std::size_t> (nb));
+        }
+      catch (...) // sqlite has no way to report an error from here
+        {
+          return compareBytes (static_cast<const char*> (a),
+                               static_cast<std::size_t> (na),
+                               static_cast<const char*> (b),
+                               static_cast<std::size_t> (nb));
+        }
+    }
+
+    void
+    collationDestroy (void* p)
+    {
+      delete static_cast<CollationData*> (p);
+    }
+
+    /*
+     * Computes sort keys on demand and keeps up to cacheSize of them.
+     * Sorting and index lookups compare the same strings many times,
+     * so most comparisons become a memcmp of two cached keys.
+     * The cache is dropped as a whole when full, this is cheap and good
+     * enough for the access pattern of a sort.
+     */
+    class SortKeyCache
+    {
+    public:
+      SortKeyCache (SortKeyFunction key, std::size_t cacheSize)
+      : _key (std::move (key))
+      , _cacheSize (cacheSize)
+      {
+      }
+
+      int
+      operator() (const char* a, std::size_t na, const char* b, std::size_t nb)
+      {
+        if (_cacheSize < 2)
+          {
+            const std::string ka = _key (a, na);
+            const std::string kb = _key (b, nb);
+            return compareBytes (ka.data (), ka.size (), kb.data (), kb.size ());
+          }
+
+        // make room first, so that the first key stays valid
+        if (_cache.size () + 2 > _cacheSize)
+          _cache.clear ();
+
+        const std::string& ka = lookup (a, na);
+        const std::string& kb = lookup (b, nb);
+        return compareBytes (ka.data (), ka.size (), kb.data (), kb.size ());
+      }
+
+    private:
+      const std::string&
+      lookup (const char* s, std::size_t n)
+      {
+        _probe.assign (s, n);
+        auto it = _cache.find (_probe);
+        if (it == _cache.end ())
+          it = _cache.emplace (_probe, _key (s, n)).first;
+
+        return it->second;
+      }
+
+      SortKeyFunction                              _key;
+      std::size_t                                  _cacheSize;
+      std::string                                  _probe;
+      std::unordered_map<std::string, std::string> _cache;
+    };
+
+  } // ns
+
+  int
+  naturalCompare (const char* a, std::size_t na, const char* b, std::size_t nb)
+  {
+    std::size_t i = 0, j = 0;
+    int         zeros = 0; // tie breaker for numbers with leading zeros
+
+    while (i < na && j < nb)
+      {
+        if (isDigit (a[i]) && isDigit (b[j]))
+          {
+            std::size_t si = i, sj = j;
+            while (si < na && a[si] == '0')
+              ++si;
+            while (sj < nb && b[sj] == '0')
+              ++sj;
+
+            std::size_t ei = si, ej = sj;
+            while (ei < na && isDigit (a[ei]))
+              ++ei;
+            while (ej < nb && isDigit (b[ej]))
+              ++ej;
+
+            // more significant digits is the bigger number
+            int rc = compareSize (ei - si, ej - sj);
+            if (rc == 0 && ei > si)
+              rc = std::memcmp (a + si, b + sj, ei - si);
+            if (rc != 0)
+              return rc;
+
+            if (zeros == 0)
+              zeros = compareSize (si - i, sj - j);
+
+            i = ei;
+            j = ej;
+          }
+        else
+          {
+            const auto ca = static_cast<unsigned char> (a[i]);
+            const auto cb = static_cast<unsigned char> (b[j]);
+            if (ca != cb)
+              return ca < cb ? -1 : 1;
+            ++i;
+            ++j;
+          }
+      }
+
+    const int rc = compareSize (na - i, nb - j);
+    return rc != 0 ? rc : zeros;
+  }
+
+  int
+  asciiNoCaseCompare (const char* a,
+                      std::size_t na,
+                      const char* b,
+                      std::size_t nb)
+  {
+    const std::size_t n = std::min (na, nb);
+    for (std::size_t i = 0; i < n; ++i)
+      {
+        const unsigned char ca = asciiLower (a[i]);
+        const unsigned char cb = asciiLower (b[i]);
+        if (ca != cb)
+          return ca < cb ? -1 : 1;
+      }
+    return compareSize (na, nb);
+  }
+
+  namespace internal
+  {
+    void
+    createCollation (sqlite3* db, const std::string& name, CollationCompare cmp)
+    {
+      ASSERT_EXCEPT (cmp, ErrUnexpected);
+
+      // xDestroy is not called if the registration fails
+      std::unique_ptr<CollationData> data{new CollationData{std::move (cmp)}};
+
+      int rc = sqlite3_create_collation_v2 (db,
+                                            name.c_str (),
+                                            SQLITE_UTF8,
+                                            data.get (),
+                                            &collationCompare,
+                                            &collationDestroy);
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (db)};
+
+      data.release ();
+    }
+
+    void
+    createSortKeyCollation (sqlite3*           db,
+                            const std::string& name,
+                            SortKeyFunction    key,
+                            std::size_t        cacheSize)
+    {
+      ASSERT_EXCEPT (key, ErrUnexpected);
+
+      createCollation (db, name, SortKeyCache{std::move (key), cacheSize});
+    }
+  }
+}
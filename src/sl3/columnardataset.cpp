@@ -0,0 +1,373 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/columnardataset.hpp>
+
+#include "stmtcolumn.hpp"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <iterator>
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  namespace
+  {
+    bool
+    hasBytes (Type type)
+    {
+      return type == Type::Text || type == Type::Blob
+             || type == Type::Variant;
+    }
+  } // ns
+
+  Column::Column (Type type)
+  : _type (type)
+  , _size (0)
+  , _nulls (0)
+  {
+    if (hasBytes (_type))
+      _offsets.push_back (0);
+  }
+
+  Type
+  Column::type () const noexcept
+  {
+    return _type;
+  }
+
+  std::size_t
+  Column::size () const noexcept
+  {
+    return _size;
+  }
+
+  std::size_t
+  Column::nullCount () const noexcept
+  {
+    return _nulls;
+  }
+
+  bool
+  Column::isNull (std::size_t row) const
+  {
+    ensureRow (row);
+    return (_validity[row / 64] & (uint64_t{1} << (row % 64))) == 0;
+  }
+
+  DbValue
+  Column::get (std::size_t row) const
+  {
+    ensureRow (row);
+    return value (row);
+  }
+
+  const uint64_t*
+  Column::validity () const noexcept
+  {
+    return _validity.data ();
+  }
+
+  const int64_t*
+  Column::ints () const
+  {
+    if (_type != Type::Int)
+      throw ErrTypeMisMatch ("column type is " + typeName (_type));
+
+    return _ints.data ();
+  }
+
+  const double*
+  Column::reals () const
+  {
+    if (_type != Type::Real)
+      throw ErrTypeMisMatch ("column type is " + typeName (_type));
+
+    return _reals.data ();
+  }
+
+  const std::size_t*
+  Column::offsets () const
+  {
+    if (_type != Type::Text && _type != Type::Blob)
+      throw ErrTypeMisMatch ("column type is " + typeName (_type));
+
+    return _offsets.data ();
+  }
+
+  const char*
+  Column::bytes () const
+  {
+    if (_type != Type::Text && _type != Type::Blob)
+      throw ErrTypeMisMatch ("column type is " + typeName (_type));
+
+    return _bytes.data ();
+  }
+
+  void
+  Column::append (const Columns& columns, int idx)
+  {
+    sqlite3_stmt* stmt = columns.get_stmt ();
+    const Type    type = internal::storageType (stmt, idx);
+
+    if (type != Type::Null && _type != Type::Variant && type != _type)
+      {
+        throw ErrTypeMisMatch (typeName (type) + " value in "
+                               + typeName (_type) + " column");
+      }
+
+    if (_size % 64 == 0)
+      _validity.push_back (0);
+
+    if (_type == Type::Int || _type == Type::Variant)
+      _ints.push_back (type == Type::Int ? sqlite3_column_int64 (stmt, idx)
+                                         : 0);
+
+    if (_type == Type::Real || _type == Type::Variant)
+      _reals.push_back (type == Type::Real ? sqlite3_column_double (stmt, idx)
+                                           : 0.0);
+
+    if (hasBytes (_type))
+      {
+        internal::appendColumnBytes (_bytes, stmt, idx, type);
+        _offsets.push_back (_bytes.size ());
+      }
+
+    if (_type == Type::Variant)
+      _types.push_back (type);
+
+    if (type == Type::Null)
+      ++_nulls;
+    else
+      _validity.back () |= uint64_t{1} << (_size % 64);
+
+    ++_size;
+  }
+
+  void
+  Column::narrow ()
+  {
+    if (_type != Type::Variant || _nulls == _size)
+      return;
+
+    auto type = Type::Null;
+    for (auto t : _types)
+      {
+        if (t == Type::Null)
+          continue;
+
+        if (type == Type::Null)
+          type = t;
+        else if (t != type)
+          return;
+      }
+
+    _type = type;
+    std::vector<Type> ().swap (_types);
+
+    if (_type != Type::Int)
+      std::vector<int64_t> ().swap (_ints);
+
+    if (_type != Type::Real)
+      std::vector<double> ().swap (_reals);
+
+    if (!hasBytes (_type))
+      {
+        std::vector<std::size_t> ().swap (_offsets);
+        std::string ().swap (_bytes);
+      }
+  }
+
+  void
+  Column::ensureRow (std::size_t row) const
+  {
+    if (row >= _size)
+      throw ErrOutOfRange ("no data at: " + std::to_string (row));
+  }
+
+  DbValue
+  Column::value (std::size_t row) const
+  {
+    auto type = _type;
+    if (type == Type::Variant)
+      type = _types[row];
+    else if ((_validity[row / 64] & (uint64_t{1} << (row % 64))) == 0)
+      type = Type::Null;
+
+    switch (type)
+      {
+      case Type::Int:
+        return DbValue (_ints[row], _type);
+
+      case Type::Real:
+        return DbValue (_reals[row], _type);
+
+      case Type::Text:
+        return DbValue (std::string (_bytes.data () + _offsets[row],
+                                     _bytes.data () + _offsets[row + 1]),
+                        _type);
+
+      case Type::Blob:
+        return DbValue (Blob (_bytes.data () + _offsets[row],
+                              _bytes.data () + _offsets[row + 1]),
+                        _type);
+
+      default:
+        return DbValue (_type);
+      }
+  }
+
+  ColumnarDataset::Row::Row (const ColumnarDataset* ds,
+                             std::size_t            row) noexcept
+  : _ds (ds)
+  , _row (row)
+  {
+  }
+
+  std::size_t
+  ColumnarDataset::Row::size () const noexcept
+  {
+    return _ds->_columns.size ();
+  }
+
+  DbValue ColumnarDataset::Row::operator[] (std::size_t field) const
+  {
+    return _ds->_columns[field].value (_row);
+  }
+
+  DbValue
+  ColumnarDataset::Row::at (std::size_t field) const
+  {
+    return _ds->column (field).get (_row);
+  }
+
+  DbValues
+  ColumnarDataset::Row::values () const
+  {
+    DbValues::container_type v;
+    v.reserve (size ());
+    for (const auto& column : _ds->_columns)
+      v.push_back (column.value (_row));
+
+    return DbValues (std::move (v));
+  }
+
+  ColumnarDataset::ColumnarDataset () noexcept
+  : _size (0)
+  {
+  }
+
+  ColumnarDataset::ColumnarDataset (Types types)
+  : _fieldtypes (std::move (types))
+  , _size (0)
+  {
+  }
+
+  std::size_t
+  ColumnarDataset::size () const noexcept
+  {
+    return _size;
+  }
+
+  std::size_t
+  ColumnarDataset::columnCount () const noexcept
+  {
+    return _columns.size ();
+  }
+
+  const Column&
+  ColumnarDataset::column (std::size_t idx) const
+  {
+    if (idx >= _columns.size ())
+      throw ErrOutOfRange ("no column at: " + std::to_string (idx));
+
+    return _columns[idx];
+  }
+
+  const Column&
+  ColumnarDataset::column (const std::string& name) const
+  {
+    return _columns[getIndex (name)];
+  }
+
+  std::size_t
+  ColumnarDataset::getIndex (const std::string& name) const
+  {
+    using namespace std;
+    auto pos = find (_names.begin (), _names.end (), name);
+    if (pos == _names.end ())
+      throw ErrOutOfRange ("Field name " + name + " not found");
+
+    return distance (_names.begin (), pos);
+  }
+
+  const std::vector<std::string>&
+  ColumnarDataset::getNames () const noexcept
+  {
+    return _names;
+  }
+
+  ColumnarDataset::Row ColumnarDataset::operator[] (std::size_t row) const
+      noexcept
+  {
+    return Row (this, row);
+  }
+
+  ColumnarDataset::Row
+  ColumnarDataset::at (std::size_t row) const
+  {
+    if (row >= _size)
+      throw ErrOutOfRange ("no data at: " + std::to_string (row));
+
+    return Row (this, row);
+  }
+
+  void
+  ColumnarDataset::reset ()
+  {
+    _names.clear ();
+    _columns.clear ();
+    _size = 0;
+  }
+
+  void
+  ColumnarDataset::append (const Columns& columns)
+  {
+    if (_columns.empty ())
+      {
+        const int typeCount = static_cast<int> (_fieldtypes.size ());
+        if (typeCount != 0 && typeCount != columns.count ())
+          {
+            throw ErrTypeMisMatch (
+                "DbValuesTypeList.size != queryrow.getColumnCount()");
+          }
+
+        _names = columns.getNames ();
+        _columns.reserve (_names.size ());
+        for (int i = 0; i < columns.count (); ++i)
+          {
+            _columns.emplace_back (Column (
+                typeCount == 0 ? Type::Variant : _fieldtypes[i]));
+          }
+      }
+
+    for (int i = 0; i < columns.count (); ++i)
+      _columns[i].append (columns, i);
+
+    ++_size;
+  }
+
+  void
+  ColumnarDataset::finish ()
+  {
+    for (auto& column : _columns)
+      column.narrow ();
+  }
+}
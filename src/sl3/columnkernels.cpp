@@ -0,0 +1,629 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/columnkernels.hpp>
+
+#include "simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sl3/error.hpp>
+#include <unordered_map>
+
+namespace sl3
+{
+  namespace
+  {
+    std::atomic<int>&
+    activeLevel ()
+    {
+      static std::atomic<int> level{
+          static_cast<int> (supportedSimdLevel ())};
+      return level;
+    }
+
+    const internal::Kernels&
+    active ()
+    {
+      return internal::kernels (static_cast<SimdLevel> (
+          activeLevel ().load (std::memory_order_relaxed)));
+    }
+
+    unsigned
+    lowestBit (uint64_t bits)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned> (__builtin_ctzll (bits));
+#else
+      unsigned i = 0;
+      while ((bits & 1) == 0)
+        {
+          bits >>= 1;
+          ++i;
+        }
+      return i;
+#endif
+    }
+
+    bool
+    isValid (const uint64_t* validity, std::size_t row)
+    {
+      return (validity[row / 64] >> (row % 64)) & 1;
+    }
+
+    template <typename T>
+    Selection
+    selectRange (const T*        v,
+                 std::size_t     n,
+                 const uint64_t* validity,
+                 T               lo,
+                 T               hi,
+                 uint64_t (*range) (const T*, T, T))
+    {
+      Selection rows;
+      if (hi < lo)
+        return rows;
+
+      // full blocks of 64 rows via the kernel, the rest one by one
+      const std::size_t blocks = n / 64;
+      for (std::size_t b = 0; b < blocks; ++b)
+        {
+          uint64_t bits = validity[b];
+          if (bits)
+            bits &= range (v + b * 64, lo, hi);
+
+          for (; bits; bits &= bits - 1)
+            rows.push_back (b * 64 + lowestBit (bits));
+        }
+
+      for (std::size_t i = blocks * 64; i < n; ++i)
+        {
+          if (isValid (validity, i) && lo <= v[i] && v[i] <= hi)
+            rows.push_back (i);
+        }
+
+      return rows;
+    }
+
+    // the first row from row on that is valid, or null if valid is false
+    std::size_t
+    nextRow (const uint64_t* validity,
+             std::size_t     n,
+             std::size_t     row,
+             bool            valid)
+    {
+      while (row < n)
+        {
+          uint64_t word = validity[row / 64];
+          if (!valid)
+            word = ~word;
+
+          word >>= row % 64;
+          if (word)
+            return std::min (n, row + lowestBit (word));
+
+          row = (row / 64 + 1) * 64;
+        }
+      return n;
+    }
+
+    template <typename T>
+    bool
+    minMax (const T*        v,
+            std::size_t     n,
+            const uint64_t* validity,
+            T*              min,
+            T*              max,
+            void (*kernel) (const T*, std::size_t, T*, T*))
+    {
+      // the kernel runs over each sequence of not null rows
+      bool        found = false;
+      std::size_t begin = nextRow (validity, n, 0, true);
+      while (begin < n)
+        {
+          const std::size_t end = nextRow (validity, n, begin, false);
+          if (!found)
+            {
+              *min = *max = v[begin];
+              found       = true;
+            }
+          kernel (v + begin, end - begin, min, max);
+          begin = nextRow (validity, n, end, true);
+        }
+
+      return found;
+    }
+
+    void
+    ensureNumeric (const Column& column)
+    {
+      if (column.type () != Type::Int && column.type () != Type::Real)
+        throw ErrTypeMisMatch ("column type is " + typeName (column.type ()));
+    }
+
+    void
+    ensureNumeric (const DbValue& value)
+    {
+      if (value.type () != Type::Int && value.type () != Type::Real)
+        throw ErrTypeMisMatch ("value type is " + typeName (value.type ()));
+    }
+
+    // 2^63, the first double above the int64_t range
+    const double int64Limit = 9223372036854775808.0;
+
+    // the smallest int >= value, false if there is none
+    bool
+    intAtLeast (const DbValue& value, int64_t* result)
+    {
+      if (value.type () == Type::Int)
+        {
+          *result = value.getInt ();
+          return true;
+        }
+
+      const double c = std::ceil (value.getReal ());
+      if (c >= int64Limit)
+        return false;
+
+      *result = c < -int64Limit ? std::numeric_limits<int64_t>::min ()
+                                : static_cast<int64_t> (c);
+      return true;
+    }
+
+    // the largest int <= value, false if there is none
+    bool
+    intAtMost (const DbValue& value, int64_t* result)
+    {
+      if (value.type () == Type::Int)
+        {
+          *result = value.getInt ();
+          return true;
+        }
+
+      const double f = std::floor (value.getReal ());
+      if (f < -int64Limit)
+        return false;
+
+      *result = f >= int64Limit ? std::numeric_limits<int64_t>::max ()
+                                : static_cast<int64_t> (f);
+      return true;
+    }
+
+    // the largest int < value, false if there is none
+    bool
+    intBelow (const DbValue& value, int64_t* result)
+    {
+      if (value.type () == Type::Int)
+        {
+          if (value.getInt () == std::numeric_limits<int64_t>::min ())
+            return false;
+
+          *result = value.getInt () - 1;
+          return true;
+        }
+
+      const double c = std::ceil (value.getReal ());
+      if (c <= -int64Limit)
+        return false;
+
+      *result = c >= int64Limit ? std::numeric_limits<int64_t>::max ()
+                                : static_cast<int64_t> (c) - 1;
+      return true;
+    }
+
+    double
+    realOf (const DbValue& value)
+    {
+      return value.type () == Type::Int
+                 ? static_cast<double> (value.getInt ())
+                 : value.getReal ();
+    }
+
+    Selection
+    selectInts (const Column& column, int64_t lo, int64_t hi)
+    {
+      return selectRange (column.ints (),
+                          column.size (),
+                          column.validity (),
+                          lo,
+                          hi,
+                          active ().rangeInt);
+    }
+
+    Selection
+    selectReals (const Column& column, double lo, double hi)
+    {
+      return selectRange (column.reals (),
+                          column.size (),
+                          column.validity (),
+                          lo,
+                          hi,
+                          active ().rangeReal);
+    }
+
+    Selection
+    selectCodes (const DictionaryColumn& column, int32_t lo, int32_t hi)
+    {
+      return selectRange (column.codes (),
+                          column.size (),
+                          column.validity (),
+                          lo,
+                          hi,
+                          active ().rangeCode);
+    }
+
+    std::string
+    textOf (const DbValue& value)
+    {
+      if (value.type () != Type::Text)
+        throw ErrTypeMisMatch ("value type is " + typeName (value.type ()));
+
+      return value.getText ();
+    }
+
+    int32_t
+    lowerCode (const DictionaryColumn& column, const std::string& text)
+    {
+      const auto& dict = column.dictionary ();
+      return static_cast<int32_t> (
+          std::lower_bound (dict.begin (), dict.end (), text)
+          - dict.begin ());
+    }
+
+    int32_t
+    upperCode (const DictionaryColumn& column, const std::string& text)
+    {
+      const auto& dict = column.dictionary ();
+      return static_cast<int32_t> (
+          std::upper_bound (dict.begin (), dict.end (), text)
+          - dict.begin ());
+    }
+  } // ns
+
+  SimdLevel
+  supportedSimdLevel () noexcept
+  {
+    static const SimdLevel level = internal::detectSimdLevel ();
+    return level;
+  }
+
+  SimdLevel
+  simdLevel () noexcept
+  {
+    return static_cast<SimdLevel> (
+        activeLevel ().load (std::memory_order_relaxed));
+  }
+
+  SimdLevel
+  setSimdLevel (SimdLevel level) noexcept
+  {
+    const int wanted = std::min (static_cast<int> (level),
+                                 static_cast<int> (supportedSimdLevel ()));
+    activeLevel ().store (wanted, std::memory_order_relaxed);
+    return static_cast<SimdLevel> (wanted);
+  }
+
+  DictionaryColumn::DictionaryColumn (const Column& column)
+  : _size (column.size ())
+  , _nulls (column.nullCount ())
+  , _validity (column.validity (), column.validity () + (_size + 63) / 64)
+  , _codes (_size, 0)
+  {
+    if (column.type () != Type::Text)
+      throw ErrTypeMisMatch ("column type is " + typeName (column.type ()));
+
+    const std::size_t* offsets = column.offsets ();
+    const char*        bytes   = column.bytes ();
+
+    // codes in the order of first appearance
+    std::unordered_map<std::string, int32_t> ids;
+    for (std::size_t i = 0; i < _size; ++i)
+      {
+        if (!isValid (column.validity (), i))
+          continue;
+
+        if (ids.size () == static_cast<std::size_t> (
+                               std::numeric_limits<int32_t>::max ()))
+          throw ErrOutOfRange ("too many distinct values");
+
+        auto id = ids.emplace (
+            std::string (bytes + offsets[i], bytes + offsets[i + 1]),
+            static_cast<int32_t> (ids.size ()));
+        _codes[i] = id.first->second;
+      }
+
+    std::vector<const std::string*> texts (ids.size ());
+    for (const auto& id : ids)
+      texts[id.second] = &id.first;
+
+    // sort the dictionary and recode the rows
+    std::vector<int32_t> order (texts.size ());
+    std::iota (order.begin (), order.end (), 0);
+    std::sort (order.begin (), order.end (), [&texts](int32_t a, int32_t b) {
+      return *texts[a] < *texts[b];
+    });
+
+    std::vector<int32_t> recode (order.size ());
+    _dictionary.reserve (order.size ());
+    for (std::size_t i = 0; i < order.size (); ++i)
+      {
+        recode[order[i]] = static_cast<int32_t> (i);
+        _dictionary.push_back (*texts[order[i]]);
+      }
+
+    for (std::size_t i = 0; i < _size; ++i)
+      {
+        if (isValid (column.validity (), i))
+          _codes[i] = recode[_codes[i]];
+      }
+  }
+
+  std::size_t
+  DictionaryColumn::size () const noexcept
+  {
+    return _size;
+  }
+
+  std::size_t
+  DictionaryColumn::nullCount () const noexcept
+  {
+    return _nulls;
+  }
+
+  bool
+  DictionaryColumn::isNull (std::size_t row) const
+  {
+    if (row >= _size)
+      throw ErrOutOfRange ("no data at: " + std::to_string (row));
+
+    return !isValid (_validity.data (), row);
+  }
+
+  DbValue
+  DictionaryColumn::get (std::size_t row) const
+  {
+    if (isNull (row))
+      return DbValue (Type::Text);
+
+    return DbValue (_dictionary[_codes[row]], Type::Text);
+  }
+
+  const uint64_t*
+  DictionaryColumn::validity () const noexcept
+  {
+    return _validity.data ();
+  }
+
+  const int32_t*
+  DictionaryColumn::codes () const noexcept
+  {
+    return _codes.data ();
+  }
+
+  const std::vector<std::string>&
+  DictionaryColumn::dictionary () const noexcept
+  {
+    return _dictionary;
+  }
+
+  std::size_t
+  count (const Column& column) noexcept
+  {
+    return column.size () - column.nullCount ();
+  }
+
+  std::size_t
+  count (const DictionaryColumn& column) noexcept
+  {
+    return column.size () - column.nullCount ();
+  }
+
+  std::size_t
+  nullCount (const Column& column) noexcept
+  {
+    return column.nullCount ();
+  }
+
+  std::size_t
+  nullCount (const DictionaryColumn& column) noexcept
+  {
+    return column.nullCount ();
+  }
+
+  DbValue
+  sum (const Column& column)
+  {
+    ensureNumeric (column);
+    if (count (column) == 0)
+      return DbValue (column.type ());
+
+    // null rows hold 0, so they need not be skipped
+    if (column.type () == Type::Int)
+      return DbValue (active ().sumInt (column.ints (), column.size ()));
+
+    return DbValue (active ().sumReal (column.reals (), column.size ()));
+  }
+
+  DbValue
+  mean (const Column& column)
+  {
+    auto total = sum (column);
+    if (total.isNull ())
+      return DbValue (Type::Real);
+
+    return DbValue (realOf (total) / static_cast<double> (count (column)));
+  }
+
+  DbValue
+  min (const Column& column)
+  {
+    ensureNumeric (column);
+    const auto& k = active ();
+    if (column.type () == Type::Int)
+      {
+        int64_t lo = 0, hi = 0;
+        if (!minMax (column.ints (),
+                     column.size (),
+                     column.validity (),
+                     &lo,
+                     &hi,
+                     k.minMaxInt))
+          return DbValue (Type::Int);
+        return DbValue (lo);
+      }
+
+    double lo = 0, hi = 0;
+    if (!minMax (column.reals (),
+                 column.size (),
+                 column.validity (),
+                 &lo,
+                 &hi,
+                 k.minMaxReal))
+      return DbValue (Type::Real);
+    return DbValue (lo);
+  }
+
+  DbValue
+  max (const Column& column)
+  {
+    ensureNumeric (column);
+    const auto& k = active ();
+    if (column.type () == Type::Int)
+      {
+        int64_t lo = 0, hi = 0;
+        if (!minMax (column.ints (),
+                     column.size (),
+                     column.validity (),
+                     &lo,
+                     &hi,
+                     k.minMaxInt))
+          return DbValue (Type::Int);
+        return DbValue (hi);
+      }
+
+    double lo = 0, hi = 0;
+    if (!minMax (column.reals (),
+                 column.size (),
+                 column.validity (),
+                 &lo,
+                 &hi,
+                 k.minMaxReal))
+      return DbValue (Type::Real);
+    return DbValue (hi);
+  }
+
+  DbValue
+  min (const DictionaryColumn& column)
+  {
+    int32_t lo = 0, hi = 0;
+    if (!minMax (column.codes (),
+                 column.size (),
+                 column.validity (),
+                 &lo,
+                 &hi,
+                 active ().minMaxCode))
+      return DbValue (Type::Text);
+    return DbValue (column.dictionary ()[lo], Type::Text);
+  }
+
+  DbValue
+  max (const DictionaryColumn& column)
+  {
+    int32_t lo = 0, hi = 0;
+    if (!minMax (column.codes (),
+                 column.size (),
+                 column.validity (),
+                 &lo,
+                 &hi,
+                 active ().minMaxCode))
+      return DbValue (Type::Text);
+    return DbValue (column.dictionary ()[hi], Type::Text);
+  }
+
+  Selection
+  selectEqual (const Column& column, const DbValue& value)
+  {
+    return selectBetween (column, value, value);
+  }
+
+  Selection
+  selectLess (const Column& column, const DbValue& value)
+  {
+    ensureNumeric (column);
+    if (value.isNull ())
+      return Selection{};
+
+    ensureNumeric (value);
+    if (column.type () == Type::Int)
+      {
+        int64_t hi = 0;
+        if (!intBelow (value, &hi))
+          return Selection{};
+        return selectInts (column, std::numeric_limits<int64_t>::min (), hi);
+      }
+
+    const double lowest = -std::numeric_limits<double>::infinity ();
+    const double bound  = realOf (value);
+    if (bound == lowest)
+      return Selection{};
+    return selectReals (column, lowest, std::nextafter (bound, lowest));
+  }
+
+  Selection
+  selectBetween (const Column&  column,
+                 const DbValue& lower,
+                 const DbValue& upper)
+  {
+    ensureNumeric (column);
+    if (lower.isNull () || upper.isNull ())
+      return Selection{};
+
+    ensureNumeric (lower);
+    ensureNumeric (upper);
+    if (column.type () == Type::Int)
+      {
+        int64_t lo = 0, hi = 0;
+        if (!intAtLeast (lower, &lo) || !intAtMost (upper, &hi))
+          return Selection{};
+        return selectInts (column, lo, hi);
+      }
+
+    return selectReals (column, realOf (lower), realOf (upper));
+  }
+
+  Selection
+  selectEqual (const DictionaryColumn& column, const DbValue& value)
+  {
+    return selectBetween (column, value, value);
+  }
+
+  Selection
+  selectLess (const DictionaryColumn& column, const DbValue& value)
+  {
+    if (value.isNull ())
+      return Selection{};
+
+    return selectCodes (column, 0, lowerCode (column, textOf (value)) - 1);
+  }
+
+  Selection
+  selectBetween (const DictionaryColumn& column,
+                 const DbValue&          lower,
+                 const DbValue&          upper)
+  {
+    if (lower.isNull () || upper.isNull ())
+      return Selection{};
+
+    return selectCodes (column,
+                        lowerCode (column, textOf (lower)),
+                        upperCode (column, textOf (upper)) - 1);
+  }
+}
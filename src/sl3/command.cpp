@@ -77,8 +77,8 @@ namespace sl3
               // SQLITE_TRANSIENT would copy the string , is unwanted here
               rc = sqlite3_bind_text (stmt,
                                       curParaNr,
-                                      val.getText ().c_str (),
-                                      val.getText ().size (),
+                                      val.getValue ().data (),
+                                      val.getValue ().size (),
                                       SQLITE_STATIC);
 
               break;
@@ -86,8 +86,8 @@ namespace sl3
             case Type::Blob:
               rc = sqlite3_bind_blob (stmt,
                                       curParaNr,
-                                      &(val.getBlob ()[0]),
-                                      val.getBlob ().size (),
+                                      val.getValue ().data (),
+                                      val.getValue ().size (),
                                       SQLITE_STATIC);
 
               break;
@@ -194,6 +194,27 @@ namespace sl3
     return ds;
   }
 
+  ColumnarDataset
+  Command::selectColumnar (const Types& types, const DbValues& parameters)
+  {
+    return selectColumnar (parameters, types);
+  }
+
+  ColumnarDataset
+  Command::selectColumnar (const DbValues& parameters, const Types& types)
+  {
+    ColumnarDataset ds{types};
+    Callback        fillds = [&ds](Columns columns) -> bool {
+      // this will throw if a type does not match.
+      ds.append (columns);
+      return true;
+    };
+
+    execute (fillds, parameters);
+    ds.finish ();
+    return ds;
+  }
+
   void
   Command::execute ()
   {
@@ -220,6 +241,27 @@ namespace sl3
 
   void
   Command::execute (Callback callback, const DbValues& parameters)
+  {
+    start (parameters);
+
+    {
+      // use this to ensure a reset of _stmt
+      using ResetGuard
+          = std::unique_ptr<sqlite3_stmt, decltype (&sqlite3_reset)>;
+      ResetGuard resetGuard (_stmt, &sqlite3_reset);
+
+      while (step ())
+        {
+          if (!callback (Columns{_stmt}))
+            break;
+        }
+    }
+
+    _connection->deliverChanges ();
+  }
+
+  void
+  Command::start (const DbValues& parameters)
   {
     _connection->ensureValid ();
 
@@ -227,41 +269,47 @@ namespace sl3
       setParameters (parameters);
 
     bind (_stmt, _parameters);
+  }
 
-    // use this to ensure a reset of _stmt
-    using ResetGuard
-        = std::unique_ptr<sqlite3_stmt, decltype (&sqlite3_reset)>;
-    ResetGuard resetGuard (_stmt, &sqlite3_reset);
+  bool
+  Command::step ()
+  {
+    _connection->ensureValid ();
 
-    bool loop = true;
-    while (loop)
+    int rc = sqlite3_step (_stmt);
+    switch (rc)
       {
-        int rc = sqlite3_step (_stmt);
+      case SQLITE_OK:
+      case SQLITE_DONE:
+        return false;
 
-        switch (rc)
-          {
-          case SQLITE_OK:
-          case SQLITE_DONE:
-            {
-              loop = false;
-              break;
-            }
-          case SQLITE_ROW:
-            {
-              loop = callback (Columns{_stmt});
-              break;
-            }
+      case SQLITE_ROW:
+        return true;
 
-          default:
-            {
-              auto         db = sqlite3_db_handle (_stmt);
-              SQLite3Error sl3error (rc, sqlite3_errmsg (db));
-              throw sl3error;
-            }
-          }
+      default:
+        {
+          auto         db = sqlite3_db_handle (_stmt);
+          SQLite3Error sl3error (rc, sqlite3_errmsg (db));
+          throw sl3error;
+        }
       }
   }
 
+  void
+  Command::finish ()
+  {
+    _connection->ensureValid ();
+    sqlite3_reset (_stmt);
+    _connection->deliverChanges ();
+  }
+
+  void
+  Command::reset () noexcept
+  {
+    if (_stmt && _connection->isValid ())
+      sqlite3_reset (_stmt);
+  }
+
   DbValues&
   Command::getParameters ()
   {
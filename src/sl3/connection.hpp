@@ -9,9 +9,17 @@
 #ifndef SL3_CONNECTION_HPP_
 #define SL3_CONNECTION_HPP_
 
+#include <map>
+#include <memory>
+#include <string>
+
 #include <sl3/database.hpp>
 
+#include "changefeed.hpp"
+#include "checkpointer.hpp"
+
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace sl3
 {
@@ -43,6 +51,36 @@ namespace sl3
       ///  throw ErrNoConnection if not valid
       void ensureValid ();
 
+      /**
+       * \brief run a transaction control statement
+       *
+       * Statements like BEGIN, COMMIT or SAVEPOINT are prepared once per
+       * connection and reused.
+       *
+       * \return the sqlite3 result code, SQLITE_OK on success
+       */
+      int control (const std::string& sql);
+
+      /// nesting level of Savepoint objects
+      int savepointLevel{0};
+
+      /// change feed, if Database::onChange is used
+      std::unique_ptr<ChangeFeed> changes;
+
+      /// deliver committed changes, if there is a change feed
+      void deliverChanges ();
+
+      /// background checkpoints, if Database::startCheckpoints is used
+      std::unique_ptr<Checkpointer> checkpoints;
+
+      /**
+       * \brief cleanup of dependent sqlite objects
+       *
+       * Objects that must be freed before sqlite3_close, like sessions,
+       * register a free function here. Called on close.
+       */
+      std::map<void*, void (*) (void*)> closeHandlers;
+
     private:
       Connection (Connection&&) = default;
 
@@ -53,6 +91,8 @@ namespace sl3
       void close (); // called by the db
 
       sqlite3* sl3db;
+
+      std::map<std::string, sqlite3_stmt*> _control;
     };
   }
   ///\endcond
@@ -86,12 +126,49 @@ namespace sl3
         }
     }
 
+    inline int
+    Connection::control (const std::string& sql)
+    {
+      if (sl3db == nullptr)
+        return SQLITE_MISUSE;
+
+      sqlite3_stmt*& stmt = _control[sql];
+      if (stmt == nullptr)
+        {
+          int rc = sqlite3_prepare_v2 (sl3db, sql.c_str (), -1, &stmt, 0);
+          if (rc != SQLITE_OK)
+            {
+              _control.erase (sql);
+              return rc;
+            }
+        }
+
+      int rc = sqlite3_step (stmt);
+      sqlite3_reset (stmt);
+
+      return rc == SQLITE_DONE ? SQLITE_OK : rc;
+    }
+
+    inline void
+    Connection::deliverChanges ()
+    {
+      if (changes)
+        changes->deliver ();
+    }
+
     inline void
     Connection::close ()
     {
       if (sl3db == nullptr)
         return;
 
+      changes.reset ();
+      checkpoints.reset ();
+
+      for (auto& handler : closeHandlers)
+        handler.second (handler.first);
+      closeHandlers.clear ();
+
       // total clean up to be sure nothing left.
       auto stm = sqlite3_next_stmt (sl3db, 0);
       while (stm != nullptr)
@@ -99,6 +176,7 @@ namespace sl3
           sqlite3_finalize (stm);
           stm = sqlite3_next_stmt (sl3db, 0);
         }
+      _control.clear ();
 
       // if  busy, use v2 for garbed collecting,
       if (sqlite3_close (sl3db) != SQLITE_OK)
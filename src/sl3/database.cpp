@@ -11,11 +11,14 @@
 #include <sqlite3.h>
 
 #include "connection.hpp"
+#include "sqltext.hpp"
 
 
 namespace
 {
-  sqlite3* opendb(const std::string& name, int openFlags)
+  sqlite3* opendb(const std::string& name,
+                  int openFlags,
+                  const std::string& vfs = "")
   {
     if (openFlags == 0)
       {
@@ -23,7 +26,10 @@ namespace
       }
 
     sqlite3* db    = nullptr;
-    auto     sl3rc = sqlite3_open_v2 (name.c_str (), &db, openFlags, nullptr);
+    auto     sl3rc = sqlite3_open_v2 (name.c_str (),
+                                      &db,
+                                      openFlags,
+                                      vfs.empty () ? nullptr : vfs.c_str ());
 
     if (sl3rc != SQLITE_OK)
       {
@@ -34,6 +40,69 @@ namespace
     return db ;
   }
 
+  // a file: URI of a path, characters with a meaning in URIs escaped
+  std::string
+  fileUri (const std::string& path)
+  {
+    static const char hex[] = "0123456789ABCDEF";
+
+    std::string uri{"file:"};
+    for (auto c : path)
+      {
+        const auto u = static_cast<unsigned char> (c);
+        if (c == '%' || c == '?' || c == '#' || u < 0x20 || u > 0x7e)
+          {
+            uri += '%';
+            uri += hex[u >> 4];
+            uri += hex[u & 0x0f];
+          }
+        else
+          {
+            uri += c;
+          }
+      }
+    return uri;
+  }
+
+  sqlite3*
+  openImmutable (const std::string& name, const sl3::OpenOptions& options)
+  {
+    const int cache
+        = options.flags & (SQLITE_OPEN_SHAREDCACHE | SQLITE_OPEN_PRIVATECACHE);
+    return opendb (fileUri (name) + "?immutable=1",
+                   SQLITE_OPEN_READONLY | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX
+                       | cache,
+                   options.vfs);
+  }
+
+  int64_t
+  intPragma (sqlite3* db, const std::string& sql)
+  {
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v2 (db, sql.c_str (), -1, &stmt, nullptr);
+    using scope_guard
+        = std::unique_ptr<sqlite3_stmt, decltype (&sqlite3_finalize)>;
+    scope_guard guard{stmt, &sqlite3_finalize};
+
+    if (rc == SQLITE_OK)
+      rc = sqlite3_step (stmt);
+
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+      throw sl3::SQLite3Error{rc, sqlite3_errmsg (db)};
+
+    return rc == SQLITE_ROW ? sqlite3_column_int64 (stmt, 0) : 0;
+  }
+
+  void
+  control (sl3::internal::Connection& connection, const std::string& sql)
+  {
+    connection.ensureValid ();
+
+    int rc = connection.control (sql);
+    if (rc != SQLITE_OK)
+      throw sl3::SQLite3Error{rc, sqlite3_errmsg (connection.db ())};
+  }
+
 }
 
 
@@ -53,6 +122,35 @@ namespace sl3
     sqlite3_extended_result_codes (_connection->db (), true);
   }
 
+  Database::Database (const std::string& name, const OpenOptions& options)
+  : _connection {new internal::Connection{
+        options.immutable ? openImmutable (name, options)
+                          : opendb (name, options.flags, options.vfs)}}
+  {
+    sqlite3_extended_result_codes (_connection->db (), true);
+
+    if (options.immutable)
+      {
+        // map the whole file, limited by SQLITE_MAX_MMAP_SIZE
+        sqlite3*      db   = _connection->db ();
+        const int64_t size = intPragma (db, "PRAGMA page_count;")
+                             * intPragma (db, "PRAGMA page_size;");
+        intPragma (db, "PRAGMA mmap_size=" + std::to_string (size) + ";");
+      }
+
+    if (options.lookasideSlotSize >= 0 && options.lookasideSlots >= 0)
+      {
+        sqlite3* db = _connection->db ();
+        int      rc = sqlite3_db_config (db,
+                                    SQLITE_DBCONFIG_LOOKASIDE,
+                                    nullptr,
+                                    options.lookasideSlotSize,
+                                    options.lookasideSlots);
+        if (rc != SQLITE_OK)
+          throw SQLite3Error{rc, sqlite3_errmsg (db)};
+      }
+  }
+
   Database::Database (Database&& other) noexcept
       : _connection (std::move (other._connection))
   {
@@ -100,6 +198,8 @@ namespace sl3
         scope_guard guard (dbMsg, &sqlite3_free);
         throw SQLite3Error{rc, dbMsg};
       }
+
+    _connection->deliverChanges ();
   }
 
   void
@@ -126,6 +226,18 @@ namespace sl3
     return Command (_connection, sql).select (types);
   }
 
+  ColumnarDataset
+  Database::selectColumnar (const std::string& sql)
+  {
+    return Command (_connection, sql).selectColumnar ();
+  }
+
+  ColumnarDataset
+  Database::selectColumnar (const std::string& sql, const Types& types)
+  {
+    return Command (_connection, sql).selectColumnar (types);
+  }
+
   DbValue
   Database::selectValue (const std::string& sql)
   {
@@ -194,6 +306,164 @@ namespace sl3
     return sqlite3_last_insert_rowid (_connection->db ());
   }
 
+  BlobStream
+  Database::openBlob (const std::string& table,
+                      const std::string& column,
+                      int64_t            rowid,
+                      BlobStream::Mode   mode,
+                      const std::string& dbname)
+  {
+    return {_connection, dbname, table, column, rowid, mode};
+  }
+
+  BlobStream
+  Database::insertZeroBlob (const std::string& table,
+                            const std::string& column,
+                            std::size_t        size,
+                            const std::string& dbname)
+  {
+    using internal::quoteIdentifier;
+    const std::string sql = "INSERT INTO " + quoteIdentifier (dbname) + "."
+                            + quoteIdentifier (table) + " ("
+                            + quoteIdentifier (column)
+                            + ") VALUES (zeroblob(?));";
+
+    Command cmd (_connection, sql);
+    cmd.execute (parameters (static_cast<int64_t> (size)));
+
+    return openBlob (table,
+                     column,
+                     getLastInsertRowid (),
+                     BlobStream::Mode::ReadWrite,
+                     dbname);
+  }
+
+  void
+  Database::onChange (ChangeCallback cb, ChangeBatchOptions options)
+  {
+    _connection->ensureValid ();
+    _connection->changes.reset ();
+    if (cb)
+      _connection->changes.reset (new internal::ChangeFeed{
+          _connection->db (), std::move (cb), options});
+  }
+
+  void
+  Database::startCheckpoints (CheckpointOptions options)
+  {
+    _connection->ensureValid ();
+    _connection->checkpoints.reset ();
+    _connection->checkpoints.reset (
+        new internal::Checkpointer{_connection->db (), options});
+  }
+
+  void
+  Database::stopCheckpoints ()
+  {
+    _connection->checkpoints.reset ();
+  }
+
+  CheckpointMetrics
+  Database::checkpointMetrics () const
+  {
+    if (!_connection->checkpoints)
+      return CheckpointMetrics{};
+
+    return _connection->checkpoints->metrics ();
+  }
+
+  Session
+  Database::createSession (const std::string& dbname)
+  {
+    return Session{_connection, dbname};
+  }
+
+  void
+  Database::applyChangeset (const Blob&     changeset,
+                            ConflictPolicy  policy,
+                            ChangesetFilter filter)
+  {
+    _connection->ensureValid ();
+    internal::applyChangeset (_connection->db (), changeset, policy, filter);
+    _connection->deliverChanges ();
+  }
+
+  void
+  Database::createVirtualTable (const std::string&                 name,
+                                std::shared_ptr<const TableSource> source,
+                                const std::string&                 keyColumn)
+  {
+    _connection->ensureValid ();
+    internal::createVirtualTable (
+        _connection->db (), name, std::move (source), keyColumn);
+  }
+
+  void
+  Database::createVirtualTable (const std::string& name,
+                                const Dataset&     ds,
+                                const std::string& keyColumn)
+  {
+    createVirtualTable (
+        name, std::make_shared<const DatasetSource> (ds), keyColumn);
+  }
+
+  void
+  Database::createCollation (const std::string& name, CollationCompare cmp)
+  {
+    _connection->ensureValid ();
+    internal::createCollation (_connection->db (), name, std::move (cmp));
+  }
+
+  void
+  Database::createCollation (const std::string& name, Collation collation)
+  {
+    switch (collation)
+      {
+      case Collation::Natural:
+        createCollation (name, &naturalCompare);
+        break;
+
+      case Collation::AsciiNoCase:
+        createCollation (name, &asciiNoCaseCompare);
+        break;
+      }
+  }
+
+  void
+  Database::createSortKeyCollation (const std::string& name,
+                                    SortKeyFunction    key,
+                                    std::size_t        cacheSize)
+  {
+    _connection->ensureValid ();
+    internal::createSortKeyCollation (
+        _connection->db (), name, std::move (key), cacheSize);
+  }
+
+  void
+  Database::registerFunction (const std::string&      name,
+                              int                     nArg,
+                              int                     flags,
+                              internal::FunctionBase* fn)
+  {
+    std::unique_ptr<internal::FunctionBase> guard (fn);
+    _connection->ensureValid ();
+    internal::createScalarFunction (
+        _connection->db (), name, nArg, flags, guard.release ());
+  }
+
+  void
+  Database::registerAggregate (const std::string&       name,
+                               int                      nArg,
+                               int                      flags,
+                               internal::AggregateBase* fn,
+                               bool                     window)
+  {
+    std::unique_ptr<internal::AggregateBase> guard (fn);
+    _connection->ensureValid ();
+    internal::createAggregateFunction (
+        _connection->db (), name, nArg, flags, guard.release (), window);
+  }
+
   sqlite3*
   Database::db ()
   {
@@ -201,37 +471,119 @@ namespace sl3
   }
 
   auto
-  Database::beginTransaction () -> Transaction
+  Database::beginTransaction (TransactionMode mode) -> Transaction
   {
-    return Transaction{*this};
+    return Transaction{_connection, mode};
   }
 
-  Database::Transaction::Transaction (Database& db)
-  : _db (&db)
+  Database::Transaction::Transaction (
+      std::shared_ptr<internal::Connection> connection,
+      TransactionMode                       mode)
+  : _connection (std::move (connection))
   {
-    _db->execute ("BEGIN TRANSACTION");
+    switch (mode)
+      {
+      case TransactionMode::Immediate:
+        control (*_connection, "BEGIN IMMEDIATE TRANSACTION");
+        break;
+      case TransactionMode::Exclusive:
+        control (*_connection, "BEGIN EXCLUSIVE TRANSACTION");
+        break;
+      default:
+        control (*_connection, "BEGIN TRANSACTION");
+        break;
+      }
   }
 
   Database::Transaction::Transaction (Transaction&& other) noexcept
-  : _db (other._db)
+  : _connection (std::move (other._connection))
   {
-    other._db = nullptr; // ensure other does not commit in d'tor
+    // other has no connection, so it does not rollback in d'tor
   }
 
   Database::Transaction::~Transaction ()
   {
-    if (_db)
-      _db->execute ("ROLLBACK TRANSACTION");
+    // if the transaction has already been rolled back by sqlite,
+    // for example because of SQLITE_FULL, this fails, ignore that
+    if (_connection)
+      _connection->control ("ROLLBACK TRANSACTION");
   }
 
   void
   Database::Transaction::commit ()
   {
-    if(_db)
+    if (_connection)
+      {
+        control (*_connection, "COMMIT TRANSACTION");
+        auto connection = std::move (_connection);
+        connection->deliverChanges ();
+      }
+  }
+
+  auto
+  Database::savepoint () -> Savepoint
+  {
+    return Savepoint{_connection};
+  }
+
+  Database::Savepoint::Savepoint (
+      std::shared_ptr<internal::Connection> connection)
+  : _connection (std::move (connection))
+  , _level (_connection->savepointLevel + 1)
+  {
+    control (*_connection, "SAVEPOINT " + name ());
+    _connection->savepointLevel = _level;
+
+    if (_connection->changes)
+      _connection->changes->mark (_level);
+  }
+
+  Database::Savepoint::Savepoint (Savepoint&& other) noexcept
+  : _connection (std::move (other._connection))
+  , _level (other._level)
+  {
+    // other has no connection, so it does not rollback in d'tor
+  }
+
+  Database::Savepoint::~Savepoint ()
+  {
+    if (_connection)
       {
-        _db->execute ("COMMIT TRANSACTION");
-        _db = nullptr;
+        if (_connection->control ("ROLLBACK TO " + name ()) == SQLITE_OK
+            && _connection->changes)
+          _connection->changes->rollbackTo (_level);
+        _connection->control ("RELEASE " + name ());
+        _connection->savepointLevel = _level - 1;
       }
   }
 
+  void
+  Database::Savepoint::release ()
+  {
+    if (_connection)
+      {
+        control (*_connection, "RELEASE " + name ());
+        _connection->savepointLevel = _level - 1;
+        auto connection = std::move (_connection);
+        connection->deliverChanges ();
+      }
+  }
+
+  void
+  Database::Savepoint::rollback ()
+  {
+    if (!_connection)
+      throw ErrNoConnection{};
+
+    control (*_connection, "ROLLBACK TO " + name ());
+    if (_connection->changes)
+      _connection->changes->rollbackTo (_level);
+  }
+
+  std::string
+  Database::Savepoint::name () const
+  {
+    return "sl3_savepoint_" + std::to_string (_level);
+  }
+
 } // ns
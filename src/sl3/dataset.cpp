@@ -8,19 +8,44 @@
 
 #include <sl3/dataset.hpp>
 
+#include "parallel.hpp"
+#include "sortkey.hpp"
+
 #include <sqlite3.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
+#include <limits>
 #include <sl3/error.hpp>
 #include <stdexcept>
+#include <string>
+#include <thread>
 
 namespace sl3
 {
-  Dataset::Dataset () noexcept : _fieldtypes (), _names () {}
+  namespace
+  {
+    // unique over all Datasets, so assigned Datasets get a new one too
+    std::size_t
+    nextGeneration () noexcept
+    {
+      static std::atomic<std::size_t> generation{0};
+      return ++generation;
+    }
+  }
+
+  Dataset::Dataset () noexcept
+  : _fieldtypes ()
+  , _names ()
+  , _generation (nextGeneration ())
+  {
+  }
+
   Dataset::Dataset (Types types)
   : _fieldtypes (std::move (types))
   , _names ()
+  , _generation (nextGeneration ())
   {
   }
 
@@ -33,7 +58,20 @@ namespace sl3
   : Container<std::vector<DbValues>> (std::move (other))
   , _fieldtypes (move (other._fieldtypes))
   , _names (move (other._names))
+  , _generation (other._generation)
   {
+    other.modified ();
+  }
+
+  Dataset&
+  Dataset::operator= (Dataset&& other)
+  {
+    Container<std::vector<DbValues>>::operator= (std::move (other));
+    _fieldtypes = std::move (other._fieldtypes);
+    _names      = std::move (other._names);
+    _generation = other._generation;
+    other.modified ();
+    return *this;
   }
 
   void
@@ -41,6 +79,7 @@ namespace sl3
   {
     _names.clear ();
     _cont.clear ();
+    modified ();
   }
 
   void
@@ -52,6 +91,70 @@ namespace sl3
 
   void
   Dataset::merge (const Dataset& other)
+  {
+    ensureMergeable (other);
+    if (&other == this)
+      {
+        // insert can not take a range of the container itself
+        const auto rows = _cont.size ();
+        _cont.reserve (2 * rows);
+        for (std::size_t i = 0; i < rows; ++i)
+          _cont.push_back (_cont[i]);
+      }
+    else
+      {
+        _cont.insert (_cont.end (), other._cont.begin (), other._cont.end ());
+      }
+    modified ();
+  }
+
+  void
+  Dataset::merge (Dataset&& other)
+  {
+    // the rows are already here, moving them would lose them
+    if (&other == this)
+      return;
+
+    ensureMergeable (other);
+    if (_cont.empty ())
+      {
+        _cont = std::move (other._cont);
+      }
+    else
+      {
+        _cont.insert (_cont.end (),
+                      std::make_move_iterator (other._cont.begin ()),
+                      std::make_move_iterator (other._cont.end ()));
+      }
+    other._cont.clear ();
+    modified ();
+    other.modified ();
+  }
+
+  void
+  Dataset::merge (const DbValues& row)
+  {
+    ensureMergeable (row);
+    _cont.push_back (row);
+    modified ();
+  }
+
+  void
+  Dataset::merge (DbValues&& row)
+  {
+    ensureMergeable (row);
+    _cont.push_back (std::move (row));
+    modified ();
+  }
+
+  void
+  Dataset::modified () noexcept
+  {
+    _generation = nextGeneration ();
+  }
+
+  void
+  Dataset::ensureMergeable (const Dataset& other) const
   {
     if (!other._names.empty ())
       {
@@ -70,12 +173,10 @@ namespace sl3
               throw ErrTypeMisMatch ();
           }
       }
-
-    _cont.insert (_cont.end (), other._cont.begin (), other._cont.end ());
   }
 
   void
-  Dataset::merge (const DbValues& row)
+  Dataset::ensureMergeable (const DbValues& row) const
   {
     if (_fieldtypes.size () > 0 && _fieldtypes.size () != row.size ())
       {
@@ -92,8 +193,6 @@ namespace sl3
               }
           }
       }
-
-    _cont.push_back (DbValues (row));
   }
 
   size_t
@@ -109,9 +208,57 @@ namespace sl3
 
   void
   Dataset::sort (const std::vector<size_t>& idxs, DbValueSort cmp)
+  {
+    ExecutionPolicy serial;
+    serial.threads = 1;
+    sort (idxs, cmp, serial);
+  }
+
+  void
+  Dataset::sort (const std::vector<size_t>& idxs,
+                 DbValueSort                cmp,
+                 const ExecutionPolicy&     policy)
   {
     ASSERT_EXCEPT(cmp, ErrNullValueAccess) ;
 
+    // check the indexes first, a compare that throws during a parallel
+    // merge would lose the rows already moved
+    std::size_t fields = _fieldtypes.size ();
+    if (fields == 0) // rows of an untyped Dataset may differ in size
+      {
+        fields = std::numeric_limits<std::size_t>::max ();
+        for (const auto& row : _cont)
+          fields = std::min (fields, row.size ());
+      }
+    for (auto idx : idxs)
+      {
+        if (idx >= fields)
+          throw ErrOutOfRange ("Field index " + std::to_string (idx)
+                               + " out of range");
+      }
+
+    std::size_t threads = policy.threads;
+    if (threads == 0)
+      threads = std::max (1u, std::thread::hardware_concurrency ());
+    if (_cont.size () < policy.minRows)
+      threads = 1;
+
+    if (cmp == &dbval_lt)
+      {
+        // compare normalized keys instead of calling cmp per field,
+        // this is always stable
+        const auto order = internal::sortedOrder (
+            internal::sortKeys (*this, idxs, threads), threads);
+        conatiner_type sorted;
+        sorted.reserve (_cont.size ());
+        for (auto pos : order)
+          sorted.push_back (std::move (_cont[pos]));
+
+        _cont.swap (sorted);
+        modified ();
+        return;
+      }
+
     auto lessValues = [&](const DbValues& a, const DbValues& b) -> bool {
       for (auto cur : idxs)
         {
@@ -123,6 +270,18 @@ namespace sl3
       return false;
     };
 
-    std::sort (begin (), end (), lessValues);
+    auto sortChunk = [&] (iterator first, iterator last) {
+      if (policy.stable)
+        std::stable_sort (first, last, lessValues);
+      else
+        std::sort (first, last, lessValues);
+    };
+
+    if (threads > 1)
+      internal::parallelSort (_cont, threads, sortChunk, lessValues);
+    else
+      sortChunk (begin (), end ());
+
+    modified ();
   }
 }
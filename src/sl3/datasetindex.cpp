@@ -0,0 +1,172 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/datasetindex.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include "sortkey.hpp"
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  namespace
+  {
+    DbValues
+    keyOf (const DbValues& row, const std::vector<std::size_t>& fields)
+    {
+      std::vector<DbValue> key;
+      key.reserve (fields.size ());
+      for (auto field : fields)
+        key.push_back (row.at (field));
+
+      return DbValues (std::move (key));
+    }
+
+    // order of memcmp, a prefix is less
+    bool
+    keyLess (const char* a, std::size_t na, const std::string& b)
+    {
+      const auto n  = std::min (na, b.size ());
+      const int  rc = n > 0 ? std::memcmp (a, b.data (), n) : 0;
+      return rc != 0 ? rc < 0 : na < b.size ();
+    }
+  } // ns
+
+  HashIndex::HashIndex (const Dataset& ds, std::vector<std::size_t> fields)
+  : _ds (&ds)
+  , _generation (ds._generation)
+  , _fields (std::move (fields))
+  , _rows ()
+  {
+    for (std::size_t i = 0; i < ds.size (); ++i)
+      _rows[keyOf (ds[i], _fields)].push_back (i);
+  }
+
+  const HashIndex::Rows&
+  HashIndex::find (const DbValues& key) const
+  {
+    static const Rows none;
+
+    ensureValid ();
+    if (key.size () != _fields.size ())
+      throw ErrTypeMisMatch ("key size != number of index fields");
+
+    auto pos = _rows.find (key);
+    return pos == _rows.end () ? none : pos->second;
+  }
+
+  bool
+  HashIndex::isValid () const noexcept
+  {
+    return _ds->_generation == _generation;
+  }
+
+  std::size_t
+  HashIndex::size () const noexcept
+  {
+    return _rows.size ();
+  }
+
+  void
+  HashIndex::ensureValid () const
+  {
+    if (!isValid ())
+      throw ErrUnexpected ("Dataset has changed, the index is outdated");
+  }
+
+  SortedIndex::SortedIndex (const Dataset& ds, std::vector<std::size_t> fields)
+  : _ds (&ds)
+  , _generation (ds._generation)
+  , _fields (std::move (fields))
+  {
+    auto keys = internal::sortKeys (ds, _fields);
+    _order    = internal::sortedOrder (keys);
+    _keys.swap (keys.bytes);
+    _offsets.swap (keys.offsets);
+  }
+
+  SortedIndex::const_iterator
+  SortedIndex::lowerBound (const DbValues& key) const
+  {
+    return bound (key, false);
+  }
+
+  SortedIndex::const_iterator
+  SortedIndex::upperBound (const DbValues& key) const
+  {
+    return bound (key, true);
+  }
+
+  SortedIndex::Range
+  SortedIndex::equalRange (const DbValues& key) const
+  {
+    return Range (bound (key, false), bound (key, true));
+  }
+
+  SortedIndex::Range
+  SortedIndex::range (const DbValues& lower, const DbValues& upper) const
+  {
+    auto first = bound (lower, false);
+    auto last  = bound (upper, false);
+    return Range (first, std::max (first, last));
+  }
+
+  SortedIndex::const_iterator
+  SortedIndex::begin () const noexcept
+  {
+    return _order.begin ();
+  }
+
+  SortedIndex::const_iterator
+  SortedIndex::end () const noexcept
+  {
+    return _order.end ();
+  }
+
+  bool
+  SortedIndex::isValid () const noexcept
+  {
+    return _ds->_generation == _generation;
+  }
+
+  void
+  SortedIndex::ensureValid () const
+  {
+    if (!isValid ())
+      throw ErrUnexpected ("Dataset has changed, the index is outdated");
+  }
+
+  SortedIndex::const_iterator
+  SortedIndex::bound (const DbValues& key, bool upper) const
+  {
+    ensureValid ();
+    if (key.size () > _fields.size ())
+      throw ErrTypeMisMatch ("key size > number of index fields");
+
+    std::string encoded;
+    for (const auto& val : key)
+      internal::appendSortKey (encoded, val.getValue ());
+
+    // every field key starts with a tag below 0xff, so this is greater
+    // than all row keys that start with the encoded key
+    if (upper)
+      encoded.push_back (static_cast<char> (0xff));
+
+    return std::lower_bound (
+        _order.begin (),
+        _order.end (),
+        encoded,
+        [this] (std::size_t row, const std::string& k) {
+          return keyLess (_keys.data () + _offsets[row],
+                          _offsets[row + 1] - _offsets[row],
+                          k);
+        });
+  }
+}
@@ -15,6 +15,7 @@
 #include <limits>
 #include <ostream>
 #include <type_traits>
+#include <utility>
 
 #include <iostream>
 
@@ -154,9 +155,15 @@ namespace sl3
     return value_lt (a.getValue (), b.getValue ());
   }
 
+  std::size_t
+  dbval_hash (const DbValue& v) noexcept
+  {
+    return value_hash (v.getValue ());
+  }
+
   DbValue::DbValue (Type type) noexcept
-      : _type (type == Type::Null ? Type::Variant : type)
   {
+    _value.auxType (type == Type::Null ? Type::Variant : type);
   }
 
   DbValue::DbValue (int val, Type type)
@@ -177,7 +184,7 @@ namespace sl3
   : DbValue (type)
   {
     ensure (type).oneOf (Type::Text, Type::Variant);
-    _value = val;
+    _value = std::move (val);
   }
 
   DbValue::DbValue (double val, Type type)
@@ -191,7 +198,7 @@ namespace sl3
   : DbValue (type)
   {
     ensure (type).oneOf (Type::Blob, Type::Variant);
-    _value = val;
+    _value = std::move (val);
   }
 
   DbValue&
@@ -200,11 +207,11 @@ namespace sl3
     if (!canAssign (other))
       {
         throw ErrTypeMisMatch (
-            typeName (_type) + "="
-            + (other._type == Type::Variant
-                   ? typeName (other._type) + " with storage type"
+            typeName (dbtype ()) + "="
+            + (other.dbtype () == Type::Variant
+                   ? typeName (other.dbtype ()) + " with storage type"
                          + typeName (other.type ())
-                   : typeName (other._type)));
+                   : typeName (other.dbtype ())));
       }
 
     assign (other);
@@ -217,11 +224,11 @@ namespace sl3
     if (!canAssign (other))
       {
         throw ErrTypeMisMatch (
-            typeName (_type) + "="
-            + (other._type == Type::Variant
-                   ? typeName (other._type) + " with storage type"
+            typeName (dbtype ()) + "="
+            + (other.dbtype () == Type::Variant
+                   ? typeName (other.dbtype ()) + " with storage type"
                          + typeName (other.type ())
-                   : typeName (other._type)));
+                   : typeName (other.dbtype ())));
       }
     _value = std::move (other._value);
 
@@ -256,6 +263,13 @@ namespace sl3
     return *this;
   }
 
+  DbValue&
+  DbValue::operator= (std::string&& val)
+  {
+    set (std::move (val));
+    return *this;
+  }
+
   DbValue&
   DbValue::operator= (const Blob& val)
   {
@@ -263,20 +277,35 @@ namespace sl3
     return *this;
   }
 
+  DbValue&
+  DbValue::operator= (Blob&& val)
+  {
+    set (std::move (val));
+    return *this;
+  }
+
   DbValue&
   DbValue::operator= (const Value& val)
   {
-    ensure (_type).oneOf (val.getType (), Type::Variant);
+    ensure (dbtype ()).oneOf (val.getType (), Type::Variant);
     _value = val;
     return *this;
   }
 
+  DbValue&
+  DbValue::operator= (Value&& val)
+  {
+    ensure (dbtype ()).oneOf (val.getType (), Type::Variant);
+    _value = std::move (val);
+    return *this;
+  }
+
   void
   DbValue::set (int val)
   {
     // not sure if I leaf this conversion,
     // but its better in text dbval.set(12); it type is real
-    if (_type == Type::Real)
+    if (dbtype () == Type::Real)
       set (static_cast<double> (val));
     else
       set (static_cast<int64_t> (val));
@@ -285,24 +314,31 @@ namespace sl3
   void
   DbValue::set (int64_t val)
   {
-    ensure (_type).oneOf (Type::Int, Type::Variant);
+    ensure (dbtype ()).oneOf (Type::Int, Type::Variant);
     _value = val;
   }
 
   void
   DbValue::set (double val)
   {
-    ensure (_type).oneOf (Type::Real, Type::Variant);
+    ensure (dbtype ()).oneOf (Type::Real, Type::Variant);
     _value = val;
   }
 
   void
   DbValue::set (const std::string& val)
   {
-    ensure (_type).oneOf (Type::Text, Type::Variant);
+    ensure (dbtype ()).oneOf (Type::Text, Type::Variant);
     _value = val;
   }
 
+  void
+  DbValue::set (std::string&& val)
+  {
+    ensure (dbtype ()).oneOf (Type::Text, Type::Variant);
+    _value = std::move (val);
+  }
+
   const Value&
   DbValue::getValue () const noexcept
   {
@@ -312,10 +348,17 @@ namespace sl3
   void
   DbValue::set (const Blob& val)
   {
-    ensure (_type).oneOf (Type::Blob, Type::Variant);
+    ensure (dbtype ()).oneOf (Type::Blob, Type::Variant);
     _value = val;
   }
 
+  void
+  DbValue::set (Blob&& val)
+  {
+    ensure (dbtype ()).oneOf (Type::Blob, Type::Variant);
+    _value = std::move (val);
+  }
+
   const int64_t&
   DbValue::getInt () const
   {
@@ -346,7 +389,7 @@ namespace sl3
     return _value.real ();
   }
 
-  const std::string&
+  std::string
   DbValue::getText () const
   {
     return _value.text ();
@@ -361,7 +404,7 @@ namespace sl3
     return _value.text ();
   }
 
-  const Blob&
+  Blob
   DbValue::getBlob () const
   {
     return _value.blob ();
@@ -455,7 +498,7 @@ namespace sl3
   Type
   DbValue::dbtype () const
   {
-    return _type;
+    return _value.auxType ();
   }
 
   Type
@@ -471,11 +514,11 @@ namespace sl3
       {
         if (other.dbtype () == Type::Variant)
           {
-            return check (other.type ()).oneOf (_type, Type::Null);
+            return check (other.type ()).oneOf (dbtype (), Type::Null);
           }
         else
           {
-            return check (_type).sameAs (other.dbtype ());
+            return check (dbtype ()).sameAs (other.dbtype ());
           }
       }
 
@@ -9,6 +9,8 @@
 #include <sl3/dbvalues.hpp>
 #include <sl3/error.hpp>
 
+#include <algorithm>
+
 namespace sl3
 {
 #ifdef _MSC_VER
@@ -91,4 +93,40 @@ namespace sl3
   {
     a.swap (b);
   }
+
+  namespace
+  {
+    std::size_t
+    hashCombine (std::size_t seed, std::size_t h) noexcept
+    {
+      return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+    }
+  }
+
+  bool
+  dbvals_eq (const DbValues& a, const DbValues& b) noexcept
+  {
+    return a.size () == b.size ()
+           && std::equal (a.begin (), a.end (), b.begin (), &dbval_eq);
+  }
+
+  std::size_t
+  dbvals_hash (const DbValues& row) noexcept
+  {
+    std::size_t h = row.size ();
+    for (const auto& val : row)
+      h = hashCombine (h, dbval_hash (val));
+
+    return h;
+  }
+
+  std::size_t
+  dbvals_hash (const DbValues& row, const std::vector<size_t>& idxs)
+  {
+    std::size_t h = idxs.size ();
+    for (auto idx : idxs)
+      h = hashCombine (h, dbval_hash (row.at (idx)));
+
+    return h;
+  }
 }
@@ -0,0 +1,315 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/function.hpp>
+
+#include <exception>
+#include <new>
+
+#include <sqlite3.h>
+
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  static_assert (FunctionFlag::Deterministic == SQLITE_DETERMINISTIC,
+                 "FunctionFlag::Deterministic out of sync with sqlite");
+
+  namespace internal
+  {
+    namespace
+    {
+      void
+      callFunction (sqlite3_context* ctx, int argc, sqlite3_value** argv)
+      {
+        auto fn = static_cast<FunctionBase*> (sqlite3_user_data (ctx));
+        try
+          {
+            fn->call (ctx, argc, argv);
+          }
+        catch (const std::bad_alloc&)
+          {
+            sqlite3_result_error_nomem (ctx);
+          }
+        catch (const std::exception& e)
+          {
+            sqlite3_result_error (ctx, e.what (), -1);
+          }
+        catch (...)
+          {
+            sqlite3_result_error (ctx, "unknown exception", -1);
+          }
+      }
+
+      void
+      destroyFunction (void* p)
+      {
+        delete static_cast<FunctionBase*> (p);
+      }
+
+      // run an aggregate callback, reporting exceptions as sql error
+      template <typename CALL>
+      void
+      guarded (sqlite3_context* ctx, CALL call)
+      {
+        try
+          {
+            call (static_cast<AggregateBase*> (sqlite3_user_data (ctx)));
+          }
+        catch (const std::bad_alloc&)
+          {
+            sqlite3_result_error_nomem (ctx);
+          }
+        catch (const std::exception& e)
+          {
+            sqlite3_result_error (ctx, e.what (), -1);
+          }
+        catch (...)
+          {
+            sqlite3_result_error (ctx, "unknown exception", -1);
+          }
+      }
+
+      void
+      aggregateStep (sqlite3_context* ctx, int argc, sqlite3_value** argv)
+      {
+        guarded (ctx, [=](AggregateBase* fn) { fn->step (ctx, argc, argv); });
+      }
+
+      void
+      aggregateFinal (sqlite3_context* ctx)
+      {
+        guarded (ctx, [=](AggregateBase* fn) { fn->final (ctx); });
+      }
+
+      void
+      aggregateValue (sqlite3_context* ctx)
+      {
+        guarded (ctx, [=](AggregateBase* fn) { fn->value (ctx); });
+      }
+
+      void
+      aggregateInverse (sqlite3_context* ctx, int argc, sqlite3_value** argv)
+      {
+        guarded (ctx,
+                 [=](AggregateBase* fn) { fn->inverse (ctx, argc, argv); });
+      }
+
+      void
+      destroyAggregate (void* p)
+      {
+        delete static_cast<AggregateBase*> (p);
+      }
+
+    } // ns
+
+    bool
+    argIsNull (sqlite3_value* v)
+    {
+      return sqlite3_value_type (v) == SQLITE_NULL;
+    }
+
+    int64_t
+    argInt64 (sqlite3_value* v)
+    {
+      return sqlite3_value_int64 (v);
+    }
+
+    double
+    argReal (sqlite3_value* v)
+    {
+      return sqlite3_value_double (v);
+    }
+
+    std::string
+    argText (sqlite3_value* v)
+    {
+      // call text first, bytes is only valid afterwards
+      auto text = reinterpret_cast<const char*> (sqlite3_value_text (v));
+      if (text == nullptr)
+        return std::string{};
+
+      return std::string (text,
+                          static_cast<std::size_t> (sqlite3_value_bytes (v)));
+    }
+
+    Blob
+    argBlob (sqlite3_value* v)
+    {
+      auto data = static_cast<const char*> (sqlite3_value_blob (v));
+      if (data == nullptr)
+        return Blob{};
+
+      return Blob (data, data + sqlite3_value_bytes (v));
+    }
+
+    Value
+    argValue (sqlite3_value* v)
+    {
+      switch (sqlite3_value_type (v))
+        {
+        case SQLITE_INTEGER:
+          return Value{argInt64 (v)};
+
+        case SQLITE_FLOAT:
+          return Value{argReal (v)};
+
+        case SQLITE_TEXT:
+          return Value{argText (v)};
+
+        case SQLITE_BLOB:
+          return Value{argBlob (v)};
+
+        default:
+          return Value{};
+        }
+    }
+
+    void*
+    aggregateContext (sqlite3_context* ctx, std::size_t size)
+    {
+      return sqlite3_aggregate_context (ctx, static_cast<int> (size));
+    }
+
+    void
+    resultNull (sqlite3_context* ctx)
+    {
+      sqlite3_result_null (ctx);
+    }
+
+    void
+    resultInt64 (sqlite3_context* ctx, int64_t val)
+    {
+      sqlite3_result_int64 (ctx, val);
+    }
+
+    void
+    resultReal (sqlite3_context* ctx, double val)
+    {
+      sqlite3_result_double (ctx, val);
+    }
+
+    void
+    resultText (sqlite3_context* ctx, const std::string& val)
+    {
+      sqlite3_result_text (ctx,
+                           val.c_str (),
+                           static_cast<int> (val.size ()),
+                           SQLITE_TRANSIENT);
+    }
+
+    void
+    resultBlob (sqlite3_context* ctx, const Blob& val)
+    {
+      sqlite3_result_blob (ctx,
+                           val.data (),
+                           static_cast<int> (val.size ()),
+                           SQLITE_TRANSIENT);
+    }
+
+    void
+    resultValue (sqlite3_context* ctx, const Value& val)
+    {
+      switch (val.getType ())
+        {
+        case Type::Int:
+          resultInt64 (ctx, val.int64 ());
+          break;
+
+        case Type::Real:
+          resultReal (ctx, val.real ());
+          break;
+
+        // data and size give the bytes without copy
+        case Type::Text:
+          sqlite3_result_text (ctx,
+                               val.data (),
+                               static_cast<int> (val.size ()),
+                               SQLITE_TRANSIENT);
+          break;
+
+        case Type::Blob:
+          sqlite3_result_blob (ctx,
+                               val.data (),
+                               static_cast<int> (val.size ()),
+                               SQLITE_TRANSIENT);
+          break;
+
+        default:
+          resultNull (ctx);
+          break;
+        }
+    }
+
+    void
+    createScalarFunction (sqlite3*           db,
+                          const std::string& name,
+                          int                nArg,
+                          int                flags,
+                          FunctionBase*      fn)
+    {
+      // xDestroy is also called if the registration fails
+      int rc = sqlite3_create_function_v2 (db,
+                                           name.c_str (),
+                                           nArg,
+                                           SQLITE_UTF8 | flags,
+                                           fn,
+                                           &callFunction,
+                                           nullptr,
+                                           nullptr,
+                                           &destroyFunction);
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (db)};
+    }
+
+    void
+    createAggregateFunction (sqlite3*           db,
+                             const std::string& name,
+                             int                nArg,
+                             int                flags,
+                             AggregateBase*     fn,
+                             bool               window)
+    {
+      int rc = SQLITE_OK;
+      if (window)
+        {
+#if SQLITE_VERSION_NUMBER >= 3025000
+          rc = sqlite3_create_window_function (db,
+                                               name.c_str (),
+                                               nArg,
+                                               SQLITE_UTF8 | flags,
+                                               fn,
+                                               &aggregateStep,
+                                               &aggregateFinal,
+                                               &aggregateValue,
+                                               &aggregateInverse,
+                                               &destroyAggregate);
+#else
+          destroyAggregate (fn);
+          throw SQLite3Error{SQLITE_ERROR,
+                             "window functions require sqlite 3.25.0"};
+#endif
+        }
+      else
+        {
+          rc = sqlite3_create_function_v2 (db,
+                                           name.c_str (),
+                                           nArg,
+                                           SQLITE_UTF8 | flags,
+                                           fn,
+                                           nullptr,
+                                           &aggregateStep,
+                                           &aggregateFinal,
+                                           &destroyAggregate);
+        }
+
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (db)};
+    }
+  }
+}
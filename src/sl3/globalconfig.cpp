@@ -0,0 +1,147 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/globalconfig.hpp>
+
+#include <sqlite3.h>
+
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  namespace
+  {
+    // sqlite3_mem_methods pass no user data to the allocation functions
+    std::shared_ptr<Allocator> installed;
+    sqlite3_mem_methods        previous;
+
+    void*
+    xMalloc (int size)
+    {
+      return installed->allocate (size);
+    }
+
+    void
+    xFree (void* p)
+    {
+      installed->deallocate (p);
+    }
+
+    void*
+    xRealloc (void* p, int size)
+    {
+      return installed->reallocate (p, size);
+    }
+
+    int
+    xSize (void* p)
+    {
+      return installed->size (p);
+    }
+
+    int
+    xRoundup (int size)
+    {
+      return installed->roundup (size);
+    }
+
+    int
+    xInit (void*)
+    {
+      return SQLITE_OK;
+    }
+
+    void
+    xShutdown (void*)
+    {
+    }
+
+    template <typename... Args>
+    void
+    configure (int option, Args... args)
+    {
+      int rc = sqlite3_config (option, args...);
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, "sqlite3_config failed, is sqlite in use?"};
+    }
+  } // ns
+
+  void
+  initialize (const GlobalConfig& config)
+  {
+    switch (config.threading)
+      {
+      case ThreadingMode::SingleThread:
+        configure (SQLITE_CONFIG_SINGLETHREAD);
+        break;
+      case ThreadingMode::MultiThread:
+        configure (SQLITE_CONFIG_MULTITHREAD);
+        break;
+      case ThreadingMode::Serialized:
+        configure (SQLITE_CONFIG_SERIALIZED);
+        break;
+      default:
+        break;
+      }
+
+    if (config.memoryStatus >= 0)
+      configure (SQLITE_CONFIG_MEMSTATUS, config.memoryStatus ? 1 : 0);
+
+    if (config.pageCacheSlotSize > 0 && config.pageCacheSlots > 0)
+      configure (SQLITE_CONFIG_PAGECACHE,
+                 static_cast<void*> (nullptr),
+                 config.pageCacheSlotSize,
+                 config.pageCacheSlots);
+
+    if (config.lookasideSlotSize >= 0 && config.lookasideSlots >= 0)
+      configure (SQLITE_CONFIG_LOOKASIDE,
+                 config.lookasideSlotSize,
+                 config.lookasideSlots);
+
+    if (config.mmapSize >= 0 || config.mmapSizeLimit >= 0)
+      {
+        // a negative value keeps the compile time setting
+        configure (SQLITE_CONFIG_MMAP_SIZE,
+                   static_cast<sqlite3_int64> (config.mmapSize),
+                   static_cast<sqlite3_int64> (config.mmapSizeLimit));
+      }
+
+    if (config.allocator)
+      {
+        if (!installed)
+          configure (SQLITE_CONFIG_GETMALLOC, &previous);
+
+        static sqlite3_mem_methods methods = {&xMalloc,
+                                              &xFree,
+                                              &xRealloc,
+                                              &xSize,
+                                              &xRoundup,
+                                              &xInit,
+                                              &xShutdown,
+                                              nullptr};
+        configure (SQLITE_CONFIG_MALLOC, &methods);
+        installed = config.allocator;
+      }
+
+    int rc = sqlite3_initialize ();
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errstr (rc)}; // LCOV_EXCL_LINE
+  }
+
+  void
+  shutdown ()
+  {
+    sqlite3_shutdown ();
+
+    if (installed)
+      {
+        sqlite3_config (SQLITE_CONFIG_MALLOC, &previous);
+        installed.reset ();
+      }
+  }
+}
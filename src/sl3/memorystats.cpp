@@ -0,0 +1,143 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/memorystats.hpp>
+
+#include <sqlite3.h>
+
+#include "connection.hpp"
+
+namespace sl3
+{
+  namespace
+  {
+    struct DbStatus
+    {
+      int64_t current;
+      int64_t highwater;
+    };
+
+    DbStatus
+    dbStatus (sqlite3* db, int op, bool reset)
+    {
+      int cur = 0, hw = 0;
+      sqlite3_db_status (db, op, &cur, &hw, reset ? 1 : 0);
+      return DbStatus{cur, hw};
+    }
+
+    DbStatus
+    status (int op, bool reset)
+    {
+      sqlite3_int64 cur = 0, hw = 0;
+      sqlite3_status64 (op, &cur, &hw, reset ? 1 : 0);
+      return DbStatus{cur, hw};
+    }
+  } // ns
+
+  DbMemoryStats
+  DbMemoryStats::operator- (const DbMemoryStats& other) const
+  {
+    DbMemoryStats d;
+    d.cacheUsed          = cacheUsed - other.cacheUsed;
+    d.cacheUsedShared    = cacheUsedShared - other.cacheUsedShared;
+    d.cacheHit           = cacheHit - other.cacheHit;
+    d.cacheMiss          = cacheMiss - other.cacheMiss;
+    d.cacheWrite         = cacheWrite - other.cacheWrite;
+    d.cacheSpill         = cacheSpill - other.cacheSpill;
+    d.lookasideUsed      = lookasideUsed - other.lookasideUsed;
+    d.lookasideHighwater = lookasideHighwater - other.lookasideHighwater;
+    d.lookasideHit       = lookasideHit - other.lookasideHit;
+    d.lookasideMissSize  = lookasideMissSize - other.lookasideMissSize;
+    d.lookasideMissFull  = lookasideMissFull - other.lookasideMissFull;
+    d.schemaUsed         = schemaUsed - other.schemaUsed;
+    d.stmtUsed           = stmtUsed - other.stmtUsed;
+    return d;
+  }
+
+  GlobalMemoryStats
+  GlobalMemoryStats::operator- (const GlobalMemoryStats& other) const
+  {
+    GlobalMemoryStats d;
+    d.memoryUsed         = memoryUsed - other.memoryUsed;
+    d.memoryHighwater    = memoryHighwater - other.memoryHighwater;
+    d.mallocCount        = mallocCount - other.mallocCount;
+    d.mallocHighwater    = mallocHighwater - other.mallocHighwater;
+    d.largestMalloc      = largestMalloc - other.largestMalloc;
+    d.pagecacheUsed      = pagecacheUsed - other.pagecacheUsed;
+    d.pagecacheOverflow  = pagecacheOverflow - other.pagecacheOverflow;
+    d.pagecacheHighwater = pagecacheHighwater - other.pagecacheHighwater;
+    d.largestPagecache   = largestPagecache - other.largestPagecache;
+    return d;
+  }
+
+  GlobalMemoryStats
+  globalMemoryStats (bool reset)
+  {
+    GlobalMemoryStats s;
+
+    auto used         = status (SQLITE_STATUS_MEMORY_USED, reset);
+    s.memoryUsed      = used.current;
+    s.memoryHighwater = used.highwater;
+
+    auto count        = status (SQLITE_STATUS_MALLOC_COUNT, reset);
+    s.mallocCount     = count.current;
+    s.mallocHighwater = count.highwater;
+
+    s.largestMalloc = status (SQLITE_STATUS_MALLOC_SIZE, reset).highwater;
+
+    s.pagecacheUsed = status (SQLITE_STATUS_PAGECACHE_USED, reset).current;
+
+    auto overflow        = status (SQLITE_STATUS_PAGECACHE_OVERFLOW, reset);
+    s.pagecacheOverflow  = overflow.current;
+    s.pagecacheHighwater = overflow.highwater;
+
+    s.largestPagecache = status (SQLITE_STATUS_PAGECACHE_SIZE, reset).highwater;
+
+    return s;
+  }
+
+  DbMemoryStats
+  Database::memoryStats (bool reset) const
+  {
+    _connection->ensureValid ();
+    sqlite3* db = _connection->db ();
+
+    DbMemoryStats s;
+
+    s.cacheUsed = dbStatus (db, SQLITE_DBSTATUS_CACHE_USED, false).current;
+#ifdef SQLITE_DBSTATUS_CACHE_USED_SHARED
+    s.cacheUsedShared
+        = dbStatus (db, SQLITE_DBSTATUS_CACHE_USED_SHARED, false).current;
+#else
+    s.cacheUsedShared = s.cacheUsed;
+#endif
+    s.cacheHit   = dbStatus (db, SQLITE_DBSTATUS_CACHE_HIT, reset).current;
+    s.cacheMiss  = dbStatus (db, SQLITE_DBSTATUS_CACHE_MISS, reset).current;
+    s.cacheWrite = dbStatus (db, SQLITE_DBSTATUS_CACHE_WRITE, reset).current;
+#ifdef SQLITE_DBSTATUS_CACHE_SPILL
+    s.cacheSpill = dbStatus (db, SQLITE_DBSTATUS_CACHE_SPILL, reset).current;
+#endif
+
+    auto lookaside = dbStatus (db, SQLITE_DBSTATUS_LOOKASIDE_USED, reset);
+    s.lookasideUsed      = lookaside.current;
+    s.lookasideHighwater = lookaside.highwater;
+
+    // these counters are reported as high water value
+    s.lookasideHit
+        = dbStatus (db, SQLITE_DBSTATUS_LOOKASIDE_HIT, reset).highwater;
+    s.lookasideMissSize
+        = dbStatus (db, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, reset).highwater;
+    s.lookasideMissFull
+        = dbStatus (db, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, reset).highwater;
+
+    s.schemaUsed = dbStatus (db, SQLITE_DBSTATUS_SCHEMA_USED, false).current;
+    s.stmtUsed   = dbStatus (db, SQLITE_DBSTATUS_STMT_USED, false).current;
+
+    return s;
+  }
+}
@@ -0,0 +1,141 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_PARALLEL_HPP_
+#define SL3_PARALLEL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace sl3
+{
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Run tasks on own threads, the last one on the calling thread
+     *
+     * Returns when all tasks are done.
+     * The first exception of a task is rethrown.
+     */
+    inline void
+    runTasks (const std::vector<std::function<void ()>>& tasks)
+    {
+      std::vector<std::exception_ptr> errors (tasks.size ());
+      auto run = [&tasks, &errors] (std::size_t i) {
+        try
+          {
+            tasks[i] ();
+          }
+        catch (...)
+          {
+            errors[i] = std::current_exception ();
+          }
+      };
+
+      std::vector<std::thread> threads;
+      for (std::size_t i = 0; i + 1 < tasks.size (); ++i)
+        threads.emplace_back (run, i);
+
+      if (!tasks.empty ())
+        run (tasks.size () - 1);
+
+      for (auto& t : threads)
+        t.join ();
+
+      for (auto& e : errors)
+        if (e)
+          std::rethrow_exception (e);
+    }
+
+    /**
+     * \internal
+     * \brief Split [0, size) into count ranges of about equal size
+     *
+     * \return count + 1 bounds
+     */
+    inline std::vector<std::size_t>
+    splitRange (std::size_t size, std::size_t count)
+    {
+      std::vector<std::size_t> bounds (count + 1);
+      for (std::size_t i = 0; i <= count; ++i)
+        bounds[i] = size * i / count;
+      return bounds;
+    }
+
+    /**
+     * \internal
+     * \brief Parallel merge sort
+     *
+     * data is split into one chunk per thread, the chunks are sorted by
+     * sortChunk (first, last) and then merged pairwise, the merges of a
+     * round in parallel. The merge keeps the order of equal elements,
+     * so the result is stable if sortChunk is.
+     */
+    template <typename T, typename SortChunk, typename Less>
+    void
+    parallelSort (std::vector<T>& data,
+                  std::size_t     threads,
+                  SortChunk       sortChunk,
+                  Less            less)
+    {
+      using Iter        = typename std::vector<T>::iterator;
+      const auto chunks = std::max<std::size_t> (
+          1, std::min (threads, data.size ()));
+      const auto bounds = splitRange (data.size (), chunks);
+
+      std::vector<std::function<void ()>> tasks;
+      for (std::size_t c = 0; c < chunks; ++c)
+        {
+          Iter first = data.begin () + bounds[c];
+          Iter last  = data.begin () + bounds[c + 1];
+          tasks.emplace_back ([first, last, &sortChunk] {
+            sortChunk (first, last);
+          });
+        }
+      runTasks (tasks);
+
+      std::vector<T> buffer (data.size ());
+      std::vector<T>* from = &data;
+      std::vector<T>* to   = &buffer;
+      for (std::size_t width = 1; width < chunks; width *= 2)
+        {
+          tasks.clear ();
+          for (std::size_t c = 0; c < chunks; c += 2 * width)
+            {
+              const auto begin = bounds[c];
+              const auto mid   = bounds[std::min (c + width, chunks)];
+              const auto end   = bounds[std::min (c + 2 * width, chunks)];
+              tasks.emplace_back ([=, &less] {
+                auto src = std::make_move_iterator (from->begin ());
+                std::merge (src + begin,
+                            src + mid,
+                            src + mid,
+                            src + end,
+                            to->begin () + begin,
+                            less);
+              });
+            }
+          runTasks (tasks);
+          std::swap (from, to);
+        }
+
+      if (from != &data)
+        data.swap (buffer);
+    }
+  }
+  /// \endcond
+}
+
+#endif
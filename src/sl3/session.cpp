@@ -0,0 +1,285 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/session.hpp>
+
+#include <sqlite3.h>
+
+#include "connection.hpp"
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+#ifdef SQLITE_ENABLE_SESSION
+
+  namespace
+  {
+    sqlite3_session*
+    createSession (sqlite3* db, const std::string& dbname)
+    {
+      sqlite3_session* session = nullptr;
+      int rc = sqlite3session_create (db, dbname.c_str (), &session);
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (db)};
+
+      return session;
+    }
+
+    void
+    deleteSession (void* session)
+    {
+      sqlite3session_delete (static_cast<sqlite3_session*> (session));
+    }
+
+    Blob
+    toBlob (sqlite3* db, int rc, int size, void* data)
+    {
+      using scope_guard = std::unique_ptr<void, decltype (&sqlite3_free)>;
+      scope_guard guard (data, &sqlite3_free);
+
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (db)};
+
+      auto bytes = static_cast<const char*> (data);
+      return Blob (bytes, bytes + size);
+    }
+
+    struct ApplyContext
+    {
+      ConflictPolicy         policy;
+      const ChangesetFilter* filter;
+    };
+
+    int
+    applyFilter (void* ctx, const char* table)
+    {
+      auto apply = static_cast<ApplyContext*> (ctx);
+      try
+        {
+          return (*apply->filter) (table) ? 1 : 0;
+        }
+      catch (...) // LCOV_EXCL_LINE
+        {
+          return 0; // LCOV_EXCL_LINE
+        }
+    }
+
+    int
+    applyConflict (void* ctx, int conflict, sqlite3_changeset_iter*)
+    {
+      auto apply = static_cast<ApplyContext*> (ctx);
+      switch (apply->policy)
+        {
+        case ConflictPolicy::Abort:
+          return SQLITE_CHANGESET_ABORT;
+
+        case ConflictPolicy::Replace:
+          // replace is only valid for these conflict types
+          if (conflict == SQLITE_CHANGESET_DATA
+              || conflict == SQLITE_CHANGESET_CONFLICT)
+            return SQLITE_CHANGESET_REPLACE;
+          return SQLITE_CHANGESET_OMIT;
+
+        default:
+          return SQLITE_CHANGESET_OMIT;
+        }
+    }
+  } // ns
+
+  Session::Session (Connection connection, const std::string& dbname)
+  : _connection (std::move (connection))
+  , _session (nullptr)
+  {
+    _connection->ensureValid ();
+    _session = createSession (_connection->db (), dbname);
+    // sessions must be deleted before the database is closed
+    _connection->closeHandlers[_session] = &deleteSession;
+  }
+
+  Session::~Session ()
+  {
+    if (_session && _connection->isValid ())
+      {
+        _connection->closeHandlers.erase (_session);
+        sqlite3session_delete (_session);
+      }
+  }
+
+  void
+  Session::attach (const std::string& table)
+  {
+    ensureOpen ();
+    int rc = sqlite3session_attach (_session, table.c_str ());
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errmsg (_connection->db ())};
+  }
+
+  void
+  Session::attachAll ()
+  {
+    ensureOpen ();
+    int rc = sqlite3session_attach (_session, nullptr);
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errmsg (_connection->db ())};
+  }
+
+  Blob
+  Session::changeset () const
+  {
+    ensureOpen ();
+    int   size = 0;
+    void* data = nullptr;
+    int   rc   = sqlite3session_changeset (_session, &size, &data);
+    return toBlob (_connection->db (), rc, size, data);
+  }
+
+  Blob
+  Session::patchset () const
+  {
+    ensureOpen ();
+    int   size = 0;
+    void* data = nullptr;
+    int   rc   = sqlite3session_patchset (_session, &size, &data);
+    return toBlob (_connection->db (), rc, size, data);
+  }
+
+  bool
+  Session::isEmpty () const
+  {
+    ensureOpen ();
+    return sqlite3session_isempty (_session) != 0;
+  }
+
+  void
+  Session::enable (bool enabled)
+  {
+    ensureOpen ();
+    sqlite3session_enable (_session, enabled ? 1 : 0);
+  }
+
+  bool
+  Session::isEnabled () const
+  {
+    ensureOpen ();
+    return sqlite3session_enable (_session, -1) != 0;
+  }
+
+  namespace internal
+  {
+    void
+    applyChangeset (sqlite3*               db,
+                    const Blob&            changeset,
+                    ConflictPolicy         policy,
+                    const ChangesetFilter& filter)
+    {
+      ApplyContext ctx{policy, &filter};
+
+      int rc = sqlite3changeset_apply (
+          db,
+          static_cast<int> (changeset.size ()),
+          const_cast<char*> (changeset.data ()),
+          filter ? &applyFilter : nullptr,
+          &applyConflict,
+          &ctx);
+
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (db)};
+    }
+  }
+
+#else
+
+  namespace
+  {
+    [[noreturn]] void
+    notEnabled ()
+    {
+      throw SQLite3Error{SQLITE_ERROR,
+                         "libsl3 was built without SQLITE_ENABLE_SESSION"};
+    }
+  } // ns
+
+  Session::Session (Connection connection, const std::string&)
+  : _connection (std::move (connection))
+  , _session (nullptr)
+  {
+    notEnabled ();
+  }
+
+  Session::~Session () {}
+
+  void
+  Session::attach (const std::string&)
+  {
+    notEnabled ();
+  }
+
+  void
+  Session::attachAll ()
+  {
+    notEnabled ();
+  }
+
+  Blob
+  Session::changeset () const
+  {
+    notEnabled ();
+  }
+
+  Blob
+  Session::patchset () const
+  {
+    notEnabled ();
+  }
+
+  bool
+  Session::isEmpty () const
+  {
+    notEnabled ();
+  }
+
+  void
+  Session::enable (bool)
+  {
+    notEnabled ();
+  }
+
+  bool
+  Session::isEnabled () const
+  {
+    notEnabled ();
+  }
+
+  namespace internal
+  {
+    void
+    applyChangeset (sqlite3*,
+                    const Blob&,
+                    ConflictPolicy,
+                    const ChangesetFilter&)
+    {
+      notEnabled ();
+    }
+  }
+
+#endif
+
+  Session::Session (Session&& other) noexcept
+  : _connection (std::move (other._connection))
+  , _session (other._session)
+  { // clear session so that d'tor of other does no action
+    other._session = nullptr;
+  }
+
+  void
+  Session::ensureOpen () const
+  {
+    if (_session == nullptr || !_connection->isValid ())
+      throw ErrNoConnection{};
+  }
+}
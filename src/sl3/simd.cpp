@@ -0,0 +1,630 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include "simd.hpp"
+
+// the vector kernels are compiled via target attributes, so the library
+// needs no special compiler flags and runs on any x86 CPU
+#if (defined(__GNUC__) || defined(__clang__))                                 \
+    && (defined(__x86_64__) || defined(__i386__))
+#define SL3_SIMD_X86 1
+#include <immintrin.h>
+#define SL3_TARGET(isa) __attribute__ ((target (isa)))
+#endif
+
+namespace sl3
+{
+  namespace internal
+  {
+    namespace
+    {
+      int64_t
+      sumIntScalar (const int64_t* v, std::size_t n)
+      {
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < n; ++i)
+          sum += static_cast<uint64_t> (v[i]);
+        return static_cast<int64_t> (sum);
+      }
+
+      double
+      sumRealScalar (const double* v, std::size_t n)
+      {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+          sum += v[i];
+        return sum;
+      }
+
+      template <typename T>
+      void
+      minMaxScalar (const T* v, std::size_t n, T* min, T* max)
+      {
+        T lo = *min;
+        T hi = *max;
+        for (std::size_t i = 0; i < n; ++i)
+          {
+            lo = v[i] < lo ? v[i] : lo;
+            hi = hi < v[i] ? v[i] : hi;
+          }
+        *min = lo;
+        *max = hi;
+      }
+
+      template <typename T>
+      uint64_t
+      rangeScalar (const T* v, T lo, T hi)
+      {
+        uint64_t mask = 0;
+        for (unsigned i = 0; i < 64; ++i)
+          mask |= static_cast<uint64_t> (lo <= v[i] && v[i] <= hi) << i;
+        return mask;
+      }
+
+      const Kernels scalarKernels = {&sumIntScalar,
+                                     &sumRealScalar,
+                                     &minMaxScalar<int64_t>,
+                                     &minMaxScalar<double>,
+                                     &minMaxScalar<int32_t>,
+                                     &rangeScalar<int64_t>,
+                                     &rangeScalar<double>,
+                                     &rangeScalar<int32_t>};
+
+#ifdef SL3_SIMD_X86
+
+      // SSE4.2 ----------------------------------------------------------
+
+      SL3_TARGET ("sse4.2")
+      int64_t
+      sumIntSse (const int64_t* v, std::size_t n)
+      {
+        __m128i     acc = _mm_setzero_si128 ();
+        std::size_t i   = 0;
+        for (; i + 2 <= n; i += 2)
+          acc = _mm_add_epi64 (
+              acc, _mm_loadu_si128 (reinterpret_cast<const __m128i*> (v + i)));
+
+        uint64_t lanes[2];
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (lanes), acc);
+        return static_cast<int64_t> (
+            lanes[0] + lanes[1]
+            + static_cast<uint64_t> (sumIntScalar (v + i, n - i)));
+      }
+
+      SL3_TARGET ("sse4.2")
+      double
+      sumRealSse (const double* v, std::size_t n)
+      {
+        __m128d     acc = _mm_setzero_pd ();
+        std::size_t i   = 0;
+        for (; i + 2 <= n; i += 2)
+          acc = _mm_add_pd (acc, _mm_loadu_pd (v + i));
+
+        double lanes[2];
+        _mm_storeu_pd (lanes, acc);
+        return lanes[0] + lanes[1] + sumRealScalar (v + i, n - i);
+      }
+
+      SL3_TARGET ("sse4.2")
+      void
+      minMaxIntSse (const int64_t* v,
+                    std::size_t    n,
+                    int64_t*       min,
+                    int64_t*       max)
+      {
+        __m128i     lo = _mm_set1_epi64x (*min);
+        __m128i     hi = _mm_set1_epi64x (*max);
+        std::size_t i  = 0;
+        for (; i + 2 <= n; i += 2)
+          {
+            __m128i x
+                = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (v + i));
+            lo = _mm_blendv_epi8 (lo, x, _mm_cmpgt_epi64 (lo, x));
+            hi = _mm_blendv_epi8 (hi, x, _mm_cmpgt_epi64 (x, hi));
+          }
+
+        int64_t lanes[2];
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (lanes), lo);
+        minMaxScalar (lanes, 2, min, max);
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (lanes), hi);
+        minMaxScalar (lanes, 2, min, max);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("sse4.2")
+      void
+      minMaxRealSse (const double* v, std::size_t n, double* min, double* max)
+      {
+        __m128d     lo = _mm_set1_pd (*min);
+        __m128d     hi = _mm_set1_pd (*max);
+        std::size_t i  = 0;
+        for (; i + 2 <= n; i += 2)
+          {
+            __m128d x = _mm_loadu_pd (v + i);
+            lo        = _mm_min_pd (lo, x);
+            hi        = _mm_max_pd (hi, x);
+          }
+
+        double lanes[2];
+        _mm_storeu_pd (lanes, lo);
+        minMaxScalar (lanes, 2, min, max);
+        _mm_storeu_pd (lanes, hi);
+        minMaxScalar (lanes, 2, min, max);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("sse4.2")
+      void
+      minMaxCodeSse (const int32_t* v,
+                     std::size_t    n,
+                     int32_t*       min,
+                     int32_t*       max)
+      {
+        __m128i     lo = _mm_set1_epi32 (*min);
+        __m128i     hi = _mm_set1_epi32 (*max);
+        std::size_t i  = 0;
+        for (; i + 4 <= n; i += 4)
+          {
+            __m128i x
+                = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (v + i));
+            lo = _mm_min_epi32 (lo, x);
+            hi = _mm_max_epi32 (hi, x);
+          }
+
+        int32_t lanes[4];
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (lanes), lo);
+        minMaxScalar (lanes, 4, min, max);
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (lanes), hi);
+        minMaxScalar (lanes, 4, min, max);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("sse4.2")
+      uint64_t
+      rangeIntSse (const int64_t* v, int64_t lo, int64_t hi)
+      {
+        const __m128i l    = _mm_set1_epi64x (lo);
+        const __m128i h    = _mm_set1_epi64x (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 2)
+          {
+            __m128i x
+                = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (v + i));
+            __m128i out
+                = _mm_or_si128 (_mm_cmpgt_epi64 (l, x), _mm_cmpgt_epi64 (x, h));
+            unsigned bits = ~_mm_movemask_pd (_mm_castsi128_pd (out)) & 0x3u;
+            mask |= static_cast<uint64_t> (bits) << i;
+          }
+        return mask;
+      }
+
+      SL3_TARGET ("sse4.2")
+      uint64_t
+      rangeRealSse (const double* v, double lo, double hi)
+      {
+        const __m128d l    = _mm_set1_pd (lo);
+        const __m128d h    = _mm_set1_pd (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 2)
+          {
+            __m128d x  = _mm_loadu_pd (v + i);
+            __m128d in = _mm_and_pd (_mm_cmpge_pd (x, l), _mm_cmple_pd (x, h));
+            mask |= static_cast<uint64_t> (_mm_movemask_pd (in)) << i;
+          }
+        return mask;
+      }
+
+      SL3_TARGET ("sse4.2")
+      uint64_t
+      rangeCodeSse (const int32_t* v, int32_t lo, int32_t hi)
+      {
+        const __m128i l    = _mm_set1_epi32 (lo);
+        const __m128i h    = _mm_set1_epi32 (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 4)
+          {
+            __m128i x
+                = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (v + i));
+            __m128i out
+                = _mm_or_si128 (_mm_cmpgt_epi32 (l, x), _mm_cmpgt_epi32 (x, h));
+            unsigned bits = ~_mm_movemask_ps (_mm_castsi128_ps (out)) & 0xfu;
+            mask |= static_cast<uint64_t> (bits) << i;
+          }
+        return mask;
+      }
+
+      const Kernels sseKernels = {&sumIntSse,
+                                  &sumRealSse,
+                                  &minMaxIntSse,
+                                  &minMaxRealSse,
+                                  &minMaxCodeSse,
+                                  &rangeIntSse,
+                                  &rangeRealSse,
+                                  &rangeCodeSse};
+
+      // AVX2 ------------------------------------------------------------
+
+      SL3_TARGET ("avx2")
+      int64_t
+      sumIntAvx2 (const int64_t* v, std::size_t n)
+      {
+        __m256i     acc = _mm256_setzero_si256 ();
+        std::size_t i   = 0;
+        for (; i + 4 <= n; i += 4)
+          acc = _mm256_add_epi64 (
+              acc,
+              _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (v + i)));
+
+        uint64_t lanes[4];
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (lanes), acc);
+        return static_cast<int64_t> (
+            lanes[0] + lanes[1] + lanes[2] + lanes[3]
+            + static_cast<uint64_t> (sumIntScalar (v + i, n - i)));
+      }
+
+      SL3_TARGET ("avx2")
+      double
+      sumRealAvx2 (const double* v, std::size_t n)
+      {
+        __m256d     acc = _mm256_setzero_pd ();
+        std::size_t i   = 0;
+        for (; i + 4 <= n; i += 4)
+          acc = _mm256_add_pd (acc, _mm256_loadu_pd (v + i));
+
+        double lanes[4];
+        _mm256_storeu_pd (lanes, acc);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+               + sumRealScalar (v + i, n - i);
+      }
+
+      SL3_TARGET ("avx2")
+      void
+      minMaxIntAvx2 (const int64_t* v,
+                     std::size_t    n,
+                     int64_t*       min,
+                     int64_t*       max)
+      {
+        __m256i     lo = _mm256_set1_epi64x (*min);
+        __m256i     hi = _mm256_set1_epi64x (*max);
+        std::size_t i  = 0;
+        for (; i + 4 <= n; i += 4)
+          {
+            __m256i x = _mm256_loadu_si256 (
+                reinterpret_cast<const __m256i*> (v + i));
+            lo = _mm256_blendv_epi8 (lo, x, _mm256_cmpgt_epi64 (lo, x));
+            hi = _mm256_blendv_epi8 (hi, x, _mm256_cmpgt_epi64 (x, hi));
+          }
+
+        int64_t lanes[4];
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (lanes), lo);
+        minMaxScalar (lanes, 4, min, max);
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (lanes), hi);
+        minMaxScalar (lanes, 4, min, max);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("avx2")
+      void
+      minMaxRealAvx2 (const double* v,
+                      std::size_t   n,
+                      double*       min,
+                      double*       max)
+      {
+        __m256d     lo = _mm256_set1_pd (*min);
+        __m256d     hi = _mm256_set1_pd (*max);
+        std::size_t i  = 0;
+        for (; i + 4 <= n; i += 4)
+          {
+            __m256d x = _mm256_loadu_pd (v + i);
+            lo        = _mm256_min_pd (lo, x);
+            hi        = _mm256_max_pd (hi, x);
+          }
+
+        double lanes[4];
+        _mm256_storeu_pd (lanes, lo);
+        minMaxScalar (lanes, 4, min, max);
+        _mm256_storeu_pd (lanes, hi);
+        minMaxScalar (lanes, 4, min, max);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("avx2")
+      void
+      minMaxCodeAvx2 (const int32_t* v,
+                      std::size_t    n,
+                      int32_t*       min,
+                      int32_t*       max)
+      {
+        __m256i     lo = _mm256_set1_epi32 (*min);
+        __m256i     hi = _mm256_set1_epi32 (*max);
+        std::size_t i  = 0;
+        for (; i + 8 <= n; i += 8)
+          {
+            __m256i x = _mm256_loadu_si256 (
+                reinterpret_cast<const __m256i*> (v + i));
+            lo = _mm256_min_epi32 (lo, x);
+            hi = _mm256_max_epi32 (hi, x);
+          }
+
+        int32_t lanes[8];
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (lanes), lo);
+        minMaxScalar (lanes, 8, min, max);
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (lanes), hi);
+        minMaxScalar (lanes, 8, min, max);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("avx2")
+      uint64_t
+      rangeIntAvx2 (const int64_t* v, int64_t lo, int64_t hi)
+      {
+        const __m256i l    = _mm256_set1_epi64x (lo);
+        const __m256i h    = _mm256_set1_epi64x (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 4)
+          {
+            __m256i x = _mm256_loadu_si256 (
+                reinterpret_cast<const __m256i*> (v + i));
+            __m256i out = _mm256_or_si256 (_mm256_cmpgt_epi64 (l, x),
+                                           _mm256_cmpgt_epi64 (x, h));
+            unsigned bits
+                = ~_mm256_movemask_pd (_mm256_castsi256_pd (out)) & 0xfu;
+            mask |= static_cast<uint64_t> (bits) << i;
+          }
+        return mask;
+      }
+
+      SL3_TARGET ("avx2")
+      uint64_t
+      rangeRealAvx2 (const double* v, double lo, double hi)
+      {
+        const __m256d l    = _mm256_set1_pd (lo);
+        const __m256d h    = _mm256_set1_pd (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 4)
+          {
+            __m256d x  = _mm256_loadu_pd (v + i);
+            __m256d in = _mm256_and_pd (_mm256_cmp_pd (x, l, _CMP_GE_OQ),
+                                        _mm256_cmp_pd (x, h, _CMP_LE_OQ));
+            mask |= static_cast<uint64_t> (_mm256_movemask_pd (in)) << i;
+          }
+        return mask;
+      }
+
+      SL3_TARGET ("avx2")
+      uint64_t
+      rangeCodeAvx2 (const int32_t* v, int32_t lo, int32_t hi)
+      {
+        const __m256i l    = _mm256_set1_epi32 (lo);
+        const __m256i h    = _mm256_set1_epi32 (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 8)
+          {
+            __m256i x = _mm256_loadu_si256 (
+                reinterpret_cast<const __m256i*> (v + i));
+            __m256i out = _mm256_or_si256 (_mm256_cmpgt_epi32 (l, x),
+                                           _mm256_cmpgt_epi32 (x, h));
+            unsigned bits
+                = ~_mm256_movemask_ps (_mm256_castsi256_ps (out)) & 0xffu;
+            mask |= static_cast<uint64_t> (bits) << i;
+          }
+        return mask;
+      }
+
+      const Kernels avx2Kernels = {&sumIntAvx2,
+                                   &sumRealAvx2,
+                                   &minMaxIntAvx2,
+                                   &minMaxRealAvx2,
+                                   &minMaxCodeAvx2,
+                                   &rangeIntAvx2,
+                                   &rangeRealAvx2,
+                                   &rangeCodeAvx2};
+
+      // AVX-512 ---------------------------------------------------------
+
+// the AVX-512 headers of GCC use _mm512_undefined_* values, which GCC
+// itself reports as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+      SL3_TARGET ("avx512f")
+      int64_t
+      sumIntAvx512 (const int64_t* v, std::size_t n)
+      {
+        __m512i     acc = _mm512_setzero_si512 ();
+        std::size_t i   = 0;
+        for (; i + 8 <= n; i += 8)
+          acc = _mm512_add_epi64 (acc, _mm512_loadu_si512 (v + i));
+
+        return static_cast<int64_t> (
+            static_cast<uint64_t> (_mm512_reduce_add_epi64 (acc))
+            + static_cast<uint64_t> (sumIntScalar (v + i, n - i)));
+      }
+
+      SL3_TARGET ("avx512f")
+      double
+      sumRealAvx512 (const double* v, std::size_t n)
+      {
+        __m512d     acc = _mm512_setzero_pd ();
+        std::size_t i   = 0;
+        for (; i + 8 <= n; i += 8)
+          acc = _mm512_add_pd (acc, _mm512_loadu_pd (v + i));
+
+        return _mm512_reduce_add_pd (acc) + sumRealScalar (v + i, n - i);
+      }
+
+      SL3_TARGET ("avx512f")
+      void
+      minMaxIntAvx512 (const int64_t* v,
+                       std::size_t    n,
+                       int64_t*       min,
+                       int64_t*       max)
+      {
+        __m512i     lo = _mm512_set1_epi64 (*min);
+        __m512i     hi = _mm512_set1_epi64 (*max);
+        std::size_t i  = 0;
+        for (; i + 8 <= n; i += 8)
+          {
+            __m512i x = _mm512_loadu_si512 (v + i);
+            lo        = _mm512_min_epi64 (lo, x);
+            hi        = _mm512_max_epi64 (hi, x);
+          }
+
+        *min = _mm512_reduce_min_epi64 (lo);
+        *max = _mm512_reduce_max_epi64 (hi);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("avx512f")
+      void
+      minMaxRealAvx512 (const double* v,
+                        std::size_t   n,
+                        double*       min,
+                        double*       max)
+      {
+        __m512d     lo = _mm512_set1_pd (*min);
+        __m512d     hi = _mm512_set1_pd (*max);
+        std::size_t i  = 0;
+        for (; i + 8 <= n; i += 8)
+          {
+            __m512d x = _mm512_loadu_pd (v + i);
+            lo        = _mm512_min_pd (lo, x);
+            hi        = _mm512_max_pd (hi, x);
+          }
+
+        *min = _mm512_reduce_min_pd (lo);
+        *max = _mm512_reduce_max_pd (hi);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("avx512f")
+      void
+      minMaxCodeAvx512 (const int32_t* v,
+                        std::size_t    n,
+                        int32_t*       min,
+                        int32_t*       max)
+      {
+        __m512i     lo = _mm512_set1_epi32 (*min);
+        __m512i     hi = _mm512_set1_epi32 (*max);
+        std::size_t i  = 0;
+        for (; i + 16 <= n; i += 16)
+          {
+            __m512i x = _mm512_loadu_si512 (v + i);
+            lo        = _mm512_min_epi32 (lo, x);
+            hi        = _mm512_max_epi32 (hi, x);
+          }
+
+        *min = _mm512_reduce_min_epi32 (lo);
+        *max = _mm512_reduce_max_epi32 (hi);
+        minMaxScalar (v + i, n - i, min, max);
+      }
+
+      SL3_TARGET ("avx512f")
+      uint64_t
+      rangeIntAvx512 (const int64_t* v, int64_t lo, int64_t hi)
+      {
+        const __m512i l    = _mm512_set1_epi64 (lo);
+        const __m512i h    = _mm512_set1_epi64 (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 8)
+          {
+            __m512i   x  = _mm512_loadu_si512 (v + i);
+            __mmask8  ge = _mm512_cmp_epi64_mask (x, l, _MM_CMPINT_NLT);
+            __mmask8  in = _mm512_mask_cmp_epi64_mask (ge, x, h, _MM_CMPINT_LE);
+            mask |= static_cast<uint64_t> (in) << i;
+          }
+        return mask;
+      }
+
+      SL3_TARGET ("avx512f")
+      uint64_t
+      rangeRealAvx512 (const double* v, double lo, double hi)
+      {
+        const __m512d l    = _mm512_set1_pd (lo);
+        const __m512d h    = _mm512_set1_pd (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 8)
+          {
+            __m512d  x  = _mm512_loadu_pd (v + i);
+            __mmask8 ge = _mm512_cmp_pd_mask (x, l, _CMP_GE_OQ);
+            __mmask8 in = _mm512_mask_cmp_pd_mask (ge, x, h, _CMP_LE_OQ);
+            mask |= static_cast<uint64_t> (in) << i;
+          }
+        return mask;
+      }
+
+      SL3_TARGET ("avx512f")
+      uint64_t
+      rangeCodeAvx512 (const int32_t* v, int32_t lo, int32_t hi)
+      {
+        const __m512i l    = _mm512_set1_epi32 (lo);
+        const __m512i h    = _mm512_set1_epi32 (hi);
+        uint64_t      mask = 0;
+        for (unsigned i = 0; i < 64; i += 16)
+          {
+            __m512i   x  = _mm512_loadu_si512 (v + i);
+            __mmask16 ge = _mm512_cmp_epi32_mask (x, l, _MM_CMPINT_NLT);
+            __mmask16 in = _mm512_mask_cmp_epi32_mask (ge, x, h, _MM_CMPINT_LE);
+            mask |= static_cast<uint64_t> (in) << i;
+          }
+        return mask;
+      }
+
+      const Kernels avx512Kernels = {&sumIntAvx512,
+                                     &sumRealAvx512,
+                                     &minMaxIntAvx512,
+                                     &minMaxRealAvx512,
+                                     &minMaxCodeAvx512,
+                                     &rangeIntAvx512,
+                                     &rangeRealAvx512,
+                                     &rangeCodeAvx512};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+    } // ns
+
+    SimdLevel
+    detectSimdLevel () noexcept
+    {
+#ifdef SL3_SIMD_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx512f"))
+        return SimdLevel::AVX512;
+      if (__builtin_cpu_supports ("avx2"))
+        return SimdLevel::AVX2;
+      if (__builtin_cpu_supports ("sse4.2"))
+        return SimdLevel::SSE42;
+#endif
+      return SimdLevel::Scalar;
+    }
+
+    const Kernels&
+    kernels (SimdLevel level) noexcept
+    {
+      switch (level)
+        {
+#ifdef SL3_SIMD_X86
+        case SimdLevel::AVX512:
+          return avx512Kernels;
+        case SimdLevel::AVX2:
+          return avx2Kernels;
+        case SimdLevel::SSE42:
+          return sseKernels;
+#endif
+        default:
+          return scalarKernels;
+        }
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_SIMD_HPP_
+#define SL3_SIMD_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sl3/columnkernels.hpp>
+
+namespace sl3
+{
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Kernels over plain arrays, one set per SimdLevel
+     *
+     * min/max functions require n > 0 and update *min and *max.
+     * range functions test 64 values and return a bitmask, bit i is set
+     * if lo <= v[i] <= hi.
+     * Sums of ints wrap around.
+     */
+    struct Kernels
+    {
+      int64_t (*sumInt) (const int64_t* v, std::size_t n);
+      double (*sumReal) (const double* v, std::size_t n);
+
+      void (*minMaxInt) (const int64_t* v,
+                         std::size_t    n,
+                         int64_t*       min,
+                         int64_t*       max);
+      void (*minMaxReal) (const double* v,
+                          std::size_t   n,
+                          double*       min,
+                          double*       max);
+      void (*minMaxCode) (const int32_t* v,
+                          std::size_t    n,
+                          int32_t*       min,
+                          int32_t*       max);
+
+      uint64_t (*rangeInt) (const int64_t* v, int64_t lo, int64_t hi);
+      uint64_t (*rangeReal) (const double* v, double lo, double hi);
+      uint64_t (*rangeCode) (const int32_t* v, int32_t lo, int32_t hi);
+    };
+
+    /**
+     * \internal
+     * \brief The highest level supported by the build and the CPU
+     */
+    SimdLevel detectSimdLevel () noexcept;
+
+    /**
+     * \internal
+     * \brief Kernels of a level, level must be supported
+     */
+    const Kernels& kernels (SimdLevel level) noexcept;
+  }
+}
+
+#endif
@@ -0,0 +1,120 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/snapshot.hpp>
+
+#include <sqlite3.h>
+
+#include "connection.hpp"
+#include "sqltext.hpp"
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  Snapshot::Snapshot (sqlite3_snapshot* snapshot)
+  : _snapshot (snapshot)
+  {
+  }
+
+  Snapshot::Snapshot (Snapshot&& other) noexcept
+  : _snapshot (other._snapshot)
+  { // clear snapshot so that d'tor of other does no action
+    other._snapshot = nullptr;
+  }
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+
+  Snapshot::~Snapshot ()
+  {
+    if (_snapshot)
+      sqlite3_snapshot_free (_snapshot);
+  }
+
+  int
+  Snapshot::compare (const Snapshot& other) const
+  {
+    if (_snapshot == nullptr || other._snapshot == nullptr)
+      throw ErrNoConnection{};
+
+    return sqlite3_snapshot_cmp (_snapshot, other._snapshot);
+  }
+
+  Snapshot
+  Database::takeSnapshot (const std::string& schema)
+  {
+    _connection->ensureValid ();
+    sqlite3* db = _connection->db ();
+
+    if (sqlite3_get_autocommit (db))
+      throw SQLite3Error{SQLITE_ERROR,
+                         "taking a snapshot needs an open transaction"};
+
+    // BEGIN is deferred, a read makes sure the read transaction exists
+    execute ("SELECT 1 FROM " + internal::quoteIdentifier (schema)
+             + ".sqlite_master LIMIT 1;");
+
+    sqlite3_snapshot* snapshot = nullptr;
+    int rc = sqlite3_snapshot_get (db, schema.c_str (), &snapshot);
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errmsg (db)};
+
+    return Snapshot{snapshot};
+  }
+
+  auto
+  Database::beginTransaction (const Snapshot& snapshot,
+                              const std::string& schema) -> Transaction
+  {
+    if (snapshot._snapshot == nullptr)
+      throw ErrNoConnection{};
+
+    Transaction transaction{_connection, TransactionMode::Deferred};
+
+    sqlite3* db = _connection->db ();
+    int rc = sqlite3_snapshot_open (db, schema.c_str (), snapshot._snapshot);
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, sqlite3_errmsg (db)};
+
+    return transaction;
+  }
+
+#else
+
+  namespace
+  {
+    [[noreturn]] void
+    notEnabled ()
+    {
+      throw SQLite3Error{SQLITE_ERROR,
+                         "libsl3 was built without SQLITE_ENABLE_SNAPSHOT"};
+    }
+  } // ns
+
+  Snapshot::~Snapshot () {}
+
+  int
+  Snapshot::compare (const Snapshot&) const
+  {
+    notEnabled ();
+  }
+
+  Snapshot
+  Database::takeSnapshot (const std::string&)
+  {
+    notEnabled ();
+  }
+
+  auto
+  Database::beginTransaction (const Snapshot&, const std::string&)
+      -> Transaction
+  {
+    notEnabled ();
+  }
+
+#endif
+}
@@ -0,0 +1,317 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include "sortkey.hpp"
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace sl3
+{
+  namespace internal
+  {
+    namespace
+    {
+      // storage classes in the order of value_lt
+      enum : char
+      {
+        nullTag   = 0x10,
+        numberTag = 0x20,
+        textTag   = 0x30,
+        blobTag   = 0x40
+      };
+
+      void
+      appendBigEndian (std::string& key, uint64_t bits)
+      {
+        char buf[8];
+        for (int i = 7; i >= 0; --i, bits >>= 8)
+          buf[i] = static_cast<char> (bits & 0xff);
+        key.append (buf, sizeof (buf));
+      }
+
+      // maps the order of doubles to the order of unsigned integers
+      uint64_t
+      orderedBits (double val)
+      {
+        if (val == 0.0)
+          val = 0.0; // -0.0 equals 0.0
+
+        uint64_t bits = 0;
+        std::memcpy (&bits, &val, sizeof (bits));
+        const uint64_t sign = uint64_t{1} << 63;
+        return (bits & sign) ? ~bits : bits | sign;
+      }
+
+      uint64_t
+      orderedBits (int64_t val)
+      {
+        return static_cast<uint64_t> (val) ^ (uint64_t{1} << 63);
+      }
+
+      // value_lt compares Int and Real as double, the exact integer is only
+      // the tie breaker between values of the same double
+      void
+      appendNumber (std::string& key, double approx, int64_t exact)
+      {
+        key.push_back (numberTag);
+        appendBigEndian (key, orderedBits (approx));
+        appendBigEndian (key, orderedBits (exact));
+      }
+
+      int64_t
+      truncated (double val)
+      {
+        const double twoPow63 = 9223372036854775808.0;
+        if (val >= -twoPow63 && val < twoPow63)
+          return static_cast<int64_t> (val);
+
+        return val < 0 ? std::numeric_limits<int64_t>::min ()
+                       : std::numeric_limits<int64_t>::max ();
+      }
+
+      // 0 is escaped as 0 0xff, the end is marked by 0 0
+      void
+      appendBytes (std::string& key, const char* data, std::size_t size,
+                   unsigned char flip)
+      {
+        for (std::size_t i = 0; i < size; ++i)
+          {
+            const auto c = static_cast<unsigned char> (data[i]) ^ flip;
+            key.push_back (static_cast<char> (c));
+            if (c == 0)
+              key.push_back (static_cast<char> (0xff));
+          }
+        key.append (2, '\0');
+      }
+
+      struct SortEntry
+      {
+        uint64_t    prefix;
+        std::size_t row;
+      };
+
+      using EntryIter = std::vector<SortEntry>::iterator;
+
+      const std::size_t prefixSize = sizeof (uint64_t);
+
+      // radix passes before a run is sorted by full key compares, bounds
+      // the recursion for keys with long common prefixes
+      const std::size_t maxDepth = 4 * prefixSize;
+
+      // the key bytes from depth on as integer, zero padded
+      uint64_t
+      loadPrefix (const SortKeys& keys, std::size_t row, std::size_t depth)
+      {
+        const std::size_t begin = keys.offsets[row] + depth;
+        const std::size_t end   = keys.offsets[row + 1];
+        const std::size_t size
+            = begin < end ? std::min (end - begin, prefixSize) : 0;
+
+        uint64_t prefix = 0;
+        for (std::size_t i = 0; i < size; ++i)
+          prefix |= uint64_t{static_cast<unsigned char> (keys.bytes[begin + i])}
+                    << (8 * (prefixSize - 1 - i));
+        return prefix;
+      }
+
+      // full compare of the keys of 2 entries, for merging sorted runs and
+      // for runs that share long prefixes
+      bool
+      entryLess (const SortKeys& keys, const SortEntry& a, const SortEntry& b)
+      {
+        const auto beginA = keys.offsets[a.row];
+        const auto sizeA  = keys.offsets[a.row + 1] - beginA;
+        const auto beginB = keys.offsets[b.row];
+        const auto sizeB  = keys.offsets[b.row + 1] - beginB;
+        const auto n      = std::min (sizeA, sizeB);
+        const int  rc     = n > 0 ? std::memcmp (keys.bytes.data () + beginA,
+                                            keys.bytes.data () + beginB,
+                                            n)
+                           : 0;
+        if (rc != 0)
+          return rc < 0;
+        if (sizeA != sizeB)
+          return sizeA < sizeB;
+        return a.row < b.row;
+      }
+
+      // sorts by the key bytes from depth on, 8 bytes per pass, so only
+      // runs of equal prefixes touch the key bytes again
+      void
+      sortEntries (const SortKeys& keys,
+                   EntryIter       first,
+                   EntryIter       last,
+                   std::size_t     depth)
+      {
+        if (depth >= maxDepth)
+          {
+            std::sort (first, last, [&keys] (const SortEntry& a,
+                                             const SortEntry& b) {
+              return entryLess (keys, a, b);
+            });
+            return;
+          }
+
+        for (auto it = first; it != last; ++it)
+          it->prefix = loadPrefix (keys, it->row, depth);
+
+        std::sort (first, last, [] (const SortEntry& a, const SortEntry& b) {
+          return a.prefix != b.prefix ? a.prefix < b.prefix : a.row < b.row;
+        });
+
+        while (first != last)
+          {
+            auto end = first + 1;
+            while (end != last && end->prefix == first->prefix)
+              ++end;
+
+            // row keys are prefix free, if a key ends in this pass, all
+            // keys of the run are equal and stay ordered by row
+            const std::size_t size
+                = keys.offsets[first->row + 1] - keys.offsets[first->row];
+            if (end - first > 1 && size > depth + prefixSize)
+              sortEntries (keys, first, end, depth + prefixSize);
+
+            first = end;
+          }
+      }
+
+      void
+      appendKeys (SortKeys&                  keys,
+                  const Dataset&             ds,
+                  const std::vector<size_t>& idxs,
+                  std::size_t                first,
+                  std::size_t                last)
+      {
+        keys.offsets.reserve (last - first + 1);
+        // a number takes 17 bytes, a guess for the others
+        keys.bytes.reserve ((last - first) * idxs.size () * 17);
+        keys.offsets.push_back (0);
+        for (auto row = first; row < last; ++row)
+          {
+            for (auto idx : idxs)
+              appendSortKey (keys.bytes, ds[row].at (idx).getValue ());
+
+            keys.offsets.push_back (keys.bytes.size ());
+          }
+      }
+    }
+
+    void
+    appendSortKey (std::string& key, const Value& v)
+    {
+      switch (v.getType ())
+        {
+        case Type::Int:
+          appendNumber (key, static_cast<double> (v.int64 ()), v.int64 ());
+          break;
+
+        case Type::Real:
+          appendNumber (key, v.real (), truncated (v.real ()));
+          break;
+
+        case Type::Text:
+          // text compares like std::string, unsigned
+          key.push_back (textTag);
+          appendBytes (key, v.data (), v.size (), 0);
+          break;
+
+        case Type::Blob:
+          // blobs compare like std::vector<char>, char might be signed
+          key.push_back (blobTag);
+          appendBytes (key,
+                       v.data (),
+                       v.size (),
+                       std::numeric_limits<char>::is_signed ? 0x80 : 0);
+          break;
+
+        default:
+          key.push_back (nullTag);
+          break;
+        }
+    }
+
+    SortKeys
+    sortKeys (const Dataset&             ds,
+              const std::vector<size_t>& idxs,
+              std::size_t                threads)
+    {
+      const auto chunks = std::max<std::size_t> (
+          1, std::min (threads, ds.size ()));
+      const auto bounds = splitRange (ds.size (), chunks);
+
+      std::vector<SortKeys>               parts (chunks);
+      std::vector<std::function<void ()>> tasks;
+      for (std::size_t c = 0; c < chunks; ++c)
+        {
+          tasks.emplace_back ([&, c] {
+            appendKeys (parts[c], ds, idxs, bounds[c], bounds[c + 1]);
+          });
+        }
+      runTasks (tasks);
+
+      if (chunks == 1)
+        return std::move (parts[0]);
+
+      SortKeys keys;
+      keys.offsets.reserve (ds.size () + 1);
+      std::size_t bytes = 0;
+      for (const auto& part : parts)
+        bytes += part.bytes.size ();
+      keys.bytes.reserve (bytes);
+
+      keys.offsets.push_back (0);
+      for (const auto& part : parts)
+        {
+          const auto base = keys.bytes.size ();
+          keys.bytes.append (part.bytes);
+          for (std::size_t i = 1; i < part.offsets.size (); ++i)
+            keys.offsets.push_back (base + part.offsets[i]);
+        }
+
+      return keys;
+    }
+
+    std::vector<std::size_t>
+    sortedOrder (const SortKeys& keys, std::size_t threads)
+    {
+      std::vector<SortEntry> entries (keys.offsets.size () - 1);
+      for (std::size_t i = 0; i < entries.size (); ++i)
+        entries[i].row = i;
+
+      if (threads > 1)
+        {
+          parallelSort (
+              entries,
+              threads,
+              [&keys] (EntryIter first, EntryIter last) {
+                sortEntries (keys, first, last, 0);
+              },
+              [&keys] (const SortEntry& a, const SortEntry& b) {
+                return entryLess (keys, a, b);
+              });
+        }
+      else
+        {
+          sortEntries (keys, entries.begin (), entries.end (), 0);
+        }
+
+      std::vector<std::size_t> order;
+      order.reserve (entries.size ());
+      for (const auto& entry : entries)
+        order.push_back (entry.row);
+
+      return order;
+    }
+  }
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_SORTKEY_HPP_
+#define SL3_SORTKEY_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <sl3/dataset.hpp>
+#include <sl3/value.hpp>
+
+namespace sl3
+{
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Append the normalized binary key of a value
+     *
+     * Keys compare bytewise, via memcmp, in the order of value_lt.
+     * The key of a value is prefix free, so keys of several values can be
+     * concatenated to the key of a row.
+     */
+    void appendSortKey (std::string& key, const Value& v);
+
+    /**
+     * \internal
+     * \brief Keys of a list of rows, stored back to back
+     *
+     * The key of row i is bytes[offsets[i], offsets[i + 1]).
+     */
+    struct SortKeys
+    {
+      std::string              bytes;
+      std::vector<std::size_t> offsets;
+    };
+
+    /**
+     * \internal
+     * \brief Keys of the given fields of each row of a Dataset
+     *
+     * The rows are split between the given number of threads.
+     *
+     * \throw sl3::ErrOutOfRange if an index is invalid
+     */
+    SortKeys sortKeys (const Dataset&             ds,
+                       const std::vector<size_t>& idxs,
+                       std::size_t                threads = 1);
+
+    /**
+     * \internal
+     * \brief Positions of the keys in ascending order
+     *
+     * Equal keys keep their order.
+     * With more than one thread, a parallel merge sort is used.
+     */
+    std::vector<std::size_t> sortedOrder (const SortKeys& keys,
+                                          std::size_t     threads = 1);
+  }
+  /// \endcond
+}
+
+#endif
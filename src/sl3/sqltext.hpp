@@ -0,0 +1,43 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_SQLTEXT_HPP_
+#define SL3_SQLTEXT_HPP_
+
+#include <string>
+
+namespace sl3
+{
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Quote a name for use as identifier in SQL
+     *
+     * The name is put into double quotes, embedded double quotes are
+     * doubled.
+     */
+    inline std::string
+    quoteIdentifier (const std::string& name)
+    {
+      std::string quoted{"\""};
+      for (auto c : name)
+        {
+          if (c == '"')
+            quoted += '"';
+          quoted += c;
+        }
+      quoted += '"';
+      return quoted;
+    }
+  }
+  /// \endcond
+}
+
+#endif
@@ -0,0 +1,74 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#ifndef SL3_STMTCOLUMN_HPP_
+#define SL3_STMTCOLUMN_HPP_
+
+#include <sqlite3.h>
+
+#include <string>
+
+#include <sl3/types.hpp>
+
+namespace sl3
+{
+  /// \cond HIDDEN_SYMBOLS
+  namespace internal
+  {
+    /**
+     * \internal
+     * \brief Storage type of a column of the current row
+     *
+     * \return Int, Real, Text, Blob or Null
+     */
+    inline Type
+    storageType (sqlite3_stmt* stmt, int idx)
+    {
+      switch (sqlite3_column_type (stmt, idx))
+        {
+        case SQLITE_INTEGER:
+          return Type::Int;
+        case SQLITE_FLOAT:
+          return Type::Real;
+        case SQLITE_TEXT:
+          return Type::Text;
+        case SQLITE_BLOB:
+          return Type::Blob;
+        default:
+          return Type::Null;
+        }
+    }
+
+    /**
+     * \internal
+     * \brief Append the bytes of a column of the current row
+     *
+     * The value is read as text if type is Type::Text, as blob if it is
+     * Type::Blob, nothing is appended for other types.
+     */
+    inline void
+    appendColumnBytes (std::string&  bytes,
+                       sqlite3_stmt* stmt,
+                       int           idx,
+                       Type          type)
+    {
+      // get the pointer first, sqlite3_column_bytes may convert it
+      const char* data = nullptr;
+      if (type == Type::Text)
+        data = reinterpret_cast<const char*> (sqlite3_column_text (stmt, idx));
+      else if (type == Type::Blob)
+        data = static_cast<const char*> (sqlite3_column_blob (stmt, idx));
+
+      if (data)
+        bytes.append (data, sqlite3_column_bytes (stmt, idx));
+    }
+  }
+  /// \endcond
+}
+
+#endif
@@ -10,22 +10,20 @@
 #include <sl3/value.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <climits>
 #include <cmath>
+#include <cstring>
 #include <iomanip>
+#include <limits>
 #include <ostream>
 #include <type_traits>
+#include <utility>
 
 namespace sl3
 {
   namespace
   {
-    // not in coverage, only used in never reachable case/if branches
-    void raiseErrUnexpected (const std::string& msg) // LCOV_EXCL_LINE
-    {
-      throw ErrUnexpected (msg); // LCOV_EXCL_LINE
-    }
-
     template <class T>
     typename std::enable_if<!std::numeric_limits<T>::is_integer, bool>::type
     almost_equal (T x, T y, int ulp)
@@ -77,177 +75,235 @@ namespace sl3
       return static_cast<OutT> (converted);
     }
 
+
+    // buffer of a text or blob value that is not inline, shared by copies
+    // of the value
+    template <typename T>
+    struct Shared
+    {
+      explicit Shared (T val)
+      : refs{1}
+      , value (std::move (val))
+      {
+      }
+
+      std::atomic<std::size_t> refs;
+      T                        value;
+    };
+
+    using SharedText = Shared<std::string>;
+    using SharedBlob = Shared<Blob>;
+
+    template <typename T>
+    Shared<T>*
+    shared (void* heap) noexcept
+    {
+      return static_cast<Shared<T>*> (heap);
+    }
+
+    template <typename T>
+    void
+    acquire (void* heap) noexcept
+    {
+      shared<T> (heap)->refs.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    void
+    release (void* heap) noexcept
+    {
+      auto buf = shared<T> (heap);
+      if (buf->refs.fetch_sub (1, std::memory_order_acq_rel) == 1)
+        delete buf;
+    }
+
+    void
+    releaseHeap (Type type, void* heap) noexcept
+    {
+      if (type == Type::Text)
+        release<std::string> (heap);
+      else
+        release<Blob> (heap);
+    }
+
+    // true if no copy shares the buffer, so it may be changed
+    template <typename T>
+    bool
+    isUnique (void* heap) noexcept
+    {
+      return shared<T> (heap)->refs.load (std::memory_order_acquire) == 1;
+    }
+
+    bool
+    bytes_eq (const Value& a, const Value& b) noexcept
+    {
+      return a.size () == b.size ()
+             && std::memcmp (a.data (), b.data (), a.size ()) == 0;
+    }
+
+    // same order as std::string
+    bool
+    text_lt (const Value& a, const Value& b) noexcept
+    {
+      const auto n  = std::min (a.size (), b.size ());
+      const int  rc = n > 0 ? std::memcmp (a.data (), b.data (), n) : 0;
+      return rc != 0 ? rc < 0 : a.size () < b.size ();
+    }
+
+    // same order as Blob
+    bool
+    blob_lt (const Value& a, const Value& b) noexcept
+    {
+      return std::lexicographical_compare (a.data (),
+                                           a.data () + a.size (),
+                                           b.data (),
+                                           b.data () + b.size ());
+    }
+
+    // finalizer of MurmurHash3
+    uint64_t
+    mix (uint64_t h) noexcept
+    {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    uint64_t
+    hashBytes (const char* data, std::size_t size, uint64_t seed) noexcept
+    {
+      const uint64_t k = 0x9e3779b97f4a7c15ULL;
+      uint64_t       h = seed ^ (size * k);
+      uint64_t       w = 0;
+      for (; size >= sizeof (w); data += sizeof (w), size -= sizeof (w))
+        {
+          std::memcpy (&w, data, sizeof (w));
+          h = (h ^ mix (w)) * k;
+        }
+      if (size > 0)
+        {
+          w = 0;
+          std::memcpy (&w, data, size);
+          h = (h ^ mix (w)) * k;
+        }
+      return mix (h);
+    }
+
+    uint64_t
+    hashInt (int64_t val) noexcept
+    {
+      return mix (static_cast<uint64_t> (val));
+    }
+
+    // value_eq compares Int and Real as double, so a Real with an integral
+    // value hashes like the Int, and an Int that is not exact as double
+    // hashes like its double
+    uint64_t
+    hashReal (double val) noexcept
+    {
+      const double twoPow63 = 9223372036854775808.0;
+      if (std::trunc (val) == val && val >= -twoPow63 && val < twoPow63)
+        return hashInt (static_cast<int64_t> (val)); // also for -0.0
+
+      uint64_t bits = 0;
+      std::memcpy (&bits, &val, sizeof (bits));
+      return mix (bits);
+    }
+
+    uint64_t
+    hashNumber (int64_t val) noexcept
+    {
+      const int64_t exact = int64_t{1} << std::numeric_limits<double>::digits;
+      if (val >= -exact && val <= exact)
+        return hashInt (val);
+
+      return hashReal (static_cast<double> (val));
+    }
+
   } //--------------------------------------------------------------------------
 
+  static_assert (sizeof (Value) == 16, "Value is expected to be 16 bytes");
+
   Value::Value () noexcept
-  : _type {Type::Null}
   {
+    _store.intval = 0;
+    _store.tag    = 0;
   }
 
   Value::Value (int val) noexcept
-  : _type {Type::Int}
+  : Value (static_cast<int64_t> (val))
   {
-    _store.intval = val;
   }
 
   Value::Value (int64_t val) noexcept
-  : _type {Type::Int}
+  : Value ()
   {
     _store.intval = val;
+    setStorage (Type::Int);
   }
 
-  Value::Value (std::string val) noexcept
-  : _type {Type::Text}
+  Value::Value (std::string val)
+  : Value ()
   {
-    new (&_store.textval) std::string (std::move (val));
+    if (val.size () <= inlineCapacity)
+      setInline (Type::Text, val.data (), val.size ());
+    else
+      setBuffer (Type::Text, new SharedText (std::move (val)));
   }
 
   Value::Value (const char* val)
-  : _type {Type::Text}
+  : Value ()
   {
-    new (&_store.textval) std::string (val);
+    const std::size_t size = std::strlen (val);
+    if (size <= inlineCapacity)
+      setInline (Type::Text, val, size);
+    else
+      setBuffer (Type::Text, new SharedText (std::string (val, size)));
   }
 
   Value::Value (double val) noexcept
-  : _type {Type::Real}
+  : Value ()
   {
     _store.realval = val;
+    setStorage (Type::Real);
   }
 
-  Value::Value (Blob val) noexcept :
-    _type {Type::Blob}
+  Value::Value (Blob val)
+  : Value ()
   {
-    new (&_store.blobval) Blob (std::move (val));
+    if (val.size () <= inlineCapacity)
+      setInline (Type::Blob, val.data (), val.size ());
+    else
+      setBuffer (Type::Blob, new SharedBlob (std::move (val)));
   }
 
   Value::~Value () noexcept
   {
-    if (_type == Type::Text)
-      {
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        _store.blobval.~vector<Blob::value_type> ();
-      }
+    releaseBuffer ();
   }
 
   Value::Value (const Value& other) noexcept
-  : _type {other._type}
+  : Value ()
   {
-    switch (_type)
-      {
-      case Type::Null:
-        break;
-
-      case Type::Int:
-        _store.intval = other._store.intval;
-        break;
-
-      case Type::Real:
-        _store.realval = other._store.realval;
-        break;
-
-      case Type::Text:
-        new (&_store.textval) std::string (other._store.textval);
-        break;
-
-      case Type::Blob:
-        new (&_store.blobval) Blob (other._store.blobval);
-        break;
-
-      default:
-        raiseErrUnexpected ("never reach"); // LCOV_EXCL_LINE
-      }
+    auxType (other.auxType ());
+    copyFrom (other);
   }
 
-  Value::Value (Value&& other) noexcept : _type (other._type)
+  Value::Value (Value&& other) noexcept
+  : Value ()
   {
-    // gcc 5.3, only release, will complain if uninitialized
-    _store.intval = 0 ;
-
-    switch (_type)
-      {
-      case Type::Null:
-        break;
-
-      case Type::Int:
-        _store.intval = std::move (other._store.intval);
-        break;
-
-      case Type::Real:
-        _store.realval = std::move (other._store.realval);
-        break;
-
-      case Type::Text:
-        new (&_store.textval) std::string (std::move (other._store.textval));
-        other._store.textval.~basic_string ();
-        break;
-
-      case Type::Blob:
-        new (&_store.blobval) Blob (std::move (other._store.blobval));
-        other._store.blobval.~vector ();
-        break;
-
-      case Type::Variant:
-        raiseErrUnexpected ("never reach"); // LCOV_EXCL_LINE
-        break;                              // LCOV_EXCL_LINE
-      }
-
-    // important, set other to null so that clear does not trial to clear
-    other._type = Type::Null;
+    auxType (other.auxType ());
+    moveFrom (other);
   }
 
   Value&
   Value::operator= (const Value& other)
   {
-    if (_type == Type::Text)
-      {
-        if (other._type == Type::Text)
-          {
-            _store.textval = other._store.textval;
-            return *this;
-          }
-
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        if (other._type == Type::Blob)
-          {
-            _store.blobval = other._store.blobval;
-            return *this;
-          }
-        _store.blobval.~vector<Blob::value_type> ();
-      }
-
-    _type = other._type;
-
-    switch (_type)
-      {
-      case Type::Null:
-        break;
-
-      case Type::Int:
-        _store.intval = other._store.intval;
-        break;
-
-      case Type::Real:
-        _store.realval = other._store.realval;
-        break;
-
-      case Type::Text:
-        new (&_store.textval) std::string (other._store.textval);
-        break;
-
-      case Type::Blob:
-        new (&_store.blobval) Blob (other._store.blobval);
-        break;
-
-      case Type::Variant:
-        raiseErrUnexpected ("never reach"); // LCOV_EXCL_LINE
-        break;                              // LCOV_EXCL_LINE
-      }
+    if (this != &other)
+      copyFrom (other);
 
     return *this;
   }
@@ -255,156 +311,101 @@ namespace sl3
   Value&
   Value::operator= (Value&& other)
   {
-    if (_type == Type::Text)
-      {
-        if (other._type == Type::Text)
-          {
-            _store.textval = std::move (other._store.textval);
-            other.setNull ();
-            return *this;
-          }
-
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        if (other._type == Type::Blob)
-          {
-            _store.blobval = std::move (other._store.blobval);
-            other.setNull ();
-            return *this;
-          }
-
-        _store.blobval.~vector<Blob::value_type> ();
-      }
-
-    _type = other._type;
-
-    switch (_type)
-      {
-      case Type::Null:
-        break;
-
-      case Type::Int:
-        _store.intval = std::move (other._store.intval);
-        break;
-
-      case Type::Real:
-        _store.realval = std::move (other._store.realval);
-        break;
-
-      case Type::Text:
-        new (&_store.textval) std::string (std::move (other._store.textval));
-        other._store.textval.~basic_string ();
-        break;
-
-      case Type::Blob:
-        new (&_store.blobval) Blob (std::move (other._store.blobval));
-        other._store.blobval.~vector ();
-        break;
-
-      case Type::Variant:
-        raiseErrUnexpected ("never reach"); // LCOV_EXCL_LINE
-        break;                              // LCOV_EXCL_LINE
-      }
-
-    // important, set other to null so that clear does not trial to clear
-    other._type = Type::Null;
-
+    moveFrom (other);
     return *this;
   }
 
   Value&
   Value::operator= (int val)
   {
-    if (_type == Type::Text)
-      {
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        _store.blobval.~vector<Blob::value_type> ();
-      }
-    _store.intval = val;
-    _type         = Type::Int;
-    return *this;
+    return *this = static_cast<int64_t> (val);
   }
 
   Value&
   Value::operator= (const int64_t& val)
   {
-    if (_type == Type::Text)
-      {
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        _store.blobval.~vector<Blob::value_type> ();
-      }
+    releaseBuffer ();
     _store.intval = val;
-    _type         = Type::Int;
+    setStorage (Type::Int);
     return *this;
   }
 
   Value&
   Value::operator= (const double& val)
   {
-    if (_type == Type::Text)
-      {
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        _store.blobval.~vector<Blob::value_type> ();
-      }
+    releaseBuffer ();
     _store.realval = val;
-    _type          = Type::Real;
+    setStorage (Type::Real);
     return *this;
   }
 
   Value&
   Value::operator= (const std::string& val)
   {
-    if (_type == Type::Text)
-      {
-        _store.textval = val;
-        return *this;
-      }
-    else if (_type == Type::Blob)
-      {
-        _store.blobval.~vector<Blob::value_type> ();
-      }
+    // reuse the buffer if no copy shares it
+    if (val.size () <= inlineCapacity)
+      setInline (Type::Text, val.data (), val.size ());
+    else if (storageType () == Type::Text && hasBuffer ()
+             && isUnique<std::string> (_store.heap))
+      shared<std::string> (_store.heap)->value = val;
+    else
+      setBuffer (Type::Text, new SharedText (val));
+
+    return *this;
+  }
+
+  Value&
+  Value::operator= (std::string&& val)
+  {
+    // take the memory of val if it does not fit inline
+    if (val.size () <= inlineCapacity)
+      setInline (Type::Text, val.data (), val.size ());
+    else if (storageType () == Type::Text && hasBuffer ()
+             && isUnique<std::string> (_store.heap))
+      shared<std::string> (_store.heap)->value = std::move (val);
+    else
+      setBuffer (Type::Text, new SharedText (std::move (val)));
 
-    new (&_store.textval) std::string (val);
-    _type = Type::Text;
     return *this;
   }
 
   Value&
   Value::operator= (const Blob& val)
   {
-    if (_type == Type::Text)
-      {
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        _store.blobval = val;
-        return *this;
-      }
-    new (&_store.blobval) Blob (val);
-    _type = Type::Blob;
+    if (val.size () <= inlineCapacity)
+      setInline (Type::Blob, val.data (), val.size ());
+    else if (storageType () == Type::Blob && hasBuffer ()
+             && isUnique<Blob> (_store.heap))
+      shared<Blob> (_store.heap)->value = val;
+    else
+      setBuffer (Type::Blob, new SharedBlob (val));
+
+    return *this;
+  }
+
+  Value&
+  Value::operator= (Blob&& val)
+  {
+    if (val.size () <= inlineCapacity)
+      setInline (Type::Blob, val.data (), val.size ());
+    else if (storageType () == Type::Blob && hasBuffer ()
+             && isUnique<Blob> (_store.heap))
+      shared<Blob> (_store.heap)->value = std::move (val);
+    else
+      setBuffer (Type::Blob, new SharedBlob (std::move (val)));
+
     return *this;
   }
 
   Value::operator int () const
   {
-    if (isNull ())
+    const auto type = storageType ();
+    if (type == Type::Null)
       throw ErrNullValueAccess ();
-    else if (_type == Type::Real)
+    else if (type == Type::Real)
       return losslessConvert1<double, int> (_store.realval);
-    else if (_type != Type::Int)
-      throw ErrTypeMisMatch ("Implicit conversion: " + typeName (_type)
+    else if (type != Type::Int)
+      throw ErrTypeMisMatch ("Implicit conversion: " + typeName (type)
                              + " to int64_t");
 
     using limit = std::numeric_limits<int>;
@@ -417,12 +418,13 @@ namespace sl3
 
   Value::operator int64_t () const
   {
-    if (isNull ())
+    const auto type = storageType ();
+    if (type == Type::Null)
       throw ErrNullValueAccess ();
-    else if (_type == Type::Real)
+    else if (type == Type::Real)
       return losslessConvert1<double, int64_t> (_store.realval);
-    else if (_type != Type::Int)
-      throw ErrTypeMisMatch ("Implicit conversion: " + typeName (_type)
+    else if (type != Type::Int)
+      throw ErrTypeMisMatch ("Implicit conversion: " + typeName (type)
                              + " to int64_t");
 
     return _store.intval;
@@ -430,47 +432,32 @@ namespace sl3
 
   Value::operator double () const
   {
-    if (isNull ())
+    const auto type = storageType ();
+    if (type == Type::Null)
       {
         throw ErrNullValueAccess ();
       }
-    else if (_type == Type::Int)
+    else if (type == Type::Int)
       {
-//        using limit = std::numeric_limits<double>;
-//        if (_store.intval < limit::min () || _store.intval > limit::max ())
-//          throw Not possible  :- );
-
         return static_cast<double>(_store.intval);
       }
-    else if (_type != Type::Real)
+    else if (type != Type::Real)
       {
-        throw ErrTypeMisMatch (typeName (_type) + " != "
+        throw ErrTypeMisMatch (typeName (type) + " != "
                                + typeName (Type::Real));
       }
 
     return _store.realval;
   }
 
-  Value::operator const std::string& () const
+  Value::operator std::string () const
   {
-    if (isNull ())
-      throw ErrNullValueAccess ();
-    else if (_type != Type::Text)
-      throw ErrTypeMisMatch (typeName (_type) + " != "
-                             + typeName (Type::Text));
-
-    return _store.textval;
+    return text ();
   }
 
-  Value::operator const Blob& () const
+  Value::operator Blob () const
   {
-    if (isNull ())
-      throw ErrNullValueAccess ();
-    else if (_type != Type::Blob)
-      throw ErrTypeMisMatch (typeName (_type) + " != "
-                             + typeName (Type::Blob));
-
-    return _store.blobval;
+    return blob ();
   }
 
   const int64_t&
@@ -480,8 +467,9 @@ namespace sl3
       throw ErrNullValueAccess ();
 
     const auto wanted = Type::Int;
-    if (_type != wanted)
-      throw ErrTypeMisMatch (typeName (_type) + " != " + typeName (wanted));
+    if (storageType () != wanted)
+      throw ErrTypeMisMatch (typeName (storageType ()) + " != "
+                             + typeName (wanted));
 
     return _store.intval;
   }
@@ -493,48 +481,85 @@ namespace sl3
       throw ErrNullValueAccess ();
 
     const auto wanted = Type::Real;
-    if (_type != wanted)
-      throw ErrTypeMisMatch (typeName (_type) + " != " + typeName (wanted));
+    if (storageType () != wanted)
+      throw ErrTypeMisMatch (typeName (storageType ()) + " != "
+                             + typeName (wanted));
 
     return _store.realval;
   }
 
-  const std::string&
+  std::string
   Value::text () const
   {
     if (isNull ())
       throw ErrNullValueAccess ();
 
     const auto wanted = Type::Text;
-    if (_type != wanted)
-      throw ErrTypeMisMatch (typeName (_type) + " != " + typeName (wanted));
+    if (storageType () != wanted)
+      throw ErrTypeMisMatch (typeName (storageType ()) + " != "
+                             + typeName (wanted));
 
-    return _store.textval;
+    return std::string (data (), size ());
   }
 
-  const Blob&
+  Blob
   Value::blob () const
   {
     if (isNull ())
       throw ErrNullValueAccess ();
 
     const auto wanted = Type::Blob;
-    if (_type != wanted)
-      throw ErrTypeMisMatch (typeName (_type) + " != " + typeName (wanted));
+    if (storageType () != wanted)
+      throw ErrTypeMisMatch (typeName (storageType ()) + " != "
+                             + typeName (wanted));
+
+    return Blob (data (), data () + size ());
+  }
+
+  const char*
+  Value::data () const noexcept
+  {
+    const auto type = storageType ();
+    if (type != Type::Text && type != Type::Blob)
+      return nullptr;
+
+    // not null for an empty blob, sqlite would bind that as NULL
+    if (isInline ())
+      return reinterpret_cast<const char*> (&_store);
+
+    if (type == Type::Text)
+      return shared<std::string> (_store.heap)->value.data ();
+
+    return shared<Blob> (_store.heap)->value.data ();
+  }
+
+  std::size_t
+  Value::size () const noexcept
+  {
+    const auto type = storageType ();
+    if (type != Type::Text && type != Type::Blob)
+      return 0;
+
+    if (isInline ())
+      return _store.inlineSize;
 
-    return _store.blobval;
+    if (type == Type::Text)
+      return shared<std::string> (_store.heap)->value.size ();
+
+    return shared<Blob> (_store.heap)->value.size ();
   }
 
   std::string
   Value::ejectText ()
   {
-    if (_type == Type::Null)
-      throw ErrNullValueAccess ();
-    else if (_type != Type::Text)
-      throw ErrTypeMisMatch (typeName (_type) + " != "
-                             + typeName (Type::Text));
+    std::string tmp;
+    // move out if no copy shares the buffer
+    if (storageType () == Type::Text && hasBuffer ()
+        && isUnique<std::string> (_store.heap))
+      tmp = std::move (shared<std::string> (_store.heap)->value);
+    else
+      tmp = text (); // checks the type
 
-    auto tmp = std::move (_store.textval);
     setNull ();
     return tmp;
   }
@@ -542,13 +567,13 @@ namespace sl3
   Blob
   Value::ejectBlob ()
   {
-    if (_type == Type::Null)
-      throw ErrNullValueAccess ();
-    else if (_type != Type::Blob)
-      throw ErrTypeMisMatch (typeName (_type) + " != "
-                             + typeName (Type::Blob));
+    Blob tmp;
+    if (storageType () == Type::Blob && hasBuffer ()
+        && isUnique<Blob> (_store.heap))
+      tmp = std::move (shared<Blob> (_store.heap)->value);
+    else
+      tmp = blob ();
 
-    auto tmp = std::move (_store.blobval);
     setNull ();
     return tmp;
   }
@@ -556,27 +581,95 @@ namespace sl3
   void
   Value::setNull () noexcept
   {
-    if (_type == Type::Text)
-      {
-        _store.textval.~basic_string<std::string::value_type> ();
-      }
-    else if (_type == Type::Blob)
-      {
-        _store.blobval.~vector<Blob::value_type> ();
-      }
-    _type = Type::Null;
+    releaseBuffer ();
+    setStorage (Type::Null);
   }
 
   bool
   Value::isNull () const noexcept
   {
-    return _type == Type::Null;
+    return storageType () == Type::Null;
   }
 
   Type
   Value::getType () const noexcept
   {
-    return _type;
+    return storageType ();
+  }
+
+  void
+  Value::setInline (Type type, const char* data, std::size_t size) noexcept
+  {
+    // data might point into the current buffer, release it last
+    const Type old     = storageType ();
+    void*      oldHeap = hasBuffer () ? _store.heap : nullptr;
+
+    if (size > 0)
+      std::memmove (reinterpret_cast<char*> (&_store), data, size);
+    _store.inlineSize = static_cast<uint8_t> (size);
+    setStorage (type);
+    _store.tag |= inlineFlag;
+
+    if (oldHeap)
+      releaseHeap (old, oldHeap);
+  }
+
+  void
+  Value::setBuffer (Type type, void* heap) noexcept
+  {
+    releaseBuffer ();
+    _store.heap = heap;
+    setStorage (type);
+  }
+
+  void
+  Value::releaseBuffer () noexcept
+  {
+    if (hasBuffer ())
+      releaseHeap (storageType (), _store.heap);
+
+    setStorage (Type::Null);
+  }
+
+  void
+  Value::setStorage (Type type) noexcept
+  {
+    _store.tag = static_cast<uint8_t> (
+        (_store.tag & ~(typeMask | inlineFlag)) | static_cast<int> (type));
+  }
+
+  void
+  Value::copyFrom (const Value& other) noexcept
+  {
+    if (this == &other)
+      return;
+
+    // share the buffer
+    if (other.storageType () == Type::Text && other.hasBuffer ())
+      acquire<std::string> (other._store.heap);
+    else if (other.storageType () == Type::Blob && other.hasBuffer ())
+      acquire<Blob> (other._store.heap);
+
+    releaseBuffer ();
+    const uint8_t aux = _store.tag & ~(typeMask | inlineFlag);
+    std::memcpy (&_store, &other._store, sizeof (Store));
+    _store.tag = static_cast<uint8_t> (
+        (other._store.tag & (typeMask | inlineFlag)) | aux);
+  }
+
+  void
+  Value::moveFrom (Value& other) noexcept
+  {
+    if (this == &other)
+      return;
+
+    releaseBuffer ();
+    const uint8_t aux = _store.tag & ~(typeMask | inlineFlag);
+    std::memcpy (&_store, &other._store, sizeof (Store));
+    _store.tag = static_cast<uint8_t> (
+        (other._store.tag & (typeMask | inlineFlag)) | aux);
+    // the buffer is owned by this now
+    other.setStorage (Type::Null);
   }
 
   std::ostream&
@@ -597,7 +690,7 @@ namespace sl3
         break;
 
       case Type::Text:
-        stm << v._store.textval;
+        stm.write (v.data (), static_cast<std::streamsize> (v.size ()));
         break;
 
       case Type::Blob:
@@ -636,11 +729,11 @@ namespace sl3
         break;
 
       case Type::Text:
-        retval = a._store.textval == b._store.textval;
+        retval = bytes_eq (a, b);
         break;
 
       case Type::Blob:
-        retval = a._store.blobval == b._store.blobval;
+        retval = bytes_eq (a, b);
         break;
 
       default:
@@ -687,7 +780,7 @@ namespace sl3
     if (a.getType () == Type::Text)
       {
         if (b.getType () == Type::Text)
-          return a._store.textval < b._store.textval;
+          return text_lt (a, b);
 
         // only blob types are bigger
         return b.getType () == Type::Blob ;
@@ -700,7 +793,7 @@ namespace sl3
       return false;
 
     // we are both bolb
-    return a._store.blobval < b._store.blobval;
+    return blob_lt (a, b);
   }
 
   void
@@ -731,29 +824,29 @@ namespace sl3
         break;
 
       case Type::Int:
-        if (b._type == Type::Int)
+        if (b.getType () == Type::Int)
           retval = a._store.intval == b._store.intval;
-        else if (b._type == Type::Real)
+        else if (b.getType () == Type::Real)
           retval = a._store.intval == b._store.realval;
 
         break;
 
       case Type::Real:
-        if (b._type == Type::Int)
+        if (b.getType () == Type::Int)
           retval = a._store.realval == b._store.intval;
-        else if (b._type == Type::Real)
+        else if (b.getType () == Type::Real)
           retval = a._store.realval == b._store.realval;
 
         break;
 
       case Type::Text:
-        if (b._type == Type::Text)
-          retval = a._store.textval == b._store.textval;
+        if (b.getType () == Type::Text)
+          retval = bytes_eq (a, b);
         break;
 
       case Type::Blob:
-        if (b._type == Type::Blob)
-          retval = a._store.blobval == b._store.blobval;
+        if (b.getType () == Type::Blob)
+          retval = bytes_eq (a, b);
         break;
 
       default:
@@ -797,7 +890,7 @@ namespace sl3
     if (a.getType () == Type::Text)
       {
         if (b.getType () == Type::Text)
-          return a._store.textval < b._store.textval;
+          return text_lt (a, b);
 
         if (b.getType () == Type::Blob)
           return true;
@@ -812,9 +905,33 @@ namespace sl3
       return false;
 
     // we are both bolb
-    return a._store.blobval < b._store.blobval;
+    return blob_lt (a, b);
   }
 
 
 
+  std::size_t
+  value_hash (const Value& v) noexcept
+  {
+    switch (v.getType ())
+      {
+      case Type::Int:
+        return static_cast<std::size_t> (hashNumber (v._store.intval));
+
+      case Type::Real:
+        return static_cast<std::size_t> (hashReal (v._store.realval));
+
+      case Type::Text:
+        return static_cast<std::size_t> (
+            hashBytes (v.data (), v.size (), 0x7465787400000000ULL));
+
+      case Type::Blob:
+        return static_cast<std::size_t> (
+            hashBytes (v.data (), v.size (), 0x626c6f6200000000ULL));
+
+      default:
+        return 0;
+      }
+  }
+
 } // ns
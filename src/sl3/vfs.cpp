@@ -0,0 +1,558 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/vfs.hpp>
+
+#include <atomic>
+#include <cstring>
+
+#include <sqlite3.h>
+
+#include <sl3/error.hpp>
+
+namespace sl3
+{
+  namespace
+  {
+    using Clock = std::chrono::steady_clock;
+
+    struct Counter
+    {
+      std::atomic<uint64_t> calls;
+      std::atomic<uint64_t> bytes;
+      std::atomic<uint64_t> nanos;
+      std::atomic<uint64_t> histogram[IoOpStats::bucketCount];
+
+      Counter () { clear (); }
+
+      void
+      clear ()
+      {
+        calls = 0;
+        bytes = 0;
+        nanos = 0;
+        for (auto& bucket : histogram)
+          bucket = 0;
+      }
+
+      void
+      record (Clock::duration time, uint64_t size)
+      {
+        using namespace std::chrono;
+        const auto ns = duration_cast<nanoseconds> (time).count ();
+        auto       us = static_cast<uint64_t> (ns / 1000);
+
+        std::size_t bucket = 0;
+        while (us > 0 && bucket + 1 < IoOpStats::bucketCount)
+          {
+            us >>= 1;
+            ++bucket;
+          }
+
+        calls += 1;
+        bytes += size;
+        nanos += static_cast<uint64_t> (ns);
+        histogram[bucket] += 1;
+      }
+
+      IoOpStats
+      load () const
+      {
+        IoOpStats s;
+        s.calls = calls;
+        s.bytes = bytes;
+        s.time  = std::chrono::nanoseconds (nanos.load ());
+        for (std::size_t i = 0; i < IoOpStats::bucketCount; ++i)
+          s.histogram[i] = histogram[i];
+        return s;
+      }
+    };
+
+    struct FileCounters
+    {
+      Counter read, write, sync, lock;
+    };
+
+    FileKind
+    kindOf (int flags)
+    {
+      if (flags & SQLITE_OPEN_MAIN_DB)
+        return FileKind::MainDb;
+
+      if (flags & (SQLITE_OPEN_MAIN_JOURNAL | SQLITE_OPEN_MASTER_JOURNAL))
+        return FileKind::Journal;
+
+      if (flags & SQLITE_OPEN_WAL)
+        return FileKind::Wal;
+
+      if (flags & (SQLITE_OPEN_TEMP_DB | SQLITE_OPEN_TEMP_JOURNAL
+                   | SQLITE_OPEN_TRANSIENT_DB | SQLITE_OPEN_SUBJOURNAL))
+        return FileKind::Temp;
+
+      return FileKind::Other;
+    }
+  } // ns
+
+  namespace
+  {
+    struct VfsState
+    {
+      std::string  name;
+      sqlite3_vfs* base;
+      sqlite3_vfs  vfs;
+      FileCounters counters[fileKindCount];
+    };
+
+    struct ShimFile
+    {
+      sqlite3_file  file; // must be first
+      sqlite3_file* real;
+      FileCounters* counters;
+    };
+
+    sqlite3_file*
+    real (sqlite3_file* f)
+    {
+      return reinterpret_cast<ShimFile*> (f)->real;
+    }
+
+    FileCounters&
+    counters (sqlite3_file* f)
+    {
+      return *reinterpret_cast<ShimFile*> (f)->counters;
+    }
+
+    sqlite3_vfs*
+    base (sqlite3_vfs* vfs)
+    {
+      return static_cast<VfsState*> (vfs->pAppData)->base;
+    }
+
+    // counted I/O methods
+
+    int
+    xRead (sqlite3_file* f, void* buf, int amount, sqlite3_int64 offset)
+    {
+      auto start = Clock::now ();
+      auto r     = real (f);
+      int  rc    = r->pMethods->xRead (r, buf, amount, offset);
+      counters (f).read.record (Clock::now () - start,
+                                static_cast<uint64_t> (amount));
+      return rc;
+    }
+
+    int
+    xWrite (sqlite3_file* f, const void* buf, int amount, sqlite3_int64 offset)
+    {
+      auto start = Clock::now ();
+      auto r     = real (f);
+      int  rc    = r->pMethods->xWrite (r, buf, amount, offset);
+      counters (f).write.record (Clock::now () - start,
+                                 static_cast<uint64_t> (amount));
+      return rc;
+    }
+
+    int
+    xSync (sqlite3_file* f, int flags)
+    {
+      auto start = Clock::now ();
+      auto r     = real (f);
+      int  rc    = r->pMethods->xSync (r, flags);
+      counters (f).sync.record (Clock::now () - start, 0);
+      return rc;
+    }
+
+    int
+    xLock (sqlite3_file* f, int level)
+    {
+      auto start = Clock::now ();
+      auto r     = real (f);
+      int  rc    = r->pMethods->xLock (r, level);
+      counters (f).lock.record (Clock::now () - start, 0);
+      return rc;
+    }
+
+    // forwarded I/O methods
+
+    int
+    xClose (sqlite3_file* f)
+    {
+      return real (f)->pMethods->xClose (real (f));
+    }
+
+    int
+    xTruncate (sqlite3_file* f, sqlite3_int64 size)
+    {
+      return real (f)->pMethods->xTruncate (real (f), size);
+    }
+
+    int
+    xFileSize (sqlite3_file* f, sqlite3_int64* size)
+    {
+      return real (f)->pMethods->xFileSize (real (f), size);
+    }
+
+    int
+    xUnlock (sqlite3_file* f, int level)
+    {
+      return real (f)->pMethods->xUnlock (real (f), level);
+    }
+
+    int
+    xCheckReservedLock (sqlite3_file* f, int* out)
+    {
+      return real (f)->pMethods->xCheckReservedLock (real (f), out);
+    }
+
+    int
+    xFileControl (sqlite3_file* f, int op, void* arg)
+    {
+      return real (f)->pMethods->xFileControl (real (f), op, arg);
+    }
+
+    int
+    xSectorSize (sqlite3_file* f)
+    {
+      return real (f)->pMethods->xSectorSize (real (f));
+    }
+
+    int
+    xDeviceCharacteristics (sqlite3_file* f)
+    {
+      return real (f)->pMethods->xDeviceCharacteristics (real (f));
+    }
+
+    int
+    xShmMap (sqlite3_file* f, int region, int size, int extend, void volatile** p)
+    {
+      return real (f)->pMethods->xShmMap (real (f), region, size, extend, p);
+    }
+
+    int
+    xShmLock (sqlite3_file* f, int offset, int n, int flags)
+    {
+      return real (f)->pMethods->xShmLock (real (f), offset, n, flags);
+    }
+
+    void
+    xShmBarrier (sqlite3_file* f)
+    {
+      real (f)->pMethods->xShmBarrier (real (f));
+    }
+
+    int
+    xShmUnmap (sqlite3_file* f, int deleteFlag)
+    {
+      return real (f)->pMethods->xShmUnmap (real (f), deleteFlag);
+    }
+
+    int
+    xFetch (sqlite3_file* f, sqlite3_int64 offset, int amount, void** p)
+    {
+      return real (f)->pMethods->xFetch (real (f), offset, amount, p);
+    }
+
+    int
+    xUnfetch (sqlite3_file* f, sqlite3_int64 offset, void* p)
+    {
+      return real (f)->pMethods->xUnfetch (real (f), offset, p);
+    }
+
+    sqlite3_io_methods
+    makeIoMethods (int version)
+    {
+      sqlite3_io_methods m;
+      std::memset (&m, 0, sizeof (m));
+
+      m.iVersion               = version;
+      m.xClose                 = &xClose;
+      m.xRead                  = &xRead;
+      m.xWrite                 = &xWrite;
+      m.xTruncate              = &xTruncate;
+      m.xSync                  = &xSync;
+      m.xFileSize              = &xFileSize;
+      m.xLock                  = &xLock;
+      m.xUnlock                = &xUnlock;
+      m.xCheckReservedLock     = &xCheckReservedLock;
+      m.xFileControl           = &xFileControl;
+      m.xSectorSize            = &xSectorSize;
+      m.xDeviceCharacteristics = &xDeviceCharacteristics;
+
+      if (version >= 2)
+        {
+          m.xShmMap     = &xShmMap;
+          m.xShmLock    = &xShmLock;
+          m.xShmBarrier = &xShmBarrier;
+          m.xShmUnmap   = &xShmUnmap;
+        }
+
+      if (version >= 3)
+        {
+          m.xFetch   = &xFetch;
+          m.xUnfetch = &xUnfetch;
+        }
+
+      return m;
+    }
+
+    // the methods of the shim must have the version of the real file
+    const sqlite3_io_methods*
+    ioMethods (int version)
+    {
+      static const sqlite3_io_methods methods[]
+          = {makeIoMethods (1), makeIoMethods (2), makeIoMethods (3)};
+
+      if (version < 1)
+        version = 1;
+      if (version > 3)
+        version = 3;
+
+      return &methods[version - 1];
+    }
+
+    // VFS methods
+
+    int
+    xOpen (sqlite3_vfs* vfs,
+           const char*  name,
+           sqlite3_file* f,
+           int          flags,
+           int*         outFlags)
+    {
+      auto impl = static_cast<VfsState*> (vfs->pAppData);
+      auto shim = reinterpret_cast<ShimFile*> (f);
+
+      shim->real     = reinterpret_cast<sqlite3_file*> (shim + 1);
+      shim->counters = &impl->counters[static_cast<int> (kindOf (flags))];
+
+      int rc = impl->base->xOpen (impl->base, name, shim->real, flags, outFlags);
+
+      shim->file.pMethods = shim->real->pMethods
+                                ? ioMethods (shim->real->pMethods->iVersion)
+                                : nullptr;
+      return rc;
+    }
+
+    int
+    xDelete (sqlite3_vfs* vfs, const char* name, int syncDir)
+    {
+      return base (vfs)->xDelete (base (vfs), name, syncDir);
+    }
+
+    int
+    xAccess (sqlite3_vfs* vfs, const char* name, int flags, int* out)
+    {
+      return base (vfs)->xAccess (base (vfs), name, flags, out);
+    }
+
+    int
+    xFullPathname (sqlite3_vfs* vfs, const char* name, int n, char* out)
+    {
+      return base (vfs)->xFullPathname (base (vfs), name, n, out);
+    }
+
+    void*
+    xDlOpen (sqlite3_vfs* vfs, const char* name)
+    {
+      return base (vfs)->xDlOpen (base (vfs), name);
+    }
+
+    void
+    xDlError (sqlite3_vfs* vfs, int n, char* msg)
+    {
+      base (vfs)->xDlError (base (vfs), n, msg);
+    }
+
+    void (*xDlSym (sqlite3_vfs* vfs, void* lib, const char* sym)) (void)
+    {
+      return base (vfs)->xDlSym (base (vfs), lib, sym);
+    }
+
+    void
+    xDlClose (sqlite3_vfs* vfs, void* lib)
+    {
+      base (vfs)->xDlClose (base (vfs), lib);
+    }
+
+    int
+    xRandomness (sqlite3_vfs* vfs, int n, char* out)
+    {
+      return base (vfs)->xRandomness (base (vfs), n, out);
+    }
+
+    int
+    xSleep (sqlite3_vfs* vfs, int micros)
+    {
+      return base (vfs)->xSleep (base (vfs), micros);
+    }
+
+    int
+    xCurrentTime (sqlite3_vfs* vfs, double* out)
+    {
+      return base (vfs)->xCurrentTime (base (vfs), out);
+    }
+
+    int
+    xGetLastError (sqlite3_vfs* vfs, int n, char* out)
+    {
+      return base (vfs)->xGetLastError (base (vfs), n, out);
+    }
+
+    int
+    xCurrentTimeInt64 (sqlite3_vfs* vfs, sqlite3_int64* out)
+    {
+      return base (vfs)->xCurrentTimeInt64 (base (vfs), out);
+    }
+
+    int
+    xSetSystemCall (sqlite3_vfs*          vfs,
+                    const char*           name,
+                    sqlite3_syscall_ptr   call)
+    {
+      return base (vfs)->xSetSystemCall (base (vfs), name, call);
+    }
+
+    sqlite3_syscall_ptr
+    xGetSystemCall (sqlite3_vfs* vfs, const char* name)
+    {
+      return base (vfs)->xGetSystemCall (base (vfs), name);
+    }
+
+    const char*
+    xNextSystemCall (sqlite3_vfs* vfs, const char* name)
+    {
+      return base (vfs)->xNextSystemCall (base (vfs), name);
+    }
+  } // ns
+
+  struct InstrumentedVfs::Impl : VfsState
+  {
+  };
+
+  constexpr std::size_t IoOpStats::bucketCount;
+
+  IoOpStats
+  IoOpStats::operator- (const IoOpStats& other) const
+  {
+    IoOpStats d;
+    d.calls = calls - other.calls;
+    d.bytes = bytes - other.bytes;
+    d.time  = time - other.time;
+    for (std::size_t i = 0; i < bucketCount; ++i)
+      d.histogram[i] = histogram[i] - other.histogram[i];
+    return d;
+  }
+
+  FileIoStats
+  FileIoStats::operator- (const FileIoStats& other) const
+  {
+    FileIoStats d;
+    d.read  = read - other.read;
+    d.write = write - other.write;
+    d.sync  = sync - other.sync;
+    d.lock  = lock - other.lock;
+    return d;
+  }
+
+  const FileIoStats& IoStats::operator[] (FileKind kind) const
+  {
+    return files[static_cast<std::size_t> (kind)];
+  }
+
+  IoStats
+  IoStats::operator- (const IoStats& other) const
+  {
+    IoStats d;
+    for (std::size_t i = 0; i < fileKindCount; ++i)
+      d.files[i] = files[i] - other.files[i];
+    return d;
+  }
+
+  InstrumentedVfs::InstrumentedVfs (const std::string& name,
+                                    const std::string& baseName)
+  : _impl (new Impl)
+  {
+    _impl->name = name;
+    _impl->base = sqlite3_vfs_find (baseName.empty () ? nullptr
+                                                      : baseName.c_str ());
+    if (_impl->base == nullptr)
+      throw SQLite3Error{SQLITE_ERROR, "no such vfs", baseName};
+
+    sqlite3_vfs* b = _impl->base;
+    sqlite3_vfs& v = _impl->vfs;
+    std::memset (&v, 0, sizeof (v));
+
+    v.iVersion   = b->iVersion < 3 ? b->iVersion : 3;
+    v.szOsFile   = static_cast<int> (sizeof (ShimFile)) + b->szOsFile;
+    v.mxPathname = b->mxPathname;
+    v.zName      = _impl->name.c_str ();
+    v.pAppData   = static_cast<VfsState*> (_impl.get ());
+
+    v.xOpen         = &xOpen;
+    v.xDelete       = &xDelete;
+    v.xAccess       = &xAccess;
+    v.xFullPathname = &xFullPathname;
+    v.xDlOpen       = b->xDlOpen ? &xDlOpen : nullptr;
+    v.xDlError      = b->xDlError ? &xDlError : nullptr;
+    v.xDlSym        = b->xDlSym ? &xDlSym : nullptr;
+    v.xDlClose      = b->xDlClose ? &xDlClose : nullptr;
+    v.xRandomness   = &xRandomness;
+    v.xSleep        = &xSleep;
+    v.xCurrentTime  = &xCurrentTime;
+    v.xGetLastError = b->xGetLastError ? &xGetLastError : nullptr;
+
+    if (v.iVersion >= 2)
+      v.xCurrentTimeInt64 = b->xCurrentTimeInt64 ? &xCurrentTimeInt64 : nullptr;
+
+    if (v.iVersion >= 3)
+      {
+        v.xSetSystemCall  = b->xSetSystemCall ? &xSetSystemCall : nullptr;
+        v.xGetSystemCall  = b->xGetSystemCall ? &xGetSystemCall : nullptr;
+        v.xNextSystemCall = b->xNextSystemCall ? &xNextSystemCall : nullptr;
+      }
+
+    int rc = sqlite3_vfs_register (&v, 0);
+    if (rc != SQLITE_OK)
+      throw SQLite3Error{rc, "vfs registration failed"}; // LCOV_EXCL_LINE
+  }
+
+  InstrumentedVfs::~InstrumentedVfs () { sqlite3_vfs_unregister (&_impl->vfs); }
+
+  const std::string&
+  InstrumentedVfs::name () const
+  {
+    return _impl->name;
+  }
+
+  IoStats
+  InstrumentedVfs::stats () const
+  {
+    IoStats s;
+    for (std::size_t i = 0; i < fileKindCount; ++i)
+      {
+        const auto& c    = _impl->counters[i];
+        s.files[i].read  = c.read.load ();
+        s.files[i].write = c.write.load ();
+        s.files[i].sync  = c.sync.load ();
+        s.files[i].lock  = c.lock.load ();
+      }
+    return s;
+  }
+
+  void
+  InstrumentedVfs::reset ()
+  {
+    for (auto& c : _impl->counters)
+      {
+        c.read.clear ();
+        c.write.clear ();
+        c.sync.clear ();
+        c.lock.clear ();
+      }
+  }
+}
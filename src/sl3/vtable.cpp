@@ -0,0 +1,632 @@
+/******************************************************************************
+ ------------- Copyright (c) 2009-2017 H a r a l d  A c h i t z ---------------
+ ---------- < h a r a l d dot a c h i t z at g m a i l dot c o m > ------------
+ ---- This Source Code Form is subject to the terms of the Mozilla Public -----
+ ---- License, v. 2.0. If a copy of the MPL was not distributed with this -----
+ ---------- file, You can obtain one at http://mozilla.org/MPL/2.0/. ----------
+ ******************************************************************************/
+
+#include <sl3/vtable.hpp>
+
+#include "sqltext.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include <sl3/error.hpp>
+#include <sl3/function.hpp>
+
+namespace sl3
+{
+  DatasetSource::DatasetSource (const Dataset& ds)
+  : _ds (ds)
+  {
+  }
+
+  std::size_t
+  DatasetSource::columnCount () const
+  {
+    if (!_ds._names.empty ())
+      return _ds._names.size ();
+
+    if (_ds._fieldtypes.size () > 0)
+      return _ds._fieldtypes.size ();
+
+    return _ds.size () > 0 ? _ds[0].size () : 0;
+  }
+
+  std::string
+  DatasetSource::columnName (std::size_t col) const
+  {
+    if (col < _ds._names.size ())
+      return _ds._names[col];
+
+    return "c" + std::to_string (col);
+  }
+
+  std::size_t
+  DatasetSource::rowCount () const
+  {
+    return _ds.size ();
+  }
+
+  const Value&
+  DatasetSource::value (std::size_t row, std::size_t col, Value&) const
+  {
+    return _ds[row][col].getValue ();
+  }
+
+  namespace
+  {
+    // idxNum bits of xBestIndex / xFilter
+    constexpr int KeyEq      = 1;
+    constexpr int KeyGt      = 2;
+    constexpr int KeyGe      = 4;
+    constexpr int KeyLt      = 8;
+    constexpr int KeyLe      = 16;
+    constexpr int KeyOrdered = 32;
+
+    int
+    typeRank (Type t)
+    {
+      switch (t)
+        {
+        case Type::Null:
+          return 0;
+        case Type::Int:
+        case Type::Real:
+          return 1;
+        case Type::Text:
+          return 2;
+        default:
+          return 3;
+        }
+    }
+
+    // storage class of an xFilter argument, as typeRank
+    int
+    argRank (sqlite3_value* arg)
+    {
+      switch (sqlite3_value_type (arg))
+        {
+        case SQLITE_NULL:
+          return 0;
+        case SQLITE_INTEGER:
+        case SQLITE_FLOAT:
+          return 1;
+        case SQLITE_TEXT:
+          return 2;
+        default:
+          return 3;
+        }
+    }
+
+    // keyRank of a table with keys of different storage classes
+    constexpr int MixedRank = 4;
+
+    int
+    compareBytes (const char* a, std::size_t na, const char* b, std::size_t nb)
+    {
+      const std::size_t n  = std::min (na, nb);
+      const int         rc = n ? std::memcmp (a, b, n) : 0;
+      if (rc != 0)
+        return rc;
+      return na < nb ? -1 : (na > nb ? 1 : 0);
+    }
+
+    // same order as sqlite uses for a column without affinity and
+    // the BINARY collation
+    int
+    compareKey (const Value& a, const Value& b)
+    {
+      const int ra = typeRank (a.getType ());
+      const int rb = typeRank (b.getType ());
+      if (ra != rb)
+        return ra < rb ? -1 : 1;
+
+      switch (ra)
+        {
+        case 0:
+          return 0;
+
+        case 1:
+          if (a.getType () == Type::Int && b.getType () == Type::Int)
+            return a.int64 () < b.int64 () ? -1
+                                           : (a.int64 () > b.int64 () ? 1 : 0);
+          else
+            {
+              const double da = a.getType () == Type::Int
+                                    ? static_cast<double> (a.int64 ())
+                                    : a.real ();
+              const double db = b.getType () == Type::Int
+                                    ? static_cast<double> (b.int64 ())
+                                    : b.real ();
+              return da < db ? -1 : (da > db ? 1 : 0);
+            }
+
+        default:
+          return compareBytes (a.data (), a.size (), b.data (), b.size ());
+        }
+    }
+
+    // module data, one per virtual table, the source is released on drop
+    struct Source
+    {
+      std::shared_ptr<const TableSource> source;
+      int                                key;
+    };
+
+    struct Table : sqlite3_vtab
+    {
+      Source*                            module{nullptr};
+      std::shared_ptr<const TableSource> source;
+      int                                key{-1};
+      std::vector<std::size_t>           order; // rows sorted by key
+      bool                               sorted{false};
+      // typeRank of all non null keys, or MixedRank
+      int keyRank{0};
+
+      const Value&
+      keyOf (std::size_t row, Value& scratch) const
+      {
+        return source->value (row, static_cast<std::size_t> (key), scratch);
+      }
+
+      void
+      ensureOrder ()
+      {
+        const std::size_t rows = source->rowCount ();
+        if (sorted && order.size () == rows)
+          return;
+
+        order.resize (rows);
+        std::iota (order.begin (), order.end (), std::size_t{0});
+        Value sa, sb;
+        keyRank = 0;
+        for (std::size_t row = 0; row < rows; ++row)
+          {
+            const int rank = typeRank (keyOf (row, sa).getType ());
+            if (rank != 0 && keyRank == 0)
+              keyRank = rank;
+            else if (rank != 0 && rank != keyRank)
+              keyRank = MixedRank;
+          }
+        std::stable_sort (
+            order.begin (), order.end (), [&](std::size_t a, std::size_t b) {
+              return compareKey (keyOf (a, sa), keyOf (b, sb)) < 0;
+            });
+        sorted = true;
+      }
+
+      std::size_t
+      lowerBound (const Value& v)
+      {
+        Value scratch;
+        return static_cast<std::size_t> (
+            std::lower_bound (order.begin (),
+                              order.end (),
+                              v,
+                              [&](std::size_t row, const Value& val) {
+                                return compareKey (keyOf (row, scratch), val)
+                                       < 0;
+                              })
+            - order.begin ());
+      }
+
+      std::size_t
+      upperBound (const Value& v)
+      {
+        Value scratch;
+        return static_cast<std::size_t> (
+            std::upper_bound (order.begin (),
+                              order.end (),
+                              v,
+                              [&](const Value& val, std::size_t row) {
+                                return compareKey (val, keyOf (row, scratch))
+                                       < 0;
+                              })
+            - order.begin ());
+      }
+    };
+
+    struct Cursor : sqlite3_vtab_cursor
+    {
+      bool        ordered{false};
+      std::size_t pos{0};
+      std::size_t end{0};
+      Value       scratch;
+
+      Table&
+      table ()
+      {
+        return *static_cast<Table*> (pVtab);
+      }
+
+      std::size_t
+      row ()
+      {
+        return ordered ? table ().order[pos] : pos;
+      }
+    };
+
+    int
+    reportError (sqlite3_vtab* vtab, const std::exception& e)
+    {
+      sqlite3_free (vtab->zErrMsg);
+      vtab->zErrMsg = sqlite3_mprintf ("%s", e.what ());
+      return SQLITE_ERROR;
+    }
+
+    int
+    xConnect (sqlite3*           db,
+              void*              aux,
+              int,
+              const char* const*,
+              sqlite3_vtab** ppVtab,
+              char**         pzErr)
+    {
+      try
+        {
+          auto src = static_cast<Source*> (aux);
+          if (!src->source)
+            throw ErrUnexpected ("the table of this module has been dropped");
+
+          std::string sql = "CREATE TABLE x(";
+          for (std::size_t i = 0; i < src->source->columnCount (); ++i)
+            {
+              if (i > 0)
+                sql += ", ";
+              sql += internal::quoteIdentifier (
+                  src->source->columnName (i));
+            }
+          sql += ")";
+
+          int rc = sqlite3_declare_vtab (db, sql.c_str ());
+          if (rc != SQLITE_OK)
+            return rc;
+
+          auto table    = new Table{};
+          table->module = src;
+          table->source = src->source;
+          table->key    = src->key;
+          *ppVtab       = table;
+          return SQLITE_OK;
+        }
+      catch (const std::exception& e)
+        {
+          *pzErr = sqlite3_mprintf ("%s", e.what ());
+          return SQLITE_ERROR;
+        }
+    }
+
+    int
+    xDisconnect (sqlite3_vtab* vtab)
+    {
+      delete static_cast<Table*> (vtab);
+      return SQLITE_OK;
+    }
+
+    int
+    xDestroy (sqlite3_vtab* vtab)
+    {
+      // DROP TABLE, the module stays registered until the database is
+      // closed, but without the source
+      static_cast<Table*> (vtab)->module->source.reset ();
+      return xDisconnect (vtab);
+    }
+
+    int
+    xBestIndex (sqlite3_vtab* vtab, sqlite3_index_info* info)
+    {
+      auto&  table = *static_cast<Table*> (vtab);
+      double rows  = 1;
+      try
+        {
+          rows = static_cast<double> (
+              std::max<std::size_t> (table.source->rowCount (), 1));
+        }
+      catch (const std::exception& e)
+        {
+          return reportError (vtab, e);
+        }
+
+      int eq = -1, lo = -1, hi = -1;
+      for (int i = 0; i < info->nConstraint; ++i)
+        {
+          const auto& c = info->aConstraint[i];
+          if (!c.usable || table.key < 0 || c.iColumn != table.key)
+            continue;
+
+          // the key is ordered by compareKey, that is BINARY
+          if (sqlite3_stricmp (sqlite3_vtab_collation (info, i), "BINARY")
+              != 0)
+            continue;
+
+          switch (c.op)
+            {
+            case SQLITE_INDEX_CONSTRAINT_EQ:
+              eq = i;
+              break;
+            case SQLITE_INDEX_CONSTRAINT_GT:
+            case SQLITE_INDEX_CONSTRAINT_GE:
+              lo = i;
+              break;
+            case SQLITE_INDEX_CONSTRAINT_LT:
+            case SQLITE_INDEX_CONSTRAINT_LE:
+              hi = i;
+              break;
+            default:
+              break;
+            }
+        }
+
+      // sqlite checks the constraints again, so omit stays false
+      int idx  = 0;
+      int argc = 0;
+      if (eq >= 0)
+        {
+          idx |= KeyEq;
+          info->aConstraintUsage[eq].argvIndex = ++argc;
+          info->estimatedCost                  = std::log2 (rows) + 1;
+          info->estimatedRows                  = 1;
+        }
+      else if (lo >= 0 || hi >= 0)
+        {
+          if (lo >= 0)
+            {
+              idx |= info->aConstraint[lo].op == SQLITE_INDEX_CONSTRAINT_GT
+                         ? KeyGt
+                         : KeyGe;
+              info->aConstraintUsage[lo].argvIndex = ++argc;
+            }
+          if (hi >= 0)
+            {
+              idx |= info->aConstraint[hi].op == SQLITE_INDEX_CONSTRAINT_LT
+                         ? KeyLt
+                         : KeyLe;
+              info->aConstraintUsage[hi].argvIndex = ++argc;
+            }
+          const double part   = (lo >= 0 && hi >= 0) ? 0.1 : 0.3;
+          info->estimatedCost = std::log2 (rows) + rows * part;
+          info->estimatedRows = static_cast<sqlite3_int64> (rows * part) + 1;
+        }
+      else
+        {
+          info->estimatedCost = rows;
+          info->estimatedRows = static_cast<sqlite3_int64> (rows);
+        }
+
+      // rows are delivered in key order whenever the key is used
+      if (table.key >= 0 && info->nOrderBy == 1
+          && info->aOrderBy[0].iColumn == table.key && !info->aOrderBy[0].desc)
+        {
+          idx |= KeyOrdered;
+          info->orderByConsumed = 1;
+        }
+
+      info->idxNum = idx;
+      return SQLITE_OK;
+    }
+
+    int
+    xOpen (sqlite3_vtab*, sqlite3_vtab_cursor** ppCursor)
+    {
+      *ppCursor = new Cursor{};
+      return SQLITE_OK;
+    }
+
+    int
+    xClose (sqlite3_vtab_cursor* cur)
+    {
+      delete static_cast<Cursor*> (cur);
+      return SQLITE_OK;
+    }
+
+    int
+    xFilter (sqlite3_vtab_cursor* cur,
+             int                  idxNum,
+             const char*,
+             int             argc,
+             sqlite3_value** argv)
+    {
+      auto& cursor = *static_cast<Cursor*> (cur);
+      auto& table  = cursor.table ();
+      try
+        {
+          cursor.pos     = 0;
+          cursor.end     = table.source->rowCount ();
+          cursor.ordered = idxNum != 0;
+          if (!cursor.ordered)
+            return SQLITE_OK;
+
+          table.ensureOrder ();
+          if (idxNum == KeyOrdered)
+            return SQLITE_OK;
+
+          // if the storage classes differ, affinity might convert key or
+          // argument, compareKey can not narrow the rows then
+          for (int i = 0; i < argc; ++i)
+            {
+              const int rank = argRank (argv[i]);
+              if (rank != 0 && rank != table.keyRank)
+                return SQLITE_OK; // all rows, still in key order
+            }
+
+          // NULL never satisfies a constraint, nulls are sorted first
+          cursor.pos = table.upperBound (Value{});
+
+          int arg = 0;
+          if (idxNum & KeyEq)
+            {
+              const Value v = internal::argValue (argv[arg++]);
+              if (v.isNull ())
+                cursor.end = cursor.pos;
+              else
+                {
+                  cursor.pos = table.lowerBound (v);
+                  cursor.end = table.upperBound (v);
+                }
+              return SQLITE_OK;
+            }
+
+          if (idxNum & (KeyGt | KeyGe))
+            {
+              const Value v = internal::argValue (argv[arg++]);
+              if (v.isNull ())
+                cursor.end = cursor.pos;
+              else
+                cursor.pos = (idxNum & KeyGt) ? table.upperBound (v)
+                                              : table.lowerBound (v);
+            }
+
+          if (idxNum & (KeyLt | KeyLe))
+            {
+              const Value v = internal::argValue (argv[arg++]);
+              if (v.isNull ())
+                cursor.end = cursor.pos;
+              else
+                cursor.end = std::min (cursor.end,
+                                       (idxNum & KeyLt) ? table.lowerBound (v)
+                                                        : table.upperBound (v));
+            }
+
+          if (cursor.end < cursor.pos)
+            cursor.end = cursor.pos;
+
+          return SQLITE_OK;
+        }
+      catch (const std::exception& e)
+        {
+          return reportError (cur->pVtab, e);
+        }
+    }
+
+    int
+    xNext (sqlite3_vtab_cursor* cur)
+    {
+      ++static_cast<Cursor*> (cur)->pos;
+      return SQLITE_OK;
+    }
+
+    int
+    xEof (sqlite3_vtab_cursor* cur)
+    {
+      auto& cursor = *static_cast<Cursor*> (cur);
+      return cursor.pos >= cursor.end;
+    }
+
+    int
+    xColumn (sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
+    {
+      auto& cursor = *static_cast<Cursor*> (cur);
+      try
+        {
+          internal::resultValue (
+              ctx,
+              cursor.table ().source->value (
+                  cursor.row (), static_cast<std::size_t> (col), cursor.scratch));
+          return SQLITE_OK;
+        }
+      catch (const std::exception& e)
+        {
+          return reportError (cur->pVtab, e);
+        }
+    }
+
+    int
+    xRowid (sqlite3_vtab_cursor* cur, sqlite3_int64* rowid)
+    {
+      *rowid = static_cast<sqlite3_int64> (static_cast<Cursor*> (cur)->row ());
+      return SQLITE_OK;
+    }
+
+    void
+    destroySource (void* p)
+    {
+      delete static_cast<Source*> (p);
+    }
+
+    const sqlite3_module*
+    sourceModule ()
+    {
+      static const sqlite3_module module = [] {
+        sqlite3_module m{};
+        m.iVersion    = 1;
+        m.xCreate     = &xConnect;
+        m.xConnect    = &xConnect;
+        m.xBestIndex  = &xBestIndex;
+        m.xDisconnect = &xDisconnect;
+        m.xDestroy    = &xDestroy;
+        m.xOpen       = &xOpen;
+        m.xClose      = &xClose;
+        m.xFilter     = &xFilter;
+        m.xNext       = &xNext;
+        m.xEof        = &xEof;
+        m.xColumn     = &xColumn;
+        m.xRowid      = &xRowid;
+        return m;
+      }();
+      return &module;
+    }
+
+  } // ns
+
+  namespace internal
+  {
+    void
+    createVirtualTable (sqlite3*                           db,
+                        const std::string&                 name,
+                        std::shared_ptr<const TableSource> source,
+                        const std::string&                 keyColumn)
+    {
+      ASSERT_EXCEPT (source, ErrUnexpected);
+
+      int key = -1;
+      if (!keyColumn.empty ())
+        {
+          for (std::size_t i = 0; i < source->columnCount (); ++i)
+            if (source->columnName (i) == keyColumn)
+              key = static_cast<int> (i);
+
+          if (key < 0)
+            throw ErrOutOfRange ("key column " + keyColumn + " not found");
+        }
+
+      // a module name of its own, a failed create must not replace the
+      // module of an existing table when it is dropped again
+      static std::atomic<unsigned long> modules{0};
+      const std::string module = "sl3_source_" + name + "_"
+                                 + std::to_string (++modules);
+
+      // destroySource is called if the registration fails
+      int rc = sqlite3_create_module_v2 (db,
+                                         module.c_str (),
+                                         sourceModule (),
+                                         new Source{std::move (source), key},
+                                         &destroySource);
+      if (rc != SQLITE_OK)
+        throw SQLite3Error{rc, sqlite3_errmsg (db)};
+
+      const std::string sql = "CREATE VIRTUAL TABLE temp."
+                              + internal::quoteIdentifier (name) + " USING "
+                              + internal::quoteIdentifier (module) + ";";
+      rc = sqlite3_exec (db, sql.c_str (), nullptr, nullptr, nullptr);
+      if (rc != SQLITE_OK)
+        {
+          const std::string msg = sqlite3_errmsg (db);
+          // drops the module, destroySource releases the source
+          sqlite3_create_module_v2 (
+              db, module.c_str (), nullptr, nullptr, nullptr);
+          throw SQLite3Error{rc, msg.c_str ()};
+        }
+    }
+  }
+}
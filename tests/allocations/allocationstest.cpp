@@ -0,0 +1,309 @@
+#include "../testing.hpp"
+#include <sl3/dataset.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+  std::atomic<std::size_t> allocations{0};
+  std::atomic<std::size_t> liveBytes{0};
+
+  // room in front of each allocation to remember its size
+  constexpr std::size_t header = alignof (std::max_align_t);
+
+  // allocations done while running f
+  template <typename F>
+  std::size_t
+  countAllocations (F f)
+  {
+    const auto before = allocations.load ();
+    f ();
+    return allocations.load () - before;
+  }
+
+  // bytes allocated by f and still in use after it
+  template <typename F>
+  std::size_t
+  countBytes (F f)
+  {
+    const auto before = liveBytes.load ();
+    f ();
+    return liveBytes.load () - before;
+  }
+}
+
+void*
+operator new (std::size_t size)
+{
+  ++allocations;
+  if (void* p = std::malloc (header + size))
+    {
+      *static_cast<std::size_t*> (p) = size;
+      liveBytes += size;
+      return static_cast<char*> (p) + header;
+    }
+
+  throw std::bad_alloc{};
+}
+
+// gcc can not see that the replaced operator new uses malloc,
+// nor that operator delete steps back to the size header
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#if __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+#endif
+
+void
+operator delete (void* p) noexcept
+{
+  if (!p)
+    return;
+
+  void* start = static_cast<char*> (p) - header;
+  liveBytes -= *static_cast<std::size_t*> (start);
+  std::free (start);
+}
+
+void
+operator delete (void* p, std::size_t) noexcept
+{
+  ::operator delete (p);
+}
+
+SCENARIO ("moving values does not allocate")
+{
+  using namespace sl3;
+
+  const std::string longText (100, 'x');
+
+  GIVEN ("a long text value and a text DbValue")
+  {
+    Value   val{longText};
+    DbValue dbval{Type::Text};
+
+    WHEN ("moving the value into the DbValue")
+    {
+      auto count = countAllocations ([&] { dbval = std::move (val); });
+
+      THEN ("nothing was allocated")
+      {
+        CHECK (count == 0);
+        CHECK (dbval.getText () == longText);
+        CHECK (val.isNull ());
+      }
+    }
+  }
+
+  GIVEN ("a long text and a long blob")
+  {
+    std::string text{longText};
+    Blob        blob (100, 'b');
+
+    WHEN ("moving them into a Value")
+    {
+      Value val;
+      auto  count = countAllocations ([&] { val = std::move (text); });
+      count += countAllocations ([&] { val = std::move (blob); });
+
+      THEN ("only the shared buffers are allocated")
+      {
+        CHECK (count == 2);
+        CHECK (val.blob () == Blob (100, 'b'));
+      }
+    }
+
+    WHEN ("moving them into a Value that owns a buffer")
+    {
+      Value       txt{std::string (200, 't')};
+      Value       bin{Blob (200, 'x')};
+      const char* bytes = text.data ();
+      auto        count = countAllocations ([&] {
+        txt = std::move (text);
+        bin = std::move (blob);
+      });
+
+      THEN ("nothing was allocated and the text memory was taken")
+      {
+        CHECK (count == 0);
+        CHECK (txt.data () == bytes);
+        CHECK (txt.text () == longText);
+        CHECK (bin.blob () == Blob (100, 'b'));
+      }
+    }
+
+    WHEN ("moving them into DbValues")
+    {
+      DbValue txt{Type::Text};
+      DbValue bin{Type::Blob};
+      auto    count = countAllocations ([&] {
+        txt.set (std::move (text));
+        bin = std::move (blob);
+      });
+
+      THEN ("only the shared buffers are allocated")
+      {
+        CHECK (count == 2);
+        CHECK (txt.getText () == longText);
+        CHECK (bin.getBlob () == Blob (100, 'b'));
+      }
+    }
+
+    WHEN ("constructing DbValues from them")
+    {
+      auto count = countAllocations ([&] {
+        DbValue txt{std::move (text), Type::Text};
+        DbValue bin{std::move (blob), Type::Blob};
+      });
+
+      THEN ("only the shared buffers are allocated")
+      {
+        CHECK (count == 2);
+      }
+    }
+  }
+
+  GIVEN ("a Dataset and rows of long texts")
+  {
+    Dataset  ds{{Type::Int, Type::Text}};
+    DbValues row{DbValue{1}, DbValue{longText, Type::Text}};
+
+    WHEN ("merging a copy of the row")
+    {
+      auto count = countAllocations ([&] { ds.merge (row); });
+
+      THEN ("the row list and the row storage are allocated")
+      {
+        CHECK (count == 2);
+        CHECK (ds.size () == 1);
+      }
+    }
+
+    WHEN ("merging the row by move")
+    {
+      auto count = countAllocations ([&] { ds.merge (std::move (row)); });
+
+      THEN ("only the row list is allocated")
+      {
+        CHECK (count == 1);
+        CHECK (ds.size () == 1);
+        CHECK (ds[0][1].getText () == longText);
+      }
+    }
+  }
+
+  GIVEN ("two Datasets with many rows")
+  {
+    const Types types{Type::Int, Type::Text};
+    Dataset     target{types};
+    Dataset     source{types};
+    for (int i = 0; i < 100; ++i)
+      {
+        target.merge (DbValues{DbValue{i}, DbValue{longText, Type::Text}});
+        source.merge (DbValues{DbValue{i}, DbValue{longText, Type::Text}});
+      }
+
+    WHEN ("merging a copy of the source")
+    {
+      auto count = countAllocations ([&] { target.merge (source); });
+
+      THEN ("each row is allocated")
+      {
+        CHECK (count >= 100);
+        CHECK (target.size () == 200);
+        CHECK (source.size () == 100);
+      }
+    }
+
+    WHEN ("merging the source by move")
+    {
+      auto count
+          = countAllocations ([&] { target.merge (std::move (source)); });
+
+      THEN ("only the row list grows")
+      {
+        CHECK (count <= 1);
+        CHECK (target.size () == 200);
+        CHECK (source.size () == 0);
+      }
+    }
+
+    WHEN ("merging the source by move into an empty Dataset")
+    {
+      Dataset empty{types};
+      auto count
+          = countAllocations ([&] { empty.merge (std::move (source)); });
+
+      THEN ("nothing was allocated")
+      {
+        CHECK (count == 0);
+        CHECK (empty.size () == 100);
+      }
+    }
+  }
+}
+
+SCENARIO ("memory used by text cells")
+{
+  using namespace sl3;
+
+  constexpr std::size_t cells = 1000;
+
+  // the cells and everything they allocated, per cell
+  auto bytesPerCell = [&] (const std::string& text) {
+    std::vector<DbValue> column;
+    auto bytes = countBytes ([&] {
+      column.reserve (cells);
+      for (std::size_t i = 0; i < cells; ++i)
+        column.emplace_back (text, Type::Text);
+    });
+    return bytes / cells;
+  };
+
+  GIVEN ("texts that fit inline")
+  {
+    const std::string shortText (14, 's');
+
+    WHEN ("storing them in cells")
+    {
+      std::vector<DbValue> column;
+      column.reserve (cells);
+      auto count = countAllocations ([&] {
+        for (std::size_t i = 0; i < cells; ++i)
+          column.emplace_back (shortText, Type::Text);
+      });
+      auto bytes = bytesPerCell (shortText);
+      MESSAGE ("bytes per cell for a text of 14 bytes: " << bytes);
+
+      THEN ("a cell is all that is used")
+      {
+        CHECK (count == 0);
+        CHECK (bytes == sizeof (DbValue));
+      }
+    }
+  }
+
+  GIVEN ("texts that do not fit inline")
+  {
+    const std::string longText (100, 'l');
+
+    WHEN ("storing them in cells")
+    {
+      auto bytes = bytesPerCell (longText);
+      MESSAGE ("bytes per cell for a text of 100 bytes: " << bytes);
+
+      THEN ("the cell, the shared buffer and the text are used")
+      {
+        CHECK (bytes
+               <= sizeof (DbValue) + sizeof (std::size_t)
+                      + sizeof (std::string) + longText.size () + 1);
+      }
+    }
+  }
+}
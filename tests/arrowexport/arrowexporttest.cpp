@@ -0,0 +1,265 @@
+#include "../testing.hpp"
+#include <sl3/arrowexport.hpp>
+#include <sl3/database.hpp>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace
+{
+  bool
+  isValid (const ArrowArray* column, int64_t row)
+  {
+    auto validity = static_cast<const uint8_t*> (column->buffers[0]);
+    return validity == nullptr || ((validity[row / 8] >> (row % 8)) & 1);
+  }
+
+  const int64_t*
+  ints (const ArrowArray* column)
+  {
+    return static_cast<const int64_t*> (column->buffers[1]);
+  }
+
+  const double*
+  reals (const ArrowArray* column)
+  {
+    return static_cast<const double*> (column->buffers[1]);
+  }
+
+  std::string
+  text (const ArrowArray* column, int64_t row)
+  {
+    auto offsets = static_cast<const int32_t*> (column->buffers[1]);
+    auto bytes   = static_cast<const char*> (column->buffers[2]);
+    return std::string (bytes + offsets[row], bytes + offsets[row + 1]);
+  }
+}
+
+SCENARIO ("exporting a query result in Arrow format")
+{
+  using namespace sl3;
+
+  GIVEN ("a table with values of each type and nulls")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE t (i INTEGER, r REAL, s TEXT, b BLOB, n);"
+                "INSERT INTO t VALUES (1, 1.5, 'one', x'0100', NULL);"
+                "INSERT INTO t VALUES (NULL, 2, NULL, NULL, NULL);"
+                "INSERT INTO t VALUES (3, 3.5, 'three', x'', NULL);");
+
+    auto cmd = db.prepare ("SELECT * FROM t;");
+
+    WHEN ("exporting with derived types")
+    {
+      ArrowExporter exporter{cmd};
+
+      ArrowSchema schema;
+      exporter.exportSchema (&schema);
+
+      THEN ("the schema is a struct with a nullable field per column")
+      {
+        CHECK (std::string (schema.format) == "+s");
+        REQUIRE (schema.n_children == 5);
+        CHECK (std::string (schema.children[0]->format) == "l");
+        CHECK (std::string (schema.children[1]->format) == "g");
+        CHECK (std::string (schema.children[2]->format) == "u");
+        CHECK (std::string (schema.children[3]->format) == "z");
+        CHECK (std::string (schema.children[4]->format) == "u");
+        CHECK (std::string (schema.children[2]->name) == "s");
+        CHECK (schema.children[0]->flags == ARROW_FLAG_NULLABLE);
+        CHECK (exporter.types ()[4] == Type::Text);
+      }
+
+      THEN ("the batch holds the values and the validity bitmaps")
+      {
+        ArrowArray batch;
+        REQUIRE (exporter.exportNext (&batch));
+        CHECK (batch.length == 3);
+        CHECK (batch.n_buffers == 1);
+        REQUIRE (batch.n_children == 5);
+
+        const ArrowArray* i = batch.children[0];
+        CHECK (i->length == 3);
+        CHECK (i->null_count == 1);
+        CHECK (i->n_buffers == 2);
+        CHECK (ints (i)[0] == 1);
+        CHECK (ints (i)[2] == 3);
+        CHECK (isValid (i, 0));
+        CHECK_FALSE (isValid (i, 1));
+
+        const ArrowArray* r = batch.children[1];
+        CHECK (r->null_count == 0);
+        CHECK (r->buffers[0] == nullptr);
+        CHECK (reals (r)[1] == 2.0);
+
+        const ArrowArray* s = batch.children[2];
+        CHECK (s->n_buffers == 3);
+        CHECK (text (s, 0) == "one");
+        CHECK (text (s, 1) == "");
+        CHECK_FALSE (isValid (s, 1));
+        CHECK (text (s, 2) == "three");
+
+        const ArrowArray* b = batch.children[3];
+        CHECK (text (b, 0) == std::string ("\x01\x00", 2));
+        CHECK (text (b, 2) == "");
+        CHECK (isValid (b, 2));
+
+        CHECK (batch.children[4]->null_count == 3);
+
+        batch.release (&batch);
+        CHECK (batch.release == nullptr);
+
+        CHECK_FALSE (exporter.exportNext (&batch));
+        CHECK (batch.release == nullptr);
+      }
+
+      schema.release (&schema);
+      CHECK (schema.release == nullptr);
+    }
+
+    WHEN ("exporting in small batches")
+    {
+      ArrowExporter exporter{cmd, {}, {}, 2};
+
+      THEN ("the rows are split")
+      {
+        ArrowArray first, second, end;
+        REQUIRE (exporter.exportNext (&first));
+        REQUIRE (exporter.exportNext (&second));
+        CHECK_FALSE (exporter.exportNext (&end));
+        CHECK (first.length == 2);
+        CHECK (second.length == 1);
+        CHECK (ints (second.children[0])[0] == 3);
+        CHECK (text (second.children[2], 0) == "three");
+
+        // a child moved out by the consumer outlives its batch
+        ArrowArray column = *first.children[2];
+        first.children[2]->release = nullptr;
+        first.release (&first);
+        CHECK (text (&column, 0) == "one");
+        column.release (&column);
+        second.release (&second);
+      }
+    }
+
+    WHEN ("a column holds ints and reals")
+    {
+      auto mixed = db.prepare ("SELECT r FROM t ORDER BY r DESC;");
+      ArrowExporter exporter{mixed};
+      ArrowSchema   schema;
+      exporter.exportSchema (&schema);
+
+      THEN ("it is exported as real")
+      {
+        CHECK (std::string (schema.children[0]->format) == "g");
+        ArrowArray batch;
+        REQUIRE (exporter.exportNext (&batch));
+        CHECK (reals (batch.children[0])[0] == 3.5);
+        CHECK (reals (batch.children[0])[1] == 2.0);
+        batch.release (&batch);
+      }
+      schema.release (&schema);
+    }
+
+    WHEN ("exporting with given types and parameters")
+    {
+      auto          query = db.prepare ("SELECT i, r FROM t WHERE r > ?;");
+      ArrowExporter exporter{
+          query, DbValues{DbValue{1.6}}, {Type::Real, Type::Variant}};
+
+      THEN ("given types are used")
+      {
+        CHECK (exporter.types ()[0] == Type::Real);
+        CHECK (exporter.types ()[1] == Type::Variant);
+
+        ArrowArray batch;
+        REQUIRE (exporter.exportNext (&batch));
+        CHECK (batch.length == 2);
+        CHECK (reals (batch.children[0])[1] == 3.0);
+        CHECK (exporter.types ()[1] == Type::Real);
+        batch.release (&batch);
+      }
+    }
+
+    WHEN ("values do not match the given types")
+    {
+      ArrowExporter exporter{
+          cmd, {}, {Type::Int, Type::Int, Type::Text, Type::Blob, Type::Int}};
+
+      THEN ("ErrTypeMisMatch is thrown")
+      {
+        ArrowArray batch;
+        CHECK_THROWS_AS (exporter.exportNext (&batch), ErrTypeMisMatch);
+      }
+    }
+
+    WHEN ("a later batch does not match the derived types")
+    {
+      auto later = db.prepare ("SELECT 1 UNION ALL SELECT 'x';");
+      ArrowExporter exporter{later, {}, {}, 1};
+
+      THEN ("ErrTypeMisMatch is thrown")
+      {
+        ArrowArray batch;
+        REQUIRE (exporter.exportNext (&batch));
+        batch.release (&batch);
+        CHECK_THROWS_AS (exporter.exportNext (&batch), ErrTypeMisMatch);
+      }
+    }
+
+    WHEN ("fetching again after a value did not match")
+    {
+      db.execute ("CREATE TABLE v (a);"
+                  "INSERT INTO v VALUES (1), (2), ('x'), (4), (5);");
+      auto          query = db.prepare ("SELECT 7, a FROM v;");
+      ArrowExporter exporter{query, {}, {Type::Int, Type::Int}, 2};
+
+      THEN ("the exporter stays failed")
+      {
+        ArrowArray batch;
+        REQUIRE (exporter.exportNext (&batch));
+        CHECK (batch.length == 2);
+        batch.release (&batch);
+        CHECK_THROWS_AS (exporter.exportNext (&batch), ErrTypeMisMatch);
+        CHECK_THROWS_AS (exporter.exportNext (&batch), ErrTypeMisMatch);
+      }
+    }
+
+    THEN ("invalid arguments throw")
+    {
+      CHECK_THROWS_AS ((ArrowExporter{cmd, {}, {Type::Int}}), ErrTypeMisMatch);
+      CHECK_THROWS_AS ((ArrowExporter{cmd, {}, {}, 0}), ErrOutOfRange);
+    }
+
+    THEN ("the command can be used again after an export")
+    {
+      {
+        ArrowExporter exporter{cmd, {}, {}, 1};
+        ArrowArray    batch;
+        REQUIRE (exporter.exportNext (&batch));
+        batch.release (&batch);
+      }
+      CHECK (cmd.select ().size () == 3);
+    }
+  }
+}
+
+SCENARIO ("exporting from a closed database")
+{
+  using namespace sl3;
+
+  GIVEN ("a command of a database that has been closed")
+  {
+    std::unique_ptr<Database> db{new Database{":memory:"}};
+    auto                      cmd = db->prepare ("SELECT 1, 2;");
+    db.reset ();
+
+    THEN ("starting an export throws ErrNoConnection")
+    {
+      CHECK_THROWS_AS ((ArrowExporter{cmd, {}, {Type::Int}}),
+                       ErrNoConnection);
+      CHECK_THROWS_AS ((ArrowExporter{cmd}), ErrNoConnection);
+    }
+  }
+}
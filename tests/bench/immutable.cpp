@@ -0,0 +1,82 @@
+/*
+ * compares point lookup throughput of a normal and an immutable open
+ *
+ * usage: sl3bench_immutable [lookups]
+ */
+
+#include <sl3/database.hpp>
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+  const char* dbfile = "sl3bench_immutable.db";
+  const int   rows   = 100000;
+
+  void
+  create ()
+  {
+    std::remove (dbfile);
+    sl3::Database db{dbfile};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);");
+    db.execute ("BEGIN;");
+    auto insert = db.prepare ("INSERT INTO t VALUES (?, ?);");
+    for (int i = 0; i < rows; ++i)
+      insert.execute (sl3::parameters (i, "value " + std::to_string (i)));
+    db.execute ("COMMIT;");
+  }
+
+  double
+  run (const sl3::OpenOptions& options, int lookups)
+  {
+    sl3::Database db{dbfile, options};
+
+    // every execute is an own read transaction
+    auto select = db.prepare ("SELECT v FROM t WHERE id = ?;");
+    auto start  = std::chrono::steady_clock::now ();
+
+    unsigned id = 1;
+    for (int i = 0; i < lookups; ++i)
+      {
+        id = id * 1103515245u + 12345u;
+        select.execute (
+            [](sl3::Columns) { return true; },
+            sl3::parameters (static_cast<int> (id % rows)));
+      }
+
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+
+    return lookups / elapsed.count ();
+  }
+}
+
+int
+main (int argc, char** argv)
+{
+  const int lookups = argc > 1 ? std::atoi (argv[1]) : 200000;
+
+  create ();
+
+  sl3::OpenOptions normal;
+  normal.flags = SQLITE_OPEN_READONLY;
+
+  sl3::OpenOptions immutable;
+  immutable.immutable = true;
+
+  std::cout << "lookups per second, " << lookups << " lookups\n";
+  std::cout << std::fixed << std::setprecision (0);
+  std::cout << std::setw (12) << std::left << "normal" << run (normal, lookups)
+            << "\n";
+  std::cout << std::setw (12) << std::left << "immutable"
+            << run (immutable, lookups) << "\n";
+
+  std::remove (dbfile);
+  return 0;
+}
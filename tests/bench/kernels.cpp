@@ -0,0 +1,114 @@
+/*
+ * compares aggregates and filters via a loop over DbValue cells with the
+ * column kernels, for each SIMD level the CPU supports
+ *
+ * usage: sl3bench_kernels [rows]
+ */
+
+#include <sl3/columnkernels.hpp>
+#include <sl3/database.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+  const char* const levelNames[] = {"Scalar", "SSE4.2", "AVX2", "AVX-512"};
+
+  template <typename F>
+  double
+  measure (F f)
+  {
+    const int repeat = 10;
+    auto      start  = std::chrono::steady_clock::now ();
+    for (int i = 0; i < repeat; ++i)
+      f ();
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+    return elapsed.count () * 1000 / repeat;
+  }
+
+  void
+  report (const std::string& name, double ms)
+  {
+    std::cout << std::setw (28) << std::left << name << std::setw (10)
+              << std::right << std::fixed << std::setprecision (3) << ms
+              << " ms\n";
+  }
+}
+
+int
+main (int argc, char** argv)
+{
+  using namespace sl3;
+  const int rows = argc > 1 ? std::atoi (argv[1]) : 2000000;
+
+  Database db{":memory:"};
+  db.execute ("CREATE TABLE t (i INTEGER, r REAL);");
+  db.execute ("WITH RECURSIVE n(x) AS (SELECT 0 UNION ALL SELECT x + 1 "
+              "FROM n WHERE x < "
+              + std::to_string (rows - 1)
+              + ") INSERT INTO t SELECT CASE WHEN x % 97 = 0 THEN NULL "
+                "ELSE abs(random()) % 1000000 END, x / 3.0 FROM n;");
+
+  auto ds      = db.select ("SELECT * FROM t;", {Type::Int, Type::Real});
+  auto columns = db.selectColumnar ("SELECT * FROM t;",
+                                    {Type::Int, Type::Real});
+  const auto& ints  = columns.column (0);
+  const auto& reals = columns.column (1);
+
+  std::cout << rows << " rows\n";
+
+  int64_t cellSum = 0;
+  report ("sum over DbValue cells", measure ([&]() {
+            cellSum = 0;
+            for (const auto& row : ds)
+              cellSum += row[0].getInt (0);
+          }));
+
+  std::size_t cellSelected = 0;
+  report ("filter over DbValue cells", measure ([&]() {
+            Selection rows;
+            for (std::size_t i = 0; i < ds.size (); ++i)
+              {
+                const auto& v = ds[i][0];
+                if (!v.isNull () && v.getInt () < 250000)
+                  rows.push_back (i);
+              }
+            cellSelected = rows.size ();
+          }));
+
+  for (int l = 0; l <= static_cast<int> (supportedSimdLevel ()); ++l)
+    {
+      setSimdLevel (static_cast<SimdLevel> (l));
+      const std::string level = levelNames[l];
+
+      int64_t total = 0;
+      report ("sum int " + level,
+              measure ([&]() { total = sum (ints).getInt (); }));
+      if (total != cellSum)
+        std::cout << "sum differs\n";
+
+      report ("sum real " + level, measure ([&]() { sum (reals); }));
+      report ("min/max int " + level, measure ([&]() {
+                min (ints);
+                max (ints);
+              }));
+
+      std::size_t selected = 0;
+      report ("filter int " + level, measure ([&]() {
+                selected = selectLess (ints, DbValue{250000}).size ();
+              }));
+      if (selected != cellSelected)
+        std::cout << "filter differs\n";
+
+      report ("filter real " + level, measure ([&]() {
+                selectBetween (reals, DbValue{1000.0}, DbValue{2000.0});
+              }));
+    }
+
+  return 0;
+}
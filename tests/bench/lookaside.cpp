@@ -0,0 +1,76 @@
+/*
+ * compares small statement throughput for different lookaside settings
+ *
+ * usage: sl3bench_lookaside [statements]
+ */
+
+#include <sl3/database.hpp>
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+  struct Setting
+  {
+    const char* name;
+    int         slotSize;
+    int         slots;
+  };
+
+  double
+  run (const Setting& setting, int statements)
+  {
+    sl3::OpenOptions options;
+    options.lookasideSlotSize = setting.slotSize;
+    options.lookasideSlots    = setting.slots;
+
+    sl3::Database db{":memory:", options};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);");
+
+    auto insert = db.prepare ("INSERT INTO t VALUES (?, ?);");
+    auto start  = std::chrono::steady_clock::now ();
+
+    for (int i = 0; i < statements; ++i)
+      {
+        insert.execute (sl3::parameters (i, "value"));
+        // a tiny statement prepared each time, as ad hoc queries are
+        db.selectValue ("SELECT v FROM t WHERE id = " + std::to_string (i));
+      }
+
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+
+    return statements / elapsed.count ();
+  }
+}
+
+int
+main (int argc, char** argv)
+{
+  const int statements = argc > 1 ? std::atoi (argv[1]) : 100000;
+
+  const Setting settings[] = {{"disabled", 0, 0},
+                              {"sqlite default", -1, -1},
+                              {"64 x 128", 128, 64},
+                              {"500 x 128", 128, 500},
+                              {"500 x 512", 512, 500},
+                              {"2000 x 256", 256, 2000}};
+
+  if (sqlite3_compileoption_used ("OMIT_LOOKASIDE"))
+    std::cout << "note: sqlite was built with SQLITE_OMIT_LOOKASIDE\n";
+
+  std::cout << "statement pairs per second, " << statements << " pairs\n";
+  for (const auto& setting : settings)
+    {
+      std::cout << std::setw (16) << std::left << setting.name
+                << std::fixed << std::setprecision (0)
+                << run (setting, statements) << "\n";
+    }
+
+  return 0;
+}
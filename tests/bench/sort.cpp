@@ -0,0 +1,80 @@
+/*
+ * compares Dataset::sort via normalized keys with sorting via a compare
+ * function, serial and parallel
+ *
+ * usage: sl3bench_sort [rows] [threads]
+ */
+
+#include <sl3/dataset.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+  // same order as dbval_lt, but not dbval_lt, so the compare path is used
+  bool
+  compareLt (const sl3::DbValue& a, const sl3::DbValue& b)
+  {
+    return sl3::dbval_lt (a, b);
+  }
+
+  sl3::Dataset
+  create (int rows)
+  {
+    using namespace sl3;
+    Dataset  ds{{Type::Int, Type::Real, Type::Text}};
+    unsigned r = 1;
+    for (int i = 0; i < rows; ++i)
+      {
+        r = r * 1103515245u + 12345u;
+        ds.merge (DbValues{DbValue{static_cast<int> (r % 1000)},
+                           DbValue{(r % 7919) / 7.0},
+                           DbValue{"name " + std::to_string (r % 100003),
+                                   Type::Text}});
+      }
+    return ds;
+  }
+
+  double
+  run (sl3::Dataset                ds,
+       sl3::Dataset::DbValueSort   cmp,
+       const sl3::ExecutionPolicy& policy)
+  {
+    auto start = std::chrono::steady_clock::now ();
+    ds.sort ({2, 0, 1}, cmp, policy);
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+    return elapsed.count () * 1000;
+  }
+}
+
+int
+main (int argc, char** argv)
+{
+  const int rows    = argc > 1 ? std::atoi (argv[1]) : 1000000;
+  const int threads = argc > 2 ? std::atoi (argv[2]) : 0;
+
+  const auto ds = create (rows);
+
+  sl3::ExecutionPolicy serial;
+  serial.threads = 1;
+  sl3::ExecutionPolicy parallel;
+  parallel.threads = threads;
+
+  std::cout << "sort by text, int, real, " << rows << " rows, ms\n";
+  std::cout << std::fixed << std::setprecision (0);
+  std::cout << std::setw (20) << std::left << "compare"
+            << run (ds, &compareLt, serial) << "\n";
+  std::cout << std::setw (20) << std::left << "keys"
+            << run (ds, &sl3::dbval_lt, serial) << "\n";
+  std::cout << std::setw (20) << std::left << "compare parallel"
+            << run (ds, &compareLt, parallel) << "\n";
+  std::cout << std::setw (20) << std::left << "keys parallel"
+            << run (ds, &sl3::dbval_lt, parallel) << "\n";
+
+  return 0;
+}
@@ -0,0 +1,271 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+#include <sqlite3.h>
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+SCENARIO("reading and writing blobs incremental")
+{
+  using namespace sl3 ;
+  GIVEN ("a database with a table containing blobs")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE tbl (id INTEGER PRIMARY KEY, data BLOB);"
+                "INSERT INTO tbl VALUES (1, x'0102030405');"
+                "INSERT INTO tbl VALUES (2, x'0A0B');"
+                "INSERT INTO tbl VALUES (3, NULL);") ;
+
+    WHEN ("opening a blob for reading")
+    {
+      auto blob = db.openBlob ("tbl", "data", 1) ;
+
+      THEN ("size and content are accessible")
+      {
+        CHECK (blob.size () == 5) ;
+        CHECK (blob.rowid () == 1) ;
+        CHECK (blob.mode () == BlobStream::Mode::ReadOnly) ;
+
+        char buf[8] = {0} ;
+        CHECK (blob.read (buf, 2, 1) == 2) ;
+        CHECK (buf[0] == 2) ;
+        CHECK (buf[1] == 3) ;
+
+        CHECK (blob.read (buf, 8, 3) == 2) ;
+        CHECK (buf[0] == 4) ;
+        CHECK (buf[1] == 5) ;
+
+        CHECK (blob.read (buf, 8, 5) == 0) ;
+        CHECK_THROWS_AS (blob.read (buf, 1, 6), ErrOutOfRange) ;
+      }
+
+      THEN ("writing is not possible")
+      {
+        char buf[1] = {9} ;
+        CHECK_THROWS_AS (blob.write (buf, 1, 0), SQLite3Error) ;
+      }
+
+      THEN ("it can be read in chunks")
+      {
+        Blob all ;
+        int calls = 0 ;
+        blob.readChunks ([&](const char* data, std::size_t n) {
+          ++calls ;
+          all.insert (all.end (), data, data + n) ;
+          return true ;
+        }, 2) ;
+        CHECK (calls == 3) ;
+        CHECK (all == (Blob{1, 2, 3, 4, 5})) ;
+
+        calls = 0 ;
+        blob.readChunks ([&](const char*, std::size_t) {
+          ++calls ;
+          return false ;
+        }, 2) ;
+        CHECK (calls == 1) ;
+        CHECK_THROWS_AS (blob.readChunks (nullptr, 0), ErrOutOfRange) ;
+      }
+
+      THEN ("it can be moved to other rows")
+      {
+        blob.reopen (2) ;
+        CHECK (blob.rowid () == 2) ;
+        CHECK (blob.size () == 2) ;
+        char buf[2] = {0} ;
+        blob.read (buf, 2, 0) ;
+        CHECK (buf[0] == 10) ;
+        CHECK (buf[1] == 11) ;
+
+        CHECK_THROWS_AS (blob.reopen (3), SQLite3Error) ;
+      }
+
+      THEN ("a closed blob can not be used any more")
+      {
+        blob.close () ;
+        CHECK_THROWS_AS ((void)blob.size (), ErrNoConnection) ;
+        CHECK_NOTHROW (blob.close ()) ;
+      }
+
+      THEN ("a moved from blob can not be used any more")
+      {
+        BlobStream other{std::move (blob)} ;
+        CHECK (other.size () == 5) ;
+        CHECK_THROWS_AS ((void)blob.size (), ErrNoConnection) ;
+      }
+    }
+
+    WHEN ("opening a blob that does not exist")
+    {
+      THEN ("this throws")
+      {
+        CHECK_THROWS_AS (db.openBlob ("tbl", "data", 3), SQLite3Error) ;
+        CHECK_THROWS_AS (db.openBlob ("tbl", "data", 99), SQLite3Error) ;
+        CHECK_THROWS_AS (db.openBlob ("nope", "data", 1), SQLite3Error) ;
+      }
+    }
+
+    WHEN ("opening a blob for writing")
+    {
+      auto blob = db.openBlob ("tbl", "data", 1, BlobStream::Mode::ReadWrite) ;
+
+      THEN ("data can be written within the blob size")
+      {
+        const char data[2] = {7, 8} ;
+        blob.write (data, 2, 3) ;
+        CHECK_THROWS_AS (blob.write (data, 2, 4), ErrOutOfRange) ;
+        blob.close () ;
+
+        auto val = db.selectValue ("SELECT data FROM tbl WHERE id = 1;") ;
+        CHECK (val.getBlob () == (Blob{1, 2, 3, 7, 8})) ;
+      }
+    }
+
+    WHEN ("the database goes away before the blob")
+    {
+      THEN ("the blob is disconnected")
+      {
+        Database* other = new Database{":memory:"} ;
+        other->execute ("CREATE TABLE t (b BLOB);"
+                        "INSERT INTO t VALUES (x'01');") ;
+        auto blob = other->openBlob ("t", "b", 1) ;
+        delete other ;
+        CHECK_THROWS_AS ((void)blob.size (), ErrNoConnection) ;
+      }
+    }
+
+    WHEN ("the database is closed while a blob is open")
+    {
+      // an earlier connection, so lazy global allocations are done
+      Database{":memory:"}.execute ("SELECT 1;") ;
+      const auto used = sqlite3_memory_used () ;
+
+      std::unique_ptr<Database> other{new Database{":memory:"}} ;
+      other->execute ("CREATE TABLE t (b BLOB);"
+                      "INSERT INTO t VALUES (x'01');") ;
+      auto blob = other->openBlob ("t", "b", 1) ;
+      other.reset () ;
+
+      THEN ("blob and connection are freed before the blob goes away")
+      {
+        CHECK (sqlite3_memory_used () == used) ;
+        CHECK_THROWS_AS ((void)blob.size (), ErrNoConnection) ;
+        CHECK_NOTHROW (blob.close ()) ;
+      }
+    }
+  }
+}
+
+
+SCENARIO("writing preallocated blobs")
+{
+  using namespace sl3 ;
+  GIVEN ("a database with a table for blobs")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE tbl (id INTEGER PRIMARY KEY,"
+                " name TEXT DEFAULT 'x', data BLOB);") ;
+
+    WHEN ("inserting a zeroblob")
+    {
+      auto blob = db.insertZeroBlob ("tbl", "data", 1000) ;
+
+      THEN ("a writable blob of the given size exists")
+      {
+        CHECK (blob.size () == 1000) ;
+        CHECK (blob.mode () == BlobStream::Mode::ReadWrite) ;
+        CHECK (blob.rowid () == db.getLastInsertRowid ()) ;
+
+        std::string chunk (100, 'a') ;
+        for (std::size_t i = 0; i < 10; ++i)
+          {
+            chunk[0] = static_cast<char> ('0' + i) ;
+            blob.write (chunk.data (), chunk.size (), i * 100) ;
+          }
+        blob.close () ;
+
+        auto val = db.selectValue ("SELECT data FROM tbl;") ;
+        REQUIRE (val.getBlob ().size () == 1000) ;
+        CHECK (val.getBlob ()[0] == '0') ;
+        CHECK (val.getBlob ()[900] == '9') ;
+        CHECK (val.getBlob ()[999] == 'a') ;
+        CHECK (db.selectValue ("SELECT name FROM tbl;").getText () == "x") ;
+      }
+    }
+
+    WHEN ("inserting into an invalid table")
+    {
+      THEN ("this throws")
+      {
+        CHECK_THROWS_AS (db.insertZeroBlob ("nope", "data", 10),
+                         SQLite3Error) ;
+      }
+    }
+  }
+}
+
+
+SCENARIO("using blobs with std streams")
+{
+  using namespace sl3 ;
+  GIVEN ("a preallocated blob")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE tbl (data BLOB);") ;
+    auto rowid = db.insertZeroBlob ("tbl", "data", 26).rowid () ;
+
+    WHEN ("writing via an ostream with a small buffer")
+    {
+      {
+        auto blob = db.openBlob ("tbl", "data", rowid,
+                                 BlobStream::Mode::ReadWrite) ;
+        BlobStreamBuf buf{blob, 4} ;
+        std::ostream out{&buf} ;
+        for (char c = 'a'; c <= 'z'; ++c)
+          out << c ;
+        out.flush () ;
+        CHECK (out.good ()) ;
+
+        out << 'X' ;
+        out.flush () ;
+        CHECK_FALSE (out.good ()) ;
+      }
+
+      THEN ("the content can be read via an istream")
+      {
+        auto blob = db.openBlob ("tbl", "data", rowid) ;
+        BlobStreamBuf buf{blob, 3} ;
+        std::istream in{&buf} ;
+        std::string content ;
+        in >> content ;
+        CHECK (content == "abcdefghijklmnopqrstuvwxyz") ;
+      }
+
+      THEN ("seeking is possible")
+      {
+        auto blob = db.openBlob ("tbl", "data", rowid,
+                                 BlobStream::Mode::ReadWrite) ;
+        BlobStreamBuf buf{blob, 5} ;
+        std::iostream io{&buf} ;
+
+        io.seekg (-3, std::ios_base::end) ;
+        CHECK (io.get () == 'x') ;
+        CHECK (io.get () == 'y') ;
+
+        io.seekp (1, std::ios_base::beg) ;
+        io.put ('B') ;
+        CHECK (io.get () == 'c') ;
+        io.seekg (1) ;
+        CHECK (io.get () == 'B') ;
+
+        io.seekg (2, std::ios_base::cur) ;
+        CHECK (io.get () == 'e') ;
+
+        io.seekg (27) ;
+        CHECK (io.fail ()) ;
+      }
+    }
+  }
+}
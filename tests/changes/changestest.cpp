@@ -0,0 +1,449 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // a VFS shim that lets xSync fail on request, so a commit fails after
+  // the commit hook has been called
+  bool failSync = false;
+
+  struct ShimFile
+  {
+    sqlite3_file  base;
+    sqlite3_file* real;
+  };
+
+  sqlite3_file*
+  real (sqlite3_file* f)
+  {
+    return reinterpret_cast<ShimFile*> (f)->real;
+  }
+
+  int
+  shimClose (sqlite3_file* f)
+  {
+    int rc = real (f)->pMethods ? real (f)->pMethods->xClose (real (f))
+                                : SQLITE_OK;
+    sqlite3_free (real (f));
+    return rc;
+  }
+
+  int
+  shimRead (sqlite3_file* f, void* p, int n, sqlite3_int64 off)
+  {
+    return real (f)->pMethods->xRead (real (f), p, n, off);
+  }
+
+  int
+  shimWrite (sqlite3_file* f, const void* p, int n, sqlite3_int64 off)
+  {
+    return real (f)->pMethods->xWrite (real (f), p, n, off);
+  }
+
+  int
+  shimTruncate (sqlite3_file* f, sqlite3_int64 size)
+  {
+    return real (f)->pMethods->xTruncate (real (f), size);
+  }
+
+  int
+  shimSync (sqlite3_file* f, int flags)
+  {
+    if (failSync)
+      return SQLITE_IOERR_FSYNC;
+    return real (f)->pMethods->xSync (real (f), flags);
+  }
+
+  int
+  shimFileSize (sqlite3_file* f, sqlite3_int64* size)
+  {
+    return real (f)->pMethods->xFileSize (real (f), size);
+  }
+
+  int
+  shimLock (sqlite3_file* f, int lock)
+  {
+    return real (f)->pMethods->xLock (real (f), lock);
+  }
+
+  int
+  shimUnlock (sqlite3_file* f, int lock)
+  {
+    return real (f)->pMethods->xUnlock (real (f), lock);
+  }
+
+  int
+  shimCheckReservedLock (sqlite3_file* f, int* out)
+  {
+    return real (f)->pMethods->xCheckReservedLock (real (f), out);
+  }
+
+  int
+  shimFileControl (sqlite3_file* f, int op, void* arg)
+  {
+    return real (f)->pMethods->xFileControl (real (f), op, arg);
+  }
+
+  int
+  shimSectorSize (sqlite3_file* f)
+  {
+    return real (f)->pMethods->xSectorSize (real (f));
+  }
+
+  int
+  shimDeviceCharacteristics (sqlite3_file* f)
+  {
+    return real (f)->pMethods->xDeviceCharacteristics (real (f));
+  }
+
+  const sqlite3_io_methods shimMethods = {1,
+                                          &shimClose,
+                                          &shimRead,
+                                          &shimWrite,
+                                          &shimTruncate,
+                                          &shimSync,
+                                          &shimFileSize,
+                                          &shimLock,
+                                          &shimUnlock,
+                                          &shimCheckReservedLock,
+                                          &shimFileControl,
+                                          &shimSectorSize,
+                                          &shimDeviceCharacteristics,
+                                          nullptr,
+                                          nullptr,
+                                          nullptr,
+                                          nullptr,
+                                          nullptr,
+                                          nullptr};
+
+  sqlite3_vfs* defaultVfs = nullptr;
+
+  int
+  shimOpen (sqlite3_vfs*,
+            const char*   name,
+            sqlite3_file* f,
+            int           flags,
+            int*          out)
+  {
+    auto file  = reinterpret_cast<ShimFile*> (f);
+    file->real = static_cast<sqlite3_file*> (
+        sqlite3_malloc (defaultVfs->szOsFile));
+    if (!file->real)
+      return SQLITE_NOMEM;
+
+    int rc = defaultVfs->xOpen (defaultVfs, name, file->real, flags, out);
+    if (rc != SQLITE_OK)
+      {
+        sqlite3_free (file->real);
+        return rc;
+      }
+
+    file->base.pMethods = &shimMethods;
+    return SQLITE_OK;
+  }
+
+  // registers the shim as "sl3_failsync"
+  void
+  registerShim ()
+  {
+    static sqlite3_vfs vfs;
+    if (defaultVfs)
+      return;
+
+    defaultVfs    = sqlite3_vfs_find (nullptr);
+    vfs           = *defaultVfs;
+    vfs.iVersion  = 1;
+    vfs.szOsFile  = sizeof (ShimFile);
+    vfs.zName     = "sl3_failsync";
+    vfs.pAppData  = nullptr;
+    vfs.xOpen     = &shimOpen;
+    sqlite3_vfs_register (&vfs, 0);
+  }
+}
+
+SCENARIO("receiving committed changes")
+{
+  using namespace sl3 ;
+  using Op = Change::Operation ;
+
+  GIVEN ("a database with a change feed")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+
+    std::vector<std::vector<Change>> batches ;
+    auto collect = [&batches](const std::vector<Change>& changes) {
+      batches.push_back (changes) ;
+    } ;
+    db.onChange (collect) ;
+
+    WHEN ("executing statements in autocommit mode")
+    {
+      db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+      db.prepare ("UPDATE t SET v = ? WHERE id = 1;")
+          .execute (parameters ("b")) ;
+      db.execute ("DELETE FROM t WHERE id = 1;") ;
+
+      THEN ("each statement delivers its change")
+      {
+        REQUIRE (batches.size () == 3) ;
+        REQUIRE (batches[0].size () == 1) ;
+        CHECK (batches[0][0].operation == Op::Insert) ;
+        CHECK (batches[0][0].database == "main") ;
+        CHECK (batches[0][0].table == "t") ;
+        CHECK (batches[0][0].rowid == 1) ;
+        CHECK (batches[1][0].operation == Op::Update) ;
+        CHECK (batches[2][0].operation == Op::Delete) ;
+      }
+    }
+
+    WHEN ("changing rows in a transaction")
+    {
+      {
+        auto trans = db.beginTransaction () ;
+        db.execute ("INSERT INTO t VALUES (1, 'a'), (2, 'b');") ;
+        CHECK (batches.empty ()) ;
+        trans.commit () ;
+      }
+
+      THEN ("the changes are delivered after the commit")
+      {
+        REQUIRE (batches.size () == 1) ;
+        CHECK (batches[0].size () == 2) ;
+      }
+    }
+
+    WHEN ("a transaction is rolled back")
+    {
+      {
+        auto trans = db.beginTransaction () ;
+        db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+      }
+      db.execute ("INSERT INTO t VALUES (2, 'b');") ;
+
+      THEN ("its changes are dropped")
+      {
+        REQUIRE (batches.size () == 1) ;
+        REQUIRE (batches[0].size () == 1) ;
+        CHECK (batches[0][0].rowid == 2) ;
+      }
+    }
+
+    WHEN ("a savepoint is rolled back")
+    {
+      {
+        auto trans = db.beginTransaction () ;
+        db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+        {
+          auto sp = db.savepoint () ;
+          db.execute ("INSERT INTO t VALUES (2, 'b');") ;
+        }
+        {
+          auto sp = db.savepoint () ;
+          db.execute ("INSERT INTO t VALUES (3, 'c');") ;
+          sp.release () ;
+        }
+        trans.commit () ;
+      }
+
+      THEN ("only the changes of the savepoint are dropped")
+      {
+        REQUIRE (batches.size () == 1) ;
+        REQUIRE (batches[0].size () == 2) ;
+        CHECK (batches[0][0].rowid == 1) ;
+        CHECK (batches[0][1].rowid == 3) ;
+      }
+    }
+
+    WHEN ("the callback uses the database")
+    {
+      int calls = 0 ;
+      int count = 0 ;
+      db.onChange ([&](const std::vector<Change>&) {
+        ++calls ;
+        count = db.selectValue ("SELECT count(*) FROM t;").getInt () ;
+        if (calls == 1)
+          db.execute ("INSERT INTO t (v) VALUES ('from callback');") ;
+      }) ;
+      db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+
+      THEN ("this works and the changes of the callback are reported too")
+      {
+        CHECK (calls == 2) ;
+        CHECK (count == 2) ;
+      }
+    }
+
+    WHEN ("the feed is stopped")
+    {
+      db.onChange (nullptr) ;
+      db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+
+      THEN ("nothing is delivered")
+      {
+        CHECK (batches.empty ()) ;
+      }
+    }
+  }
+}
+
+SCENARIO("using change batch options")
+{
+  using namespace sl3 ;
+  using Op = Change::Operation ;
+
+  GIVEN ("a database with a table")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);"
+                "INSERT INTO t VALUES (1, 'a');") ;
+
+    std::vector<std::vector<Change>> batches ;
+    auto collect = [&batches](const std::vector<Change>& changes) {
+      batches.push_back (changes) ;
+    } ;
+
+    WHEN ("using a maximal batch size")
+    {
+      ChangeBatchOptions options ;
+      options.maxBatchSize = 2 ;
+      db.onChange (collect, options) ;
+      db.execute ("INSERT INTO t (v) VALUES ('b'), ('c'), ('d'), ('e'),"
+                  " ('f');") ;
+
+      THEN ("the changes are split into batches")
+      {
+        REQUIRE (batches.size () == 3) ;
+        CHECK (batches[0].size () == 2) ;
+        CHECK (batches[1].size () == 2) ;
+        CHECK (batches[2].size () == 1) ;
+      }
+    }
+
+    WHEN ("coalescing changes")
+    {
+      ChangeBatchOptions options ;
+      options.coalesce = true ;
+      db.onChange (collect, options) ;
+      {
+        auto trans = db.beginTransaction () ;
+        db.execute ("UPDATE t SET v = 'x' WHERE id = 1;"
+                    "UPDATE t SET v = 'y' WHERE id = 1;"
+                    "INSERT INTO t VALUES (2, 'b');"
+                    "UPDATE t SET v = 'z' WHERE id = 2;"
+                    "INSERT INTO t VALUES (3, 'c');"
+                    "DELETE FROM t WHERE id = 3;"
+                    "DELETE FROM t WHERE id = 1;") ;
+        trans.commit () ;
+      }
+
+      THEN ("each row is reported once with its net effect")
+      {
+        REQUIRE (batches.size () == 1) ;
+        REQUIRE (batches[0].size () == 2) ;
+        CHECK (batches[0][0].rowid == 1) ;
+        CHECK (batches[0][0].operation == Op::Delete) ;
+        CHECK (batches[0][1].rowid == 2) ;
+        CHECK (batches[0][1].operation == Op::Insert) ;
+      }
+    }
+  }
+}
+
+SCENARIO("changes of a commit that fails")
+{
+  using namespace sl3 ;
+
+  const std::string dbfile{"sl3test_changes.db"} ;
+  std::remove (dbfile.c_str ()) ;
+
+  GIVEN ("a database with a change feed and a reader that blocks commits")
+  {
+    Database db{dbfile};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+
+    std::vector<Change> changes ;
+    db.onChange ([&changes](const std::vector<Change>& batch) {
+      changes.insert (changes.end (), batch.begin (), batch.end ()) ;
+    }) ;
+
+    Database reader{dbfile};
+    reader.execute ("BEGIN; SELECT count(*) FROM t;") ;
+
+    db.execute ("BEGIN; INSERT INTO t VALUES (1, 'a');") ;
+    CHECK_THROWS_AS (db.execute ("COMMIT;"), SQLite3Error) ;
+
+    WHEN ("the transaction is rolled back after the busy commit")
+    {
+      db.execute ("ROLLBACK;") ;
+      reader.execute ("COMMIT;") ;
+      db.execute ("INSERT INTO t VALUES (2, 'b');") ;
+
+      THEN ("only the changes that were committed are delivered")
+      {
+        REQUIRE (changes.size () == 1) ;
+        CHECK (changes[0].rowid == 2) ;
+      }
+    }
+
+    WHEN ("the commit is retried")
+    {
+      CHECK (changes.empty ()) ;
+      reader.execute ("COMMIT;") ;
+      db.execute ("COMMIT;") ;
+
+      THEN ("the changes are delivered once")
+      {
+        REQUIRE (changes.size () == 1) ;
+        CHECK (changes[0].rowid == 1) ;
+      }
+    }
+  }
+
+  std::remove (dbfile.c_str ()) ;
+}
+
+SCENARIO("changes of a commit that fails after the commit hook")
+{
+  using namespace sl3 ;
+
+  const std::string dbfile{"sl3test_changes_sync.db"} ;
+  std::remove (dbfile.c_str ()) ;
+  registerShim () ;
+
+  GIVEN ("a database with a change feed and a failing file system")
+  {
+    OpenOptions options ;
+    options.vfs = "sl3_failsync" ;
+    Database db{dbfile, options};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+
+    std::vector<Change> changes ;
+    db.onChange ([&changes](const std::vector<Change>& batch) {
+      changes.insert (changes.end (), batch.begin (), batch.end ()) ;
+    }) ;
+
+    WHEN ("a commit fails and sqlite rolls back")
+    {
+      db.execute ("BEGIN; INSERT INTO t VALUES (1, 'a');") ;
+      failSync = true ;
+      CHECK_THROWS_AS (db.execute ("COMMIT;"), SQLite3Error) ;
+      failSync = false ;
+      db.execute ("INSERT INTO t VALUES (2, 'b');") ;
+
+      THEN ("the changes of the failed commit are not delivered")
+      {
+        REQUIRE (changes.size () == 1) ;
+        CHECK (changes[0].rowid == 2) ;
+      }
+    }
+  }
+
+  std::remove (dbfile.c_str ()) ;
+}
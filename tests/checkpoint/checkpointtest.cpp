@@ -0,0 +1,227 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+#include <sl3/vfs.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace
+{
+  // poll until pred is true, or give up after some seconds
+  bool
+  eventually (const std::function<bool ()>& pred)
+  {
+    for (int i = 0; i < 500; ++i)
+      {
+        if (pred ())
+          return true;
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+      }
+    return pred ();
+  }
+}
+
+SCENARIO("background checkpoints")
+{
+  using namespace sl3 ;
+
+  const std::string dbfile{"sl3test_checkpoint.db"} ;
+  std::remove (dbfile.c_str ()) ;
+  std::remove ((dbfile + "-wal").c_str ()) ;
+  std::remove ((dbfile + "-shm").c_str ()) ;
+
+  GIVEN ("a WAL database with background checkpoints")
+  {
+    Database db{dbfile};
+    db.execute ("PRAGMA journal_mode=WAL;"
+                "CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+
+    THEN ("metrics are zero before starting")
+    {
+      CHECK (db.checkpointMetrics ().checkpoints == 0) ;
+      CHECK (db.checkpointMetrics ().walFrames == 0) ;
+    }
+
+    WHEN ("writing more frames than the passive threshold")
+    {
+      CheckpointOptions options ;
+      options.passiveFrames  = 1 ;
+      options.fullFrames     = 1000000 ;
+      options.truncateFrames = 1000000 ;
+      options.idleTime       = std::chrono::milliseconds (60000) ;
+      db.startCheckpoints (options) ;
+
+      db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+
+      THEN ("a passive checkpoint runs in the background")
+      {
+        CHECK (eventually ([&db]() {
+          return db.checkpointMetrics ().checkpoints > 0;
+        })) ;
+        auto m = db.checkpointMetrics () ;
+        CHECK (m.lastMode == CheckpointMode::Passive) ;
+        CHECK (m.maxWalFrames > 0) ;
+        CHECK (m.errors == 0) ;
+        CHECK (m.totalDuration >= m.lastDuration) ;
+        CHECK (m.maxDuration >= m.lastDuration) ;
+      }
+    }
+
+    WHEN ("writing more frames than the truncate threshold")
+    {
+      CheckpointOptions options ;
+      options.passiveFrames  = 1 ;
+      options.fullFrames     = 1 ;
+      options.truncateFrames = 1 ;
+      options.idleTime       = std::chrono::milliseconds (60000) ;
+      db.startCheckpoints (options) ;
+
+      db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+
+      THEN ("the WAL is truncated")
+      {
+        CHECK (eventually ([&db]() {
+          auto m = db.checkpointMetrics ();
+          return m.checkpoints > 0 && m.walFrames == 0;
+        })) ;
+        CHECK (db.checkpointMetrics ().lastMode == CheckpointMode::Truncate) ;
+      }
+    }
+
+    WHEN ("writes stop for the idle time")
+    {
+      CheckpointOptions options ;
+      options.passiveFrames  = 1000000 ;
+      options.fullFrames     = 1000000 ;
+      options.truncateFrames = 1000000 ;
+      options.idleTime       = std::chrono::milliseconds (20) ;
+      db.startCheckpoints (options) ;
+
+      db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+      db.execute ("INSERT INTO t VALUES (2, 'b');") ;
+
+      THEN ("the WAL is truncated once")
+      {
+        CHECK (eventually ([&db]() {
+          return db.checkpointMetrics ().checkpoints > 0;
+        })) ;
+        std::this_thread::sleep_for (std::chrono::milliseconds (100)) ;
+        auto m = db.checkpointMetrics () ;
+        CHECK (m.checkpoints == 1) ;
+        CHECK (m.lastMode == CheckpointMode::Truncate) ;
+        CHECK (m.walFrames == 0) ;
+        CHECK (m.walBytes == 0) ;
+      }
+    }
+
+    WHEN ("stopping the checkpoints")
+    {
+      db.startCheckpoints () ;
+      db.stopCheckpoints () ;
+
+      THEN ("writes work as before and metrics are reset")
+      {
+        db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+        CHECK (db.checkpointMetrics ().checkpoints == 0) ;
+        db.stopCheckpoints () ;
+      }
+    }
+    WHEN ("stopping the checkpoints after changing the auto checkpoint")
+    {
+      db.execute ("PRAGMA wal_autocheckpoint=250;") ;
+      db.startCheckpoints () ;
+      db.stopCheckpoints () ;
+
+      THEN ("the previous auto checkpoint is restored")
+      {
+        auto val = db.selectValue ("PRAGMA wal_autocheckpoint;") ;
+        CHECK (val.getInt () == 250) ;
+      }
+    }
+
+    WHEN ("stopping the checkpoints with auto checkpoints turned off")
+    {
+      db.execute ("PRAGMA wal_autocheckpoint=0;") ;
+      db.startCheckpoints () ;
+      db.stopCheckpoints () ;
+
+      THEN ("auto checkpoints stay off")
+      {
+        auto val = db.selectValue ("PRAGMA wal_autocheckpoint;") ;
+        CHECK (val.getInt () == 0) ;
+      }
+    }
+  }
+
+  GIVEN ("a database that is not in WAL mode")
+  {
+    Database db{dbfile};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY);") ;
+
+    THEN ("starting checkpoints throws")
+    {
+      CHECK_THROWS_AS (db.startCheckpoints (), SQLite3Error) ;
+    }
+  }
+
+  GIVEN ("an in memory database")
+  {
+    Database db{":memory:"};
+
+    THEN ("starting checkpoints throws")
+    {
+      CHECK_THROWS_AS (db.startCheckpoints (), SQLite3Error) ;
+    }
+  }
+
+  std::remove (dbfile.c_str ()) ;
+  std::remove ((dbfile + "-wal").c_str ()) ;
+  std::remove ((dbfile + "-shm").c_str ()) ;
+}
+
+SCENARIO("background checkpoints of a database using an other VFS")
+{
+  using namespace sl3 ;
+
+  const std::string dbfile{"sl3test_checkpoint_vfs.db"} ;
+  std::remove (dbfile.c_str ()) ;
+  std::remove ((dbfile + "-wal").c_str ()) ;
+  std::remove ((dbfile + "-shm").c_str ()) ;
+
+  GIVEN ("a WAL database opened via an instrumented VFS")
+  {
+    InstrumentedVfs io{"sl3test_checkpoint_io"};
+    OpenOptions     options ;
+    options.vfs = io.name () ;
+    Database db{dbfile, options};
+    db.execute ("PRAGMA journal_mode=WAL;"
+                "CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+
+    CheckpointOptions checkpoints ;
+    checkpoints.passiveFrames = 1 ;
+    checkpoints.idleTime      = std::chrono::milliseconds (60000) ;
+    db.startCheckpoints (checkpoints) ;
+
+    WHEN ("a checkpoint runs")
+    {
+      io.reset () ;
+      db.execute ("INSERT INTO t VALUES (1, 'a');") ;
+      REQUIRE (eventually ([&db]() {
+        return db.checkpointMetrics ().checkpoints > 0;
+      })) ;
+      db.stopCheckpoints () ;
+
+      THEN ("it writes the database file via the same VFS")
+      {
+        CHECK (io.stats ()[FileKind::MainDb].write.calls > 0) ;
+      }
+    }
+  }
+
+  std::remove (dbfile.c_str ()) ;
+  std::remove ((dbfile + "-wal").c_str ()) ;
+  std::remove ((dbfile + "-shm").c_str ()) ;
+}
@@ -0,0 +1,168 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+  int
+  natural (const std::string& a, const std::string& b)
+  {
+    return sl3::naturalCompare (a.data (), a.size (), b.data (), b.size ());
+  }
+
+  int
+  nocase (const std::string& a, const std::string& b)
+  {
+    return sl3::asciiNoCaseCompare (a.data (), a.size (), b.data (), b.size ());
+  }
+
+  std::vector<std::string>
+  column (sl3::Database& db, const std::string& sql)
+  {
+    std::vector<std::string> result;
+    for (const auto& row : db.select (sql))
+      result.push_back (row[0].getText ());
+    return result;
+  }
+}
+
+SCENARIO("comparing with built in collations")
+{
+  using namespace sl3 ;
+
+  WHEN ("comparing natural")
+  {
+    THEN ("numbers are compared by value")
+    {
+      CHECK (natural ("file9", "file10") < 0) ;
+      CHECK (natural ("file10", "file9") > 0) ;
+      CHECK (natural ("file10", "file10") == 0) ;
+      CHECK (natural ("a2b3", "a2b10") < 0) ;
+      CHECK (natural ("abc", "abd") < 0) ;
+      CHECK (natural ("abc", "ab") > 0) ;
+      CHECK (natural ("", "") == 0) ;
+      CHECK (natural ("10", "a") < 0) ;
+    }
+
+    THEN ("leading zeros are a tie breaker only")
+    {
+      CHECK (natural ("x007", "x7") > 0) ;
+      CHECK (natural ("x007", "x8") < 0) ;
+      CHECK (natural ("x0", "x00") < 0) ;
+    }
+  }
+
+  WHEN ("comparing ascii no case")
+  {
+    THEN ("ascii letters are compared case insensitive")
+    {
+      CHECK (nocase ("Hello", "hELLO") == 0) ;
+      CHECK (nocase ("abc", "ABD") < 0) ;
+      CHECK (nocase ("ab", "AB c") < 0) ;
+      CHECK (nocase ("\xc3\x84", "\xc3\xa4") != 0) ;
+    }
+  }
+}
+
+SCENARIO("using collations in sql")
+{
+  using namespace sl3 ;
+  GIVEN ("a database with file names")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE files (name TEXT);"
+                "INSERT INTO files VALUES ('File10'), ('file9'), ('file1'),"
+                " ('FILE2');") ;
+
+    WHEN ("registering the natural collation")
+    {
+      db.createCollation ("natsort", Collation::Natural) ;
+
+      THEN ("it can be used for ORDER BY")
+      {
+        auto names = column (
+            db, "SELECT name FROM files ORDER BY lower(name) COLLATE natsort;") ;
+        CHECK (names
+               == (std::vector<std::string>{"file1", "FILE2", "file9", "File10"})) ;
+      }
+
+      THEN ("it can be used in an index")
+      {
+        db.execute ("CREATE INDEX idx ON files (name COLLATE natsort);") ;
+        auto names = column (
+            db, "SELECT name FROM files WHERE name > 'file5' COLLATE natsort"
+                " ORDER BY name COLLATE natsort;") ;
+        CHECK (names == (std::vector<std::string>{"file9"})) ;
+      }
+    }
+
+    WHEN ("registering the ascii no case collation")
+    {
+      db.createCollation ("ascii", Collation::AsciiNoCase) ;
+
+      THEN ("it compares case insensitive")
+      {
+        CHECK (db.selectValue ("SELECT count(*) FROM files WHERE name ="
+                               " 'FILE10' COLLATE ascii;")
+                   .getInt ()
+               == 1) ;
+      }
+    }
+
+    WHEN ("registering a custom compare function")
+    {
+      db.createCollation ("bylength",
+                          [](const char*, std::size_t na,
+                             const char*, std::size_t nb) {
+                            return static_cast<int> (na) - static_cast<int> (nb);
+                          }) ;
+
+      THEN ("it is used")
+      {
+        auto names = column (
+            db, "SELECT name FROM files ORDER BY name COLLATE bylength, name;") ;
+        CHECK (names.front () == "FILE2") ;
+        CHECK (names.back () == "File10") ;
+      }
+
+      THEN ("an empty function is not accepted")
+      {
+        CHECK_THROWS_AS (db.createCollation ("x", CollationCompare{}),
+                         ErrUnexpected) ;
+      }
+    }
+
+    WHEN ("registering a sort key collation")
+    {
+      int calls = 0 ;
+      auto key = [&calls](const char* s, std::size_t n) {
+        ++calls ;
+        std::string k ;
+        for (std::size_t i = n; i > 0; --i)
+          k.push_back (s[i - 1]) ;
+        return k ;
+      } ;
+
+      THEN ("keys are computed once per string if cached")
+      {
+        db.createSortKeyCollation ("reversed", key, 16) ;
+        auto names = column (
+            db, "SELECT name FROM files ORDER BY name COLLATE reversed;") ;
+        CHECK (names
+               == (std::vector<std::string>{"File10", "file1", "FILE2", "file9"})) ;
+        CHECK (calls == 4) ;
+      }
+
+      THEN ("keys are computed for each comparison without cache")
+      {
+        db.createSortKeyCollation ("reversed", key, 0) ;
+        auto names = column (
+            db, "SELECT name FROM files ORDER BY name COLLATE reversed;") ;
+        CHECK (names.front () == "File10") ;
+        CHECK (calls > 4) ;
+      }
+    }
+  }
+}
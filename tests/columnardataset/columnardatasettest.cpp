@@ -0,0 +1,179 @@
+#include "../testing.hpp"
+#include <sl3/columnardataset.hpp>
+#include <sl3/database.hpp>
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+  bool
+  validBit (const sl3::Column& column, std::size_t row)
+  {
+    return (column.validity ()[row / 64] >> (row % 64)) & 1;
+  }
+}
+
+SCENARIO ("loading a query result column by column")
+{
+  using namespace sl3;
+
+  GIVEN ("a table with values of each type and nulls")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE t (i INTEGER, r REAL, s TEXT, b BLOB, v);"
+                "INSERT INTO t VALUES (1, 1.5, 'one', x'0100', 1);"
+                "INSERT INTO t VALUES (NULL, NULL, NULL, NULL, 'two');"
+                "INSERT INTO t VALUES (3, 3.5, '', x'', NULL);"
+                "INSERT INTO t VALUES (4, 4.5, 'four', x'ff', 4.5);");
+
+    WHEN ("selecting without types")
+    {
+      auto ds = db.selectColumnar ("SELECT * FROM t;");
+
+      THEN ("the columns get the storage type of their values")
+      {
+        REQUIRE (ds.size () == 4);
+        REQUIRE (ds.columnCount () == 5);
+        CHECK (ds.getNames ()[2] == "s");
+        CHECK (ds.column (0).type () == Type::Int);
+        CHECK (ds.column (1).type () == Type::Real);
+        CHECK (ds.column ("s").type () == Type::Text);
+        CHECK (ds.column ("b").type () == Type::Blob);
+        CHECK (ds.column ("v").type () == Type::Variant);
+      }
+
+      THEN ("int and real values are contiguous arrays")
+      {
+        const auto& ints = ds.column (0);
+        CHECK (ints.ints ()[0] == 1);
+        CHECK (ints.ints ()[1] == 0);
+        CHECK (ints.ints ()[3] == 4);
+        CHECK (ds.column (1).reals ()[2] == 3.5);
+        CHECK_THROWS_AS (ints.reals (), ErrTypeMisMatch);
+        CHECK_THROWS_AS (ints.bytes (), ErrTypeMisMatch);
+      }
+
+      THEN ("text and blob values are bytes with offsets")
+      {
+        const auto& text = ds.column (2);
+        CHECK (text.offsets ()[0] == 0);
+        CHECK (text.offsets ()[1] == 3);
+        CHECK (text.offsets ()[2] == 3);
+        CHECK (text.offsets ()[3] == 3);
+        CHECK (text.offsets ()[4] == 7);
+        CHECK (std::string (text.bytes (), 7) == "onefour");
+
+        const auto& blob = ds.column (3);
+        CHECK (blob.offsets ()[4] == 3);
+        CHECK (std::memcmp (blob.bytes (), "\x01\x00\xff", 3) == 0);
+        CHECK_THROWS_AS (blob.ints (), ErrTypeMisMatch);
+      }
+
+      THEN ("the validity bitmap marks null values")
+      {
+        const auto& ints = ds.column (0);
+        CHECK (validBit (ints, 0));
+        CHECK_FALSE (validBit (ints, 1));
+        CHECK (validBit (ints, 2));
+        CHECK (ints.nullCount () == 1);
+        CHECK (ints.isNull (1));
+        CHECK_FALSE (ds.column (4).isNull (1));
+        CHECK (ds.column (4).isNull (2));
+        CHECK_THROWS_AS (ints.isNull (4), ErrOutOfRange);
+      }
+
+      THEN ("rows and cells are accessed like in a Dataset")
+      {
+        auto rows = db.select ("SELECT * FROM t;");
+        for (std::size_t i = 0; i < ds.size (); ++i)
+          {
+            REQUIRE (ds[i].size () == rows[i].size ());
+            for (std::size_t j = 0; j < ds[i].size (); ++j)
+              {
+                CHECK (value_eq (ds[i][j].getValue (), rows[i][j].getValue ()));
+                CHECK (ds[i][j].type () == rows[i][j].type ());
+              }
+          }
+
+        CHECK (ds[0][2].getText () == "one");
+        CHECK (ds.at (3).at (4).getReal () == 4.5);
+        CHECK (ds[1][4].dbtype () == Type::Variant);
+        CHECK (ds[1][0].isNull ());
+        CHECK (ds[2].values ().size () == 5);
+        CHECK_THROWS_AS (ds.at (4), ErrOutOfRange);
+        CHECK_THROWS_AS (ds.at (0).at (5), ErrOutOfRange);
+        CHECK_THROWS_AS (ds.column (5), ErrOutOfRange);
+        CHECK_THROWS_AS (ds.column ("x"), ErrOutOfRange);
+      }
+
+      THEN ("reset removes all data")
+      {
+        ds.reset ();
+        CHECK (ds.size () == 0);
+        CHECK (ds.columnCount () == 0);
+      }
+    }
+
+    WHEN ("selecting with types")
+    {
+      Types types{Type::Int, Type::Real, Type::Text, Type::Blob,
+                  Type::Variant};
+      auto  ds = db.selectColumnar ("SELECT * FROM t;", types);
+
+      THEN ("the columns have the given types")
+      {
+        CHECK (ds.column (0).type () == Type::Int);
+        CHECK (ds.column (3).type () == Type::Blob);
+        CHECK (ds[0][0].dbtype () == Type::Int);
+      }
+    }
+
+    WHEN ("selecting with types that do not match")
+    {
+      THEN ("ErrTypeMisMatch is thrown")
+      {
+        CHECK_THROWS_AS (
+            db.selectColumnar ("SELECT i, s FROM t;", {Type::Int, Type::Int}),
+            ErrTypeMisMatch);
+        CHECK_THROWS_AS (db.selectColumnar ("SELECT i FROM t;",
+                                            {Type::Int, Type::Int}),
+                         ErrTypeMisMatch);
+      }
+    }
+
+    WHEN ("selecting via a Command with parameters")
+    {
+      auto cmd = db.prepare ("SELECT i, s FROM t WHERE i > ?;");
+      auto ds  = cmd.selectColumnar (DbValues{DbValue{1}});
+
+      THEN ("the matching rows are loaded")
+      {
+        REQUIRE (ds.size () == 2);
+        CHECK (ds[1][1].getText () == "four");
+      }
+    }
+  }
+
+  GIVEN ("more rows than bits in a validity word")
+  {
+    Database db{":memory:"};
+    auto     ds = db.selectColumnar (
+        "WITH RECURSIVE n(x) AS (SELECT 0 UNION ALL SELECT x + 1 FROM n "
+        "WHERE x < 199) "
+        "SELECT CASE WHEN x % 3 = 0 THEN NULL ELSE x END FROM n;");
+
+    THEN ("every row has its bit")
+    {
+      const auto& column = ds.column (0);
+      REQUIRE (column.size () == 200);
+      CHECK (column.nullCount () == 67);
+      for (std::size_t i = 0; i < column.size (); ++i)
+        {
+          CHECK (validBit (column, i) == (i % 3 != 0));
+          if (i % 3 != 0)
+            CHECK (column.ints ()[i] == static_cast<int64_t> (i));
+        }
+    }
+  }
+}
@@ -0,0 +1,256 @@
+#include "../testing.hpp"
+#include <sl3/columnkernels.hpp>
+#include <sl3/database.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // 1000 rows of int, real and text with nulls, row 128 to 191 all null,
+  // row 256 to 319 without nulls
+  sl3::ColumnarDataset
+  create (sl3::Database& db)
+  {
+    using namespace sl3;
+    db.execute ("CREATE TABLE t (i INTEGER, r REAL, s TEXT);");
+    auto     cmd = db.prepare ("INSERT INTO t VALUES (?, ?, ?);");
+    unsigned r   = 1;
+    db.execute ("BEGIN;");
+    for (int i = 0; i < 1000; ++i)
+      {
+        r = r * 1103515245u + 12345u;
+        const bool isNull
+            = (i >= 128 && i < 192) || (!(i >= 256 && i < 320) && r % 7 == 0);
+        if (isNull)
+          {
+            cmd.execute (DbValues{DbValue{Type::Variant},
+                                  DbValue{Type::Variant},
+                                  DbValue{Type::Variant}});
+            continue;
+          }
+        const int v = static_cast<int> ((r >> 8) % 2001) - 1000;
+        cmd.execute (DbValues{DbValue{v},
+                              DbValue{v / 8.0},
+                              DbValue{"t" + std::to_string (v % 50)}});
+      }
+    db.execute ("COMMIT;");
+    return db.selectColumnar ("SELECT * FROM t;",
+                              {Type::Int, Type::Real, Type::Text});
+  }
+
+  template <typename Column, typename Predicate>
+  sl3::Selection
+  expected (const Column& column, Predicate pred)
+  {
+    sl3::Selection rows;
+    for (std::size_t i = 0; i < column.size (); ++i)
+      {
+        auto value = column.get (i);
+        if (!value.isNull () && pred (value))
+          rows.push_back (i);
+      }
+    return rows;
+  }
+
+  std::vector<sl3::SimdLevel>
+  levels ()
+  {
+    using sl3::SimdLevel;
+    std::vector<SimdLevel> result;
+    for (auto level : {SimdLevel::Scalar,
+                       SimdLevel::SSE42,
+                       SimdLevel::AVX2,
+                       SimdLevel::AVX512})
+      {
+        if (static_cast<int> (level)
+            <= static_cast<int> (sl3::supportedSimdLevel ()))
+          result.push_back (level);
+      }
+    return result;
+  }
+}
+
+SCENARIO ("aggregates over columns")
+{
+  using namespace sl3;
+
+  GIVEN ("int, real and text columns with nulls")
+  {
+    Database         db{":memory:"};
+    auto             ds    = create (db);
+    const auto&      ints  = ds.column (0);
+    const auto&      reals = ds.column (1);
+    DictionaryColumn texts{ds.column (2)};
+
+    // reference values, per cell
+    int64_t     isum = 0, imin = 0, imax = 0;
+    double      rsum  = 0;
+    std::size_t nulls = 0;
+    std::string smin, smax;
+    bool        first = true;
+    for (std::size_t i = 0; i < ds.size (); ++i)
+      {
+        if (ds[i][0].isNull ())
+          {
+            ++nulls;
+            continue;
+          }
+        const auto v = ds[i][0].getInt ();
+        const auto s = ds[i][2].getText ();
+        isum += v;
+        rsum += ds[i][1].getReal ();
+        imin = first || v < imin ? v : imin;
+        imax = first || v > imax ? v : imax;
+        smin = first || s < smin ? s : smin;
+        smax = first || s > smax ? s : smax;
+        first = false;
+      }
+
+    THEN ("the aggregates match a loop over the cells")
+    {
+      for (auto level : levels ())
+        {
+          const int levelNumber = static_cast<int> (level);
+          CAPTURE (levelNumber);
+          REQUIRE (setSimdLevel (level) == level);
+          CHECK (nullCount (ints) == nulls);
+          CHECK (count (ints) == ds.size () - nulls);
+          CHECK (count (texts) == ds.size () - nulls);
+          CHECK (sum (ints).getInt () == isum);
+          CHECK (sum (reals).getReal () == doctest::Approx (rsum));
+          CHECK (min (ints).getInt () == imin);
+          CHECK (max (ints).getInt () == imax);
+          CHECK (min (reals).getReal () == imin / 8.0);
+          CHECK (max (reals).getReal () == imax / 8.0);
+          CHECK (mean (ints).getReal ()
+                 == doctest::Approx (static_cast<double> (isum)
+                                     / count (ints)));
+          CHECK (min (texts).getText () == smin);
+          CHECK (max (texts).getText () == smax);
+        }
+    }
+
+    THEN ("filters select the same rows as a loop over the cells")
+    {
+      for (auto level : levels ())
+        {
+          const int levelNumber = static_cast<int> (level);
+          CAPTURE (levelNumber);
+          REQUIRE (setSimdLevel (level) == level);
+          CHECK (selectEqual (ints, DbValue{7})
+                 == expected (ints, [](const DbValue& v) {
+                      return v.getInt () == 7;
+                    }));
+          CHECK (selectLess (ints, DbValue{-250})
+                 == expected (ints, [](const DbValue& v) {
+                      return v.getInt () < -250;
+                    }));
+          CHECK (selectBetween (ints, DbValue{-10}, DbValue{300})
+                 == expected (ints, [](const DbValue& v) {
+                      return v.getInt () >= -10 && v.getInt () <= 300;
+                    }));
+          CHECK (selectLess (reals, DbValue{2.5})
+                 == expected (reals, [](const DbValue& v) {
+                      return v.getReal () < 2.5;
+                    }));
+          CHECK (selectBetween (reals, DbValue{-1}, DbValue{1.0})
+                 == expected (reals, [](const DbValue& v) {
+                      return v.getReal () >= -1 && v.getReal () <= 1;
+                    }));
+          CHECK (selectEqual (texts, DbValue{"t7", Type::Text})
+                 == expected (texts, [](const DbValue& v) {
+                      return v.getText () == "t7";
+                    }));
+          CHECK (selectLess (texts, DbValue{"t3", Type::Text})
+                 == expected (texts, [](const DbValue& v) {
+                      return v.getText () < "t3";
+                    }));
+          CHECK (selectBetween (texts,
+                                DbValue{"t-2", Type::Text},
+                                DbValue{"t2", Type::Text})
+                 == expected (texts, [](const DbValue& v) {
+                      return v.getText () >= "t-2" && v.getText () <= "t2";
+                    }));
+        }
+    }
+
+    setSimdLevel (supportedSimdLevel ());
+  }
+}
+
+SCENARIO ("comparing numbers of an other type")
+{
+  using namespace sl3;
+
+  GIVEN ("an int column")
+  {
+    Database db{":memory:"};
+    auto     ds = db.selectColumnar ("SELECT 1 UNION ALL SELECT 2 UNION ALL "
+                                     "SELECT 3 UNION ALL SELECT NULL;");
+    const auto& ints = ds.column (0);
+
+    THEN ("real values are compared exactly")
+    {
+      CHECK (selectEqual (ints, DbValue{2.0}) == Selection{1});
+      CHECK (selectEqual (ints, DbValue{2.5}).empty ());
+      CHECK (selectLess (ints, DbValue{2.5}) == (Selection{0, 1}));
+      CHECK (selectLess (ints, DbValue{2.0}) == Selection{0});
+      CHECK (selectBetween (ints, DbValue{1.5}, DbValue{3.5})
+             == (Selection{1, 2}));
+      CHECK (selectLess (ints, DbValue{1e300}) == (Selection{0, 1, 2}));
+      CHECK (selectLess (ints, DbValue{-1e300}).empty ());
+      CHECK (selectLess (ints,
+                         DbValue{std::numeric_limits<int64_t>::min ()})
+                 .empty ());
+    }
+
+    THEN ("null values select nothing")
+    {
+      CHECK (selectEqual (ints, DbValue{Type::Int}).empty ());
+      CHECK (selectBetween (ints, DbValue{1}, DbValue{Type::Int}).empty ());
+    }
+
+    THEN ("other types throw")
+    {
+      CHECK_THROWS_AS (selectEqual (ints, DbValue{"1", Type::Text}),
+                       ErrTypeMisMatch);
+      CHECK_THROWS_AS (DictionaryColumn{ints}, ErrTypeMisMatch);
+    }
+  }
+
+  GIVEN ("a column without values")
+  {
+    Database db{":memory:"};
+    auto     ds = db.selectColumnar ("SELECT NULL;", {Type::Real});
+
+    THEN ("aggregates are null")
+    {
+      CHECK (sum (ds.column (0)).isNull ());
+      CHECK (mean (ds.column (0)).isNull ());
+      CHECK (min (ds.column (0)).isNull ());
+      CHECK (max (ds.column (0)).isNull ());
+      CHECK (count (ds.column (0)) == 0);
+    }
+  }
+
+  GIVEN ("a text column")
+  {
+    Database db{":memory:"};
+    auto     ds = db.selectColumnar (
+        "SELECT 'b' UNION ALL SELECT 'a' UNION ALL SELECT 'b' UNION ALL "
+        "SELECT NULL;");
+
+    THEN ("the dictionary holds the sorted distinct texts")
+    {
+      DictionaryColumn texts{ds.column (0)};
+      CHECK (texts.dictionary () == (std::vector<std::string>{"a", "b"}));
+      CHECK (texts.codes ()[0] == 1);
+      CHECK (texts.codes ()[1] == 0);
+      CHECK (texts.isNull (3));
+      CHECK (texts.get (2).getText () == "b");
+      CHECK_THROWS_AS (sum (ds.column (0)), ErrTypeMisMatch);
+    }
+  }
+}
@@ -3,6 +3,9 @@
 #include <sl3/database.hpp>
 #include <sl3/error.hpp>
 
+#include <sqlite3.h>
+
+#include <cstdio>
 #include <string>
 #include <utility>
 
@@ -33,6 +36,110 @@ SCENARIO("creating a database")
 
 
 
+SCENARIO("creating a database with options")
+{
+  GIVEN ("open options with lookaside settings")
+  {
+    sl3::OpenOptions options ;
+    options.lookasideSlotSize = 256 ;
+
+    WHEN ("the lookaside allocator is disabled")
+    {
+      options.lookasideSlots = 0 ;
+      sl3::Database db{":memory:", options};
+      db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);"
+                  "INSERT INTO t VALUES (1, 'one');") ;
+
+      THEN ("no lookaside slot is used")
+      {
+        CHECK (db.memoryStats ().lookasideHit == 0) ;
+      }
+    }
+
+    WHEN ("lookaside slots are configured")
+    {
+      options.lookasideSlots = 100 ;
+      sl3::Database db{":memory:", options};
+      db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);"
+                  "INSERT INTO t VALUES (1, 'one');") ;
+
+      THEN ("lookaside slots are used, if sqlite was built with lookaside")
+      {
+        if (sqlite3_compileoption_used ("OMIT_LOOKASIDE"))
+          CHECK (db.memoryStats ().lookasideHit == 0) ;
+        else
+          CHECK (db.memoryStats ().lookasideHit > 0) ;
+      }
+    }
+
+    WHEN ("the open fails")
+    {
+      options.lookasideSlots = 100 ;
+      options.flags          = SQLITE_OPEN_READWRITE ;
+
+      THEN ("constructing the db throws")
+      {
+        CHECK_THROWS_AS (sl3::Database ("/this/does/not/exist/123", options),
+                         sl3::SQLite3Error) ;
+      }
+    }
+  }
+}
+
+SCENARIO("opening an immutable database")
+{
+  GIVEN ("a database file that is not changed anymore")
+  {
+    const std::string dbfile{"sl3test_immutable #1?.db"} ;
+    std::remove (dbfile.c_str ()) ;
+    {
+      sl3::Database db{dbfile};
+      db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);"
+                  "INSERT INTO t VALUES (1, 'one');") ;
+    }
+
+    sl3::OpenOptions options ;
+    options.immutable = true ;
+
+    WHEN ("opening it immutable")
+    {
+      sl3::Database db{dbfile, options};
+
+      THEN ("it can be read")
+      {
+        CHECK (db.selectValue ("SELECT v FROM t;").getText () == "one") ;
+      }
+
+      THEN ("it can not be written")
+      {
+        CHECK_THROWS_AS (db.execute ("INSERT INTO t VALUES (2, 'two');"),
+                         sl3::SQLite3Error) ;
+      }
+
+      THEN ("the file is memory mapped, if sqlite supports mmap")
+      {
+        auto mmap = db.selectValue ("PRAGMA mmap_size;") ;
+        if (!sqlite3_compileoption_used ("MAX_MMAP_SIZE=0"))
+          CHECK (mmap.getInt () > 0) ;
+      }
+    }
+
+    std::remove (dbfile.c_str ()) ;
+  }
+
+  GIVEN ("a file that does not exist")
+  {
+    sl3::OpenOptions options ;
+    options.immutable = true ;
+
+    THEN ("opening it immutable throws")
+    {
+      CHECK_THROWS_AS (sl3::Database ("sl3test_nosuchfile.db", options),
+                       sl3::SQLite3Error) ;
+    }
+  }
+}
+
 SCENARIO("creating some test data")
 {
   GIVEN ("an im memory database")
@@ -644,3 +751,152 @@ SCENARIO("using transactions")
 }
 
 
+
+SCENARIO("using transaction modes")
+{
+  GIVEN("a database file and two connections")
+  {
+    const std::string dbfile{"sl3test_transaction_modes.db"} ;
+    std::remove (dbfile.c_str ()) ;
+
+    sl3::Database db1{dbfile};
+    sl3::Database db2{dbfile};
+    db1.execute ("CREATE TABLE tbltest (f INTEGER);") ;
+
+    WHEN ("starting an immediate transaction")
+    {
+      auto trans = db1.beginTransaction (sl3::TransactionMode::Immediate) ;
+
+      THEN ("an other writer can not start one")
+      {
+        CHECK_THROWS_AS (
+            db2.beginTransaction (sl3::TransactionMode::Immediate),
+            sl3::SQLite3Error) ;
+      }
+
+      AND_THEN ("an other reader can still read")
+      {
+        CHECK_NOTHROW ((void)db2.select ("SELECT * FROM tbltest;")) ;
+      }
+    }
+
+    WHEN ("starting an exclusive transaction")
+    {
+      auto trans = db1.beginTransaction (sl3::TransactionMode::Exclusive) ;
+      db1.execute ("INSERT INTO tbltest VALUES (1);") ;
+
+      THEN ("an other connection can not read")
+      {
+        CHECK_THROWS_AS ((void)db2.select ("SELECT * FROM tbltest;"),
+                         sl3::SQLite3Error) ;
+      }
+
+      AND_THEN ("after commit the data is visible")
+      {
+        trans.commit () ;
+        CHECK (db2.selectValue ("SELECT COUNT(*) FROM tbltest;").getInt ()
+               == 1) ;
+      }
+    }
+
+    WHEN ("starting a transaction on a moved from db")
+    {
+      sl3::Database db3{std::move (db1)} ;
+      THEN ("this throws")
+      {
+        CHECK_THROWS_AS (db1.beginTransaction (), sl3::ErrNoConnection) ;
+        CHECK_NOTHROW (db3.beginTransaction ().commit ()) ;
+      }
+    }
+
+    std::remove (dbfile.c_str ()) ;
+  }
+}
+
+
+SCENARIO("using savepoints")
+{
+  GIVEN("a database with a table")
+  {
+    sl3::Database db{":memory:"};
+    db.execute ("CREATE TABLE tbltest (f INTEGER);") ;
+
+    auto count = [&db]() {
+      return db.selectValue ("SELECT COUNT(*) FROM tbltest;").getInt () ;
+    } ;
+
+    WHEN ("a savepoint goes out of scope without release")
+    {
+      {
+        auto sp = db.savepoint () ;
+        db.execute ("INSERT INTO tbltest VALUES (1);") ;
+        CHECK (count () == 1) ;
+      }
+      THEN ("the changes are rolled back")
+      {
+        CHECK (count () == 0) ;
+      }
+    }
+
+    WHEN ("nesting savepoints within a transaction")
+    {
+      auto trans = db.beginTransaction () ;
+      db.execute ("INSERT INTO tbltest VALUES (1);") ;
+      {
+        auto outer = db.savepoint () ;
+        db.execute ("INSERT INTO tbltest VALUES (2);") ;
+        {
+          auto inner = db.savepoint () ;
+          CHECK (inner.name () != outer.name ()) ;
+          db.execute ("INSERT INTO tbltest VALUES (3);") ;
+        }
+        CHECK (count () == 2) ;
+        {
+          auto inner = db.savepoint () ;
+          db.execute ("INSERT INTO tbltest VALUES (4);") ;
+          inner.release () ;
+          CHECK_NOTHROW (inner.release ()) ;
+          CHECK_THROWS_AS (inner.rollback (), sl3::ErrNoConnection) ;
+        }
+        outer.release () ;
+      }
+      trans.commit () ;
+
+      THEN ("only the released changes are committed")
+      {
+        CHECK (count () == 3) ;
+        CHECK (db.selectValue ("SELECT SUM(f) FROM tbltest;").getInt () == 7) ;
+      }
+    }
+
+    WHEN ("doing a partial rollback")
+    {
+      auto sp = db.savepoint () ;
+      db.execute ("INSERT INTO tbltest VALUES (1);") ;
+      sp.rollback () ;
+      CHECK (count () == 0) ;
+      db.execute ("INSERT INTO tbltest VALUES (2);") ;
+      sp.release () ;
+
+      THEN ("the savepoint was usable after the rollback")
+      {
+        CHECK (count () == 1) ;
+      }
+    }
+
+    WHEN ("moving a savepoint")
+    {
+      {
+        auto sp = db.savepoint () ;
+        db.execute ("INSERT INTO tbltest VALUES (1);") ;
+        sl3::Database::Savepoint sp1{std::move (sp)} ;
+        sp.release () ;
+        CHECK (count () == 1) ;
+      }
+      THEN ("release on the moved from object did not effect the database")
+      {
+        CHECK (count () == 0) ;
+      }
+    }
+  }
+}
@@ -2,6 +2,8 @@
 #include <sl3/database.hpp>
 
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 SCENARIO("dataset creation and defautl operatores")
 {
@@ -285,3 +287,253 @@ SCENARIO("doing some things via dbvalues on rows of datasets")
 
 
 
+
+SCENARIO("grouping rows of a dataset by hash")
+{
+  using namespace sl3 ;
+  GIVEN ("a dataset with duplicated keys")
+  {
+    Database db{":memory:"};
+    Dataset ds = db.select ("SELECT 1, 'a', 10 UNION ALL "
+                            "SELECT 1.0, 'a', 20 UNION ALL "
+                            "SELECT 2, 'b', 30 ;");
+    REQUIRE (ds.size () == 3);
+
+    WHEN ("hashing the rows on the first 2 fields")
+    {
+      const std::vector<size_t> key{0, 1};
+
+      THEN ("rows with equal keys have the same hash")
+      {
+        CHECK (dbvals_hash (ds[0], key) == dbvals_hash (ds[1], key));
+        CHECK_FALSE (dbvals_eq (ds[0], ds[1]));
+        CHECK_THROWS_AS ((void)dbvals_hash (ds[0], {3}), ErrOutOfRange);
+      }
+    }
+
+    WHEN ("counting full rows in an unordered map")
+    {
+      std::unordered_map<DbValues, int> counts;
+      for (const auto& row : ds)
+        ++counts[row];
+      counts[ds[0]] += 1;
+
+      THEN ("every distinct row is counted")
+      {
+        CHECK (counts.size () == 3);
+        CHECK (counts[ds[0]] == 2);
+      }
+    }
+  }
+}
+
+SCENARIO("sorting a dataset with mixed storage types")
+{
+  using namespace sl3 ;
+  GIVEN ("a variant dataset with values of all storage types")
+  {
+    Dataset ds{{Type::Variant, Type::Variant}};
+    const std::vector<DbValue> values{DbValue{Type::Variant},
+                                      DbValue{-3},
+                                      DbValue{2},
+                                      DbValue{2.0},
+                                      DbValue{-2.5},
+                                      DbValue{-0.0},
+                                      DbValue{0},
+                                      DbValue{1e300},
+                                      DbValue{std::string ("a"), Type::Variant},
+                                      DbValue{std::string ("a\0", 2),
+                                              Type::Variant},
+                                      DbValue{std::string ("\xff"),
+                                              Type::Variant},
+                                      DbValue{std::string (""), Type::Variant},
+                                      DbValue{Blob{'\x80'}, Type::Variant},
+                                      DbValue{Blob{'\x7f', 0}, Type::Variant},
+                                      DbValue{Blob{}, Type::Variant}};
+    for (std::size_t i = 0; i < values.size (); ++i)
+      for (std::size_t j = 0; j < values.size (); j += 3)
+        ds.merge (DbValues{values[(i * 7) % values.size ()], values[j]});
+
+    WHEN ("sorting with the default compare")
+    {
+      ds.sort ({0, 1});
+
+      THEN ("the order is the order of dbval_lt")
+      {
+        for (std::size_t i = 1; i < ds.size (); ++i)
+          {
+            const auto& a = ds[i - 1];
+            const auto& b = ds[i];
+            CHECK_FALSE (dbval_lt (b[0], a[0]));
+            if (!dbval_lt (a[0], b[0]))
+              CHECK_FALSE (dbval_lt (b[1], a[1]));
+          }
+      }
+    }
+
+    WHEN ("sorting by an invalid index")
+    {
+      THEN ("an exception is thrown")
+      {
+        CHECK_THROWS_AS (ds.sort ({2}), ErrOutOfRange);
+      }
+    }
+  }
+}
+
+SCENARIO("sorting a dataset in parallel")
+{
+  using namespace sl3 ;
+  GIVEN ("a dataset with many duplicated keys")
+  {
+    Dataset ds{{Type::Int, Type::Text}};
+    for (int i = 0; i < 1000; ++i)
+      ds.merge (DbValues{DbValue{(i * 7919) % 13},
+                         DbValue{std::to_string (i), Type::Text}});
+
+    ExecutionPolicy policy;
+    policy.threads = 4;
+    policy.minRows = 0;
+
+    Dataset expected = ds;
+    expected.sort ({0});
+
+    WHEN ("sorting with the default compare")
+    {
+      ds.sort ({0}, &dbval_lt, policy);
+
+      THEN ("the result is the same as sorting serial")
+      {
+        REQUIRE (ds.size () == expected.size ());
+        for (std::size_t i = 0; i < ds.size (); ++i)
+          CHECK (dbvals_eq (ds[i], expected[i]));
+      }
+    }
+
+    WHEN ("sorting stable with an own compare")
+    {
+      policy.stable = true;
+      ds.sort ({0}, &dbval_type_lt, policy);
+
+      THEN ("equal rows keep their order")
+      {
+        REQUIRE (ds.size () == expected.size ());
+        for (std::size_t i = 0; i < ds.size (); ++i)
+          CHECK (dbvals_eq (ds[i], expected[i]));
+      }
+    }
+
+    WHEN ("sorting with an own compare")
+    {
+      ds.sort ({1}, &dbval_type_lt, policy);
+
+      THEN ("the rows are sorted")
+      {
+        for (std::size_t i = 1; i < ds.size (); ++i)
+          CHECK_FALSE (dbval_type_lt (ds[i][1], ds[i - 1][1]));
+      }
+    }
+
+    WHEN ("sorting by an invalid index")
+    {
+      THEN ("the exception of a worker thread is passed on")
+      {
+        CHECK_THROWS_AS (ds.sort ({2}, &dbval_type_lt, policy),
+                         ErrOutOfRange);
+        CHECK_THROWS_AS (ds.sort ({2}, &dbval_lt, policy), ErrOutOfRange);
+      }
+    }
+
+    WHEN ("sorting by an invalid index that is only reached on ties")
+    {
+      const Dataset before = ds;
+
+      THEN ("an exception is thrown and no row is lost")
+      {
+        CHECK_THROWS_AS (ds.sort ({0, 2}, &dbval_type_lt, policy),
+                         ErrOutOfRange);
+        REQUIRE (ds.size () == before.size ());
+        for (std::size_t i = 0; i < ds.size (); ++i)
+          CHECK (dbvals_eq (ds[i], before[i]));
+      }
+    }
+  }
+}
+
+SCENARIO("sorting a dataset with long identical keys")
+{
+  using namespace sl3 ;
+  GIVEN ("rows with the same long text and a text that differs at its end")
+  {
+    const std::string text (1000000, 'x');
+    Dataset           ds{{Type::Text, Type::Int}};
+    ds.merge (DbValues{DbValue{text + "b", Type::Text}, DbValue{0}});
+    ds.merge (DbValues{DbValue{text, Type::Text}, DbValue{1}});
+    ds.merge (DbValues{DbValue{text + "a", Type::Text}, DbValue{2}});
+    ds.merge (DbValues{DbValue{text, Type::Text}, DbValue{3}});
+
+    const std::vector<int64_t> expected{1, 3, 2, 0};
+
+    WHEN ("sorting serial")
+    {
+      ds.sort ({0});
+
+      THEN ("the rows are sorted and equal rows keep their order")
+      {
+        for (std::size_t i = 0; i < ds.size (); ++i)
+          CHECK (ds[i][1].getInt () == expected[i]);
+      }
+    }
+
+    WHEN ("sorting in parallel")
+    {
+      ExecutionPolicy policy;
+      policy.threads = 2;
+      policy.minRows = 0;
+      ds.sort ({0}, &dbval_lt, policy);
+
+      THEN ("the rows are sorted and equal rows keep their order")
+      {
+        for (std::size_t i = 0; i < ds.size (); ++i)
+          CHECK (ds[i][1].getInt () == expected[i]);
+      }
+    }
+  }
+}
+
+SCENARIO("merging a dataset into itself")
+{
+  using namespace sl3 ;
+  GIVEN ("a dataset with rows")
+  {
+    const std::string text (100, 'x');
+    Dataset           ds{{Type::Int, Type::Text}};
+    ds.merge (DbValues{DbValue{1}, DbValue{text, Type::Text}});
+    ds.merge (DbValues{DbValue{2}, DbValue{text, Type::Text}});
+
+    WHEN ("merging a copy of itself")
+    {
+      ds.merge (ds);
+
+      THEN ("the rows are there twice")
+      {
+        REQUIRE (ds.size () == 4);
+        CHECK (ds[2][0].getInt () == 1);
+        CHECK (ds[3][0].getInt () == 2);
+        CHECK (ds[3][1].getText () == text);
+      }
+    }
+
+    WHEN ("moving itself into itself")
+    {
+      ds.merge (std::move (ds));
+
+      THEN ("nothing changed")
+      {
+        REQUIRE (ds.size () == 2);
+        CHECK (ds[0][0].getInt () == 1);
+        CHECK (ds[1][1].getText () == text);
+      }
+    }
+  }
+}
@@ -0,0 +1,166 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+#include <sl3/datasetindex.hpp>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+  std::vector<std::string>
+  names (const sl3::Dataset& ds, sl3::SortedIndex::Range range)
+  {
+    std::vector<std::string> result;
+    for (auto it = range.first; it != range.second; ++it)
+      result.push_back (ds[*it][1].getText ());
+    return result;
+  }
+}
+
+SCENARIO ("hash index on a dataset")
+{
+  using namespace sl3;
+
+  GIVEN ("a dataset with duplicated keys")
+  {
+    Database db{":memory:"};
+    Dataset  ds = db.select ("SELECT 1, 'a', 'x' UNION ALL "
+                             "SELECT 2, 'b', 'y' UNION ALL "
+                             "SELECT 1.0, 'c', 'x' UNION ALL "
+                             "SELECT 1, 'd', 'z' ;");
+
+    WHEN ("indexing a single field")
+    {
+      HashIndex index{ds, {0}};
+
+      THEN ("equal values are found, also of an other storage type")
+      {
+        CHECK (index.size () == 2);
+        CHECK (index.find (DbValues{DbValue{1}})
+               == (HashIndex::Rows{0, 2, 3}));
+        CHECK (index.find (DbValues{DbValue{2.0}}) == (HashIndex::Rows{1}));
+        CHECK (index.find (DbValues{DbValue{3}}).empty ());
+      }
+
+      THEN ("a key of a wrong size throws")
+      {
+        CHECK_THROWS_AS (
+            (void)index.find (DbValues{DbValue{1}, DbValue{1}}),
+            ErrTypeMisMatch);
+      }
+    }
+
+    WHEN ("indexing composite fields")
+    {
+      HashIndex index{ds, {0, 2}};
+
+      THEN ("all fields have to match")
+      {
+        DbValues key{DbValue{1}, DbValue{"x", Type::Text}};
+        CHECK (index.find (key) == (HashIndex::Rows{0, 2}));
+      }
+    }
+
+    WHEN ("indexing an invalid field")
+    {
+      THEN ("an exception is thrown")
+      {
+        CHECK_THROWS_AS (HashIndex (ds, {3}), ErrOutOfRange);
+      }
+    }
+
+    WHEN ("the dataset is changed after the build")
+    {
+      HashIndex index{ds, {0}};
+      ds.merge (DbValues{DbValue{1}, DbValue{"e", Type::Text},
+                         DbValue{"x", Type::Text}});
+
+      THEN ("the index is outdated")
+      {
+        CHECK_FALSE (index.isValid ());
+        CHECK_THROWS_AS ((void)index.find (DbValues{DbValue{1}}),
+                         ErrUnexpected);
+      }
+    }
+  }
+}
+
+SCENARIO ("sorted index on a dataset")
+{
+  using namespace sl3;
+
+  GIVEN ("a dataset with numbers and names")
+  {
+    Database db{":memory:"};
+    Dataset  ds = db.select ("SELECT 5, 'e' UNION ALL "
+                             "SELECT 1, 'a' UNION ALL "
+                             "SELECT 3, 'c' UNION ALL "
+                             "SELECT 3.0, 'c2' UNION ALL "
+                             "SELECT NULL, 'n' UNION ALL "
+                             "SELECT 4.5, 'd' ;");
+
+    SortedIndex index{ds, {0}};
+
+    THEN ("rows are iterated in key order, equal keys in dataset order")
+    {
+      CHECK (names (ds, {index.begin (), index.end ()})
+             == (std::vector<std::string>{"n", "a", "c", "c2", "d", "e"}));
+    }
+
+    THEN ("equal ranges are found")
+    {
+      CHECK (names (ds, index.equalRange (DbValues{DbValue{3}}))
+             == (std::vector<std::string>{"c", "c2"}));
+      CHECK (names (ds, index.equalRange (DbValues{DbValue{2}})).empty ());
+    }
+
+    THEN ("ranges are found")
+    {
+      CHECK (names (ds, index.range (DbValues{DbValue{2}},
+                                     DbValues{DbValue{5}}))
+             == (std::vector<std::string>{"c", "c2", "d"}));
+      CHECK (names (ds, index.range (DbValues{DbValue{5}},
+                                     DbValues{DbValue{2}}))
+                 .empty ());
+      CHECK (*index.upperBound (DbValues{DbValue{4.5}}) == 0);
+    }
+
+    WHEN ("sorting the dataset")
+    {
+      ds.sort ({1});
+
+      THEN ("the index is outdated")
+      {
+        CHECK_FALSE (index.isValid ());
+        CHECK_THROWS_AS ((void)index.lowerBound (DbValues{DbValue{1}}),
+                         ErrUnexpected);
+      }
+    }
+  }
+
+  GIVEN ("a composite index")
+  {
+    Database db{":memory:"};
+    Dataset  ds = db.select ("SELECT 1, 'b' UNION ALL "
+                             "SELECT 2, 'a' UNION ALL "
+                             "SELECT 1, 'a' ;");
+    SortedIndex index{ds, {0, 1}};
+
+    THEN ("a key for the first fields only finds all matching rows")
+    {
+      CHECK (names (ds, index.equalRange (DbValues{DbValue{1}}))
+             == (std::vector<std::string>{"a", "b"}));
+      CHECK (names (ds, index.equalRange (DbValues{
+                            DbValue{1}, DbValue{"b", Type::Text}}))
+             == (std::vector<std::string>{"b"}));
+    }
+
+    THEN ("a key with too many fields throws")
+    {
+      CHECK_THROWS_AS (
+          (void)index.lowerBound (
+              DbValues{DbValue{1}, DbValue{1}, DbValue{1}}),
+          ErrTypeMisMatch);
+    }
+  }
+}
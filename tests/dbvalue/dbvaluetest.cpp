@@ -475,3 +475,32 @@ SCENARIO ("sorting")
 }
 
 
+
+SCENARIO ("compact storage of the type")
+{
+  using namespace sl3;
+
+  CHECK (sizeof (DbValue) == sizeof (Value));
+
+  GIVEN ("a text typed DbValue")
+  {
+    DbValue val{std::string (20, 'x'), Type::Text};
+
+    WHEN ("copying, moving and assigning it")
+    {
+      DbValue copy{val};
+      DbValue moved{std::move (copy)};
+      DbValue variant{Type::Variant};
+      variant = moved;
+
+      THEN ("each keeps its own type")
+      {
+        CHECK (moved.dbtype () == Type::Text);
+        CHECK (copy.dbtype () == Type::Text);
+        CHECK (variant.dbtype () == Type::Variant);
+        CHECK (variant.getText () == std::string (20, 'x'));
+        CHECK_THROWS_AS (moved = 1, ErrTypeMisMatch);
+      }
+    }
+  }
+}
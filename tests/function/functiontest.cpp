@@ -0,0 +1,337 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+  int64_t
+  twice (int64_t val)
+  {
+    return 2 * val;
+  }
+
+  int instances = 0;
+
+  struct Percentile
+  {
+    std::vector<double> values;
+    double              p{0};
+
+    Percentile () { ++instances; }
+    ~Percentile () { --instances; }
+
+    void
+    step (double v, double percent)
+    {
+      values.push_back (v);
+      p = percent;
+    }
+
+    sl3::Value
+    final ()
+    {
+      if (values.empty ())
+        return sl3::Value{};
+
+      std::sort (values.begin (), values.end ());
+      auto idx = static_cast<std::size_t> (p / 100 * (values.size () - 1));
+      return sl3::Value{values[idx]};
+    }
+  };
+
+  struct Concat
+  {
+    std::string result;
+
+    void
+    step (const std::string& s)
+    {
+      if (s == "fail")
+        throw std::runtime_error ("step failed");
+      result += s;
+    }
+
+    std::string
+    final ()
+    {
+      return result;
+    }
+  };
+
+  struct MovingSum
+  {
+    int64_t sum{0};
+
+    void
+    step (int64_t v)
+    {
+      sum += v;
+    }
+
+    void
+    inverse (int64_t v)
+    {
+      sum -= v;
+    }
+
+    int64_t
+    value () const
+    {
+      return sum;
+    }
+
+    int64_t
+    final ()
+    {
+      return sum;
+    }
+  };
+}
+
+SCENARIO("creating scalar functions")
+{
+  using namespace sl3 ;
+  GIVEN ("a database")
+  {
+    Database db{":memory:"};
+
+    WHEN ("registering a lambda with typed arguments")
+    {
+      db.createFunction ("plus", [](int64_t a, int64_t b) { return a + b; }) ;
+
+      THEN ("it can be used in SQL")
+      {
+        CHECK (db.selectValue ("SELECT plus (2, 3);").getInt () == 5) ;
+      }
+
+      THEN ("the arity is deduced from the lambda")
+      {
+        CHECK_THROWS_AS (db.selectValue ("SELECT plus (1);"), SQLite3Error) ;
+        CHECK_THROWS_AS (db.selectValue ("SELECT plus (1, 2, 3);"),
+                         SQLite3Error) ;
+      }
+    }
+
+    WHEN ("registering functions with different types")
+    {
+      db.createFunction ("half", [](double d) { return d / 2; }) ;
+      db.createFunction ("greet", [](const std::string& name) {
+        return "hello " + name;
+      }) ;
+      db.createFunction ("bloblen", [](const Blob& b) {
+        return static_cast<int> (b.size ());
+      }) ;
+      db.createFunction ("twice", &twice) ;
+      db.createFunction ("noop", []() {}) ;
+
+      THEN ("arguments and results are converted")
+      {
+        CHECK (db.selectValue ("SELECT half (3);").getReal () == 1.5) ;
+        CHECK (db.selectValue ("SELECT greet ('world');").getText ()
+               == "hello world") ;
+        CHECK (db.selectValue ("SELECT greet ('a' || x'00' || 'b');")
+                   .getText ()
+                   .size ()
+               == 9) ;
+        CHECK (db.selectValue ("SELECT bloblen (x'010203');").getInt () == 3) ;
+        CHECK (db.selectValue ("SELECT twice (21);").getInt () == 42) ;
+        CHECK (db.selectValue ("SELECT noop ();").isNull ()) ;
+      }
+    }
+
+    WHEN ("registering a function taking Values")
+    {
+      db.createFunction ("typeof2", [](const Value& v) {
+        return typeName (v.getType ());
+      }) ;
+      db.createFunction ("coalesce2", [](Value a, Value b) {
+        return a.isNull () ? b : a;
+      }) ;
+
+      THEN ("the original type and NULL are visible")
+      {
+        CHECK (db.selectValue ("SELECT typeof2 (NULL);").getText ()
+               == "Null") ;
+        CHECK (db.selectValue ("SELECT typeof2 (1);").getText () == "Int") ;
+        CHECK (db.selectValue ("SELECT typeof2 (1.5);").getText () == "Real") ;
+        CHECK (db.selectValue ("SELECT typeof2 ('a');").getText () == "Text") ;
+        CHECK (db.selectValue ("SELECT typeof2 (x'01');").getText ()
+               == "Blob") ;
+
+        CHECK (db.selectValue ("SELECT coalesce2 (NULL, 'x');").getText ()
+               == "x") ;
+        CHECK (db.selectValue ("SELECT coalesce2 (NULL, NULL);").isNull ()) ;
+      }
+    }
+
+    WHEN ("a function throws")
+    {
+      db.createFunction ("fail", [](int64_t) -> int64_t {
+        throw std::runtime_error ("failed on purpose");
+      }) ;
+
+      THEN ("the statement fails with the exception message")
+      {
+        try
+          {
+            db.selectValue ("SELECT fail (1);") ;
+            FAIL ("exception expected") ;
+          }
+        catch (const SQLite3Error& e)
+          {
+            CHECK (std::string{e.what ()}.find ("failed on purpose")
+                   != std::string::npos) ;
+          }
+      }
+    }
+
+    WHEN ("a function is used in an index")
+    {
+      db.execute ("CREATE TABLE t (a INTEGER);") ;
+      db.createFunction ("mod7", [](int64_t a) { return a % 7; }) ;
+      db.createFunction ("detmod7",
+                         [](int64_t a) { return a % 7; },
+                         FunctionFlag::Deterministic) ;
+
+      THEN ("it needs to be deterministic")
+      {
+        CHECK_THROWS_AS (db.execute ("CREATE INDEX i1 ON t (mod7 (a));"),
+                         SQLite3Error) ;
+        CHECK_NOTHROW (db.execute ("CREATE INDEX i2 ON t (detmod7 (a));")) ;
+
+        db.execute ("INSERT INTO t VALUES (1), (8), (9);") ;
+        CHECK (db.selectValue ("SELECT count(*) FROM t WHERE detmod7 (a) = 1;")
+                   .getInt ()
+               == 2) ;
+      }
+    }
+
+    WHEN ("registering a function twice")
+    {
+      db.createFunction ("f", []() { return 1; }) ;
+      db.createFunction ("f", []() { return 2; }) ;
+
+      THEN ("the last one wins")
+      {
+        CHECK (db.selectValue ("SELECT f ();").getInt () == 2) ;
+      }
+    }
+
+    WHEN ("registering with an invalid name")
+    {
+      THEN ("this throws")
+      {
+        CHECK_THROWS_AS (
+            db.createFunction (std::string (300, 'x'), []() { return 1; }),
+            SQLite3Error) ;
+      }
+    }
+  }
+}
+
+
+SCENARIO("creating aggregate functions")
+{
+  using namespace sl3 ;
+  GIVEN ("a database with grouped values")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE t (grp TEXT, val REAL);"
+                "INSERT INTO t VALUES ('a', 1), ('a', 2), ('a', 3), ('a', 4),"
+                " ('a', 5), ('b', 10), ('b', 20);") ;
+
+    WHEN ("registering an aggregate class")
+    {
+      db.createAggregate<Percentile> ("percentile") ;
+
+      THEN ("each group gets its own state")
+      {
+        Dataset ds = db.select ("SELECT grp, percentile (val, 50) FROM t"
+                                " GROUP BY grp ORDER BY grp;") ;
+        REQUIRE (ds.size () == 2) ;
+        CHECK (ds[0][1].getReal () == 3.0) ;
+        CHECK (ds[1][1].getReal () == 10.0) ;
+        CHECK (instances == 0) ;
+      }
+
+      THEN ("final is called for empty input")
+      {
+        CHECK (db.selectValue ("SELECT percentile (val, 50) FROM t"
+                               " WHERE 0;")
+                   .isNull ()) ;
+        CHECK (instances == 0) ;
+      }
+
+      THEN ("the arity is deduced from step")
+      {
+        CHECK_THROWS_AS (db.selectValue ("SELECT percentile (val) FROM t;"),
+                         SQLite3Error) ;
+      }
+    }
+
+    WHEN ("an aggregate throws")
+    {
+      db.createAggregate<Concat> ("concat") ;
+
+      THEN ("the statement fails")
+      {
+        CHECK (db.selectValue ("SELECT concat (grp) FROM t;").getText ()
+               == "aaaaabb") ;
+        db.execute ("INSERT INTO t VALUES ('fail', 0);") ;
+        CHECK_THROWS_AS (db.selectValue ("SELECT concat (grp) FROM t;"),
+                         SQLite3Error) ;
+      }
+    }
+  }
+}
+
+SCENARIO("creating window functions")
+{
+  using namespace sl3 ;
+  GIVEN ("a database with a series of values")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE t (x INTEGER);"
+                "INSERT INTO t VALUES (1), (2), (3), (4), (5);") ;
+
+#if SQLITE_VERSION_NUMBER >= 3025000
+    WHEN ("registering a window function class")
+    {
+      db.createWindowFunction<MovingSum> ("movingsum") ;
+
+      THEN ("it can be used with a sliding window")
+      {
+        Dataset ds = db.select (
+            "SELECT movingsum (x) OVER (ORDER BY x"
+            " ROWS BETWEEN 1 PRECEDING AND CURRENT ROW) FROM t;") ;
+        REQUIRE (ds.size () == 5) ;
+        CHECK (ds[0][0].getInt () == 1) ;
+        CHECK (ds[1][0].getInt () == 3) ;
+        CHECK (ds[2][0].getInt () == 5) ;
+        CHECK (ds[4][0].getInt () == 9) ;
+      }
+
+      THEN ("it can be used as aggregate")
+      {
+        CHECK (db.selectValue ("SELECT movingsum (x) FROM t;").getInt ()
+               == 15) ;
+      }
+    }
+#else
+    WHEN ("registering a window function class")
+    {
+      THEN ("this throws since sqlite has no window functions")
+      {
+        CHECK_THROWS_AS (db.createWindowFunction<MovingSum> ("movingsum"),
+                         SQLite3Error) ;
+      }
+    }
+#endif
+  }
+}
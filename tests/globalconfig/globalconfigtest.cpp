@@ -0,0 +1,182 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+#include <sl3/globalconfig.hpp>
+
+#include <sqlite3.h>
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+SCENARIO("slab allocator")
+{
+  using namespace sl3 ;
+
+  GIVEN ("a slab allocator")
+  {
+    SlabAllocator slab{4096};
+
+    WHEN ("allocating small and large blocks")
+    {
+      void* small = slab.allocate (10) ;
+      void* large = slab.allocate (SlabAllocator::maxSlabSize + 1) ;
+
+      THEN ("sizes are rounded up and memory is aligned")
+      {
+        REQUIRE (small != nullptr) ;
+        REQUIRE (large != nullptr) ;
+        CHECK (slab.size (small) == 16) ;
+        CHECK (slab.size (large) >= SlabAllocator::maxSlabSize + 1) ;
+        CHECK (reinterpret_cast<uintptr_t> (small) % 8 == 0) ;
+        CHECK (reinterpret_cast<uintptr_t> (large) % 8 == 0) ;
+        CHECK (slab.roundup (10) == 16) ;
+        CHECK (slab.roundup (17) == 32) ;
+        CHECK (slab.roundup (3000) == 3000) ;
+        CHECK (slab.allocations () == 2) ;
+
+        slab.deallocate (small) ;
+        slab.deallocate (large) ;
+        CHECK (slab.allocations () == 0) ;
+      }
+
+      THEN ("freed blocks are reused")
+      {
+        slab.deallocate (small) ;
+        void* again = slab.allocate (12) ;
+        CHECK (again == small) ;
+        slab.deallocate (again) ;
+        slab.deallocate (large) ;
+      }
+
+      THEN ("reallocate keeps the content")
+      {
+        std::memcpy (small, "0123456789", 10) ;
+        void* bigger = slab.reallocate (small, 100) ;
+        REQUIRE (bigger != nullptr) ;
+        CHECK (std::memcmp (bigger, "0123456789", 10) == 0) ;
+        CHECK (slab.reallocate (bigger, 50) == bigger) ;
+        slab.deallocate (bigger) ;
+        slab.deallocate (large) ;
+      }
+    }
+
+    WHEN ("allocating from several threads")
+    {
+      auto work = [&slab]() {
+        std::vector<void*> blocks ;
+        for (int i = 1; i < 1000; ++i)
+          blocks.push_back (slab.allocate (i % 3000 + 1)) ;
+        for (auto p : blocks)
+          slab.deallocate (p) ;
+      } ;
+      std::thread t1{work}, t2{work} ;
+      work () ;
+      t1.join () ;
+      t2.join () ;
+
+      THEN ("all blocks are returned")
+      {
+        CHECK (slab.allocations () == 0) ;
+        CHECK (slab.chunkBytes () > 0) ;
+      }
+    }
+  }
+}
+
+SCENARIO("configuring sqlite")
+{
+  using namespace sl3 ;
+
+  GIVEN ("a configuration with a slab allocator")
+  {
+    auto slab = std::make_shared<SlabAllocator> () ;
+
+    GlobalConfig config ;
+    config.threading         = ThreadingMode::MultiThread ;
+    config.memoryStatus      = 0 ;
+    config.lookasideSlotSize = 128 ;
+    config.lookasideSlots    = 64 ;
+    config.mmapSize          = 0 ;
+    config.allocator         = slab ;
+
+    shutdown () ;
+    initialize (config) ;
+
+    THEN ("sqlite allocates from the slab allocator")
+    {
+      {
+        Database db{":memory:"};
+        db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+        auto cmd = db.prepare ("INSERT INTO t VALUES (?, 'value');") ;
+        for (int i = 0; i < 100; ++i)
+          cmd.execute (parameters (i)) ;
+
+        CHECK (slab->allocations () > 0) ;
+        CHECK (db.selectValue ("SELECT COUNT(*) FROM t;").getInt () == 100) ;
+      }
+
+      AND_THEN ("a second initialize throws while sqlite is in use")
+      {
+        CHECK_THROWS_AS (initialize (config), SQLite3Error) ;
+      }
+    }
+
+    shutdown () ;
+
+    THEN ("after shutdown sqlite uses the previous allocator")
+    {
+      const auto before = slab->allocations () ;
+      Database   db{":memory:"};
+      db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY);") ;
+      CHECK (slab->allocations () == before) ;
+    }
+  }
+}
+
+SCENARIO("keeping the memory status setting")
+{
+  using namespace sl3 ;
+
+  // true if sqlite counts the memory of a new connection
+  auto counted = []() {
+    const auto before = sqlite3_memory_used () ;
+    Database   db{":memory:"};
+    return sqlite3_memory_used () != before;
+  } ;
+
+  GIVEN ("memory statistics turned off")
+  {
+    GlobalConfig off ;
+    off.memoryStatus = 0 ;
+    shutdown () ;
+    initialize (off) ;
+    REQUIRE_FALSE (counted ()) ;
+
+    WHEN ("initializing with a default configuration")
+    {
+      shutdown () ;
+      initialize (GlobalConfig{}) ;
+
+      THEN ("they stay off")
+      {
+        CHECK_FALSE (counted ()) ;
+      }
+    }
+
+    WHEN ("turning them on again")
+    {
+      GlobalConfig on ;
+      on.memoryStatus = 1 ;
+      shutdown () ;
+      initialize (on) ;
+
+      THEN ("memory is counted")
+      {
+        CHECK (counted ()) ;
+      }
+    }
+  }
+
+  shutdown () ;
+}
@@ -0,0 +1,77 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+SCENARIO("reading memory statistics")
+{
+  using namespace sl3 ;
+
+  GIVEN ("a database with a table")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+
+    auto before = db.memoryStats () ;
+
+    THEN ("schema and cache memory is reported")
+    {
+      CHECK (before.schemaUsed > 0) ;
+      CHECK (before.cacheUsed > 0) ;
+      CHECK (before.cacheUsedShared <= before.cacheUsed) ;
+    }
+
+    WHEN ("running a workload")
+    {
+      auto cmd = db.prepare ("INSERT INTO t VALUES (?, 'value');") ;
+      for (int i = 0; i < 1000; ++i)
+        cmd.execute (parameters (i)) ;
+      db.execute ("SELECT COUNT(*) FROM t;") ;
+
+      auto diff = db.memoryStats () - before ;
+
+      THEN ("the difference shows the cache activity")
+      {
+        CHECK (diff.cacheHit > 0) ;
+        CHECK (diff.cacheHit + diff.cacheMiss > 0) ;
+        CHECK (diff.stmtUsed > 0) ;
+      }
+
+      THEN ("a reset clears the counters")
+      {
+        db.memoryStats (true) ;
+        CHECK (db.memoryStats ().cacheHit == 0) ;
+      }
+    }
+  }
+
+  GIVEN ("a moved from database")
+  {
+    Database db{":memory:"};
+    Database moved{std::move (db)};
+
+    THEN ("reading statistics throws")
+    {
+      CHECK_THROWS_AS (db.memoryStats (), ErrNoConnection) ;
+    }
+  }
+
+  GIVEN ("the process wide statistics")
+  {
+    auto before = globalMemoryStats () ;
+
+    WHEN ("allocating memory in sqlite")
+    {
+      Database db{":memory:"};
+      db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);") ;
+      auto diff = globalMemoryStats () - before ;
+
+      THEN ("memory usage has grown")
+      {
+        CHECK (diff.memoryUsed > 0) ;
+        CHECK (diff.mallocCount > 0) ;
+        auto now = globalMemoryStats () ;
+        CHECK (now.memoryHighwater >= now.memoryUsed) ;
+        CHECK (now.largestMalloc > 0) ;
+      }
+    }
+  }
+}
@@ -0,0 +1,175 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+#include <string>
+
+namespace
+{
+  const char* schema
+      = "CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);"
+        "CREATE TABLE u (id INTEGER PRIMARY KEY, v TEXT);" ;
+
+  std::string
+  valueOf (sl3::Database& db, int id, const std::string& tbl = "t")
+  {
+    auto v = db.selectValue ("SELECT v FROM " + tbl
+                             + " WHERE id = " + std::to_string (id) + ";") ;
+    return v.isNull () ? std::string{"NULL"} : v.getText () ;
+  }
+}
+
+SCENARIO("recording and applying changesets")
+{
+  using namespace sl3 ;
+
+  REQUIRE (build_sqlite3_session) ;
+
+  GIVEN ("a source and a replica with the same schema")
+  {
+    Database source{":memory:"};
+    Database replica{":memory:"};
+    source.execute (schema) ;
+    replica.execute (schema) ;
+
+    auto session = source.createSession () ;
+
+    THEN ("a new session is empty and enabled")
+    {
+      CHECK (session.isEmpty ()) ;
+      CHECK (session.isEnabled ()) ;
+    }
+
+    WHEN ("changing rows of an attached table")
+    {
+      session.attach ("t") ;
+      source.execute ("INSERT INTO t VALUES (1, 'a');"
+                      "INSERT INTO t VALUES (2, 'b');"
+                      "INSERT INTO u VALUES (1, 'x');"
+                      "UPDATE t SET v = 'c' WHERE id = 2;") ;
+
+      THEN ("only that table is recorded and can be applied")
+      {
+        CHECK_FALSE (session.isEmpty ()) ;
+        replica.applyChangeset (session.changeset ()) ;
+        CHECK (valueOf (replica, 1) == "a") ;
+        CHECK (valueOf (replica, 2) == "c") ;
+        CHECK (replica.selectValue ("SELECT COUNT(*) FROM u;").getInt () == 0) ;
+      }
+
+      THEN ("a patchset gives the same result")
+      {
+        replica.applyChangeset (session.patchset ()) ;
+        CHECK (valueOf (replica, 1) == "a") ;
+        CHECK (valueOf (replica, 2) == "c") ;
+      }
+    }
+
+    WHEN ("recording all tables")
+    {
+      session.attachAll () ;
+      source.execute ("INSERT INTO t VALUES (1, 'a');"
+                      "INSERT INTO u VALUES (1, 'x');") ;
+
+      THEN ("changes of all tables are applied")
+      {
+        replica.applyChangeset (session.changeset ()) ;
+        CHECK (valueOf (replica, 1) == "a") ;
+        CHECK (valueOf (replica, 1, "u") == "x") ;
+      }
+
+      THEN ("a filter selects the tables to apply")
+      {
+        replica.applyChangeset (
+            session.changeset (), ConflictPolicy::Abort,
+            [](const std::string& tbl) { return tbl == "u"; }) ;
+        CHECK (replica.selectValue ("SELECT COUNT(*) FROM t;").getInt () == 0) ;
+        CHECK (valueOf (replica, 1, "u") == "x") ;
+      }
+    }
+
+    WHEN ("recording is disabled")
+    {
+      session.attach ("t") ;
+      session.enable (false) ;
+      source.execute ("INSERT INTO t VALUES (1, 'a');") ;
+
+      THEN ("nothing is recorded")
+      {
+        CHECK_FALSE (session.isEnabled ()) ;
+        CHECK (session.isEmpty ()) ;
+      }
+    }
+
+    WHEN ("the replica has conflicting data")
+    {
+      session.attach ("t") ;
+      replica.execute ("INSERT INTO t VALUES (1, 'old');"
+                       "INSERT INTO t VALUES (9, 'keep');") ;
+      source.execute ("INSERT INTO t VALUES (1, 'new');"
+                      "INSERT INTO t VALUES (2, 'b');") ;
+      auto changeset = session.changeset () ;
+
+      THEN ("abort throws and applies nothing")
+      {
+        REQUIRE_THROWS_AS (replica.applyChangeset (changeset), SQLite3Error) ;
+        CHECK (valueOf (replica, 1) == "old") ;
+        CHECK (replica.selectValue ("SELECT COUNT(*) FROM t;").getInt () == 2) ;
+      }
+
+      THEN ("omit keeps the existing row and applies the rest")
+      {
+        replica.applyChangeset (changeset, ConflictPolicy::Omit) ;
+        CHECK (valueOf (replica, 1) == "old") ;
+        CHECK (valueOf (replica, 2) == "b") ;
+      }
+
+      THEN ("replace overwrites the existing row")
+      {
+        replica.applyChangeset (changeset, ConflictPolicy::Replace) ;
+        CHECK (valueOf (replica, 1) == "new") ;
+        CHECK (valueOf (replica, 2) == "b") ;
+        CHECK (valueOf (replica, 9) == "keep") ;
+      }
+    }
+
+    WHEN ("the session is moved")
+    {
+      session.attach ("t") ;
+      auto moved = std::move (session) ;
+      source.execute ("INSERT INTO t VALUES (1, 'a');") ;
+
+      THEN ("the new object records, the old one is invalid")
+      {
+        CHECK_FALSE (moved.isEmpty ()) ;
+        CHECK_THROWS_AS (session.isEmpty (), ErrNoConnection) ;
+      }
+    }
+  }
+
+  GIVEN ("a session of a database that gets closed")
+  {
+    Database* db = new Database{":memory:"};
+    db->execute (schema) ;
+    auto session = db->createSession () ;
+    session.attach ("t") ;
+    delete db ;
+
+    THEN ("using the session throws")
+    {
+      CHECK_THROWS_AS (session.changeset (), ErrNoConnection) ;
+      CHECK_THROWS_AS (session.attach ("u"), ErrNoConnection) ;
+    }
+  }
+
+  GIVEN ("an invalid changeset")
+  {
+    Database db{":memory:"};
+    db.execute (schema) ;
+
+    THEN ("applying it throws")
+    {
+      CHECK_THROWS_AS (db.applyChangeset (Blob{'x', 'y', 'z'}),
+                       SQLite3Error) ;
+    }
+  }
+}
@@ -0,0 +1,88 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+#include <cstdio>
+#include <string>
+
+SCENARIO("reading a snapshot from several connections")
+{
+  using namespace sl3 ;
+
+  REQUIRE (build_sqlite3_snapshot) ;
+
+  const std::string dbfile{"sl3test_snapshot.db"} ;
+  std::remove (dbfile.c_str ()) ;
+  std::remove ((dbfile + "-wal").c_str ()) ;
+  std::remove ((dbfile + "-shm").c_str ()) ;
+
+  GIVEN ("a WAL database and three connections")
+  {
+    Database writer{dbfile};
+    writer.execute ("PRAGMA journal_mode=WAL;"
+                    "CREATE TABLE t (id INTEGER PRIMARY KEY);"
+                    "INSERT INTO t VALUES (1);") ;
+
+    Database reader1{dbfile};
+    Database reader2{dbfile};
+
+    auto count = [](Database& db) {
+      return db.selectValue ("SELECT COUNT(*) FROM t;").getInt ();
+    } ;
+
+    WHEN ("a snapshot is taken and the writer continues")
+    {
+      auto trans1   = reader1.beginTransaction () ;
+      auto snapshot = reader1.takeSnapshot () ;
+      writer.execute ("INSERT INTO t VALUES (2);") ;
+
+      THEN ("another connection reads the state of the snapshot")
+      {
+        auto trans2 = reader2.beginTransaction (snapshot) ;
+        CHECK (count (reader1) == 1) ;
+        CHECK (count (reader2) == 1) ;
+        CHECK (count (writer) == 2) ;
+      }
+
+      THEN ("a newer snapshot compares greater")
+      {
+        auto trans2 = reader2.beginTransaction () ;
+        auto newer  = reader2.takeSnapshot () ;
+        CHECK (newer.compare (snapshot) > 0) ;
+        CHECK (snapshot.compare (newer) < 0) ;
+        CHECK (snapshot.compare (snapshot) == 0) ;
+      }
+
+      THEN ("a moved snapshot can not be used")
+      {
+        auto moved = std::move (snapshot) ;
+        CHECK_THROWS_AS (reader2.beginTransaction (snapshot), ErrNoConnection) ;
+        CHECK_THROWS_AS (moved.compare (snapshot), ErrNoConnection) ;
+      }
+    }
+
+    WHEN ("the schema name contains quotes")
+    {
+      auto trans1 = reader1.beginTransaction () ;
+
+      THEN ("the name is quoted and nothing else is executed")
+      {
+        CHECK_THROWS_AS (
+            reader1.takeSnapshot ("main\".sqlite_master; DROP TABLE t; --"),
+            SQLite3Error) ;
+        CHECK (count (writer) == 1) ;
+      }
+    }
+
+    WHEN ("no transaction is active")
+    {
+      THEN ("taking a snapshot throws")
+      {
+        CHECK_THROWS_AS (reader1.takeSnapshot (), SQLite3Error) ;
+      }
+    }
+  }
+
+  std::remove (dbfile.c_str ()) ;
+  std::remove ((dbfile + "-wal").c_str ()) ;
+  std::remove ((dbfile + "-shm").c_str ()) ;
+}
@@ -5,6 +5,7 @@
 #include <string>
 #include <limits>
 #include <sstream>
+#include <unordered_set>
 
 using ValueList = std::vector<sl3::Value> ;
 
@@ -619,3 +620,213 @@ SCENARIO("stringing values")
 
 
 
+SCENARIO("compact storage of text and blob values")
+{
+  using namespace sl3;
+
+  CHECK (sizeof (Value) == 16);
+
+  GIVEN ("texts that fit inline and texts that do not")
+  {
+    const std::string shortText (14, 'a');
+    const std::string longText (15, 'b');
+    const std::string withZero ("a\0b", 3);
+
+    WHEN ("creating values from them")
+    {
+      Value s{shortText};
+      Value l{longText};
+      Value z{withZero};
+
+      THEN ("the bytes are accessible without copy")
+      {
+        CHECK (s.size () == 14);
+        CHECK (std::string (s.data (), s.size ()) == shortText);
+        CHECK (l.size () == 15);
+        CHECK (std::string (l.data (), l.size ()) == longText);
+        CHECK (z.text () == withZero);
+      }
+
+      THEN ("non bytes values have no data")
+      {
+        CHECK (Value{}.data () == nullptr);
+        CHECK (Value{1}.size () == 0);
+        CHECK (Value{Blob{}}.data () != nullptr);
+      }
+
+      THEN ("text access returns a copy")
+      {
+        const std::string copy = l.text ();
+        CHECK (static_cast<std::string> (l) == longText);
+        l = shortText;
+        CHECK (copy == longText);
+        CHECK (l.text () == shortText);
+      }
+
+      THEN ("copies and moves keep the content")
+      {
+        Value sc{s};
+        Value lc{l};
+        CHECK (sc.text () == shortText);
+        CHECK (lc.text () == longText);
+        CHECK (sc.data () != s.data ());
+        CHECK (lc.data () == l.data ());
+
+        Value lm{std::move (lc)};
+        CHECK (lm.text () == longText);
+        CHECK (lc.isNull ());
+      }
+
+      THEN ("assignments between the storage forms work")
+      {
+        s = l;
+        CHECK (s.text () == longText);
+        s = shortText;
+        CHECK (s.text () == shortText);
+        const Value& same = l;
+        l = same;
+        CHECK (l.text () == longText);
+        l = Blob (20, 'x');
+        CHECK (l.getType () == Type::Blob);
+        CHECK (l.blob () == Blob (20, 'x'));
+        l = 2.5;
+        CHECK (l.real () == 2.5);
+      }
+    }
+  }
+}
+
+SCENARIO("hashing values")
+{
+  using namespace sl3;
+
+  GIVEN ("values that are equal according to value_eq")
+  {
+    THEN ("they have the same hash")
+    {
+      CHECK (value_hash (Value{}) == value_hash (Value{}));
+      CHECK (value_hash (Value{2}) == value_hash (Value{2.0}));
+      CHECK (value_hash (Value{0}) == value_hash (Value{-0.0}));
+      CHECK (value_hash (Value{"a long text to hash"})
+             == value_hash (Value{std::string ("a long text to hash")}));
+
+      const int64_t big = std::numeric_limits<int64_t>::max ();
+      CHECK (value_eq (Value{big}, Value{static_cast<double> (big)}));
+      CHECK (value_hash (Value{big})
+             == value_hash (Value{static_cast<double> (big)}));
+
+      const int64_t odd = (int64_t{1} << 60) + 1;
+      CHECK (value_eq (Value{odd}, Value{static_cast<double> (odd)}));
+      CHECK (value_hash (Value{odd})
+             == value_hash (Value{static_cast<double> (odd)}));
+    }
+  }
+
+  GIVEN ("an unordered set of values")
+  {
+    std::unordered_set<Value> values;
+
+    WHEN ("inserting duplicates of different types")
+    {
+      values.insert (Value{1});
+      values.insert (Value{1.0});
+      values.insert (Value{1.5});
+      values.insert (Value{"1"});
+      values.insert (Value{Blob{'1'}});
+      values.insert (Value{});
+      values.insert (Value{});
+
+      THEN ("only values that are not equal are kept")
+      {
+        CHECK (values.size () == 5);
+        CHECK (values.count (Value{1.0}) == 1);
+        CHECK (values.count (Value{2}) == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("sharing text and blob buffers between copies")
+{
+  using namespace sl3;
+
+  GIVEN ("a value with a long text and some copies of it")
+  {
+    const std::string text (100, 'x');
+    Value             val{text};
+    Value             copy{val};
+    std::vector<Value> copies (3, val);
+
+    THEN ("all copies share the buffer")
+    {
+      CHECK (copy.data () == val.data ());
+      for (const auto& c : copies)
+        CHECK (c.data () == val.data ());
+    }
+
+    WHEN ("assigning to the original")
+    {
+      val = std::string (100, 'y');
+
+      THEN ("the copies keep the old content")
+      {
+        CHECK (val.text () == std::string (100, 'y'));
+        CHECK (copy.text () == text);
+        CHECK (copies[2].text () == text);
+        CHECK (copy.data () == copies[0].data ());
+      }
+    }
+
+    WHEN ("the original goes away")
+    {
+      val.setNull ();
+      copies.clear ();
+
+      THEN ("the last copy is still valid")
+      {
+        CHECK (copy.text () == text);
+      }
+    }
+
+    WHEN ("ejecting the text of a value that shares its buffer")
+    {
+      auto ejected = copy.ejectText ();
+
+      THEN ("the text is copied and the others keep it")
+      {
+        CHECK (ejected == text);
+        CHECK (copy.isNull ());
+        CHECK (val.text () == text);
+      }
+    }
+
+    WHEN ("ejecting the text of the only owner")
+    {
+      copies.clear ();
+      copy.setNull ();
+      const char* bytes   = val.data ();
+      auto        ejected = val.ejectText ();
+
+      THEN ("the text is moved out")
+      {
+        CHECK (ejected == text);
+        CHECK (ejected.data () == bytes);
+        CHECK (val.isNull ());
+      }
+    }
+
+    WHEN ("a copy is assigned the value it shares")
+    {
+      copy = val;
+      Value& same = copy;
+      copy = same;
+
+      THEN ("the buffer is still shared")
+      {
+        CHECK (copy.data () == val.data ());
+        CHECK (copy.text () == text);
+      }
+    }
+  }
+}
+
@@ -0,0 +1,137 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+#include <sl3/vfs.hpp>
+
+#include <cstdio>
+#include <numeric>
+#include <string>
+
+namespace
+{
+  const std::string dbfile{"sl3test_vfs.db"} ;
+
+  void
+  removeFiles ()
+  {
+    std::remove (dbfile.c_str ()) ;
+    std::remove ((dbfile + "-journal").c_str ()) ;
+    std::remove ((dbfile + "-wal").c_str ()) ;
+    std::remove ((dbfile + "-shm").c_str ()) ;
+  }
+
+  uint64_t
+  histogramSum (const sl3::IoOpStats& op)
+  {
+    return std::accumulate (op.histogram.begin (), op.histogram.end (),
+                            uint64_t{0}) ;
+  }
+}
+
+SCENARIO("counting file I/O")
+{
+  using namespace sl3 ;
+
+  removeFiles () ;
+
+  GIVEN ("an instrumented vfs")
+  {
+    InstrumentedVfs io{"sl3test_io"};
+    CHECK (io.name () == "sl3test_io") ;
+
+    OpenOptions options ;
+    options.vfs = io.name () ;
+
+    WHEN ("writing with a rollback journal")
+    {
+      {
+        Database db{dbfile, options};
+        db.execute ("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);"
+                    "INSERT INTO t VALUES (1, 'one');") ;
+      }
+      auto stats = io.stats () ;
+
+      THEN ("main db and journal I/O is counted")
+      {
+        const auto& main = stats[FileKind::MainDb] ;
+        CHECK (main.write.calls > 0) ;
+        CHECK (main.write.bytes > 0) ;
+        CHECK (main.sync.calls > 0) ;
+        CHECK (main.lock.calls > 0) ;
+        CHECK (histogramSum (main.write) == main.write.calls) ;
+        CHECK (stats[FileKind::Journal].write.calls > 0) ;
+        CHECK (stats[FileKind::Wal].write.calls == 0) ;
+      }
+
+      AND_WHEN ("reading in a new connection")
+      {
+        const auto before = io.stats () ;
+        Database   db{dbfile, options};
+        CHECK (db.selectValue ("SELECT v FROM t;").getText () == "one") ;
+        auto diff = io.stats () - before ;
+
+        THEN ("the difference shows the reads")
+        {
+          CHECK (diff[FileKind::MainDb].read.calls > 0) ;
+          CHECK (diff[FileKind::MainDb].write.calls == 0) ;
+        }
+      }
+    }
+
+    WHEN ("writing in WAL mode")
+    {
+      Database db{dbfile, options};
+      db.execute ("PRAGMA journal_mode=WAL;"
+                  "CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT);"
+                  "INSERT INTO t VALUES (1, 'one');") ;
+
+      THEN ("WAL writes are counted")
+      {
+        auto stats = io.stats () ;
+        CHECK (stats[FileKind::Wal].write.calls > 0) ;
+        CHECK (stats[FileKind::Wal].sync.calls > 0) ;
+        CHECK (db.selectValue ("SELECT COUNT(*) FROM t;").getInt () == 1) ;
+      }
+
+      THEN ("reset sets counters to 0")
+      {
+        io.reset () ;
+        CHECK (io.stats ()[FileKind::Wal].write.calls == 0) ;
+      }
+    }
+
+    WHEN ("using a temp table")
+    {
+      Database db{dbfile, options};
+      db.execute ("PRAGMA temp_store=FILE;"
+                  "CREATE TEMP TABLE tmp (v);"
+                  "INSERT INTO tmp VALUES (1);") ;
+
+      THEN ("temp files are counted separately")
+      {
+        CHECK (io.stats ()[FileKind::MainDb].write.calls == 0) ;
+      }
+    }
+  }
+
+  GIVEN ("an unknown base vfs")
+  {
+    THEN ("creating the shim throws")
+    {
+      CHECK_THROWS_AS (InstrumentedVfs ("sl3test_io", "nosuchvfs"),
+                       SQLite3Error) ;
+    }
+  }
+
+  GIVEN ("an unknown vfs name in the options")
+  {
+    OpenOptions options ;
+    options.vfs = "nosuchvfs" ;
+
+    THEN ("opening throws")
+    {
+      CHECK_THROWS_AS (Database (dbfile, options), SQLite3Error) ;
+    }
+  }
+
+  removeFiles () ;
+}
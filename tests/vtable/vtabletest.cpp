@@ -0,0 +1,314 @@
+#include "../testing.hpp"
+#include <sl3/database.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // columnar source, id and name in separate vectors
+  class VectorColumns final : public sl3::TableSource
+  {
+  public:
+    std::vector<int64_t>     ids;
+    std::vector<std::string> names;
+    mutable int              nameReads = 0;
+
+    std::size_t
+    columnCount () const override
+    {
+      return 2;
+    }
+
+    std::string
+    columnName (std::size_t col) const override
+    {
+      return col == 0 ? "id" : "name";
+    }
+
+    std::size_t
+    rowCount () const override
+    {
+      return ids.size ();
+    }
+
+    const sl3::Value&
+    value (std::size_t row, std::size_t col, sl3::Value& scratch) const override
+    {
+      if (col == 0)
+        scratch = ids[row];
+      else
+        {
+          ++nameReads;
+          scratch = names[row];
+        }
+      return scratch;
+    }
+  };
+
+  // a source that fails on every access
+  class FailingSource final : public sl3::TableSource
+  {
+  public:
+    std::size_t
+    columnCount () const override
+    {
+      return 1;
+    }
+
+    std::string
+    columnName (std::size_t) const override
+    {
+      return "x";
+    }
+
+    std::size_t
+    rowCount () const override
+    {
+      throw std::runtime_error ("rowCount failed");
+    }
+
+    const sl3::Value&
+    value (std::size_t, std::size_t, sl3::Value&) const override
+    {
+      throw std::runtime_error ("value failed");
+    }
+  };
+
+  std::vector<int64_t>
+  ints (sl3::Database& db, const std::string& sql)
+  {
+    std::vector<int64_t> result;
+    for (const auto& row : db.select (sql))
+      result.push_back (row[0].getInt ());
+    return result;
+  }
+}
+
+SCENARIO("querying a Dataset via a virtual table")
+{
+  using namespace sl3 ;
+  GIVEN ("a database and a Dataset")
+  {
+    Database db{":memory:"};
+    db.execute ("CREATE TABLE orders (id INTEGER, customer INTEGER);"
+                "INSERT INTO orders VALUES (1, 10), (2, 20), (3, 10);") ;
+
+    Database other{":memory:"};
+    Dataset customers = other.select (
+        "SELECT 10 AS cid, 'alice' AS cname"
+        " UNION ALL SELECT 20, 'bob' UNION ALL SELECT 30, 'carol';") ;
+
+    WHEN ("creating a virtual table for the Dataset")
+    {
+      db.createVirtualTable ("customers", customers, "cid") ;
+
+      THEN ("it can be queried and joined")
+      {
+        CHECK (db.selectValue ("SELECT count(*) FROM customers;").getInt ()
+               == 3) ;
+
+        Dataset ds = db.select ("SELECT o.id, c.cname FROM orders o"
+                                " JOIN customers c ON c.cid = o.customer"
+                                " ORDER BY o.id;") ;
+        REQUIRE (ds.size () == 3) ;
+        CHECK (ds[0][1].getText () == "alice") ;
+        CHECK (ds[1][1].getText () == "bob") ;
+        CHECK (ds[2][1].getText () == "alice") ;
+      }
+
+      THEN ("it is read only")
+      {
+        CHECK_THROWS_AS (
+            db.execute ("INSERT INTO customers VALUES (40, 'dave');"),
+            SQLite3Error) ;
+      }
+
+      THEN ("the name can not be used twice")
+      {
+        CHECK_THROWS_AS (db.createVirtualTable ("customers", customers),
+                         SQLite3Error) ;
+      }
+    }
+
+    WHEN ("using an unknown key column")
+    {
+      THEN ("this throws")
+      {
+        CHECK_THROWS_AS (db.createVirtualTable ("c", customers, "nope"),
+                         ErrOutOfRange) ;
+      }
+    }
+  }
+}
+
+SCENARIO("using the key column of a virtual table")
+{
+  using namespace sl3 ;
+  GIVEN ("a columnar source with a key column")
+  {
+    Database db{":memory:"};
+    auto     source = std::make_shared<VectorColumns> () ;
+    for (int64_t i = 100; i > 0; --i)
+      {
+        source->ids.push_back (i) ;
+        source->names.push_back ("n" + std::to_string (i)) ;
+      }
+    db.createVirtualTable ("data", source, "id") ;
+
+    WHEN ("querying by equality on the key")
+    {
+      auto val = db.selectValue ("SELECT name FROM data WHERE id = 42;") ;
+
+      THEN ("only the matching row is read")
+      {
+        CHECK (val.getText () == "n42") ;
+        CHECK (source->nameReads == 1) ;
+      }
+    }
+
+    WHEN ("querying a range on the key")
+    {
+      auto ids = ints (db, "SELECT id FROM data WHERE id > 95 AND id <= 98;") ;
+
+      THEN ("the rows are found in key order")
+      {
+        CHECK (ids == (std::vector<int64_t>{96, 97, 98})) ;
+      }
+    }
+
+    WHEN ("querying open ranges")
+    {
+      THEN ("lower and upper bounds work alone")
+      {
+        CHECK (ints (db, "SELECT id FROM data WHERE id >= 99;")
+               == (std::vector<int64_t>{99, 100})) ;
+        CHECK (ints (db, "SELECT id FROM data WHERE id < 3;")
+               == (std::vector<int64_t>{1, 2})) ;
+        CHECK (ints (db, "SELECT id FROM data WHERE id < 2.5;")
+               == (std::vector<int64_t>{1, 2})) ;
+        CHECK (ints (db, "SELECT id FROM data WHERE id > 200;").empty ()) ;
+        CHECK (ints (db, "SELECT id FROM data WHERE id > NULL;").empty ()) ;
+        CHECK (ints (db, "SELECT id FROM data WHERE id = '5';").empty ()) ;
+      }
+    }
+
+    WHEN ("ordering by the key")
+    {
+      auto ids = ints (db, "SELECT id FROM data ORDER BY id LIMIT 3;") ;
+
+      THEN ("the rows are sorted")
+      {
+        CHECK (ids == (std::vector<int64_t>{1, 2, 3})) ;
+      }
+    }
+
+    WHEN ("joining against the key")
+    {
+      db.execute ("CREATE TABLE t (ref INTEGER);"
+                  "INSERT INTO t VALUES (7), (8), (1000);") ;
+      auto ds = db.select ("SELECT name FROM t JOIN data ON id = ref"
+                           " ORDER BY ref;") ;
+
+      THEN ("lookups are done via the key")
+      {
+        REQUIRE (ds.size () == 2) ;
+        CHECK (ds[0][0].getText () == "n7") ;
+        CHECK (ds[1][0].getText () == "n8") ;
+        CHECK (source->nameReads == 2) ;
+      }
+    }
+  }
+}
+
+SCENARIO("lifetime and errors of virtual table sources")
+{
+  using namespace sl3 ;
+  GIVEN ("a database with a virtual table")
+  {
+    Database db{":memory:"};
+    auto     source = std::make_shared<VectorColumns> ();
+    source->ids     = {1, 2};
+    source->names   = {"a", "b"};
+    db.createVirtualTable ("data", source) ;
+    REQUIRE (source.use_count () > 1) ;
+
+    WHEN ("creating a second table with the same name")
+    {
+      auto other = std::make_shared<VectorColumns> ();
+      CHECK_THROWS_AS (db.createVirtualTable ("data", other), SQLite3Error) ;
+
+      THEN ("the new source is released and the table still works")
+      {
+        CHECK (other.use_count () == 1) ;
+        CHECK (ints (db, "SELECT id FROM data ORDER BY id;")
+               == (std::vector<int64_t>{1, 2})) ;
+      }
+    }
+
+    WHEN ("dropping the table")
+    {
+      db.execute ("DROP TABLE data;") ;
+
+      THEN ("the source is released")
+      {
+        CHECK (source.use_count () == 1) ;
+      }
+    }
+  }
+
+  GIVEN ("a source that throws")
+  {
+    Database db{":memory:"};
+    db.createVirtualTable ("bad", std::make_shared<FailingSource> ()) ;
+
+    WHEN ("querying the table")
+    {
+      THEN ("this is an error of the query")
+      {
+        CHECK_THROWS_AS (db.execute ("SELECT x FROM bad;"), SQLite3Error) ;
+      }
+    }
+  }
+}
+
+SCENARIO("key constraints that sqlite compares differently")
+{
+  using namespace sl3 ;
+  GIVEN ("a virtual table with a text key")
+  {
+    Database db{":memory:"};
+    Database other{":memory:"};
+    Dataset  people = other.select (
+        "SELECT 'Alice' AS name, 1 AS n"
+        " UNION ALL SELECT 'bob', 2 UNION ALL SELECT '7', 3;") ;
+    db.createVirtualTable ("people", people, "name") ;
+
+    WHEN ("comparing with an other collation")
+    {
+      THEN ("the rows sqlite matches are found")
+      {
+        CHECK (ints (db, "SELECT n FROM people"
+                         " WHERE name = 'alice' COLLATE NOCASE;")
+               == (std::vector<int64_t>{1})) ;
+        CHECK (ints (db, "SELECT n FROM people"
+                         " WHERE name > 'B' COLLATE NOCASE;")
+               == (std::vector<int64_t>{2})) ;
+      }
+    }
+
+    WHEN ("joining with a column that applies its affinity")
+    {
+      db.execute ("CREATE TABLE t (ref INTEGER);"
+                  "INSERT INTO t VALUES (7);") ;
+
+      THEN ("the converted key matches")
+      {
+        CHECK (ints (db, "SELECT n FROM t JOIN people ON name = ref;")
+               == (std::vector<int64_t>{3})) ;
+      }
+    }
+  }
+}